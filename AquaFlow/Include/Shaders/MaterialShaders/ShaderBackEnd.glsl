@@ -95,29 +95,22 @@ SampleInfo EvokeShader(in Ray ray, in CollisionInfo collisionInfo, in uint mater
 
 void main()
 {
-	uint GlobalIdx = gl_GlobalInvocationID.x;
+	// The inactive -1 wraps around to the queue 0
+	MaterialQueue Queue = sMaterialQueues[pMaterialRef + 1];
 
-	if (GlobalIdx >= uRayCount)
+	// Only the sorted range of this material, or every live ray without sorting
+	if (gl_GlobalInvocationID.x >= Queue.RayCount)
 		return;
 
-	if (uRayCount == 0)
-		return;
-
-	CollisionInfo collisionInfo = sCollisionInfos[GetActiveIndex(GlobalIdx)];
-	RayInfo rayInfo = sRayInfos[GetActiveIndex(GlobalIdx)];
-	Ray ray = sRays[GetActiveIndex(GlobalIdx)];
+	uint GlobalIdx = Queue.RayOffset + gl_GlobalInvocationID.x;
+	uint RayIdx = GetActiveIndex(GlobalIdx);
 
-	if (ray.Active == 0)
+	// Paths ended in the earlier bounces
+	if (LoadRayActive(RayIdx) != 0)
 		return;
 
-	// Initializing the random numbers
-	sRandomSeed = HashCombine(GlobalIdx, pRandomSeed);
-
-	if (sRandomSeed == 0)
-		sRandomSeed = 0x9e3770b9;
-
 	// Dispatch the correct material here, and don't process the inactive rays
-	uint MaterialRef = ray.MaterialIndex;
+	uint MaterialRef = LoadRayMaterialIndex(RayIdx);
 
 	bool MaterialPass = (MaterialRef == pMaterialRef);
 
@@ -129,6 +122,17 @@ void main()
 	if (!(MaterialPass || InactivePass))
 		return;
 
+	// The rest of the ray is only loaded for the rays this pipeline shades
+	CollisionInfo collisionInfo = LoadCollisionInfo(RayIdx);
+	RayInfo rayInfo = LoadRayInfo(RayIdx);
+	Ray ray = LoadRay(RayIdx);
+
+	// Initializing the random numbers
+	sRandomSeed = HashCombine(HashCombine(GlobalIdx, pRandomSeed), uFrameSeed);
+
+	if (sRandomSeed == 0)
+		sRandomSeed = 0x9e3770b9;
+
 	// Sampling and dispatching to the approapriate shader
 	SampleInfo sampleInfo;
 
@@ -139,57 +143,54 @@ void main()
 
 	//SampleInfo sampleInfo = EvokeShader(ray, collisionInfo, MaterialRef);
 
-	// prevent the throughput from dropping too much
-	// sampleInfo.Throughput = max(vec3(uThroughputFloor), sampleInfo.Throughput);
-
-	if (pBounceCount < 4)
-		sampleInfo.Throughput = vec3(1.0);
-
-
 	rayInfo.Throughput.xyz *= sampleInfo.Throughput;
-	
-	sRayInfos[GetActiveIndex(GlobalIdx)].Throughput = rayInfo.Throughput;
-
-	float cutoff = NormalizedMagnitude(rayInfo.Throughput.xyz);
-	cutoff = max(uThroughputFloor, cutoff);
 
 	/************ applying the russian roulette ***************/
 
-	float Xi = GetRandom(sRandomSeed);
-
-	if (Xi > cutoff)
+	// Only after the minimum bounce limit, the survival follows the path throughput
+	// Paths ending at a light, the sky or nothing terminate anyway
+	if (!InactivePass && pBounceCount + 1 >= uMinBounceLimit)
 	{
-		sRays[GetActiveIndex(GlobalIdx)].Active = RR_CUTOFF_CONST;
-		return;
+		float Survival = clamp(MaxComponent(rayInfo.Throughput.xyz), uThroughputFloor, 1.0);
+
+		if (GetRandom(sRandomSeed) >= Survival)
+		{
+			StoreRayActive(RayIdx, RR_CUTOFF_CONST);
+			return;
+		}
+
+		// Survivors carry the weight of the terminated paths, the estimate stays unbiased
+		sampleInfo.Luminance /= Survival;
+		rayInfo.Throughput.xyz /= Survival;
 	}
 
-	sampleInfo.Luminance /= cutoff;
+	StoreThroughput(RayIdx, rayInfo.Throughput);
 
 	/**********************************************************/
 
 	// Update the color values and ray directions
 	if(!sampleInfo.IsInvalid)
-		sRayInfos[GetActiveIndex(GlobalIdx)].Luminance *= vec4(sampleInfo.Luminance * sampleInfo.Weight, 1.0);
-		//sRayInfos[GetActiveIndex(GlobalIdx)].Luminance *= vec4(sampleInfo.Luminance, 1.0);
-		//sRayInfos[GetActiveIndex(GlobalIdx)].Luminance *= vec4(sampleInfo.iNormal * sampleInfo.Weight, 1.0);
-		//sRayInfos[GetActiveIndex(GlobalIdx)].Luminance *= vec4(sampleInfo.iNormal, 1.0);
+		StoreLuminance(RayIdx, rayInfo.Luminance * vec4(sampleInfo.Luminance * sampleInfo.Weight, 1.0));
+		//StoreLuminance(RayIdx, rayInfo.Luminance * vec4(sampleInfo.Luminance, 1.0));
+		//StoreLuminance(RayIdx, rayInfo.Luminance * vec4(sampleInfo.iNormal * sampleInfo.Weight, 1.0));
+		//StoreLuminance(RayIdx, rayInfo.Luminance * vec4(sampleInfo.iNormal, 1.0));
 	else
-		sRayInfos[GetActiveIndex(GlobalIdx)].Luminance = vec4(0.0, 0.0, 0.0, 1.0);
+		StoreLuminance(RayIdx, vec4(0.0, 0.0, 0.0, 1.0));
 
 	float sign = sampleInfo.IsReflected ? 1.0 : -1.0;
 
 	// Aim at the sampled direction
-	sRays[GetActiveIndex(GlobalIdx)].Origin =
-		collisionInfo.IntersectionPoint + sign * collisionInfo.Normal * TOLERENCE;
-
-	sRays[GetActiveIndex(GlobalIdx)].Direction = sampleInfo.Direction;
+	StoreRayOrigin(RayIdx, collisionInfo.IntersectionPoint + sign * collisionInfo.Normal * TOLERENCE);
+	StoreRayDirection(RayIdx, sampleInfo.Direction);
 
 	// Figure out if the ray went into a terminating material
+	uint Active = SKYBOX_MATERIAL_ID;
+
 	if (collisionInfo.HitOccured)
-		sRays[GetActiveIndex(GlobalIdx)].Active = collisionInfo.IsLightSrc ? LIGHT_MATERIAL_ID : 0;
-	else
-		sRays[GetActiveIndex(GlobalIdx)].Active = SKYBOX_MATERIAL_ID;
+		Active = collisionInfo.IsLightSrc ? LIGHT_MATERIAL_ID : 0;
 
 	if (sampleInfo.IsInvalid)
-		sRays[GetActiveIndex(GlobalIdx)].Active = EMPTY_MATERIAL_ID;
+		Active = EMPTY_MATERIAL_ID;
+
+	StoreRayActive(RayIdx, Active);
 }
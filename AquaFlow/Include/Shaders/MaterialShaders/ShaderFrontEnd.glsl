@@ -35,17 +35,29 @@ struct Face
 
 layout(std430, set = 0, binding = 0) buffer RayBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sRayWords[];
+#else
 	Ray sRays[];
+#endif
 };
 
 layout(std430, set = 0, binding = 1) buffer RayInfoBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sRayInfoWords[];
+#else
 	RayInfo sRayInfos[];
+#endif
 };
 
 layout(std430, set = 0, binding = 2) buffer CollisionInfoBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sCollisionWords[];
+#else
 	CollisionInfo sCollisionInfos[];
+#endif
 };
 
 layout(std430, set = 0, binding = 3) readonly buffer VertexBuffer
@@ -80,16 +92,28 @@ layout(std430, set = 0, binding = 8) readonly buffer LightPropsBuffer
 
 layout(set = 0, binding = 9) uniform sampler2D uCubeMap;
 
+// Entry 0 belongs to the inactive ray shader, material i sits at i + 1
+layout(std430, set = 0, binding = 10) readonly buffer MaterialQueueBuffer
+{
+	MaterialQueue sMaterialQueues[];
+};
+
 layout(std140, set = 1, binding = 0) uniform ShaderData
 {
 	uint uRayCount;
 	float uThroughputFloor; // minimum russian roulette probability
+	uint uMinBounceLimit; // paths shorter than this never face the russian roulette
 
 	// Skybox stuff...
 	uint uSkyboxExists;
 	vec4 uSkyboxColor; // The alpha channel holds the rotation of the cube map
+
+	uint uFrameSeed; // mixed into pRandomSeed, changes every frame
 };
 
+// One half of the ray buffers, for the accessors of RayStreams.glsl stitched after this file
+#define RAY_STREAM_STRIDE uRayCount
+
 uint GetActiveIndex(uint index)
 {
 	//return index;
@@ -32,15 +32,49 @@ layout(std430, set = 0, binding = 1) buffer CountBuffer
 	uint sCounts[];
 };
 
+// Laid out like a RayQueue, the dispatch arguments followed by the element count
+layout(std430, set = 0, binding = 2) readonly buffer ElementCountBuffer
+{
+	uint sDispatchArgs[3];
+	uint sElementCount;
+};
+
+// Elements below MAX_BIN_COUNT are counted in shared memory first, so every workgroup
+// issues at most one global atomic per bin instead of one per element and bin
+// Larger elements (if any) go straight to the global counts
+#ifndef MAX_BIN_COUNT
+#define MAX_BIN_COUNT 2048
+#endif
+
+shared uint sBinCounts[MAX_BIN_COUNT];
+
 void main()
 {
 	uint GlobalIdx = gl_GlobalInvocationID.x;
+	uint LocalIdx = gl_LocalInvocationID.x;
+
+	uint BinCount = min(pLargestElem, MAX_BIN_COUNT);
+
+	for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
+		sBinCounts[Bin] = 0;
+
+	barrier();
+
+	if (GlobalIdx < min(sElementCount, pBufferSize))
+	{
+		uint Elem = uint(sBuffer[GlobalIdx].CompareElem);
+
+		if (Elem < BinCount)
+			atomicAdd(sBinCounts[Elem], 1);
+		else if (Elem < pLargestElem)
+			atomicAdd(sCounts[Elem], 1);
+	}
 
-	if (GlobalIdx >= pBufferSize)
-		return;
+	barrier();
 
-	for (uint i = 0; i < pLargestElem; i++)
+	for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
 	{
-		atomicAdd(sCounts[i], uint(sBuffer[GlobalIdx].CompareElem == i));
+		if (sBinCounts[Bin] != 0)
+			atomicAdd(sCounts[Bin], sBinCounts[Bin]);
 	}
 }
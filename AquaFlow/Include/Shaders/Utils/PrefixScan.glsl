@@ -0,0 +1,172 @@
+#version 440
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+/*
+	Prefix sum of a uint buffer, split into tiles of TILE_SIZE elements
+	PREFIX_SCAN_STAGE picks one of the three dispatches:
+	* 0 --> every workgroup scans its tile in place and stores the tile total in sTileSums
+	* 1 --> a single workgroup turns the tile totals into exclusive tile offsets
+	* 2 --> every workgroup adds the offset of its tile to its elements
+
+	A buffer fitting into a single tile only needs the first stage
+	Within a tile, every invocation sums ITEMS_PER_THREAD neighbouring elements and
+	the invocation sums are scanned with a work efficient (Blelloch) scan in shared memory
+*/
+
+#ifndef ITEMS_PER_THREAD
+#define ITEMS_PER_THREAD 4
+#endif
+
+// WORKGROUP_SIZE has to be a power of two
+#define TILE_SIZE (WORKGROUP_SIZE * ITEMS_PER_THREAD)
+
+layout(push_constant) uniform MetaData
+{
+	uint pBufferSize;
+	uint pInclusive;
+};
+
+layout(std430, set = 0, binding = 0) buffer Elements
+{
+	uint sElements[];
+};
+
+layout(std430, set = 0, binding = 1) buffer TileSums
+{
+	uint sTileSums[];
+};
+
+shared uint sScan[WORKGROUP_SIZE];
+
+// Exclusive scan of one value per invocation, total receives the sum of all of them
+uint ScanWorkGroup(uint value, out uint total)
+{
+	uint LocalIdx = gl_LocalInvocationID.x;
+
+	sScan[LocalIdx] = value;
+
+	barrier();
+
+	// Up sweep, builds the partial sums in place
+	for (uint Stride = 1; Stride < WORKGROUP_SIZE; Stride <<= 1)
+	{
+		uint Idx = (LocalIdx + 1) * 2 * Stride - 1;
+
+		if (Idx < WORKGROUP_SIZE)
+			sScan[Idx] += sScan[Idx - Stride];
+
+		barrier();
+	}
+
+	total = sScan[WORKGROUP_SIZE - 1];
+
+	barrier();
+
+	if (LocalIdx == 0)
+		sScan[WORKGROUP_SIZE - 1] = 0;
+
+	barrier();
+
+	// Down sweep, pushes the partial sums back to the leaves
+	for (uint Stride = WORKGROUP_SIZE / 2; Stride > 0; Stride >>= 1)
+	{
+		uint Idx = (LocalIdx + 1) * 2 * Stride - 1;
+
+		if (Idx < WORKGROUP_SIZE)
+		{
+			uint Left = sScan[Idx - Stride];
+			sScan[Idx - Stride] = sScan[Idx];
+			sScan[Idx] += Left;
+		}
+
+		barrier();
+	}
+
+	uint Prefix = sScan[LocalIdx];
+
+	barrier();
+
+	return Prefix;
+}
+
+#if PREFIX_SCAN_STAGE == 1
+	#define SCAN_ARRAY sTileSums
+#else
+	#define SCAN_ARRAY sElements
+#endif
+
+// Scans SCAN_ARRAY[tileBegin, tileBegin + TILE_SIZE) on top of carry, returns the sum of the tile
+uint ScanTile(uint tileBegin, uint carry, bool inclusive)
+{
+	uint ThreadBegin = tileBegin + gl_LocalInvocationID.x * ITEMS_PER_THREAD;
+
+	uint Values[ITEMS_PER_THREAD];
+	uint ThreadSum = 0;
+
+	for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+	{
+		uint Idx = ThreadBegin + i;
+
+		Values[i] = Idx < pBufferSize ? SCAN_ARRAY[Idx] : 0;
+		ThreadSum += Values[i];
+	}
+
+	uint TileSum;
+	uint Prefix = carry + ScanWorkGroup(ThreadSum, TileSum);
+
+	for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+	{
+		uint Idx = ThreadBegin + i;
+
+		if (Idx < pBufferSize)
+			SCAN_ARRAY[Idx] = inclusive ? Prefix + Values[i] : Prefix;
+
+		Prefix += Values[i];
+	}
+
+	return TileSum;
+}
+
+#if PREFIX_SCAN_STAGE == 0
+
+void main()
+{
+	uint TileSum = ScanTile(gl_WorkGroupID.x * TILE_SIZE, 0, pInclusive != 0);
+
+	if (gl_LocalInvocationID.x == 0)
+		sTileSums[gl_WorkGroupID.x] = TileSum;
+}
+
+#elif PREFIX_SCAN_STAGE == 1
+
+// pBufferSize holds the tile count here
+void main()
+{
+	uint Carry = 0;
+
+	for (uint TileBegin = 0; TileBegin < pBufferSize; TileBegin += TILE_SIZE)
+		Carry += ScanTile(TileBegin, Carry, false);
+}
+
+#elif PREFIX_SCAN_STAGE == 2
+
+void main()
+{
+	// The first tile starts at zero anyway
+	if (gl_WorkGroupID.x == 0)
+		return;
+
+	uint Offset = sTileSums[gl_WorkGroupID.x];
+	uint TileBegin = gl_WorkGroupID.x * TILE_SIZE;
+
+	for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+	{
+		uint Idx = TileBegin + i * WORKGROUP_SIZE + gl_LocalInvocationID.x;
+
+		if (Idx < pBufferSize)
+			sElements[Idx] += Offset;
+	}
+}
+
+#endif
@@ -0,0 +1,247 @@
+#version 440
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+/*
+	LSD radix sort of the ArrayRef elements, every pass sorts a single digit of RADIX_BITS
+	RADIX_SORT_STAGE picks one of the three dispatches of a pass:
+	* 0 --> every workgroup counts the digits of its tile
+	* 1 --> a single workgroup turns the counts into exclusive offsets (digit major, tile minor)
+	* 2 --> every workgroup scatters its tile to those offsets, equal digits keep their order
+
+	Reads the active half of sBuffer and writes the other one, like the merge sort
+	Keys at or above pKeyCount share the last digit, so the inactive material ids cost no extra passes
+	Only the first sElementCount elements are sorted, the tiles past them leave right away
+*/
+
+#ifndef RADIX_BITS
+#define RADIX_BITS 8
+#endif
+
+#ifndef ITEMS_PER_THREAD
+#define ITEMS_PER_THREAD 8
+#endif
+
+#define RADIX_BIN_COUNT (1 << RADIX_BITS)
+#define TILE_SIZE (WORKGROUP_SIZE * ITEMS_PER_THREAD)
+
+// WORKGROUP_SIZE has to be a multiple of 32
+#define MASK_WORDS (WORKGROUP_SIZE / 32)
+
+struct ArrayRef
+{
+	uint CompareElem;
+	uint ElemIdx;
+};
+
+layout(push_constant) uniform MetaData
+{
+	uint pBufferSize;
+	uint pActiveBuffer;
+	uint pShift;
+	uint pKeyCount;
+};
+
+layout(std430, set = 0, binding = 0) buffer RefBuffer
+{
+	ArrayRef sBuffer[];
+};
+
+// Digit counts and later the offsets of every tile
+layout(std430, set = 0, binding = 1) buffer CountBuffer
+{
+	uint sGroupCounts[];
+};
+
+// Laid out like a RayQueue, the dispatch arguments followed by the element count
+layout(std430, set = 0, binding = 2) readonly buffer ElementCountBuffer
+{
+	uint sDispatchArgs[3];
+	uint sElementCount;
+};
+
+uint ActiveIndex(uint index)
+{
+	return pBufferSize * pActiveBuffer + index;
+}
+
+uint InactiveIndex(uint index)
+{
+	return pBufferSize * (1 - pActiveBuffer) + index;
+}
+
+uint GetDigit(uint key)
+{
+	return (min(key, pKeyCount - 1) >> pShift) & (RADIX_BIN_COUNT - 1);
+}
+
+// Digits this pass can produce, the scan only walks these
+uint GetBinCount()
+{
+	return min(RADIX_BIN_COUNT, ((pKeyCount - 1) >> pShift) + 1);
+}
+
+uint GetElementCount()
+{
+	return min(sElementCount, pBufferSize);
+}
+
+uint GetGroupCount()
+{
+	return (GetElementCount() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+#if RADIX_SORT_STAGE == 0
+
+shared uint sBinCounts[RADIX_BIN_COUNT];
+
+void main()
+{
+	uint LocalIdx = gl_LocalInvocationID.x;
+	uint BinCount = GetBinCount();
+	uint GroupCount = GetGroupCount();
+	uint ElementCount = GetElementCount();
+
+	// The whole workgroup leaves together, no barrier is left waiting
+	if (gl_WorkGroupID.x >= GroupCount)
+		return;
+
+	for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
+		sBinCounts[Bin] = 0;
+
+	barrier();
+
+	uint TileBegin = gl_WorkGroupID.x * TILE_SIZE;
+
+	for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+	{
+		uint Idx = TileBegin + i * WORKGROUP_SIZE + LocalIdx;
+
+		if (Idx < ElementCount)
+			atomicAdd(sBinCounts[GetDigit(sBuffer[ActiveIndex(Idx)].CompareElem)], 1);
+	}
+
+	barrier();
+
+	for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
+		sGroupCounts[Bin * GroupCount + gl_WorkGroupID.x] = sBinCounts[Bin];
+}
+
+#elif RADIX_SORT_STAGE == 1
+
+shared uint sScan[WORKGROUP_SIZE];
+
+void main()
+{
+	uint LocalIdx = gl_LocalInvocationID.x;
+	uint CountSize = GetBinCount() * GetGroupCount();
+
+	uint Carry = 0;
+
+	for (uint Base = 0; Base < CountSize; Base += WORKGROUP_SIZE)
+	{
+		uint Idx = Base + LocalIdx;
+		uint Value = Idx < CountSize ? sGroupCounts[Idx] : 0;
+
+		sScan[LocalIdx] = Value;
+
+		barrier();
+
+		// Inclusive Hillis-Steele scan of the chunk
+		for (uint Offset = 1; Offset < WORKGROUP_SIZE; Offset <<= 1)
+		{
+			uint Addend = LocalIdx >= Offset ? sScan[LocalIdx - Offset] : 0;
+
+			barrier();
+
+			sScan[LocalIdx] += Addend;
+
+			barrier();
+		}
+
+		if (Idx < CountSize)
+			sGroupCounts[Idx] = Carry + sScan[LocalIdx] - Value;
+
+		Carry += sScan[WORKGROUP_SIZE - 1];
+
+		barrier();
+	}
+}
+
+#elif RADIX_SORT_STAGE == 2
+
+shared uint sBinOffsets[RADIX_BIN_COUNT];
+
+// One bit per invocation and digit, the rank of an element is the number of
+// set bits below its own one in the mask of its digit
+shared uint sDigitMasks[RADIX_BIN_COUNT * MASK_WORDS];
+
+void main()
+{
+	uint LocalIdx = gl_LocalInvocationID.x;
+	uint BinCount = GetBinCount();
+	uint GroupCount = GetGroupCount();
+	uint ElementCount = GetElementCount();
+
+	if (gl_WorkGroupID.x >= GroupCount)
+		return;
+
+	for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
+		sBinOffsets[Bin] = sGroupCounts[Bin * GroupCount + gl_WorkGroupID.x];
+
+	uint TileBegin = gl_WorkGroupID.x * TILE_SIZE;
+
+	uint Word = LocalIdx / 32;
+	uint LowerBits = (1u << (LocalIdx % 32)) - 1u;
+
+	// Rounds walk the tile in order, so the elements of earlier rounds always rank lower
+	for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+	{
+		for (uint Mask = LocalIdx; Mask < BinCount * MASK_WORDS; Mask += WORKGROUP_SIZE)
+			sDigitMasks[Mask] = 0;
+
+		barrier();
+
+		uint Idx = TileBegin + i * WORKGROUP_SIZE + LocalIdx;
+		bool Valid = Idx < ElementCount;
+
+		ArrayRef Elem;
+		uint Digit = 0;
+
+		if (Valid)
+		{
+			Elem = sBuffer[ActiveIndex(Idx)];
+			Digit = GetDigit(Elem.CompareElem);
+
+			atomicOr(sDigitMasks[Digit * MASK_WORDS + Word], 1u << (LocalIdx % 32));
+		}
+
+		barrier();
+
+		if (Valid)
+		{
+			uint Rank = uint(bitCount(sDigitMasks[Digit * MASK_WORDS + Word] & LowerBits));
+
+			for (uint w = 0; w < Word; w++)
+				Rank += uint(bitCount(sDigitMasks[Digit * MASK_WORDS + w]));
+
+			sBuffer[InactiveIndex(sBinOffsets[Digit] + Rank)] = Elem;
+		}
+
+		barrier();
+
+		for (uint Bin = LocalIdx; Bin < BinCount; Bin += WORKGROUP_SIZE)
+		{
+			uint Count = 0;
+
+			for (uint w = 0; w < MASK_WORDS; w++)
+				Count += uint(bitCount(sDigitMasks[Bin * MASK_WORDS + w]));
+
+			sBinOffsets[Bin] += Count;
+		}
+
+		barrier();
+	}
+}
+
+#endif
@@ -0,0 +1,58 @@
+#version 440
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+#include "DescSet0.glsl"
+
+/*
+	Turns the scanned material ref counts into the indirect dispatches of the material pipelines
+	Each material only runs over its own range of the sorted rays:
+	* Entry 0 --> the empty, skybox and light ids, which the sort puts right after the last material
+	* Entry i + 1 --> material i, from sMaterialOffsets[i] to sMaterialOffsets[i + 1]
+
+	Without sorting every entry covers all of the live rays, the shaders still filter by material
+	The group counts assume the material pipelines use WORKGROUP_SIZE as well
+*/
+
+layout(push_constant) uniform QueueData
+{
+	uint pMaterialCount;
+	uint pSorted;
+};
+
+void WriteQueue(uint queueIdx, uint rayOffset, uint rayCount)
+{
+	sMaterialQueues[queueIdx].GroupCountX = (rayCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	sMaterialQueues[queueIdx].GroupCountY = 1;
+	sMaterialQueues[queueIdx].GroupCountZ = 1;
+	sMaterialQueues[queueIdx].RayOffset = rayOffset;
+	sMaterialQueues[queueIdx].RayCount = rayCount;
+}
+
+void main()
+{
+	uint QueueIdx = gl_GlobalInvocationID.x;
+
+	if (QueueIdx > pMaterialCount)
+		return;
+
+	uint LiveCount = sRayQueues[0].RayCount;
+
+	if (pSorted == 0)
+	{
+		WriteQueue(QueueIdx, 0, LiveCount);
+		return;
+	}
+
+	if (QueueIdx == 0)
+	{
+		uint InactiveOffset = sMaterialOffsets[pMaterialCount];
+		WriteQueue(0, InactiveOffset, LiveCount - InactiveOffset);
+		return;
+	}
+
+	uint MaterialIdx = QueueIdx - 1;
+	uint RayOffset = sMaterialOffsets[MaterialIdx];
+
+	WriteQueue(QueueIdx, RayOffset, sMaterialOffsets[MaterialIdx + 1] - RayOffset);
+}
@@ -16,6 +16,27 @@ struct RayInfo
 	vec4 Throughput;
 };
 
+// Live rays of a bounce, the group counts are read by vkCmdDispatchIndirect
+// Queue zero is the current one, queue one collects the survivors of the compaction
+struct RayQueue
+{
+	uint GroupCountX;
+	uint GroupCountY;
+	uint GroupCountZ;
+	uint RayCount;
+};
+
+// Sorted rays of a single material pipeline, entry 0 belongs to the inactive ray shader
+// and material i sits at i + 1
+struct MaterialQueue
+{
+	uint GroupCountX;
+	uint GroupCountY;
+	uint GroupCountZ;
+	uint RayOffset;
+	uint RayCount;
+};
+
 struct Material
 {
 	vec3 Albedo;
@@ -47,6 +68,17 @@ struct LightInfo
 	uint LightPropsIndex;
 };
 
+struct InstanceInfo
+{
+	mat4 WorldToObject;
+	mat4 ObjectToWorld;
+
+	uint RootIndex;
+	uint MaterialIndex;
+	uint Padding1;
+	uint Padding2;
+};
+
 struct Node
 {
 	vec3 MinBound;
@@ -56,10 +88,45 @@ struct Node
 	uint EndIndex;
 
 	uint FirstChildIndex;
-	uint Padding;
+	uint SplitAxis;
 	uint SecondChildIndex;
 };
 
+#define COMPACT_INTERNAL_NODE 0xFFFFFFFFu
+
+struct CompactNode
+{
+	// Half precision bounds of the left child followed by the right one
+	uint ChildBounds[6];
+
+	// Left child for internal nodes, first face for leaves
+	uint ChildIndex;
+	uint TriangleCount;
+};
+
+#ifndef BVH_WIDTH
+#define BVH_WIDTH 4
+#endif
+
+#define WIDE_EMPTY_SLOT 0xFFFFFFFFu
+
+struct WideNode
+{
+	// Child bounds split per component
+	float MinX[BVH_WIDTH];
+	float MinY[BVH_WIDTH];
+	float MinZ[BVH_WIDTH];
+
+	float MaxX[BVH_WIDTH];
+	float MaxY[BVH_WIDTH];
+	float MaxZ[BVH_WIDTH];
+
+	// Child node, first face of a leaf or WIDE_EMPTY_SLOT
+	uint ChildIndex[BVH_WIDTH];
+	// Zero for internal slots
+	uint TriangleCount[BVH_WIDTH];
+};
+
 struct CollisionInfo
 {
 	// Values set by the collision solver...
@@ -86,6 +153,34 @@ struct RayRef
 	uint FieldIndex;
 };
 
+// Ray, ray info and collision info buffers as a stream per word, see RayStreams.glsl
+#ifndef RAY_SOA_LAYOUT
+#define RAY_SOA_LAYOUT 0
+#endif
+
+// Word offsets of the std430 layouts above
+#define RAY_WORDS 8
+#define RAY_ORIGIN_WORD 0
+#define RAY_MATERIAL_INDEX_WORD 3
+#define RAY_DIRECTION_WORD 4
+#define RAY_ACTIVE_WORD 7
+
+#define RAY_INFO_WORDS 12
+#define RAY_INFO_COORDINATE_WORD 0
+#define RAY_INFO_LUMINANCE_WORD 4
+#define RAY_INFO_THROUGHPUT_WORD 8
+
+#define COLLISION_INFO_WORDS 16
+#define COLLISION_NORMAL_WORD 0
+#define COLLISION_RAY_DIS_WORD 3
+#define COLLISION_POINT_WORD 4
+#define COLLISION_NORMAL_INVERTED_WORD 7
+#define COLLISION_BCOORDS_WORD 8
+#define COLLISION_PRIMITIVE_ID_WORD 11
+#define COLLISION_MATERIAL_INDEX_WORD 12
+#define COLLISION_HIT_OCCURED_WORD 13
+#define COLLISION_IS_LIGHT_SRC_WORD 14
+
 vec3 GetPoint(Ray ray, float Par)
 {
 	return ray.Origin + ray.Direction * Par;
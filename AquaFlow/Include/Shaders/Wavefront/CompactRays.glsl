@@ -0,0 +1,99 @@
+#version 440
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+#include "DescSet0.glsl"
+#include "DescSet1.glsl"
+
+/*
+	Stream compaction of the rays after the shading stage
+	RAY_COMPACTION_STAGE picks one of the two dispatches:
+	* 0 --> live rays move to the front of the inactive buffer, the ones which ended
+	        in this bounce are folded into the pixel mean right away
+	* 1 --> a single invocation turns the survivor count into the queue of the next bounce
+
+	Survivors don't keep their order, the ray sort restores the material coherence
+	The indirect dispatches of the later stages have to use WORKGROUP_SIZE as well
+*/
+
+layout(push_constant) uniform RayData
+{
+	uint pRayCount;
+	uint pActiveBuffer;
+};
+
+uint ActiveBufferIndex(uint index)
+{
+	return pRayCount * pActiveBuffer + index;
+}
+
+uint InactiveBufferIndex(uint index)
+{
+	return pRayCount * (1 - pActiveBuffer) + index;
+}
+
+#define RAY_STREAM_STRIDE pRayCount
+#include "RayStreams.glsl"
+#include "PixelMean.glsl"
+
+#if RAY_COMPACTION_STAGE == 0
+
+shared uint sSurvivorCount;
+shared uint sSurvivorBase;
+
+void main()
+{
+	uint GlobalIdx = gl_GlobalInvocationID.x;
+	uint LocalIdx = gl_LocalInvocationID.x;
+
+	if (LocalIdx == 0)
+		sSurvivorCount = 0;
+
+	barrier();
+
+	bool Valid = GlobalIdx < sRayQueues[0].RayCount;
+	bool Survived = Valid && LoadRayActive(ActiveBufferIndex(GlobalIdx)) == 0;
+
+	// One global atomic per workgroup instead of one per ray
+	uint LocalSlot = 0;
+
+	if (Survived)
+		LocalSlot = atomicAdd(sSurvivorCount, 1);
+
+	barrier();
+
+	if (LocalIdx == 0)
+		sSurvivorBase = atomicAdd(sRayQueues[1].RayCount, sSurvivorCount);
+
+	barrier();
+
+	if (Survived)
+	{
+		uint Slot = InactiveBufferIndex(sSurvivorBase + LocalSlot);
+
+		CopyRay(Slot, ActiveBufferIndex(GlobalIdx));
+		CopyRayInfo(Slot, ActiveBufferIndex(GlobalIdx));
+	}
+	else if (Valid)
+		AccumulatePixelMean(ActiveBufferIndex(GlobalIdx));
+}
+
+#elif RAY_COMPACTION_STAGE == 1
+
+void main()
+{
+	if (gl_GlobalInvocationID.x != 0)
+		return;
+
+	uint RayCount = sRayQueues[1].RayCount;
+
+	sRayQueues[0].GroupCountX = (RayCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	sRayQueues[0].GroupCountY = 1;
+	sRayQueues[0].GroupCountZ = 1;
+	sRayQueues[0].RayCount = RayCount;
+
+	// Ready for the next compaction
+	sRayQueues[1].RayCount = 0;
+}
+
+#endif
@@ -5,7 +5,11 @@
 
 layout(set = 0, binding = 0) buffer RayBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sRayWords[];
+#else
 	Ray sRays[];
+#endif
 };
 
 layout(set = 0, binding = 1) uniform CameraInfo
@@ -20,7 +24,11 @@ layout(set = 0, binding = 1) uniform CameraInfo
 
 layout(set = 0, binding = 2) buffer CollisionInfoBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sCollisionWords[];
+#else
 	CollisionInfo sCollisionInfos[];
+#endif
 };
 
 layout(set = 0, binding = 3) buffer SortingRefsBuffer
@@ -30,7 +38,27 @@ layout(set = 0, binding = 3) buffer SortingRefsBuffer
 
 layout(set = 0, binding = 4) buffer RayInfoBuffer
 {
+#if RAY_SOA_LAYOUT
+	uint sRayInfoWords[];
+#else
 	RayInfo sRayInfos[];
+#endif
+};
+
+layout(set = 0, binding = 5) buffer RayQueueBuffer
+{
+	RayQueue sRayQueues[];
+};
+
+layout(set = 0, binding = 6) buffer MaterialQueueBuffer
+{
+	MaterialQueue sMaterialQueues[];
+};
+
+// Exclusive prefix sum of the material ref counts
+layout(set = 0, binding = 7) readonly buffer MaterialOffsetBuffer
+{
+	uint sMaterialOffsets[];
 };
 
 #endif
@@ -72,8 +72,34 @@ layout(std140, set = 1, binding = 9) uniform SceneInfo
 
 	uint ResetImage;
 	uint FrameCount;
+
+	// Top level leaves index meshes first, then lights and then instances
+	uint TopLevelRoot;
+	uint InstanceCount;
+
+	// Zero for the binary nodes, one for the compact ones and two for the wide ones
+	uint NodeLayout;
+
+	// Per frame values, a reused recording of the trace only sees them through here
+	uint FrameSeed;
+	mat4 CameraView;
 } uSceneInfo;
 
 layout(set = 1, binding = 10) uniform sampler2D uCubeMap;
 
+layout(std430, set = 1, binding = 11) readonly buffer InstanceInfoBuffer
+{
+	InstanceInfo sInstanceInfos[];
+};
+
+layout(std430, set = 1, binding = 12) readonly buffer CompactNodeBuffer
+{
+	CompactNode sCompactNodes[];
+};
+
+layout(std430, set = 1, binding = 13) readonly buffer WideNodeBuffer
+{
+	WideNode sWideNodes[];
+};
+
 #endif
\ No newline at end of file
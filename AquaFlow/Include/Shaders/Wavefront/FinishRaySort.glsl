@@ -29,21 +29,23 @@ uint IndexOffsetRayRef(uint index)
 	return pRayRefActiveBuffer * pRayCount + index;
 }
 
+#define RAY_STREAM_STRIDE pRayCount
+#include "RayStreams.glsl"
+
 void main()
 {
 	uint GlobalIdx = gl_GlobalInvocationID.x;
 
-	if (GlobalIdx >= pRayCount)
+	// The sorted live rays sit at the front, nothing behind them is read anymore
+	if (GlobalIdx >= min(sRayQueues[0].RayCount, pRayCount))
 		return;
 	
 	uint InactiveBuffer = 1 - pActiveBuffer;
 
-	sRays[IndexOffsetInactive(GlobalIdx)] =
-		sRays[IndexOffsetActive(sRayRefs[IndexOffsetRayRef(GlobalIdx)].FieldIndex)];
-
-	sCollisionInfos[IndexOffsetInactive(GlobalIdx)] =
-		sCollisionInfos[IndexOffsetActive(sRayRefs[IndexOffsetRayRef(GlobalIdx)].FieldIndex)];
+	uint SrcIdx = IndexOffsetActive(sRayRefs[IndexOffsetRayRef(GlobalIdx)].FieldIndex);
+	uint DstIdx = IndexOffsetInactive(GlobalIdx);
 
-	sRayInfos[IndexOffsetInactive(GlobalIdx)] =
-		sRayInfos[IndexOffsetActive(sRayRefs[IndexOffsetRayRef(GlobalIdx)].FieldIndex)];
+	CopyRay(DstIdx, SrcIdx);
+	CopyCollisionInfo(DstIdx, SrcIdx);
+	CopyRayInfo(DstIdx, SrcIdx);
 }
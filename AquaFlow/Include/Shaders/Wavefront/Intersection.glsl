@@ -6,12 +6,20 @@ layout(local_size_x = WORKGROUP_SIZE) in;
 
 #define STACK_SIZE 64
 
+#ifndef OCCLUSION_QUERY
+#define OCCLUSION_QUERY 0
+#endif
+
+#ifndef WATERTIGHT_INTERSECTION
+#define WATERTIGHT_INTERSECTION 0
+#endif
+
 #include "DescSet0.glsl"
 #include "DescSet1.glsl"
 
 layout(push_constant) uniform RayData
 {
-	uint pRayCount;
+	uint pRayCount; // Size of a ray buffer half, the live count is in sRayQueues
 	uint pActiveBuffer;
 };
 
@@ -21,17 +29,28 @@ struct AABB_CollisionInfo
 	float RayDis;
 };
 
+struct RayQuery
+{
+	vec3 Origin;
+	vec3 Direction;
+
+	// Computed once per traversal, the slab test only multiplies
+	vec3 InvDirection;
+
+#if WATERTIGHT_INTERSECTION
+	// Axis permutation and shear of the watertight triangle test
+	ivec3 Axes;
+	vec3 Shear;
+#endif
+};
+
 uint IndexOffset(uint index)
 {
 	return pRayCount * pActiveBuffer + index;
 }
 
-void SwapWithCondition(inout float a, inout float b, bool condition)
-{
-	float Temp = b;
-	b = condition ? a : b;
-	a = condition ? Temp : a;
-}
+#define RAY_STREAM_STRIDE pRayCount
+#include "RayStreams.glsl"
 
 vec3 InterpolateNormal(in vec3 bCoords, uint PrimitiveID)
 {
@@ -55,158 +74,547 @@ vec3 GetSurfaceNormal(in CollisionInfo HitInfo)
 	return InterpolateNormal(HitInfo.bCoords, HitInfo.PrimitiveID) * HitInfo.NormalInverted;
 }
 
-void CheckRayTriangleCollision(inout CollisionInfo hitInfo, in Ray ray, in vec3 A, in vec3 B, in vec3 C)
+RayQuery MakeRayQuery(in Ray ray)
+{
+	RayQuery query;
+
+	query.Origin = ray.Origin;
+	query.Direction = ray.Direction;
+	query.InvDirection = 1.0 / ray.Direction;
+
+#if WATERTIGHT_INTERSECTION
+	vec3 Magnitude = abs(ray.Direction);
+
+	// The dominant axis becomes z, swapping x and y keeps the winding for negative directions
+	int Z = Magnitude.x > Magnitude.y ? (Magnitude.x > Magnitude.z ? 0 : 2) : (Magnitude.y > Magnitude.z ? 1 : 2);
+	int X = (Z + 1) % 3;
+	int Y = (X + 1) % 3;
+
+	if (ray.Direction[Z] < 0.0)
+	{
+		int Temp = X;
+		X = Y;
+		Y = Temp;
+	}
+
+	query.Axes = ivec3(X, Y, Z);
+	query.Shear = vec3(ray.Direction[X] / ray.Direction[Z],
+		ray.Direction[Y] / ray.Direction[Z], 1.0 / ray.Direction[Z]);
+#endif
+
+	return query;
+}
+
+void FillTriangleHit(inout CollisionInfo hitInfo, in RayQuery ray,
+	in vec3 A, in vec3 B, in vec3 C, in vec3 bCoords, in float rayDis)
 {
-	hitInfo.HitOccured = false;
+	// Only reached by accepted hits, the misses never pay for the normal
+	vec3 Normal = normalize(cross(B - A, C - A));
 
+	hitInfo.bCoords = bCoords;
+	hitInfo.IntersectionPoint = ray.Origin + rayDis * ray.Direction;
+	hitInfo.RayDis = rayDis;
+	hitInfo.HitOccured = true;
+
+	hitInfo.NormalInverted = dot(Normal, ray.Direction) < 0 ? 1.0 : -1.0;
+	hitInfo.Normal = Normal * hitInfo.NormalInverted;
+}
+
+// hitInfo is only written for hits closer than maxDis
+bool CheckRayTriangleCollision(inout CollisionInfo hitInfo, in RayQuery ray,
+	in vec3 A, in vec3 B, in vec3 C, in float maxDis)
+{
 	vec3 E1 = B - A;
 	vec3 E2 = C - A;
 
-	// Normal, Determinant and the ray dis calculation
-	vec3 Normal = normalize(cross(E1, E2));
-
 	vec3 H = cross(ray.Direction, E2);
 	float Determinant = dot(E1, H);
 
+	if (abs(Determinant) <= TOLERENCE)
+		return false;
+
 	float DeterminantInv = 1.0 / Determinant;
 
 	vec3 T = ray.Origin - A;
+	float U = dot(T, H) * DeterminantInv;
+
+	if (U < 0.0 || U > 1.0)
+		return false;
+
 	vec3 Q = cross(T, E1);
+	float V = dot(ray.Direction, Q) * DeterminantInv;
+
+	if (V < 0.0 || U + V > 1.0)
+		return false;
+
 	float Alpha = dot(E2, Q) * DeterminantInv;
 
-	// Calculate barycentric coords
-	vec3 bCoords;
+	if (Alpha <= 0.0 || Alpha >= maxDis)
+		return false;
 
-	bCoords.g = dot(T, H) * DeterminantInv;
-	bCoords.b = dot(ray.Direction, Q) * DeterminantInv;
-	bCoords.r = 1.0 - bCoords.b - bCoords.g;
+	FillTriangleHit(hitInfo, ray, A, B, C, vec3(1.0 - U - V, U, V), Alpha);
 
-	// Prepare the HitInfo buffer
-	hitInfo.bCoords = bCoords;
-	hitInfo.IntersectionPoint = ray.Origin + Alpha * ray.Direction;
-	hitInfo.Normal = Normal;
-	hitInfo.RayDis = Alpha;
+	return true;
+}
 
-	hitInfo.HitOccured = (bCoords.x >= 0.0 && bCoords.y >= 0.0 && bCoords.z >= 0.0) &&
-		Alpha > 0.0 && abs(Determinant) > TOLERENCE;
+#if WATERTIGHT_INTERSECTION
 
-	hitInfo.NormalInverted = dot(Normal, ray.Direction) < 0 ? 1.0 : -1.0;
-	hitInfo.Normal *= hitInfo.NormalInverted;
+// Woop, Benthin and Wald's watertight test, rays through shared edges never slip between the triangles
+// Unlike the CPU version, there is no double precision fallback for edge functions that are exactly zero
+bool CheckRayTriangleCollisionWatertight(inout CollisionInfo hitInfo, in RayQuery ray,
+	in vec3 A, in vec3 B, in vec3 C, in float maxDis)
+{
+	vec3 LocalA = A - ray.Origin;
+	vec3 LocalB = B - ray.Origin;
+	vec3 LocalC = C - ray.Origin;
+
+	vec2 ShearedA = vec2(LocalA[ray.Axes.x], LocalA[ray.Axes.y]) - ray.Shear.xy * LocalA[ray.Axes.z];
+	vec2 ShearedB = vec2(LocalB[ray.Axes.x], LocalB[ray.Axes.y]) - ray.Shear.xy * LocalB[ray.Axes.z];
+	vec2 ShearedC = vec2(LocalC[ray.Axes.x], LocalC[ray.Axes.y]) - ray.Shear.xy * LocalC[ray.Axes.z];
+
+	float U = ShearedC.x * ShearedB.y - ShearedC.y * ShearedB.x;
+	float V = ShearedA.x * ShearedC.y - ShearedA.y * ShearedC.x;
+	float W = ShearedB.x * ShearedA.y - ShearedB.y * ShearedA.x;
+
+	if ((U < 0.0 || V < 0.0 || W < 0.0) && (U > 0.0 || V > 0.0 || W > 0.0))
+		return false;
+
+	float Determinant = U + V + W;
+
+	if (Determinant == 0.0)
+		return false;
+
+	float T = ray.Shear.z * (U * LocalA[ray.Axes.z] + V * LocalB[ray.Axes.z] + W * LocalC[ray.Axes.z]);
+
+	// Compares the scaled distance, so the division only happens for accepted hits
+	float Sign = Determinant < 0.0 ? -1.0 : 1.0;
+
+	if (T * Sign <= 0.0 || T * Sign >= maxDis * Determinant * Sign)
+		return false;
+
+	float DeterminantInv = 1.0 / Determinant;
+
+	FillTriangleHit(hitInfo, ray, A, B, C, vec3(U, V, W) * DeterminantInv, T * DeterminantInv);
+
+	return true;
 }
 
+#endif
+
 void CheckRayAABB_Collision(inout AABB_CollisionInfo hitInfo,
-	in Ray ray, in vec3 minCorner, in vec3 maxCorner)
+	in RayQuery ray, in vec3 minCorner, in vec3 maxCorner)
+{
+	// Slab test against the precomputed reciprocal, no divisions per box
+	vec3 T0 = (minCorner - ray.Origin) * ray.InvDirection;
+	vec3 T1 = (maxCorner - ray.Origin) * ray.InvDirection;
+
+	vec3 TNear = min(T0, T1);
+	vec3 TFar = max(T0, T1);
+
+	float tMin = max(max(TNear.x, TNear.y), TNear.z);
+	float tMax = min(min(TFar.x, TFar.y), TFar.z);
+
+	hitInfo.HitOccured = tMin < tMax && tMax > 0.0;
+	hitInfo.RayDis = tMin > 0.0 ? tMin : 0.0;
+}
+
+bool TestLeafTriangles(inout CollisionInfo ClosestHit, in RayQuery ray, in uint beginIndex, in uint endIndex)
+{
+	bool FoundCloser = false;
+
+	for (uint j = beginIndex; j < endIndex; j++)
+	{
+	#if WATERTIGHT_INTERSECTION
+		bool Replaced = CheckRayTriangleCollisionWatertight(ClosestHit, ray,
+	#else
+		bool Replaced = CheckRayTriangleCollision(ClosestHit, ray,
+	#endif
+			sPositions[sFaces[j].Indices.x],
+			sPositions[sFaces[j].Indices.y],
+			sPositions[sFaces[j].Indices.z], ClosestHit.RayDis);
+
+		if (!Replaced)
+			continue;
+
+		ClosestHit.PrimitiveID = j;
+		ClosestHit.MaterialIndex = sFaces[j].MaterialRef;
+
+		FoundCloser = true;
+	}
+
+	return FoundCloser;
+}
+
+bool FindCollisionNode(inout CollisionInfo ClosestHit, in RayQuery ray, in uint rootIndex)
 {
-	hitInfo.HitOccured = false;
+	// Both children are tested before they are pushed, the far one goes first
+	// Near and far come from the split axis and the sign of the ray, so no distances are compared
+	bool FoundCloser = false;
 
-	float tMin = (minCorner.x - ray.Origin.x) / ray.Direction.x;
-	float tMax = (maxCorner.x - ray.Origin.x) / ray.Direction.x;
+	AABB_CollisionInfo FirstHit;
+	AABB_CollisionInfo SecondHit;
 
-	SwapWithCondition(tMin, tMax, tMin > tMax);
+	uint NodeStackIndices[STACK_SIZE];
+	float NodeStackDis[STACK_SIZE];
+	uint StackPtr = 0;
 
-	float tyMin = (minCorner.y - ray.Origin.y) / ray.Direction.y;
-	float tyMax = (maxCorner.y - ray.Origin.y) / ray.Direction.y;
+	CheckRayAABB_Collision(FirstHit, ray, sNodes[rootIndex].MinBound, sNodes[rootIndex].MaxBound);
 
-	SwapWithCondition(tyMin, tyMax, tyMin > tyMax);
+	if (!FirstHit.HitOccured || FirstHit.RayDis > ClosestHit.RayDis)
+		return false;
 
-	float txMin = tMin;
-	float txMax = tMax;
+	NodeStackIndices[StackPtr] = rootIndex;
+	NodeStackDis[StackPtr++] = FirstHit.RayDis;
 
-	tMin = max(tMin, tyMin);
-	tMax = min(tMax, tyMax);
+	while (StackPtr != 0)
+	{
+		--StackPtr;
 
-	float tzMin = (minCorner.z - ray.Origin.z) / ray.Direction.z;
-	float tzMax = (maxCorner.z - ray.Origin.z) / ray.Direction.z;
+		uint CurrentIndex = NodeStackIndices[StackPtr];
 
-	SwapWithCondition(tzMin, tzMax, tzMin > tzMax);
+		// The closest hit might have moved since the push
+		if (NodeStackDis[StackPtr] > ClosestHit.RayDis)
+			continue;
 
-	tMin = max(tMin, tzMin);
-	tMax = min(tMax, tzMax);
+		uint FirstChild = sNodes[CurrentIndex].FirstChildIndex;
 
-	hitInfo.HitOccured =
-		(tMin < tzMax) && (tzMin < tMax) &&
-		(tMin < tyMax) && (tyMin < tMax) &&
-		((tMin < tMax) && (tMax > 0.0));
+		if (FirstChild == rootIndex)
+		{
+			FoundCloser = TestLeafTriangles(ClosestHit, ray,
+				sNodes[CurrentIndex].BeginIndex, sNodes[CurrentIndex].EndIndex) || FoundCloser;
 
-	hitInfo.RayDis = tMin > 0.0 ? tMin : 0.0;
+		#if OCCLUSION_QUERY
+			if (FoundCloser)
+				return true;
+		#endif
+
+			continue;
+		}
+
+		uint SecondChild = sNodes[CurrentIndex].SecondChildIndex;
+
+		CheckRayAABB_Collision(FirstHit, ray, sNodes[FirstChild].MinBound, sNodes[FirstChild].MaxBound);
+		CheckRayAABB_Collision(SecondHit, ray, sNodes[SecondChild].MinBound, sNodes[SecondChild].MaxBound);
+
+		bool PushFirst = FirstHit.HitOccured && FirstHit.RayDis <= ClosestHit.RayDis;
+		bool PushSecond = SecondHit.HitOccured && SecondHit.RayDis <= ClosestHit.RayDis;
+
+		// A ray going down the split axis reaches the second child first
+		bool SecondNear = ray.Direction[sNodes[CurrentIndex].SplitAxis] < 0.0;
+
+		if (SecondNear ? PushFirst : PushSecond)
+		{
+			NodeStackIndices[StackPtr] = SecondNear ? FirstChild : SecondChild;
+			NodeStackDis[StackPtr++] = SecondNear ? FirstHit.RayDis : SecondHit.RayDis;
+		}
+
+		if (SecondNear ? PushSecond : PushFirst)
+		{
+			NodeStackIndices[StackPtr] = SecondNear ? SecondChild : FirstChild;
+			NodeStackDis[StackPtr++] = SecondNear ? SecondHit.RayDis : FirstHit.RayDis;
+		}
+	}
+
+	return FoundCloser;
 }
 
-bool FindCollisionNode(inout CollisionInfo ClosestHit, in Ray ray, in uint rootIndex)
+void UnpackChildBounds(out vec3 minBound, out vec3 maxBound, in uint nodeIndex, in uint child)
 {
+	uint Offset = 3 * child;
+
+	vec2 First = unpackHalf2x16(sCompactNodes[nodeIndex].ChildBounds[Offset]);
+	vec2 Second = unpackHalf2x16(sCompactNodes[nodeIndex].ChildBounds[Offset + 1]);
+	vec2 Third = unpackHalf2x16(sCompactNodes[nodeIndex].ChildBounds[Offset + 2]);
+
+	minBound = vec3(First.x, First.y, Second.x);
+	maxBound = vec3(Second.y, Third.x, Third.y);
+}
+
+bool FindCollisionCompactNode(inout CollisionInfo ClosestHit, in RayQuery ray, in uint rootIndex)
+{
+	// Each fetch tests both children, so the boxes are culled before they are pushed
 	bool FoundCloser = false;
 
-	CollisionInfo hitInfo;
+	AABB_CollisionInfo LeftHit;
+	AABB_CollisionInfo RightHit;
 
-	AABB_CollisionInfo hitInfoAABB;
+	vec3 MinBound, MaxBound;
 
 	uint NodeStackIndices[STACK_SIZE];
+	float NodeStackDis[STACK_SIZE];
 	uint StackPtr = 0;
 
-	NodeStackIndices[StackPtr++] = rootIndex;
+	NodeStackIndices[StackPtr] = rootIndex;
+	NodeStackDis[StackPtr++] = 0.0;
 
 	while (StackPtr != 0)
 	{
-		uint CurrentIndex = NodeStackIndices[--StackPtr];
+		--StackPtr;
+
+		uint CurrentIndex = NodeStackIndices[StackPtr];
+
+		// The closest hit might have moved since the push
+		if (NodeStackDis[StackPtr] > ClosestHit.RayDis)
+			continue;
+
+		uint ChildIndex = sCompactNodes[CurrentIndex].ChildIndex;
+		uint TriangleCount = sCompactNodes[CurrentIndex].TriangleCount;
 
-		CheckRayAABB_Collision(hitInfoAABB, ray,
-			sNodes[CurrentIndex].MinBound, sNodes[CurrentIndex].MaxBound);
+		if (TriangleCount != COMPACT_INTERNAL_NODE)
+		{
+			FoundCloser = TestLeafTriangles(ClosestHit, ray, ChildIndex, ChildIndex + TriangleCount) || FoundCloser;
+
+		#if OCCLUSION_QUERY
+			if (FoundCloser)
+				return true;
+		#endif
+
+			continue;
+		}
+
+		UnpackChildBounds(MinBound, MaxBound, CurrentIndex, 0);
+		CheckRayAABB_Collision(LeftHit, ray, MinBound, MaxBound);
 
-		NodeStackIndices[StackPtr++] = sNodes[CurrentIndex].FirstChildIndex;
-		NodeStackIndices[StackPtr++] = sNodes[CurrentIndex].SecondChildIndex;
+		UnpackChildBounds(MinBound, MaxBound, CurrentIndex, 1);
+		CheckRayAABB_Collision(RightHit, ray, MinBound, MaxBound);
 
-		bool Revert = !hitInfoAABB.HitOccured || hitInfoAABB.RayDis > ClosestHit.RayDis ||
-			sNodes[CurrentIndex].FirstChildIndex == rootIndex;
+		bool PushLeft = LeftHit.HitOccured && LeftHit.RayDis <= ClosestHit.RayDis;
+		bool PushRight = RightHit.HitOccured && RightHit.RayDis <= ClosestHit.RayDis;
 
-		StackPtr -= Revert ? 2 : 0;
+		// The nearer child is pushed last, so it is popped first
+		bool LeftFirst = LeftHit.RayDis < RightHit.RayDis;
 
-		if (sNodes[CurrentIndex].FirstChildIndex == rootIndex && hitInfoAABB.HitOccured)
+		if (PushLeft && PushRight)
 		{
-			for (uint j = sNodes[CurrentIndex].BeginIndex;
-				j < sNodes[CurrentIndex].EndIndex; j++)
+			NodeStackIndices[StackPtr] = LeftFirst ? ChildIndex + 1 : ChildIndex;
+			NodeStackDis[StackPtr++] = LeftFirst ? RightHit.RayDis : LeftHit.RayDis;
+
+			NodeStackIndices[StackPtr] = LeftFirst ? ChildIndex : ChildIndex + 1;
+			NodeStackDis[StackPtr++] = LeftFirst ? LeftHit.RayDis : RightHit.RayDis;
+
+			continue;
+		}
+
+		if (PushLeft || PushRight)
+		{
+			NodeStackIndices[StackPtr] = PushLeft ? ChildIndex : ChildIndex + 1;
+			NodeStackDis[StackPtr++] = PushLeft ? LeftHit.RayDis : RightHit.RayDis;
+		}
+	}
+
+	return FoundCloser;
+}
+
+bool FindCollisionWideNode(inout CollisionInfo ClosestHit, in RayQuery ray, in uint rootIndex)
+{
+	// Leaves are tested as soon as their box is hit, only the internal children are pushed
+	bool FoundCloser = false;
+
+	AABB_CollisionInfo hitInfoAABB;
+
+	uint NodeStackIndices[STACK_SIZE];
+	float NodeStackDis[STACK_SIZE];
+	uint StackPtr = 0;
+
+	NodeStackIndices[StackPtr] = rootIndex;
+	NodeStackDis[StackPtr++] = 0.0;
+
+	while (StackPtr != 0)
+	{
+		--StackPtr;
+
+		uint CurrentIndex = NodeStackIndices[StackPtr];
+
+		if (NodeStackDis[StackPtr] > ClosestHit.RayDis)
+			continue;
+
+		uint PushBase = StackPtr;
+
+		for (uint i = 0; i < BVH_WIDTH; i++)
+		{
+			uint ChildIndex = sWideNodes[CurrentIndex].ChildIndex[i];
+
+			// Used slots are packed at the front
+			if (ChildIndex == WIDE_EMPTY_SLOT)
+				break;
+
+			CheckRayAABB_Collision(hitInfoAABB, ray,
+				vec3(sWideNodes[CurrentIndex].MinX[i], sWideNodes[CurrentIndex].MinY[i], sWideNodes[CurrentIndex].MinZ[i]),
+				vec3(sWideNodes[CurrentIndex].MaxX[i], sWideNodes[CurrentIndex].MaxY[i], sWideNodes[CurrentIndex].MaxZ[i]));
+
+			if (!hitInfoAABB.HitOccured || hitInfoAABB.RayDis > ClosestHit.RayDis)
+				continue;
+
+			uint TriangleCount = sWideNodes[CurrentIndex].TriangleCount[i];
+
+			if (TriangleCount != 0)
 			{
-				CheckRayTriangleCollision(hitInfo, ray,
-					sPositions[sFaces[j].Indices.x],
-					sPositions[sFaces[j].Indices.y],
-					sPositions[sFaces[j].Indices.z]);
+				FoundCloser = TestLeafTriangles(ClosestHit, ray, ChildIndex, ChildIndex + TriangleCount) || FoundCloser;
 
-				hitInfo.PrimitiveID = j;
-				hitInfo.MaterialIndex = sFaces[j].MaterialRef;
+			#if OCCLUSION_QUERY
+				if (FoundCloser)
+					return true;
+			#endif
 
-				bool Replaced = hitInfo.HitOccured &&
-					(hitInfo.RayDis < ClosestHit.RayDis);
+				continue;
+			}
 
-				FoundCloser = FoundCloser || Replaced;
+			// Insertion keeps the pushed children sorted, the nearest one ends up on top
+			uint Slot = StackPtr++;
 
-				ClosestHit = Replaced ? hitInfo : ClosestHit;
+			while (Slot > PushBase && NodeStackDis[Slot - 1] < hitInfoAABB.RayDis)
+			{
+				NodeStackIndices[Slot] = NodeStackIndices[Slot - 1];
+				NodeStackDis[Slot] = NodeStackDis[Slot - 1];
+				Slot--;
 			}
+
+			NodeStackIndices[Slot] = ChildIndex;
+			NodeStackDis[Slot] = hitInfoAABB.RayDis;
 		}
 	}
 
 	return FoundCloser;
 }
 
-void TestRayMeshCollisions(inout CollisionInfo ClosestHit, in Ray ray)
+bool FindMeshCollision(inout CollisionInfo ClosestHit, in RayQuery ray, in uint rootIndex)
+{
+	// Uniform across the dispatch, so the branch doesn't diverge
+	if (uSceneInfo.NodeLayout == 1)
+		return FindCollisionCompactNode(ClosestHit, ray, rootIndex);
+
+	if (uSceneInfo.NodeLayout == 2)
+		return FindCollisionWideNode(ClosestHit, ray, rootIndex);
+
+	return FindCollisionNode(ClosestHit, ray, rootIndex);
+}
+
+void TestRayInstanceCollisions(inout CollisionInfo ClosestHit, in RayQuery ray, in uint instanceIndex)
 {
-	// For all the mesh objects...
+	// The direction stays unnormalized, so ray distances mean the same in both spaces
+	Ray LocalRay;
+	LocalRay.Origin = (sInstanceInfos[instanceIndex].WorldToObject * vec4(ray.Origin, 1.0)).xyz;
+	LocalRay.Direction = (sInstanceInfos[instanceIndex].WorldToObject * vec4(ray.Direction, 0.0)).xyz;
 
-	for (uint i = 0; i < uSceneInfo.MeshCount; i++)
+	if (!FindMeshCollision(ClosestHit, MakeRayQuery(LocalRay), sInstanceInfos[instanceIndex].RootIndex))
+		return;
+
+	mat3 NormalTransform = transpose(mat3(sInstanceInfos[instanceIndex].WorldToObject));
+
+	ClosestHit.IntersectionPoint = ray.Origin + ClosestHit.RayDis * ray.Direction;
+	ClosestHit.Normal = normalize(NormalTransform * ClosestHit.Normal);
+	ClosestHit.MaterialIndex = sInstanceInfos[instanceIndex].MaterialIndex;
+	ClosestHit.IsLightSrc = false;
+}
+
+void TestRayObjectCollisions(inout CollisionInfo ClosestHit, in RayQuery ray, in uint objectIndex)
+{
+	uint SceneObjectCount = uSceneInfo.MeshCount + uSceneInfo.LightCount;
+
+	if (objectIndex >= SceneObjectCount)
 	{
-		bool FoundCloser = FindCollisionNode(ClosestHit, ray, sMeshInfos[i].BeginIndex);
-		ClosestHit.IsLightSrc = ClosestHit.IsLightSrc && (!FoundCloser);
+		TestRayInstanceCollisions(ClosestHit, ray, objectIndex - SceneObjectCount);
+		return;
 	}
+
+	// Objects past the mesh count are light sources
+	bool IsLightSrc = objectIndex >= uSceneInfo.MeshCount;
+
+	uint RootIndex = IsLightSrc ? sLightInfos[objectIndex - uSceneInfo.MeshCount].BeginIndex :
+		sMeshInfos[objectIndex].BeginIndex;
+
+	bool FoundCloser = FindMeshCollision(ClosestHit, ray, RootIndex);
+	ClosestHit.IsLightSrc = FoundCloser ? IsLightSrc : ClosestHit.IsLightSrc;
 }
 
-void TestRayLightCollisions(inout CollisionInfo ClosestHit, in Ray ray)
+void TestRaySceneCollisions(inout CollisionInfo ClosestHit, in Ray worldRay)
 {
-	// For all the light sources...
+	// Shared by the top level walk and every mesh that isn't instanced
+	RayQuery ray = MakeRayQuery(worldRay);
 
-	for (uint i = 0; i < uSceneInfo.LightCount; i++)
+	// Walking the top level tree first, only the objects whose bounds are hit get traversed
+	// The children are ordered front to back like in FindCollisionNode
+
+	uint RootIndex = uSceneInfo.TopLevelRoot;
+
+	AABB_CollisionInfo FirstHit;
+	AABB_CollisionInfo SecondHit;
+
+	uint NodeStackIndices[STACK_SIZE];
+	float NodeStackDis[STACK_SIZE];
+	uint StackPtr = 0;
+
+	CheckRayAABB_Collision(FirstHit, ray, sNodes[RootIndex].MinBound, sNodes[RootIndex].MaxBound);
+
+	if (!FirstHit.HitOccured || FirstHit.RayDis > ClosestHit.RayDis)
+		return;
+
+	NodeStackIndices[StackPtr] = RootIndex;
+	NodeStackDis[StackPtr++] = FirstHit.RayDis;
+
+	while (StackPtr != 0)
 	{
-		bool FoundCloser = FindCollisionNode(ClosestHit, ray, sLightInfos[i].BeginIndex);
-		ClosestHit.IsLightSrc = ClosestHit.IsLightSrc || FoundCloser;
+		--StackPtr;
+
+		uint CurrentIndex = NodeStackIndices[StackPtr];
+
+		if (NodeStackDis[StackPtr] > ClosestHit.RayDis)
+			continue;
+
+		uint FirstChild = sNodes[CurrentIndex].FirstChildIndex;
+
+		if (FirstChild == RootIndex)
+		{
+			for (uint i = sNodes[CurrentIndex].BeginIndex; i < sNodes[CurrentIndex].EndIndex; i++)
+				TestRayObjectCollisions(ClosestHit, ray, i);
+
+		#if OCCLUSION_QUERY
+			if (ClosestHit.HitOccured)
+				return;
+		#endif
+
+			continue;
+		}
+
+		uint SecondChild = sNodes[CurrentIndex].SecondChildIndex;
+
+		CheckRayAABB_Collision(FirstHit, ray, sNodes[FirstChild].MinBound, sNodes[FirstChild].MaxBound);
+		CheckRayAABB_Collision(SecondHit, ray, sNodes[SecondChild].MinBound, sNodes[SecondChild].MaxBound);
+
+		bool PushFirst = FirstHit.HitOccured && FirstHit.RayDis <= ClosestHit.RayDis;
+		bool PushSecond = SecondHit.HitOccured && SecondHit.RayDis <= ClosestHit.RayDis;
+
+		bool SecondNear = ray.Direction[sNodes[CurrentIndex].SplitAxis] < 0.0;
+
+		if (SecondNear ? PushFirst : PushSecond)
+		{
+			NodeStackIndices[StackPtr] = SecondNear ? FirstChild : SecondChild;
+			NodeStackDis[StackPtr++] = SecondNear ? FirstHit.RayDis : SecondHit.RayDis;
+		}
+
+		if (SecondNear ? PushSecond : PushFirst)
+		{
+			NodeStackIndices[StackPtr] = SecondNear ? SecondChild : FirstChild;
+			NodeStackDis[StackPtr++] = SecondNear ? SecondHit.RayDis : FirstHit.RayDis;
+		}
 	}
 }
 
+// Any hit query for shadow and light visibility rays, only hits closer than maxDis count
+// Compiled with OCCLUSION_QUERY, the traversal stops at the first triangle it finds
+bool TestRaySceneOcclusion(in Ray ray, in float maxDis)
+{
+	CollisionInfo AnyHit;
+
+	AnyHit.HitOccured = false;
+	AnyHit.IsLightSrc = false;
+	AnyHit.RayDis = maxDis;
+
+	TestRaySceneCollisions(AnyHit, ray);
+
+	return AnyHit.HitOccured;
+}
+
 void CheckForRayCollisions(inout CollisionInfo ClosestHit, in Ray ray)
 {
 	ClosestHit.HitOccured = false;
@@ -214,29 +622,50 @@ void CheckForRayCollisions(inout CollisionInfo ClosestHit, in Ray ray)
 
 	ClosestHit.RayDis = MAX_DIS;
 
-	TestRayLightCollisions(ClosestHit, ray);
-	TestRayMeshCollisions(ClosestHit, ray);
+	TestRaySceneCollisions(ClosestHit, ray);
 
 	if (!ClosestHit.HitOccured)
 		ClosestHit.MaterialIndex = -2;
 }
 
+#if OCCLUSION_QUERY
+
 void main()
 {
 	uint GlobalIdx = gl_GlobalInvocationID.x;
 
-	if (GlobalIdx >= pRayCount)
+	if (GlobalIdx >= sRayQueues[0].RayCount)
 		return;
 
-	if (sRays[IndexOffset(GlobalIdx)].Active == 0)
+	if (LoadRayActive(IndexOffset(GlobalIdx)) != 0)
 		return;
 
-	// Check for collision
-	CheckForRayCollisions(sCollisionInfos[IndexOffset(GlobalIdx)], sRays[IndexOffset(GlobalIdx)]);
+	// The producer of the visibility rays stores the distance to the sampled point in RayDis
+	StoreHitOccured(IndexOffset(GlobalIdx), TestRaySceneOcclusion(
+		LoadRay(IndexOffset(GlobalIdx)), LoadRayDis(IndexOffset(GlobalIdx))));
+}
+
+#else
+
+void main()
+{
+	uint GlobalIdx = gl_GlobalInvocationID.x;
+
+	if (GlobalIdx >= sRayQueues[0].RayCount)
+		return;
+
+	if (LoadRayActive(IndexOffset(GlobalIdx)) != 0)
+		return;
+
+	// Check for collision, the misses leave the surface fields undefined
+	CollisionInfo ClosestHit;
+	CheckForRayCollisions(ClosestHit, LoadRay(IndexOffset(GlobalIdx)));
+
+	StoreCollisionInfo(IndexOffset(GlobalIdx), ClosestHit);
 
 	// Setting the necessary markers for the next stages
-	sRays[IndexOffset(GlobalIdx)].MaterialIndex =
-		sCollisionInfos[IndexOffset(GlobalIdx)].IsLightSrc && 
-		sCollisionInfos[IndexOffset(GlobalIdx)].HitOccured ?
-		-3 : sCollisionInfos[IndexOffset(GlobalIdx)].MaterialIndex;
-}
\ No newline at end of file
+	StoreRayMaterialIndex(IndexOffset(GlobalIdx),
+		ClosestHit.IsLightSrc && ClosestHit.HitOccured ? -3 : ClosestHit.MaterialIndex);
+}
+
+#endif
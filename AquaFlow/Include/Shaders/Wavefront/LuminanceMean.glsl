@@ -5,10 +5,6 @@ layout(local_size_x = WORKGROUP_SIZE) in;
 #include "DescSet0.glsl"
 #include "DescSet1.glsl"
 
-layout(set = 2, binding = 0, rgba8) uniform image2D uImageOutput;
-layout(set = 2, binding = 1, rgba32f) uniform image2D uColorMean;
-layout(set = 2, binding = 2, rgba32f) uniform image2D uColorVariance;
-
 layout(push_constant) uniform ShaderData
 {
 	uint pRayCount;
@@ -25,28 +21,17 @@ uint InactiveBufferIndex(uint index)
 	return pRayCount * (1 - pActiveBuffer) + index;
 }
 
+#define RAY_STREAM_STRIDE pRayCount
+#include "RayStreams.glsl"
+#include "PixelMean.glsl"
+
 void main()
 {
 	uint GlobalIdx = gl_GlobalInvocationID.x;
 
-	if (GlobalIdx >= pRayCount)
+	// The rays retired by the compaction are in the image already
+	if (GlobalIdx >= sRayQueues[0].RayCount)
 		return;
 
-	uvec2 Coordinate = sRayInfos[ActiveBufferIndex(GlobalIdx)].ImageCoordinate;
-	vec3 IncomingLight = sRayInfos[ActiveBufferIndex(GlobalIdx)].Luminance.rgb;
-
-	uint activeIdx = sRays[ActiveBufferIndex(GlobalIdx)].Active;
-
-	// Add luminances which only hit the skybox or a light src...
-	//if (activeIdx != -3 && activeIdx != -2)
-	if (activeIdx != -3)
-		IncomingLight = vec3(0.0);
-
-	vec3 ExistingColor = imageLoad(uColorMean, ivec2(Coordinate)).rgb;
-
-	vec3 Delta = IncomingLight - ExistingColor;
-	vec3 Color = ExistingColor + Delta / uSceneInfo.FrameCount;
-
-	imageStore(uColorMean, ivec2(Coordinate), vec4(Color, 1.0));
-	imageStore(uImageOutput, ivec2(Coordinate), vec4(Color, 1.0));
+	AccumulatePixelMean(ActiveBufferIndex(GlobalIdx));
 }
@@ -0,0 +1,37 @@
+#ifndef PIXEL_MEAN_GLSL
+#define PIXEL_MEAN_GLSL
+
+// Running mean of the pixel colors, every path has to be folded in exactly once per frame
+// Expects DescSet0.glsl, DescSet1.glsl and RayStreams.glsl to be included first
+
+layout(set = 2, binding = 0, rgba8) uniform image2D uImageOutput;
+layout(set = 2, binding = 1, rgba32f) uniform image2D uColorMean;
+layout(set = 2, binding = 2, rgba32f) uniform image2D uColorVariance;
+
+void AccumulatePixelMean(uint bufferIndex)
+{
+	uvec2 Coordinate = LoadImageCoordinate(bufferIndex);
+
+	// Padding rays of the edge tiles
+	if (any(greaterThanEqual(Coordinate, uvec2(uSceneInfo.ImageResolution))))
+		return;
+
+	vec3 IncomingLight = LoadLuminance(bufferIndex).rgb;
+
+	uint activeIdx = LoadRayActive(bufferIndex);
+
+	// Add luminances which only hit the skybox or a light src...
+	//if (activeIdx != -3 && activeIdx != -2)
+	if (activeIdx != -3)
+		IncomingLight = vec3(0.0);
+
+	vec3 ExistingColor = imageLoad(uColorMean, ivec2(Coordinate)).rgb;
+
+	vec3 Delta = IncomingLight - ExistingColor;
+	vec3 Color = ExistingColor + Delta / uSceneInfo.FrameCount;
+
+	imageStore(uColorMean, ivec2(Coordinate), vec4(Color, 1.0));
+	imageStore(uImageOutput, ivec2(Coordinate), vec4(Color, 1.0));
+}
+
+#endif
@@ -18,6 +18,9 @@ uint IndexOffset(uint index)
 	return pRayCount * pActiveBuffer + index;
 }
 
+#define RAY_STREAM_STRIDE pRayCount
+#include "RayStreams.glsl"
+
 void main()
 {
 	uint GlobalIdx = gl_GlobalInvocationID.x;
@@ -29,6 +32,9 @@ void main()
 
 	sRayRefs[GlobalIdx].FieldIndex = GlobalIdx;
 
-	sRayRefs[GlobalIdx].MaterialIndex
-		= sRays[IndexOffset(GlobalIdx)].MaterialIndex;
+	// Slots past the live rays hold leftovers of the earlier bounces, the largest key
+	// keeps them behind every live ray, so the sorted live rays stay at the front
+	// Only the merge sort dispatches over them, the radix sort stops at the live count
+	sRayRefs[GlobalIdx].MaterialIndex = GlobalIdx < sRayQueues[0].RayCount ?
+		LoadRayMaterialIndex(IndexOffset(GlobalIdx)) : 0xFFFFFFFFu;
 }
@@ -0,0 +1,274 @@
+#ifndef RAY_STREAMS_GLSL
+#define RAY_STREAMS_GLSL
+
+// Accessors of the ray, ray info and collision info buffers, the stages never index them directly
+// With RAY_SOA_LAYOUT, every 4 byte word of the structs is a stream of its own, so a stage only
+// moves the fields it touches. The buffers keep their sizes and each half keeps its own byte range,
+// word w of the element i in half h sits at (h * words + w) * RAY_STREAM_STRIDE + i % RAY_STREAM_STRIDE
+// Expects the buffers and RAY_STREAM_STRIDE (element count of one half) to be declared first
+
+#if RAY_SOA_LAYOUT
+
+uint StreamIndex(uint words, uint word, uint index)
+{
+	uint Half = index / RAY_STREAM_STRIDE;
+	return (Half * (words - 1) + word) * RAY_STREAM_STRIDE + index;
+}
+
+vec3 LoadRayVec3(uint word, uint index)
+{
+	return uintBitsToFloat(uvec3(sRayWords[StreamIndex(RAY_WORDS, word, index)],
+		sRayWords[StreamIndex(RAY_WORDS, word + 1, index)], sRayWords[StreamIndex(RAY_WORDS, word + 2, index)]));
+}
+
+void StoreRayVec3(uint word, uint index, in vec3 value)
+{
+	uvec3 Bits = floatBitsToUint(value);
+
+	sRayWords[StreamIndex(RAY_WORDS, word, index)] = Bits.x;
+	sRayWords[StreamIndex(RAY_WORDS, word + 1, index)] = Bits.y;
+	sRayWords[StreamIndex(RAY_WORDS, word + 2, index)] = Bits.z;
+}
+
+vec4 LoadRayInfoVec4(uint word, uint index)
+{
+	return uintBitsToFloat(uvec4(sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word, index)],
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 1, index)], sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 2, index)],
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 3, index)]));
+}
+
+void StoreRayInfoVec4(uint word, uint index, in vec4 value)
+{
+	uvec4 Bits = floatBitsToUint(value);
+
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word, index)] = Bits.x;
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 1, index)] = Bits.y;
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 2, index)] = Bits.z;
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word + 3, index)] = Bits.w;
+}
+
+vec3 LoadCollisionVec3(uint word, uint index)
+{
+	return uintBitsToFloat(uvec3(sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word, index)],
+		sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word + 1, index)], sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word + 2, index)]));
+}
+
+void StoreCollisionVec3(uint word, uint index, in vec3 value)
+{
+	uvec3 Bits = floatBitsToUint(value);
+
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word, index)] = Bits.x;
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word + 1, index)] = Bits.y;
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word + 2, index)] = Bits.z;
+}
+
+// Rays...
+
+Ray LoadRay(uint index)
+{
+	Ray ray;
+	ray.Origin = LoadRayVec3(RAY_ORIGIN_WORD, index);
+	ray.MaterialIndex = sRayWords[StreamIndex(RAY_WORDS, RAY_MATERIAL_INDEX_WORD, index)];
+	ray.Direction = LoadRayVec3(RAY_DIRECTION_WORD, index);
+	ray.Active = sRayWords[StreamIndex(RAY_WORDS, RAY_ACTIVE_WORD, index)];
+
+	return ray;
+}
+
+void StoreRay(uint index, in Ray ray)
+{
+	StoreRayVec3(RAY_ORIGIN_WORD, index, ray.Origin);
+	sRayWords[StreamIndex(RAY_WORDS, RAY_MATERIAL_INDEX_WORD, index)] = ray.MaterialIndex;
+	StoreRayVec3(RAY_DIRECTION_WORD, index, ray.Direction);
+	sRayWords[StreamIndex(RAY_WORDS, RAY_ACTIVE_WORD, index)] = ray.Active;
+}
+
+uint LoadRayActive(uint index)
+{
+	return sRayWords[StreamIndex(RAY_WORDS, RAY_ACTIVE_WORD, index)];
+}
+
+void StoreRayActive(uint index, uint active)
+{
+	sRayWords[StreamIndex(RAY_WORDS, RAY_ACTIVE_WORD, index)] = active;
+}
+
+uint LoadRayMaterialIndex(uint index)
+{
+	return sRayWords[StreamIndex(RAY_WORDS, RAY_MATERIAL_INDEX_WORD, index)];
+}
+
+void StoreRayMaterialIndex(uint index, uint materialIndex)
+{
+	sRayWords[StreamIndex(RAY_WORDS, RAY_MATERIAL_INDEX_WORD, index)] = materialIndex;
+}
+
+void StoreRayOrigin(uint index, in vec3 origin)
+{
+	StoreRayVec3(RAY_ORIGIN_WORD, index, origin);
+}
+
+void StoreRayDirection(uint index, in vec3 direction)
+{
+	StoreRayVec3(RAY_DIRECTION_WORD, index, direction);
+}
+
+void CopyRay(uint dst, uint src)
+{
+	for (uint word = 0; word < RAY_WORDS; word++)
+		sRayWords[StreamIndex(RAY_WORDS, word, dst)] = sRayWords[StreamIndex(RAY_WORDS, word, src)];
+}
+
+// Ray infos...
+
+RayInfo LoadRayInfo(uint index)
+{
+	RayInfo rayInfo;
+	rayInfo.ImageCoordinate = uvec2(sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD, index)],
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD + 1, index)]);
+	rayInfo.Luminance = LoadRayInfoVec4(RAY_INFO_LUMINANCE_WORD, index);
+	rayInfo.Throughput = LoadRayInfoVec4(RAY_INFO_THROUGHPUT_WORD, index);
+
+	return rayInfo;
+}
+
+void StoreRayInfo(uint index, in RayInfo rayInfo)
+{
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD, index)] = rayInfo.ImageCoordinate.x;
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD + 1, index)] = rayInfo.ImageCoordinate.y;
+	StoreRayInfoVec4(RAY_INFO_LUMINANCE_WORD, index, rayInfo.Luminance);
+	StoreRayInfoVec4(RAY_INFO_THROUGHPUT_WORD, index, rayInfo.Throughput);
+}
+
+uvec2 LoadImageCoordinate(uint index)
+{
+	return uvec2(sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD, index)],
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD + 1, index)]);
+}
+
+vec4 LoadLuminance(uint index)
+{
+	return LoadRayInfoVec4(RAY_INFO_LUMINANCE_WORD, index);
+}
+
+void StoreLuminance(uint index, in vec4 luminance)
+{
+	StoreRayInfoVec4(RAY_INFO_LUMINANCE_WORD, index, luminance);
+}
+
+vec4 LoadThroughput(uint index)
+{
+	return LoadRayInfoVec4(RAY_INFO_THROUGHPUT_WORD, index);
+}
+
+void StoreThroughput(uint index, in vec4 throughput)
+{
+	StoreRayInfoVec4(RAY_INFO_THROUGHPUT_WORD, index, throughput);
+}
+
+void CopyRayInfo(uint dst, uint src)
+{
+	// The padding after the image coordinate is never touched
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD, dst)] =
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD, src)];
+	sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD + 1, dst)] =
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, RAY_INFO_COORDINATE_WORD + 1, src)];
+
+	for (uint word = RAY_INFO_LUMINANCE_WORD; word < RAY_INFO_WORDS; word++)
+		sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word, dst)] = sRayInfoWords[StreamIndex(RAY_INFO_WORDS, word, src)];
+}
+
+// Collision infos...
+
+CollisionInfo LoadCollisionInfo(uint index)
+{
+	CollisionInfo collisionInfo;
+	collisionInfo.Normal = LoadCollisionVec3(COLLISION_NORMAL_WORD, index);
+	collisionInfo.RayDis = uintBitsToFloat(sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_RAY_DIS_WORD, index)]);
+	collisionInfo.IntersectionPoint = LoadCollisionVec3(COLLISION_POINT_WORD, index);
+	collisionInfo.NormalInverted = uintBitsToFloat(sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_NORMAL_INVERTED_WORD, index)]);
+	collisionInfo.bCoords = LoadCollisionVec3(COLLISION_BCOORDS_WORD, index);
+	collisionInfo.PrimitiveID = sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_PRIMITIVE_ID_WORD, index)];
+	collisionInfo.MaterialIndex = sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_MATERIAL_INDEX_WORD, index)];
+	collisionInfo.HitOccured = sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_HIT_OCCURED_WORD, index)] != 0;
+	collisionInfo.IsLightSrc = sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_IS_LIGHT_SRC_WORD, index)] != 0;
+
+	return collisionInfo;
+}
+
+void StoreCollisionInfo(uint index, in CollisionInfo collisionInfo)
+{
+	StoreCollisionVec3(COLLISION_NORMAL_WORD, index, collisionInfo.Normal);
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_RAY_DIS_WORD, index)] = floatBitsToUint(collisionInfo.RayDis);
+	StoreCollisionVec3(COLLISION_POINT_WORD, index, collisionInfo.IntersectionPoint);
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_NORMAL_INVERTED_WORD, index)] = floatBitsToUint(collisionInfo.NormalInverted);
+	StoreCollisionVec3(COLLISION_BCOORDS_WORD, index, collisionInfo.bCoords);
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_PRIMITIVE_ID_WORD, index)] = collisionInfo.PrimitiveID;
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_MATERIAL_INDEX_WORD, index)] = collisionInfo.MaterialIndex;
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_HIT_OCCURED_WORD, index)] = uint(collisionInfo.HitOccured);
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_IS_LIGHT_SRC_WORD, index)] = uint(collisionInfo.IsLightSrc);
+}
+
+float LoadRayDis(uint index)
+{
+	return uintBitsToFloat(sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_RAY_DIS_WORD, index)]);
+}
+
+void StoreHitOccured(uint index, bool hitOccured)
+{
+	sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, COLLISION_HIT_OCCURED_WORD, index)] = uint(hitOccured);
+}
+
+void CopyCollisionInfo(uint dst, uint src)
+{
+	// The last word is padding
+	for (uint word = 0; word < COLLISION_INFO_WORDS - 1; word++)
+		sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word, dst)] = sCollisionWords[StreamIndex(COLLISION_INFO_WORDS, word, src)];
+}
+
+#else
+
+// Rays...
+
+Ray LoadRay(uint index) { return sRays[index]; }
+void StoreRay(uint index, in Ray ray) { sRays[index] = ray; }
+
+uint LoadRayActive(uint index) { return sRays[index].Active; }
+void StoreRayActive(uint index, uint active) { sRays[index].Active = active; }
+
+uint LoadRayMaterialIndex(uint index) { return sRays[index].MaterialIndex; }
+void StoreRayMaterialIndex(uint index, uint materialIndex) { sRays[index].MaterialIndex = materialIndex; }
+
+void StoreRayOrigin(uint index, in vec3 origin) { sRays[index].Origin = origin; }
+void StoreRayDirection(uint index, in vec3 direction) { sRays[index].Direction = direction; }
+
+void CopyRay(uint dst, uint src) { sRays[dst] = sRays[src]; }
+
+// Ray infos...
+
+RayInfo LoadRayInfo(uint index) { return sRayInfos[index]; }
+void StoreRayInfo(uint index, in RayInfo rayInfo) { sRayInfos[index] = rayInfo; }
+
+uvec2 LoadImageCoordinate(uint index) { return sRayInfos[index].ImageCoordinate; }
+
+vec4 LoadLuminance(uint index) { return sRayInfos[index].Luminance; }
+void StoreLuminance(uint index, in vec4 luminance) { sRayInfos[index].Luminance = luminance; }
+
+vec4 LoadThroughput(uint index) { return sRayInfos[index].Throughput; }
+void StoreThroughput(uint index, in vec4 throughput) { sRayInfos[index].Throughput = throughput; }
+
+void CopyRayInfo(uint dst, uint src) { sRayInfos[dst] = sRayInfos[src]; }
+
+// Collision infos...
+
+CollisionInfo LoadCollisionInfo(uint index) { return sCollisionInfos[index]; }
+void StoreCollisionInfo(uint index, in CollisionInfo collisionInfo) { sCollisionInfos[index] = collisionInfo; }
+
+float LoadRayDis(uint index) { return sCollisionInfos[index].RayDis; }
+void StoreHitOccured(uint index, bool hitOccured) { sCollisionInfos[index].HitOccured = hitOccured; }
+
+void CopyCollisionInfo(uint dst, uint src) { sCollisionInfos[dst] = sCollisionInfos[src]; }
+
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+#include "ThreadPool.h"
+#include "Process/ThreadCommandPools.h"
+
+AQUA_BEGIN
+
+// Records the items of a long list on several threads, one secondary command buffer per contiguous chunk
+// The primary buffer replays the chunks in the order of the items, the result matches a serial recording
+class ParallelRecorder
+{
+public:
+	ParallelRecorder(std::shared_ptr<ThreadPool> threadPool, const vkEngine::ThreadCommandPools& commandPools,
+		uint32_t familyIndex);
+
+	~ParallelRecorder() { Reset(); }
+
+	ParallelRecorder(const ParallelRecorder&) = delete;
+	ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+	// recordFn(cmd, index) records a single item, the items of different chunks are recorded concurrently
+	// Short lists are recorded straight into the primary buffer on the calling thread
+	template <typename Fn>
+	void Record(vk::CommandBuffer primary, uint32_t itemCount, Fn&& recordFn,
+		const vk::CommandBufferInheritanceInfo& inheritanceInfo = {});
+
+	// Frees the secondary buffers of every recording so far
+	// The primary buffers replaying them must have finished executing, or never be submitted
+	void Reset();
+
+	// The calling thread records a chunk as well
+	uint32_t GetThreadCount() const { return mThreadPool->GetThreadCount() + 1; }
+
+	size_t GetSecondaryCount() const { return mRecorded.size(); }
+
+	// Number of secondary buffers a recording is split into, one or less means it's recorded inline
+	static uint32_t GetChunkCount(uint32_t itemCount, uint32_t threadCount);
+	// Items [first, second) of the chunk, consecutive chunks cover consecutive items
+	static std::pair<uint32_t, uint32_t> GetChunkRange(uint32_t itemCount, uint32_t chunkCount, uint32_t chunk);
+
+	// Below that a secondary buffer costs more than the recording it takes off the calling thread
+	static constexpr uint32_t sMinChunkSize = 8;
+
+private:
+	std::shared_ptr<ThreadPool> mThreadPool;
+	vkEngine::ThreadCommandPools mCommandPools;
+	uint32_t mFamilyIndex = 0;
+
+	// Every buffer goes back to the allocator of the thread that recorded it
+	std::vector<std::pair<vk::CommandBuffer, const vkEngine::CommandBufferAllocator*>> mRecorded;
+};
+
+template <typename Fn>
+void AQUA_NAMESPACE::ParallelRecorder::Record(vk::CommandBuffer primary, uint32_t itemCount, Fn&& recordFn,
+	const vk::CommandBufferInheritanceInfo& inheritanceInfo /*= {}*/)
+{
+	uint32_t chunkCount = GetChunkCount(itemCount, GetThreadCount());
+
+	if (chunkCount <= 1)
+	{
+		for (uint32_t i = 0; i < itemCount; i++)
+			recordFn(primary, i);
+
+		return;
+	}
+
+	// Sized up front, the tasks write into their own slots
+	size_t firstSlot = mRecorded.size();
+	mRecorded.resize(firstSlot + chunkCount);
+
+	{
+		TaskGroup group(*mThreadPool);
+
+		for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			group.Run([this, &recordFn, &inheritanceInfo, itemCount, chunkCount, chunk, firstSlot]()
+			{
+				auto [begin, end] = GetChunkRange(itemCount, chunkCount, chunk);
+
+				// Nobody else records from the pools of this thread while the task runs
+				const vkEngine::CommandBufferAllocator& allocator = mCommandPools[mFamilyIndex];
+				vk::CommandBuffer secondary = allocator.BeginSecondaryCommands(inheritanceInfo);
+
+				for (uint32_t i = begin; i < end; i++)
+					recordFn(secondary, i);
+
+				secondary.end();
+
+				mRecorded[firstSlot + chunk] = { secondary, &allocator };
+			});
+		}
+
+		group.Wait();
+	}
+
+	std::vector<vk::CommandBuffer> secondaries;
+	secondaries.reserve(chunkCount);
+
+	for (size_t slot = firstSlot; slot < mRecorded.size(); slot++)
+		secondaries.push_back(mRecorded[slot].first);
+
+	primary.executeCommands(secondaries);
+}
+
+AQUA_END
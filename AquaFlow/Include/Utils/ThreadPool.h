@@ -0,0 +1,107 @@
+#pragma once
+#include "../Core/AqCore.h"
+
+AQUA_BEGIN
+
+// Fixed size pool where every worker owns a deque of tasks
+// A worker pops its own deque from the back and steals from the front of the others once it runs dry
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Tasks submitted from a worker go to its own deque, the rest are distributed round robin
+	void Submit(Task&& task);
+
+	// Runs pending tasks on the calling thread until the condition holds
+	template <typename Pred>
+	void HelpUntil(Pred&& condition);
+
+	uint32_t GetThreadCount() const { return mThreadCount; }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex Lock;
+		std::deque<Task> Tasks;
+	};
+
+	// Fixed before any worker starts, the workers themselves read it
+	uint32_t mThreadCount = 0;
+
+	std::vector<std::thread> mWorkers;
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+
+	std::mutex mSleepLock;
+	std::condition_variable mSleepCondition;
+
+	std::atomic<int64_t> mPendingCount = 0;
+	std::atomic<uint32_t> mNextQueue = 0;
+	bool mShutdown = false;
+
+private:
+	void WorkerLoop(uint32_t index);
+
+	bool TryRunTask();
+	bool TryPop(uint32_t index, Task& task);
+	bool TrySteal(uint32_t index, Task& task);
+
+	// Returns the worker index of the calling thread or UINT32_MAX for foreign threads
+	uint32_t GetLocalQueueIndex() const;
+};
+
+// Tracks the outstanding tasks of a single fork/join region
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool) : mPool(pool) {}
+	~TaskGroup() { Wait(); }
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	template <typename Fn>
+	void Run(Fn&& fn);
+
+	// The calling thread keeps executing tasks while it waits
+	void Wait();
+
+private:
+	ThreadPool& mPool;
+	std::atomic<uint32_t> mOutstanding = 0;
+};
+
+template <typename Pred>
+void AQUA_NAMESPACE::ThreadPool::HelpUntil(Pred&& condition)
+{
+	while (!condition())
+	{
+		if (!TryRunTask())
+			std::this_thread::yield();
+	}
+}
+
+template <typename Fn>
+void AQUA_NAMESPACE::TaskGroup::Run(Fn&& fn)
+{
+	mOutstanding.fetch_add(1, std::memory_order_relaxed);
+
+	mPool.Submit([this, task = std::forward<Fn>(fn)]() mutable
+	{
+		task();
+		mOutstanding.fetch_sub(1, std::memory_order_release);
+	});
+}
+
+inline void AQUA_NAMESPACE::TaskGroup::Wait()
+{
+	mPool.HelpUntil([this]() { return mOutstanding.load(std::memory_order_acquire) == 0; });
+}
+
+AQUA_END
@@ -2,22 +2,65 @@
 #include "RaytracingStructures.h"
 #include "Core.h"
 
+#include "../Utils/ThreadPool.h"
+
 AQUA_BEGIN
 PH_BEGIN
 
-using SplitFunction = std::function<float(const BVH&, const Node&, int)>;
+// Triangle centroids of the BVH under construction, computed once per build and kept in face order
+using CentroidSpan = std::span<const glm::vec3>;
+
+// Returns the distance of the split plane from node.MinBound along the given axis
+using SplitFunction = std::function<float(const BVH&, CentroidSpan, const Node&, int)>;
+
+// Cost model of the surface area heuristic
+struct SAH_Parameters
+{
+	uint32_t BinCount = 16;
+
+	float TraversalCost = 1.0f;
+	float IntersectionCost = 1.0f;
+
+	// Nodes holding more triangles than this are split even if the SAH prefers a leaf
+	uint32_t MaxLeafSize = 16;
+};
 
 // TODO: We could add multiple functions here, each of which activate
 // when a certain condition is met
 struct SplitStrategy
 {
 	SplitFunction mSplit;
+
+	// When set, every node evaluates the binned SAH on all three axes and
+	// becomes a leaf as soon as splitting costs more than intersecting its triangles
+	bool mUseSAH = false;
+	// Also the cost model of DefaultSplitFn::sSAH when it's the split function
+	SAH_Parameters mSAH_Params{};
+};
+
+struct BVHQualityReport
+{
+	// Expected cost of a random ray against the tree, relative to the root area
+	float SAHCost = 0.0f;
+
+	uint32_t NodeCount = 0;
+	uint32_t LeafCount = 0;
+	uint32_t MaxDepth = 0;
+	uint32_t MaxLeafSize = 0;
+	float AverageLeafSize = 0.0f;
+
+	// Bucket i holds the number of leaves with [2^i, 2^(i + 1)) triangles
+	// The empty leaves are only counted by the EmptyLeafCount
+	std::vector<uint32_t> LeafSizeHistogram;
+	uint32_t EmptyLeafCount = 0;
 };
 
+std::ostream& operator<<(std::ostream& stream, const BVHQualityReport& report);
+
 // TODO: The only thing remaining now is to utilize GPU to construct BVH structure
 
-// NOTE: not thread safe
-// TODO: yet to test out...
+// NOTE: not thread safe, a single factory can't run concurrent builds
+// A build itself is spread across the thread pool once it has been set
 class BVHFactory
 {
 public:
@@ -26,21 +69,39 @@ public:
 	void SetDepth(int depth) { mDepth = depth; }
 	void SetSplitStrategy(const SplitStrategy& strategy) { mStrategy = strategy; }
 
+	// Subtrees and the reductions over large nodes are handed over to the pool
+	// The resulting node layout matches the single threaded build exactly
+	void SetThreadPool(std::shared_ptr<ThreadPool> pool) { mThreadPool = pool; }
+	// Nodes with fewer triangles than this are split on the calling thread
+	void SetTaskGrainSize(uint32_t grainSize) { mTaskGrainSize = grainSize; }
+
 	template <typename VertIt, typename IdxIt>
 	BVH Build(VertIt vBeg, VertIt vEnd, IdxIt iBeg, IdxIt iEnd);
 
 	void Cleanup();
 
+	// Tree statistics to compare split strategies on the CPU
+	static BVHQualityReport GenerateQualityReport(const BVH& bvh, const SAH_Parameters& costModel = {});
+
+	// Builds a tree over whole objects, each leaf holds the index of exactly one box
+	// Like the BLAS, child indices are relative to the root and leaves point back at it
+	static std::vector<Node> BuildTopLevel(const std::vector<Box>& bounds);
+
 private:
 	BVH mCurrent;
-	std::vector<glm::vec3> mVertices;
-	std::vector<Face> mFaces;
+	std::vector<glm::vec3> mCentroids;
 
 	int mDepth = 18;
 	float mTolerence = 0.001f;
 
 	SplitStrategy mStrategy{ DefaultSplitFn::sSpatialSplit };
 
+	std::shared_ptr<ThreadPool> mThreadPool;
+	uint32_t mTaskGrainSize = 4096;
+
+	// Nodes are preallocated, so references to them stay valid while other threads append
+	std::atomic<uint32_t> mNodeCount = 0;
+
 public:
 	struct DefaultSplitFn
 	{
@@ -50,6 +111,15 @@ public:
 	};
 
 private:
+	struct SplitPlane
+	{
+		float Position = 0.0f;
+		int Axis = 0;
+
+		// Only evaluated by the SAH strategy
+		float Cost = FLT_MAX;
+	};
+
 	void Clear();
 
 	template <typename Iter>
@@ -59,15 +129,21 @@ private:
 	void SetFaces(Iter begin, Iter end);
 
 
+	void ComputeCentroids();
+
 	void SplitRecursive(Node& parentNode, int depth);
 	void EncloseIntoBoundingBox(Node& node);
 
-	// vec3 and axis idx
-	std::pair<float, int> GetOptimalSplit(const Node& box);
+	// Restores the depth first order of the single threaded build
+	void ReorderNodes();
+
+	SplitPlane GetOptimalSplit(const Node& node);
+	SplitPlane GetOptimalSplitSAH(const Node& node);
+
+	bool ShouldSplit(const Node& node, const SplitPlane& plane) const;
 
-	glm::vec3 TriangleCentroid(uint32_t i);
-	std::pair<Box, Box> SplitBox(const Node& node);
-	std::pair<Node, Node> MakeChildNodes(const Node& parentNode, const Box& leftBox, const Box& rightBox);
+	const glm::vec3& TriangleCentroid(uint32_t i) const { return mCentroids[i]; }
+	std::pair<Node, Node> MakeChildNodes(const Node& parentNode, const SplitPlane& plane);
 };
 
 template <typename VertIt, typename IdxIt>
@@ -79,31 +155,41 @@ BVH AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::Build(VertIt vBeg, VertIt vEn
 	SetFaces(iBeg, iEnd);
 
 	Clear();
+	ComputeCentroids();
 
-	Node& rootNode = mCurrent.Nodes.emplace_back();
+	// A binary tree whose leaves are never empty has at most 2N - 1 nodes
+	size_t faceCount = mCurrent.Faces.size();
+	mCurrent.Nodes.resize(std::max<size_t>(2 * faceCount, 2) - 1);
+	mNodeCount.store(1);
+
+	Node& rootNode = mCurrent.Nodes[0];
 
 	rootNode.BeginIndex = 0;
-	rootNode.EndIndex = static_cast<uint32_t>(mFaces.size());
+	rootNode.EndIndex = static_cast<uint32_t>(faceCount);
 
 	EncloseIntoBoundingBox(rootNode);
 	SplitRecursive(rootNode, mDepth);
 
-	mCurrent.Vertices = std::move(mVertices);
-	mCurrent.Faces = std::move(mFaces);
+	mCurrent.Nodes.resize(mNodeCount.load());
+
+	if (mThreadPool)
+		ReorderNodes();
+
+	mCentroids.clear();
 
-	return mCurrent;
+	return std::move(mCurrent);
 }
 
 template <typename Iter>
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SetFaces(Iter begin, Iter end)
 {
-	mFaces.assign(begin, end);
+	mCurrent.Faces.assign(begin, end);
 }
 
 template <typename Iter>
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SetVertices(Iter begin, Iter end)
 {
-	mVertices.assign(begin, end);
+	mCurrent.Vertices.assign(begin, end);
 }
 
 PH_END
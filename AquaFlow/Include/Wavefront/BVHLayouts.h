@@ -0,0 +1,67 @@
+#pragma once
+#include "RayTracingStructures.h"
+#include "Core.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+struct RayQuery;
+
+// Work done by a single reference traversal
+struct TraversalStats
+{
+	uint64_t NodeFetches = 0;
+	uint64_t BoxTests = 0;
+	uint64_t TriangleTests = 0;
+
+	TraversalStats& operator+=(const TraversalStats& other);
+};
+
+std::ostream& operator<<(std::ostream& stream, const TraversalStats& stats);
+
+// Rewrites the binary tree of BVHFactory into the other GPU layouts
+// Child indices and face ranges stay relative to the mesh, exactly like in BVH::Nodes
+class BVHConverter
+{
+public:
+	// Node i of the result corresponds to node i of the binary tree
+	static std::vector<CompactNode> ToCompact(const BVH& bvh);
+
+	// Bounds of the left (childIndex = 0) or the right child, widened to half precision
+	static Box UnpackChildBounds(const CompactNode& node, uint32_t childIndex);
+
+	// Collapses the binary tree by repeatedly opening the largest internal child until Width slots are used
+	// Wide nodes are emitted in breadth first order, node 0 is the root
+	// Instantiated for the widths 4 and 8
+	template <uint32_t Width>
+	static std::vector<WideNode<Width>> ToWide(const BVH& bvh);
+};
+
+// CPU mirror of the traversal loops in Intersection.glsl, used to compare the layouts
+// NOTE: the traversal functions return the closest hit distance or FLT_MAX
+class BVHTraverser
+{
+public:
+	explicit BVHTraverser(const BVH& bvh) : mBVH(bvh) {}
+
+	float TraceBinary(const Ray& ray, TraversalStats& stats) const;
+	// Any hit closer than maxDis, returns as soon as a leaf reports one
+	bool OccludedBinary(const Ray& ray, float maxDis, TraversalStats& stats) const;
+	float TraceCompact(const std::vector<CompactNode>& nodes, const Ray& ray, TraversalStats& stats) const;
+
+	template <uint32_t Width>
+	float TraceWide(const std::vector<WideNode<Width>>& nodes, const Ray& ray, TraversalStats& stats) const;
+
+private:
+	const BVH& mBVH;
+
+private:
+	// Front to back walk ordered by the split axis, like FindCollisionNode
+	float WalkBinary(const Ray& ray, float maxDis, bool anyHit, TraversalStats& stats) const;
+
+	float IntersectTriangles(const RayQuery& ray, uint32_t begin, uint32_t end,
+		float closestHit, TraversalStats& stats) const;
+};
+
+PH_END
+AQUA_END
@@ -0,0 +1,120 @@
+#pragma once
+#include "WavefrontConfig.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+enum class DependencyAccess
+{
+	eRead                       = 1,
+	eWrite                      = 2,
+	eReadWrite                  = 3,
+	eIndirectRead               = 4, // Dispatch arguments, read by the shader as well
+	eIndirectReadWrite          = 5,
+	eTransferRead               = 6,
+	eTransferWrite              = 7,
+};
+
+// Buffers and images a single stage reads or writes
+// Ranges of the same buffer have to either match exactly or stay disjoint, like the two ray buffer halves
+class StageDependencies
+{
+public:
+	StageDependencies() = default;
+
+	template <typename T>
+	StageDependencies& Add(const vkEngine::Buffer<T>& buffer, DependencyAccess access,
+		size_t first = 0, size_t count = std::numeric_limits<size_t>::max());
+
+	// Storage images, always in the general layout
+	StageDependencies& Add(const vkEngine::Image& image, DependencyAccess access);
+
+	// Every access of the other stage as well, for stages which don't depend on each other
+	StageDependencies& Merge(const StageDependencies& other);
+
+private:
+	struct ResourceAccess
+	{
+		uint64_t Handle = 0;
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Size = VK_WHOLE_SIZE;
+
+		bool IsImage = false;
+		vk::ImageSubresourceRange ImageRange;
+
+		vk::PipelineStageFlags Stages;
+		vk::AccessFlags Access;
+	};
+
+	std::vector<ResourceAccess> mAccesses;
+
+private:
+	StageDependencies& AddAccess(const ResourceAccess& resource, DependencyAccess access);
+
+	friend class DependencyTracker;
+};
+
+// Derives the buffer and image barriers of every stage from the accesses of the earlier stages
+// Only the resources a stage touches get a barrier, so the independent stages can overlap
+// Keeps its state between the traces, so they have to be submitted in the recorded order
+class DependencyTracker
+{
+public:
+	DependencyTracker() = default;
+
+	// Records a single barrier with everything the stage has to wait for, if anything
+	void Synchronize(vk::CommandBuffer commandBuffer, const StageDependencies& stage);
+
+	// Waits for everything that came before, for recordings which can't know their predecessors
+	void Flush(vk::CommandBuffer commandBuffer);
+
+	void Reset();
+
+private:
+	struct ResourceState
+	{
+		// Last write and the stages and accesses it was made visible to
+		vk::PipelineStageFlags WriteStages;
+		vk::AccessFlags WriteAccess;
+		uint64_t WriteIndex = 0;
+
+		vk::PipelineStageFlags VisibleStages;
+		vk::AccessFlags VisibleAccess;
+
+		// Reads since the last write, the next write has to wait for them
+		vk::PipelineStageFlags ReadStages;
+		uint64_t ReadIndex = 0;
+	};
+
+	using ResourceKey = std::tuple<uint64_t, vk::DeviceSize, vk::DeviceSize>;
+
+	// Compute, indirect and transfer stages
+	static constexpr size_t sStageCount = 3;
+
+	std::map<ResourceKey, ResourceState> mStates;
+
+	// Index of the last stage before which a barrier from the first stage to the second one was recorded
+	// Lets a stage skip the barriers some unrelated stage in between already recorded for it
+	std::array<std::array<uint64_t, sStageCount>, sStageCount> mFences{};
+	uint64_t mStageIndex = 1;
+
+private:
+	bool IsOrdered(vk::PipelineStageFlags srcStages, uint64_t srcIndex, vk::PipelineStageFlags dstStages) const;
+	void RecordFences(vk::PipelineStageFlags srcStages, vk::PipelineStageFlags dstStages);
+};
+
+template <typename T>
+StageDependencies& StageDependencies::Add(const vkEngine::Buffer<T>& buffer, DependencyAccess access,
+	size_t first, size_t count)
+{
+	ResourceAccess resource{};
+	resource.Handle = reinterpret_cast<uint64_t>(static_cast<VkBuffer>(buffer.GetNativeHandles().Handle));
+	resource.Offset = static_cast<vk::DeviceSize>(first * sizeof(T));
+	resource.Size = count == std::numeric_limits<size_t>::max() ?
+		VK_WHOLE_SIZE : static_cast<vk::DeviceSize>(count * sizeof(T));
+
+	return AddAccess(resource, access);
+}
+
+PH_END
+AQUA_END
@@ -10,8 +10,9 @@ public:
 	Executor();
 
 	// TODO: Freezes when complex geometry is introduced
-	// The underlying bottleneck is probably an excessive use of memory barriers...
-	// We could replace them with vk::Semaphore's or vk::Fence's to improve the speed...
+	// Records the next tile, returns ePending until every tile of the frame has been traced
+	// The scene uniform changes with each call, so the previous one must have finished executing
+	// TraceSession::End doesn't wait for the geometry, the submission must wait on GetTraceSession().GetSceneUploads()
 	TraceResult Trace(vk::CommandBuffer commandBuffer);
 
 	void SetTraceSession(const TraceSession& traceSession);
@@ -19,8 +20,15 @@ public:
 	template<typename Iter>
 	void SetMaterialPipelines(Iter Begin, Iter End);
 
+	// The flags change the recorded stages, so they invalidate the reused recording as well
 	void SetSortingFlag(bool allowSort)
-	{ mExecutorInfo->CreateInfo.AllowSorting = allowSort; }
+	{ mExecutorInfo->CreateInfo.AllowSorting = allowSort; mExecutorInfo->TraceRecordingValid = false; }
+
+	void SetSortAlgorithm(RaySortAlgorithm algorithm)
+	{ mExecutorInfo->CreateInfo.SortAlgorithm = algorithm; mExecutorInfo->TraceRecordingValid = false; }
+
+	void SetCompactionFlag(bool allowCompaction)
+	{ mExecutorInfo->CreateInfo.AllowCompaction = allowCompaction; mExecutorInfo->TraceRecordingValid = false; }
 
 	void SetCameraView(const glm::mat4& cameraView);
 
@@ -28,10 +36,11 @@ public:
 	TraceSession GetTraceSession() const { return mExecutorInfo->TracingSession; }
 
 	glm::ivec2 GetTargetResolution() const { return mExecutorInfo->Target.ImageResolution; }
+	glm::ivec2 GetTileCounts() const;
 	vkEngine::Image GetPresentable() const { return mExecutorInfo->Target.Presentable; }
 	vkEngine::Buffer<WavefrontSceneInfo> GetSceneInfo() const { return mExecutorInfo->Scene; }
 
-	// For debugging...
+	// For debugging, the ray buffers only read back as structs with RayBufferLayout::eArrayOfStructs
 	RayBuffer GetRayBuffer() const { return mExecutorInfo->Rays; }
 	CollisionInfoBuffer GetCollisionBuffer() const { return mExecutorInfo->CollisionInfos; }
 	RayRefBuffer GetRayRefBuffer() const { return mExecutorInfo->RayRefs; }
@@ -48,21 +57,47 @@ private:
 
 	uint32_t GetRandomNumber();
 
-	void ExecuteRayGenerator(vk::CommandBuffer commandBuffer, uint32_t pActiveBuffer, glm::uvec3 workGroups);
+	// Every stage of a single frame, the per frame values have to be in the uniforms already
+	void RecordTrace(vk::CommandBuffer commandBuffer);
+
+	// Records the trace into the reused secondary command buffer
+	void RecordReusableTrace();
+
+	void ExecuteRayGenerator(vk::CommandBuffer commandBuffer,
+		uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups);
 	void ExecuteRaySortFinisher(vk::CommandBuffer commandBuffer, 
-		uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t pRayRefBuffer, glm::uvec3 workGroups);
+		uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t pRayRefBuffer);
+
+	// Returns the half of the ray reference buffer holding the sorted references
+	uint32_t ExecuteRaySorter(vk::CommandBuffer commandBuffer, uint32_t pMaterialCount);
 
 	void ExecutePrefixSummer(vk::CommandBuffer commandBuffer, uint32_t pMaterialCount);
 	void ExecuteRayCounter(vk::CommandBuffer commandBuffer, 
-		uint32_t pRayCount, uint32_t pMaterialCount, glm::uvec3 workGroups);
+		uint32_t pRayCount, uint32_t pMaterialCount);
 
+	// Turns the sorted material ranges (or the whole live range when unsorted) into indirect dispatches
+	void ExecuteMaterialQueueBuilder(vk::CommandBuffer commandBuffer, uint32_t pMaterialCount, bool sorted);
+
+	// Dispatched over the live rays, or over the whole half for the merge sort
 	void ExecuteRaySortPreparer(vk::CommandBuffer commandBuffer, 
-		uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups);
+		uint32_t pRayCount, uint32_t pActiveBuffer);
+
+	// The stages below only dispatch over the live rays of the current ray queue
+	StageDependencies GetTesterDependencies(uint32_t pRayCount, uint32_t pActiveBuffer) const;
 
 	void ExecuteIntersectionTester(vk::CommandBuffer commandBuffer, 
-		uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups);
+		uint32_t pRayCount, uint32_t pActiveBuffer);
+
+	// Expects the maximum distance of every ray in CollisionInfo::RayDis, writes the visibility to HitOccured
+	void ExecuteOcclusionTester(vk::CommandBuffer commandBuffer,
+		uint32_t pRayCount, uint32_t pActiveBuffer);
+
+	void ResetRayQueues(vk::CommandBuffer commandBuffer, uint32_t pRayCount);
 
-	void RecordLuminanceMean(vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t intersectionWorkgroups);
+	// Moves the live rays into the inactive half and retires the finished ones into the image
+	void ExecuteRayCompactor(vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pActiveBuffer);
+
+	void RecordLuminanceMean(vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pActiveBuffer);
 
 	void RecordPostProcess(vk::CommandBuffer commandBuffer, PostProcessFlags postProcess, glm::uvec3 workGroups);
 
@@ -71,7 +106,7 @@ private:
 	void InvalidateMaterialData();
 
 	void RecordMaterialPipelines(vk::CommandBuffer commandBuffer,
-		uint32_t pRayCount, uint32_t pBounceIdx, uint32_t pActiveBuffer, glm::uvec3 workGroups);
+		uint32_t pRayCount, uint32_t pBounceIdx, uint32_t pActiveBuffer);
 
 	void UpdateMaterialDescriptors();
 
@@ -82,9 +117,14 @@ template<typename Iter>
 inline void Executor::SetMaterialPipelines(Iter Begin, Iter End)
 {
 	mExecutorInfo->MaterialResources.clear();
+
+	uint32_t QueueWorkGroupSize = mExecutorInfo->PipelineResources.MaterialQueueBuilder.GetWorkGroupSize().x;
 	
 	for (; Begin != End; Begin++)
 	{
+		_STL_ASSERT(Begin->GetWorkGroupSize().x == QueueWorkGroupSize,
+			"Material pipelines must use the intersection workgroup size of the estimator!");
+
 		mExecutorInfo->MaterialResources.emplace_back(*Begin);
 
 		// For optimizations...
@@ -95,7 +135,28 @@ inline void Executor::SetMaterialPipelines(Iter Begin, Iter End)
 	mExecutorInfo->RefCounts.Resize(glm::max(static_cast<uint32_t>(mExecutorInfo->MaterialResources.size()
 		+ 2), static_cast<uint32_t>(32)));
 
+	mExecutorInfo->PipelineResources.PrefixSummer.SetBuffer(mExecutorInfo->RefCounts);
+
+	// One queue per material plus the inactive ray shader
+	mExecutorInfo->MaterialQueues.Resize(static_cast<uint32_t>(mExecutorInfo->MaterialResources.size() + 1));
+
+	auto& queueBuilder = mExecutorInfo->PipelineResources.MaterialQueueBuilder;
+
+	queueBuilder.mRayQueues = mExecutorInfo->RayQueues;
+	queueBuilder.mMaterialQueues = mExecutorInfo->MaterialQueues;
+	queueBuilder.mMaterialOffsets = mExecutorInfo->RefCounts;
+	queueBuilder.UpdateDescriptors();
+
 	InvalidateMaterialData();
+
+	mExecutorInfo->TraceRecordingValid = false;
+
+	if (mExecutorInfo->TracingSession)
+	{
+		// The resized queues have to be rebound
+		mExecutorInfo->PipelineResources.InactiveRayShader.UpdateDescriptors();
+		UpdateMaterialDescriptors();
+	}
 }
 
 PH_END
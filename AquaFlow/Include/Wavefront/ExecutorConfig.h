@@ -1,8 +1,13 @@
 #pragma once
 #include "WavefrontConfig.h"
 #include "MaterialPipeline.h"
+#include "RadixSortRecorder.h"
+#include "PrefixScanRecorder.h"
 
 #include "TraceSession.h"
+#include "DependencyTracker.h"
+
+#include "../Utils/ParallelRecorder.h"
 
 AQUA_BEGIN
 PH_BEGIN
@@ -13,20 +18,29 @@ struct ExecutionPipelines
 {
 	RayGenerationPipeline RayGenerator; // Simulates physical camera...
 	IntersectionPipeline IntersectionPipeline; // Intersection testing stage...
+	IntersectionPipeline OcclusionPipeline; // Any hit testing for shadow and light visibility rays
 
 	// Sorting stages...
 	RaySortEpiloguePipeline RaySortPreparer;
 	std::shared_ptr<RaySortRecorder> SortRecorder;
+	RadixSortRecorder RadixSorter; // Shares the ray reference buffer with the merge sorter
 	RaySortEpiloguePipeline RaySortFinisher;
 
 	// Ref counting and prefix sum stages...
 	RayRefCounterPipeline RayRefCounter;
-	PrefixSumPipeline PrefixSummer; // Fix me: bad implementation... 
+	PrefixScanRecorder PrefixSummer; // Exclusive scan of the ref counts
 
 	// Handles three default shaders: Empty, Skybox, and light shader
 	// All of them will deactivate the ray
 	MaterialPipeline InactiveRayShader; // TODO: Skybox shader hasn't been implemented yet...
 
+	// Sizes the material dispatches from the sorted ranges
+	MaterialQueuePipeline MaterialQueueBuilder;
+
+	// Packs the live rays after shading, the later stages only dispatch over them
+	RayCompactionPipeline RayCompactor;
+	RayCompactionPipeline RayQueueFinalizer;
+
 	LuminanceMeanPipeline LuminanceMean; // Accumulates the incoming light into an average sum
 	PostProcessImagePipeline PostProcessor; // For post processing...
 };
@@ -34,9 +48,23 @@ struct ExecutionPipelines
 struct ExecutorCreateInfo
 {
 	glm::ivec2 TargetResolution = { 1920, 1080 };
+
+	// The ray buffers only hold a single tile, the Executor::Trace renders one tile per call
+	// The tile area must be a multiple of the intersection workgroup size
 	glm::ivec2 TileSize = { 1920, 1080 };
 
 	bool AllowSorting = true;
+	RaySortAlgorithm SortAlgorithm = RaySortAlgorithm::eRadixSort;
+
+	bool AllowCompaction = true;
+
+	// Records the bounce loop once into a secondary command buffer, and replays it in every trace
+	bool ReuseRecording = false;
+	uint32_t QueueFamilyIndex = 0; // Family of the command buffers passed to the Executor::Trace
+
+	// More than one records the material dispatches of every bounce into secondary buffers on that many threads
+	// Ignored by the reused recording, a secondary buffer can't replay the others
+	uint32_t RecordThreadCount = 1;
 };
 
 struct ExecutionInfo
@@ -52,6 +80,8 @@ struct ExecutionInfo
 	RayInfoBuffer RayInfos;
 	CollisionInfoBuffer CollisionInfos;
 	RayRefBuffer RayRefs; // For sorting...
+	RayQueueBuffer RayQueues; // Live rays of the current bounce and the survivors of the compaction
+	MaterialQueueBuffer MaterialQueues; // Resized by the SetMaterialPipelines
 
 	vkEngine::Buffer<uint32_t> RefCounts; // Resized by the SetMaterialPipelines
 	vkEngine::Buffer<WavefrontSceneInfo> Scene;
@@ -69,9 +99,32 @@ struct ExecutionInfo
 	std::random_device RandomDevice;
 	std::mt19937 RandomEngine;
 
+	// Barriers between the stages, derived from what each of them reads and writes
+	DependencyTracker Dependencies;
+
+	// Tile rendered by the next trace, in the row major order
+	uint32_t TileIndex = 0;
+
+	// Half of the ray buffers the next trace starts in, the one the previous luminance mean didn't read
+	uint32_t FirstActiveBuffer = 0;
+
+	// Reused recording of the trace, invalidated by the Executor setters
+	vkEngine::CommandBufferAllocator TraceCommandAllocator;
+	vk::CommandBuffer TraceRecording;
+	bool TraceRecordingValid = false;
+
+	// Set when the ExecutorCreateInfo::RecordThreadCount asks for more than one thread
+	std::shared_ptr<ParallelRecorder> MaterialRecorder;
+
 	// Init random stuff...
 	ExecutionInfo()
 		: RandomDevice(), RandomEngine(RandomDevice()) {}
+
+	~ExecutionInfo()
+	{
+		if (TraceRecording)
+			TraceCommandAllocator.Free(TraceRecording);
+	}
 };
 
 PH_END
@@ -10,7 +10,9 @@ class LocalRadixSortPipeline : public vkEngine::ComputePipeline
 public:
 	LocalRadixSortPipeline() = default;
 
-	LocalRadixSortPipeline(uint32_t workGroupSize) { CompileShader(workGroupSize); }
+	// The shader is read from Utils/LocalRadixSort.glsl under the given directory
+	LocalRadixSortPipeline(uint32_t workGroupSize, const std::string& shaderDirectory)
+	{ CompileShader(workGroupSize, shaderDirectory); }
 
 	void UploadBuffer(const vkEngine::Buffer<uint32_t>& buffer)
 	{
@@ -37,40 +39,29 @@ private:
 private:
 	// Helper method...
 
-	void CompileShader(uint32_t workGroupSize)
+	void CompileShader(uint32_t workGroupSize, const std::string& shaderDirectory)
 	{
+		_STL_ASSERT(workGroupSize != 0 && (workGroupSize & (workGroupSize - 1)) == 0,
+			"The work group size of the local radix sort must be a power of two!");
+
 		mWorkgroupSize = workGroupSize;
 
 		vkEngine::PShader shader;
 
-		/*** TODO: Shader source must be hard - coded in the class field! ***/
-
-		std::string ShaderPath = "D:/Dev/VulkanEngine/vkEngineTester/Shaders/Utils/LocalRadixSort.glsl";
-
-		std::string ShaderBackEnd;
-		vkEngine::ReadFile(ShaderPath, ShaderBackEnd);
-
-		/********************************************************************/
-
-		// Combine the front-end implementation to the backend shader
-		//std::string FullShader = "#version 440\n\n";
-		//FullShader += mShaderFrontEnd + ShaderBackEnd;
-
 		uint32_t Stride = 2;
 
-		// TODO: Assert that the mWorkGroupSize must a multiple of two!
-
 		shader.AddMacro("WORKGROUP_SIZE", std::to_string(mWorkgroupSize));
 		shader.AddMacro("TREE_DEPTH", std::to_string((uint32_t) (glm::log2((float) mWorkgroupSize) + 0.5f)));
 		shader.AddMacro("STRIDE", std::to_string(Stride));
 
-		shader.SetShader("eCompute", ShaderBackEnd);
+		shader.SetFilepath("eCompute", shaderDirectory + "Utils/LocalRadixSort.glsl");
 
 		// Compile the shader
 		auto Errors = shader.CompileShaders();
 
-		CompileErrorChecker checker("../vkEngineTester/Logging/ShaderFails/Shader.glsl");
+		CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
 		auto ErrorInfos = checker.GetErrors(Errors);
+		checker.AssertOnError(ErrorInfos);
 
 		this->SetShader(shader);
 	}
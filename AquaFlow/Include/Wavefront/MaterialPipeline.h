@@ -32,6 +32,7 @@ public:
 	GeometryBuffers mGeometry;
 	LightInfoBuffer mLightInfos;
 	LightPropsBuffer mLightProps;
+	MaterialQueueBuffer mMaterialQueues;
 
 	ShaderDataUniform mShaderData;
 
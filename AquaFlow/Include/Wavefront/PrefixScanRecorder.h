@@ -0,0 +1,56 @@
+#pragma once
+#include "WavefrontWorkflow.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+// Sizes baked into the prefix scan shaders
+struct PrefixScanInfo
+{
+	// Has to be a power of two
+	uint32_t WorkGroupSize = 256;
+	uint32_t ItemsPerThread = 4;
+};
+
+// Parallel prefix sum of a uint buffer, scans the material ref counts and the ray compaction flags
+// Buffers fitting into one tile (WorkGroupSize * ItemsPerThread elements) take a single dispatch,
+// larger ones take three: tile scans, a scan of the tile sums and the tile offset addition
+class PrefixScanRecorder
+{
+public:
+	PrefixScanRecorder() = default;
+
+	PrefixScanRecorder(const PrefixScanInfo& info, vkEngine::ResourcePool manager,
+		const PrefixScanPipeline& scanTiles, const PrefixScanPipeline& scanTileSums,
+		const PrefixScanPipeline& addTileOffsets);
+
+	// Has to be called again whenever the buffer is resized
+	void SetBuffer(const vkEngine::Buffer<uint32_t>& buffer);
+
+	// Scans the first elementCount elements in place
+	void Run(vk::CommandBuffer commandBuffer, uint32_t elementCount, PrefixScanType type);
+
+	uint32_t GetTileCount(uint32_t elementCount) const;
+
+	vkEngine::Buffer<uint32_t> GetBuffer() const { return mBuffer; }
+	PrefixScanInfo GetInfo() const { return mInfo; }
+
+	explicit operator bool() const { return static_cast<bool>(mScanTilesPass); }
+
+private:
+	vkEngine::Buffer<uint32_t> mBuffer;
+	vkEngine::Buffer<uint32_t> mTileSums;
+
+	PrefixScanPipeline mScanTilesPass;
+	PrefixScanPipeline mScanTileSumsPass;
+	PrefixScanPipeline mAddTileOffsetsPass;
+
+	PrefixScanInfo mInfo;
+
+private:
+	void RecordStage(vk::CommandBuffer commandBuffer, PrefixScanPipeline& pipeline,
+		uint32_t pBufferSize, uint32_t pInclusive, uint32_t workGroups);
+};
+
+PH_END
+AQUA_END
@@ -0,0 +1,61 @@
+#pragma once
+#include "WavefrontWorkflow.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+// Sizes baked into the radix sort shaders
+struct RadixSortInfo
+{
+	// Has to be a multiple of 32
+	uint32_t WorkGroupSize = 256;
+	uint32_t ItemsPerThread = 8;
+
+	// Material counts below 2^RadixBits are sorted in a single pass
+	uint32_t RadixBits = 8;
+};
+
+// LSD radix sort of the ray references by their material index
+// Every digit takes three dispatches: per tile counts, one scan and a stable scatter
+// Like SortRecorder, the buffer holds two halves and Run returns the one with the sorted elements
+// Only the first RayCount elements of the element count buffer are sorted, the count stays on the GPU
+class RadixSortRecorder
+{
+public:
+	RadixSortRecorder() = default;
+
+	RadixSortRecorder(const RadixSortInfo& info, vkEngine::ResourcePool manager,
+		const RadixSortPipeline& histogram, const RadixSortPipeline& scan, const RadixSortPipeline& scatter);
+
+	// The RayCount of the first entry in the elementCounts is read when the sort runs
+	void SetBuffers(const RayRefBuffer& buffer, const RayQueueBuffer& elementCounts);
+
+	// Keys at or above keyCount are treated as keyCount - 1
+	uint32_t Run(vk::CommandBuffer commandBuffer, uint32_t keyCount);
+
+	uint32_t GetPassCount(uint32_t keyCount) const;
+	uint32_t GetTileCount(uint32_t elementCount) const;
+
+	RayRefBuffer GetBuffer() const { return mBuffer; }
+	RadixSortInfo GetInfo() const { return mInfo; }
+
+	explicit operator bool() const { return static_cast<bool>(mHistogramPass); }
+
+private:
+	RayRefBuffer mBuffer;
+	RayQueueBuffer mElementCounts;
+	vkEngine::Buffer<uint32_t> mGroupCounts;
+
+	RadixSortPipeline mHistogramPass;
+	RadixSortPipeline mScanPass;
+	RadixSortPipeline mScatterPass;
+
+	RadixSortInfo mInfo;
+
+private:
+	void RecordStage(vk::CommandBuffer commandBuffer, RadixSortPipeline& pipeline, uint32_t pBufferSize,
+		uint32_t pActiveBuffer, uint32_t pShift, uint32_t pKeyCount, uint32_t workGroups);
+};
+
+PH_END
+AQUA_END
@@ -0,0 +1,178 @@
+#pragma once
+#include "RayTracingStructures.h"
+#include "Core.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+// CPU counterparts of the ray/box and ray/triangle tests in Intersection.glsl
+
+// Everything a traversal derives from the ray once instead of per box or per triangle
+struct RayQuery
+{
+	glm::vec3 Origin;
+	glm::vec3 Direction;
+	glm::vec3 InvDirection;
+
+	// Axis permutation and shear of the watertight triangle test
+	glm::ivec3 Axes;
+	glm::vec3 Shear;
+};
+
+struct TriangleHit
+{
+	float Distance = FLT_MAX;
+
+	// Weights of the vertices A, B and C
+	glm::vec3 bCoords = glm::vec3(0.0f);
+
+	// Faces against the ray
+	glm::vec3 Normal = glm::vec3(0.0f);
+};
+
+inline RayQuery MakeRayQuery(const Ray& ray)
+{
+	RayQuery query;
+
+	query.Origin = ray.Origin;
+	query.Direction = ray.Direction;
+	query.InvDirection = 1.0f / ray.Direction;
+
+	glm::vec3 Magnitude = glm::abs(ray.Direction);
+
+	// The dominant axis becomes z, swapping x and y keeps the winding for negative directions
+	int Z = Magnitude.x > Magnitude.y ? (Magnitude.x > Magnitude.z ? 0 : 2) : (Magnitude.y > Magnitude.z ? 1 : 2);
+	int X = (Z + 1) % 3;
+	int Y = (X + 1) % 3;
+
+	if (ray.Direction[Z] < 0.0f)
+		std::swap(X, Y);
+
+	query.Axes = glm::ivec3(X, Y, Z);
+	query.Shear = glm::vec3(ray.Direction[X] / ray.Direction[Z],
+		ray.Direction[Y] / ray.Direction[Z], 1.0f / ray.Direction[Z]);
+
+	return query;
+}
+
+// Slab test with the precomputed reciprocal, entry is clamped to the ray origin
+inline bool IntersectSlab(const RayQuery& ray, const glm::vec3& minBound, const glm::vec3& maxBound, float& entry)
+{
+	glm::vec3 T0 = (minBound - ray.Origin) * ray.InvDirection;
+	glm::vec3 T1 = (maxBound - ray.Origin) * ray.InvDirection;
+
+	glm::vec3 TNear = glm::min(T0, T1);
+	glm::vec3 TFar = glm::max(T0, T1);
+
+	float Enter = std::max(std::max(TNear.x, TNear.y), TNear.z);
+	float Exit = std::min(std::min(TFar.x, TFar.y), TFar.z);
+
+	entry = std::max(Enter, 0.0f);
+
+	return Enter < Exit && Exit > 0.0f;
+}
+
+// Moller-Trumbore, rejects as early as possible and only fills the hit for accepted triangles
+// Triangles whose determinant doesn't exceed the tolerence are treated as parallel to the ray
+inline bool IntersectTriangle(const RayQuery& ray, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C,
+	float maxDis, TriangleHit& hit, float tolerence = FLT_EPSILON)
+{
+	glm::vec3 E1 = B - A;
+	glm::vec3 E2 = C - A;
+
+	glm::vec3 H = glm::cross(ray.Direction, E2);
+	float Determinant = glm::dot(E1, H);
+
+	if (std::abs(Determinant) <= tolerence)
+		return false;
+
+	float DeterminantInv = 1.0f / Determinant;
+
+	glm::vec3 T = ray.Origin - A;
+	float U = glm::dot(T, H) * DeterminantInv;
+
+	if (U < 0.0f || U > 1.0f)
+		return false;
+
+	glm::vec3 Q = glm::cross(T, E1);
+	float V = glm::dot(ray.Direction, Q) * DeterminantInv;
+
+	if (V < 0.0f || U + V > 1.0f)
+		return false;
+
+	float Distance = glm::dot(E2, Q) * DeterminantInv;
+
+	if (Distance <= 0.0f || Distance >= maxDis)
+		return false;
+
+	glm::vec3 Normal = glm::normalize(glm::cross(E1, E2));
+
+	hit.Distance = Distance;
+	hit.bCoords = glm::vec3(1.0f - U - V, U, V);
+	hit.Normal = glm::dot(Normal, ray.Direction) < 0.0f ? Normal : -Normal;
+
+	return true;
+}
+
+// Woop, Benthin and Wald's watertight test, rays through shared edges and vertices never slip between triangles
+inline bool IntersectTriangleWatertight(const RayQuery& ray, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C,
+	float maxDis, TriangleHit& hit)
+{
+	glm::vec3 LocalA = A - ray.Origin;
+	glm::vec3 LocalB = B - ray.Origin;
+	glm::vec3 LocalC = C - ray.Origin;
+
+	int X = ray.Axes.x, Y = ray.Axes.y, Z = ray.Axes.z;
+
+	float Ax = LocalA[X] - ray.Shear.x * LocalA[Z];
+	float Ay = LocalA[Y] - ray.Shear.y * LocalA[Z];
+	float Bx = LocalB[X] - ray.Shear.x * LocalB[Z];
+	float By = LocalB[Y] - ray.Shear.y * LocalB[Z];
+	float Cx = LocalC[X] - ray.Shear.x * LocalC[Z];
+	float Cy = LocalC[Y] - ray.Shear.y * LocalC[Z];
+
+	float U = Cx * By - Cy * Bx;
+	float V = Ax * Cy - Ay * Cx;
+	float W = Bx * Ay - By * Ax;
+
+	// Edge functions that are exactly zero are recomputed in double precision
+	if (U == 0.0f || V == 0.0f || W == 0.0f)
+	{
+		U = static_cast<float>(static_cast<double>(Cx) * By - static_cast<double>(Cy) * Bx);
+		V = static_cast<float>(static_cast<double>(Ax) * Cy - static_cast<double>(Ay) * Cx);
+		W = static_cast<float>(static_cast<double>(Bx) * Ay - static_cast<double>(By) * Ax);
+	}
+
+	if ((U < 0.0f || V < 0.0f || W < 0.0f) && (U > 0.0f || V > 0.0f || W > 0.0f))
+		return false;
+
+	float Determinant = U + V + W;
+
+	if (Determinant == 0.0f)
+		return false;
+
+	float Az = ray.Shear.z * LocalA[Z];
+	float Bz = ray.Shear.z * LocalB[Z];
+	float Cz = ray.Shear.z * LocalC[Z];
+
+	float T = U * Az + V * Bz + W * Cz;
+
+	// Compares the scaled distance, so the division only happens for accepted hits
+	float Sign = Determinant < 0.0f ? -1.0f : 1.0f;
+
+	if (T * Sign <= 0.0f || T * Sign >= maxDis * Determinant * Sign)
+		return false;
+
+	float DeterminantInv = 1.0f / Determinant;
+
+	glm::vec3 Normal = glm::normalize(glm::cross(B - A, C - A));
+
+	hit.Distance = T * DeterminantInv;
+	hit.bCoords = glm::vec3(U, V, W) * DeterminantInv;
+	hit.Normal = glm::dot(Normal, ray.Direction) < 0.0f ? Normal : -Normal;
+
+	return true;
+}
+
+PH_END
+AQUA_END
@@ -30,6 +30,21 @@ enum class TraceResult
 	eUnknownError        = 2,
 };
 
+// GPU layout of the mesh BVHs, the top level tree always uses the binary nodes
+enum class BVHNodeLayout
+{
+	eBinary              = 0,
+	eCompact             = 1,
+	eWide                = 2,
+};
+
+// Memory layout of the ray, ray info and collision info buffers
+enum class RayBufferLayout
+{
+	eArrayOfStructs      = 0,
+	eStructOfArrays      = 1, // every 4 byte field in its own stream, the stages only touch what they use
+};
+
 using CameraMovementFlags = vk::Flags<CameraMovementFlagBits>;
 
 struct Ray
@@ -47,6 +62,26 @@ struct RayInfo
 	alignas(16) glm::vec4 Throughput;
 };
 
+// Live rays of a bounce, the first three fields double as a vk::DispatchIndirectCommand
+struct RayQueue
+{
+	alignas(4) uint32_t GroupCountX = 0;
+	alignas(4) uint32_t GroupCountY = 1;
+	alignas(4) uint32_t GroupCountZ = 1;
+	alignas(4) uint32_t RayCount = 0;
+};
+
+// Contiguous range of the sorted rays shaded by a single material pipeline
+// Entry 0 belongs to the inactive ray shader, material i sits at i + 1
+struct MaterialQueue
+{
+	alignas(4) uint32_t GroupCountX = 0;
+	alignas(4) uint32_t GroupCountY = 1;
+	alignas(4) uint32_t GroupCountZ = 1;
+	alignas(4) uint32_t RayOffset = 0;
+	alignas(4) uint32_t RayCount = 0;
+};
+
 // Set 1
 
 struct PhysicalCamera
@@ -83,10 +118,16 @@ struct ShaderData
 	// minimum allowed throughput...
 	alignas(4) float ThroughputFloor = 0.15f;
 
+	// Russian roulette starts at this bounce...
+	alignas(4) uint32_t uMinBounceLimit = 3;
+
 	// Skybox stuff...
 	alignas(4) uint32_t uSkyboxExists = false;
 	// The alpha channel contains the rotation of the cube map
 	alignas(16) glm::vec4 uSkyboxColor = glm::vec4(0.0f, 1.0f, 1.0f, 0.0f);
+
+	// Mixed into the per dispatch seeds, changes every frame
+	alignas(4) uint32_t uFrameSeed = 0;
 };
 struct LightProperties
 {
@@ -109,6 +150,27 @@ struct MeshInfo
 	alignas(4) uint32_t MaterialIndex = uint32_t(-1);
 };
 
+// One placement of a shared mesh BVH
+struct InstanceInfo
+{
+	alignas(16) glm::mat4 WorldToObject = glm::mat4(1.0f);
+	alignas(16) glm::mat4 ObjectToWorld = glm::mat4(1.0f);
+
+	alignas(4) uint32_t RootIndex = 0;
+	alignas(4) uint32_t MaterialIndex = uint32_t(-1);
+	alignas(4) uint32_t Padding1 = 0;
+	alignas(4) uint32_t Padding2 = 0;
+};
+
+// Geometry and BVH uploaded once by TraceSession::CreateMeshHandle
+struct MeshHandle
+{
+	uint32_t RootIndex = 0;
+
+	glm::vec3 MinBound = glm::vec3(0.0f);
+	glm::vec3 MaxBound = glm::vec3(0.0f);
+};
+
 struct SceneInfo
 {
 	alignas(8) glm::ivec2 MinBound = glm::ivec2(0, 0);
@@ -140,6 +202,16 @@ struct WavefrontSceneInfo
 	alignas(4) uint32_t ResetImage = 1;
 
 	alignas(4) uint32_t FrameCount = 1;
+
+	// Root of the top level tree over the mesh, light and instance BVHs (in the node buffer)
+	alignas(4) uint32_t TopLevelRoot = 0;
+	alignas(4) uint32_t InstanceCount = 0;
+
+	alignas(4) uint32_t NodeLayout = static_cast<uint32_t>(BVHNodeLayout::eBinary);
+
+	// Per frame values, a reused recording of the trace only sees them through here
+	alignas(4) uint32_t FrameSeed = 0;
+	alignas(16) glm::mat4 CameraView = glm::mat4(1.0f);
 };
 
 struct CollisionInfo
@@ -187,19 +259,76 @@ struct Node
 	alignas(4) uint32_t EndIndex = 0;
 
 	alignas(4) uint32_t FirstChildIndex = 0;
-	alignas(4) uint32_t Padding = 0;
+	// The first child holds the lower half along this axis
+	alignas(4) uint32_t SplitAxis = 0;
 	alignas(4) uint32_t SecondChildIndex = 0;
 };
 
+// 32 byte node carrying the half precision bounds of both of its children
+// Siblings are stored next to each other, so the second child index is implicit
+struct CompactNode
+{
+	static constexpr uint32_t sInternalNode = uint32_t(-1);
+
+	// Left child min and max followed by the right child min and max, two halves per element
+	alignas(4) uint32_t ChildBounds[6] = {};
+
+	// Left child for internal nodes, first face for leaves
+	alignas(4) uint32_t ChildIndex = 0;
+	alignas(4) uint32_t TriangleCount = sInternalNode;
+};
+
+// Node of a BVH with up to Width children, their bounds are stored per component
+// so a single fetch feeds the box tests of every child at once
+template <uint32_t Width>
+struct WideNode
+{
+	static constexpr uint32_t sWidth = Width;
+	static constexpr uint32_t sEmptySlot = uint32_t(-1);
+
+	alignas(4) float MinX[Width];
+	alignas(4) float MinY[Width];
+	alignas(4) float MinZ[Width];
+
+	alignas(4) float MaxX[Width];
+	alignas(4) float MaxY[Width];
+	alignas(4) float MaxZ[Width];
+
+	// Child node for internal slots, first face for leaves and sEmptySlot for the unused ones
+	alignas(4) uint32_t ChildIndex[Width];
+	// Zero for internal slots
+	alignas(4) uint32_t TriangleCount[Width];
+
+	WideNode()
+	{
+		for (uint32_t i = 0; i < Width; i++)
+		{
+			MinX[i] = MinY[i] = MinZ[i] = FLT_MAX;
+			MaxX[i] = MaxY[i] = MaxZ[i] = -FLT_MAX;
+
+			ChildIndex[i] = sEmptySlot;
+			TriangleCount[i] = 0;
+		}
+	}
+};
+
+// Width of the wide nodes traversed by the intersection shader (BVH_WIDTH)
+using GPUWideNode = WideNode<4>;
+
 using NodeBuffer = vkEngine::Buffer<Node>;
+using CompactNodeBuffer = vkEngine::Buffer<CompactNode>;
+using WideNodeBuffer = vkEngine::Buffer<GPUWideNode>;
 using MaterialBuffer = vkEngine::Buffer<Material>;
 using LightPropsBuffer = vkEngine::Buffer<LightProperties>;
 using CollisionInfoBuffer = vkEngine::Buffer<CollisionInfo>;
 using RayBuffer = vkEngine::Buffer<Ray>;
 using RayInfoBuffer = vkEngine::Buffer<RayInfo>;
+using RayQueueBuffer = vkEngine::Buffer<RayQueue>;
+using MaterialQueueBuffer = vkEngine::Buffer<MaterialQueue>;
 
 using MeshInfoBuffer = vkEngine::Buffer<MeshInfo>;
 using LightInfoBuffer = vkEngine::Buffer<LightInfo>;
+using InstanceInfoBuffer = vkEngine::Buffer<InstanceInfo>;
 
 using ShaderDataUniform = vkEngine::Buffer<ShaderData>;
 
@@ -212,6 +341,8 @@ struct GeometryBuffers
 	FaceBuffer Faces;
 
 	NodeBuffer Nodes;
+	CompactNodeBuffer CompactNodes;
+	WideNodeBuffer WideNodes;
 };
 
 struct BVH
@@ -262,6 +393,8 @@ struct WavefrontTraceInfo
 
 	uint32_t MaxBounceLimit = 8;
 	uint32_t MinBounceLimit = 3;
+
+	BVHNodeLayout NodeLayout = BVHNodeLayout::eBinary;
 };
 
 struct Box
@@ -278,6 +411,28 @@ struct Box
 		return position.x > Min.x && position.y > Min.y && position.z > Min.z &&
 			position.x < Max.x && position.y < Max.y && position.z < Max.z;
 	}
+
+	// Encloses all eight corners of the box once they have gone through the transform
+	Box Transform(const glm::mat4& transform) const
+	{
+		glm::vec3 MinBound = glm::vec3(FLT_MAX);
+		glm::vec3 MaxBound = glm::vec3(-FLT_MAX);
+
+		for (int i = 0; i < 8; i++)
+		{
+			glm::vec3 Corner;
+			Corner.x = (i & 1) ? Max.x : Min.x;
+			Corner.y = (i & 2) ? Max.y : Min.y;
+			Corner.z = (i & 4) ? Max.z : Min.z;
+
+			Corner = glm::vec3(transform * glm::vec4(Corner, 1.0f));
+
+			MinBound = glm::min(MinBound, Corner);
+			MaxBound = glm::max(MaxBound, Corner);
+		}
+
+		return Box(MinBound, MaxBound);
+	}
 };
 
 struct Tile
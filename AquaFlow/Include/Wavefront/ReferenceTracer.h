@@ -0,0 +1,150 @@
+#pragma once
+#include "RayTracingStructures.h"
+#include "Core.h"
+
+#include "../Utils/ThreadPool.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+struct ReferenceTracerCreateInfo
+{
+	glm::ivec2 TargetResolution = { 1920, 1080 };
+
+	// Threads working on every stage, including the calling one (zero picks the hardware concurrency)
+	uint32_t ThreadCount = 0;
+	// Rays handed to a thread at once
+	uint32_t BatchSize = 4096;
+
+	// Mirrors TOLERENCE of the intersection and material shaders
+	float Tolerence = 0.001f;
+	uint32_t BVH_Depth = 32;
+};
+
+// Wall clock time of a Trace call, split by stage
+struct ReferenceTraceStats
+{
+	// Rays that went through the intersection stage
+	uint64_t RayCount = 0;
+	uint32_t ThreadCount = 1;
+
+	double GenerationSeconds = 0.0;
+	double IntersectionSeconds = 0.0;
+	double ShadingSeconds = 0.0;
+	double AccumulationSeconds = 0.0;
+
+	double GetTotalSeconds() const;
+	double GetRaysPerSecond() const;
+	double GetRaysPerSecondPerCore() const;
+};
+
+std::ostream& operator<<(std::ostream& stream, const ReferenceTraceStats& stats);
+
+// CPU mirror of the wavefront estimator, runs without a Vulkan device
+// Ray generation, intersection, shading and luminance accumulation are separate passes over
+// the whole ray buffer, exactly like the GPU stages, each one split across the thread pool
+// Material shaders are user GLSL, so every material reference is shaded with a Lambert + GGX Cook-Torrance
+// model of its Material entry instead. Only paths ending on a light source contribute, like in LuminanceMean.glsl
+// NOTE: results only depend on the scene and the frame count, never on the thread count
+class ReferenceTracer
+{
+public:
+	explicit ReferenceTracer(const ReferenceTracerCreateInfo& createInfo);
+
+	// Same submission flow as TraceSession, so one scene description can feed both
+	void Begin(const WavefrontTraceInfo& beginInfo);
+	void SubmitRenderable(const MeshData& meshData);
+	void SubmitLightSrc(const MeshData& meshData, const glm::vec3& lightIntensity);
+	MeshHandle CreateMeshHandle(const MeshData& meshData);
+	void SubmitInstance(const MeshHandle& mesh, const glm::mat4& transform, uint32_t materialIndex);
+	void End();
+
+	// Indexed by Face::MaterialRef and the material index of the instances
+	void SetMaterials(const std::vector<Material>& materials) { mMaterials = materials; }
+
+	void SetCameraView(const glm::mat4& view);
+	void SetCameraSpecs(const PhysicalCamera& camera);
+
+	// Every frame traces one path per pixel and folds it into the running mean
+	ReferenceTraceStats Trace(uint32_t frameCount = 1);
+
+	void ResetImage();
+
+	// Row major, the alpha channel is always one
+	const std::vector<glm::vec4>& GetMeanImage() const { return mMeanImage; }
+	uint32_t GetFrameCount() const { return mFrameCount; }
+
+private:
+	struct LightSource
+	{
+		uint32_t MeshIndex = 0;
+		glm::vec3 Color = glm::vec3(0.0f);
+	};
+
+	ReferenceTracerCreateInfo mCreateInfo;
+	WavefrontTraceInfo mTraceInfo;
+
+	std::shared_ptr<ThreadPool> mThreadPool;
+
+	// Same object order as the top level tree of TraceSession: meshes, lights and then instances
+	std::vector<BVH> mMeshes;
+	std::vector<uint32_t> mRenderables;
+	std::vector<LightSource> mLights;
+	std::vector<InstanceInfo> mInstances;
+	std::vector<Box> mObjectBounds;
+	std::vector<Node> mTopLevel;
+
+	std::vector<Material> mMaterials;
+
+	// Ray buffers of the current frame
+	std::vector<Ray> mRays;
+	std::vector<RayInfo> mRayInfos;
+	std::vector<CollisionInfo> mCollisionInfos;
+
+	std::vector<glm::vec4> mMeanImage;
+	uint32_t mFrameCount = 0;
+
+	// Seeds of the ray generation and every bounce
+	std::mt19937 mRandomEngine;
+
+	bool mOpenScope = false;
+
+private:
+	uint32_t BuildMesh(const MeshData& meshData);
+
+	template <typename Fn>
+	void ParallelFor(uint32_t count, Fn&& fn);
+
+	void GenerateRays(uint32_t frameSeed);
+	uint64_t IntersectRays();
+	void ShadeRays(uint32_t bounceIdx, uint32_t bounceSeed);
+	void AccumulateLuminance();
+
+	void CheckForRayCollisions(CollisionInfo& closestHit, const Ray& ray) const;
+	bool TestObjectCollisions(CollisionInfo& closestHit, const Ray& ray, uint32_t objectIndex) const;
+};
+
+template <typename Fn>
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::ParallelFor(uint32_t count, Fn&& fn)
+{
+	uint32_t BatchSize = std::max(mCreateInfo.BatchSize, 1u);
+
+	if (!mThreadPool || count <= BatchSize)
+	{
+		fn(0, count);
+		return;
+	}
+
+	TaskGroup group(*mThreadPool);
+
+	for (uint32_t begin = 0; begin < count; begin += BatchSize)
+	{
+		uint32_t end = std::min(begin + BatchSize, count);
+		group.Run([&fn, begin, end]() { fn(begin, end); });
+	}
+
+	group.Wait();
+}
+
+PH_END
+AQUA_END
@@ -19,6 +19,12 @@ public:
 	// (Only works at eReceiving stage)
 	// (For developers: eLightSrc corresponds to face id -- 1 and eObject corresponds to 0)
 	void SubmitLightSrc(const MeshData& meshData, const glm::vec3& lightIntensity, uint32_t bvhDepth);
+	// (Only works at eReceiving stage)
+	// (Uploads the geometry and its BVH once, without placing it in the scene)
+	MeshHandle CreateMeshHandle(const MeshData& meshData, uint32_t bvhDepth);
+	// (Only works at eReceiving stage)
+	// (Places the shared mesh with an object to world transform, the material overrides the face materials)
+	void SubmitInstance(const MeshHandle& mesh, const glm::mat4& transform, uint32_t materialIndex);
 	// Ending the scope (eReceiving state --> eReady state)
 	void End();
 
@@ -40,6 +46,9 @@ public:
 	GeometryBuffers GetLocalBuffers() const { return mSessionInfo->LocalBuffers; }
 	vkEngine::Buffer<PhysicalCamera> GetPhysicalCameraBuffer() const { return mSessionInfo->CameraSpecsBuffer; }
 
+	// The submission of the first trace after End has to wait on it
+	vkEngine::Core::GpuFuture GetSceneUploads() const { return mSessionInfo->SceneUploads; }
+
 	const glm::mat4& GetCameraView() const { return mSessionInfo->CameraView; }
 	const PhysicalCamera& GetCameraSpecs() const { return mSessionInfo->CameraSpecs; }
 
@@ -53,28 +62,29 @@ private:
 
 	void UpdateSceneBuffers();
 
+	// Builds the tree over the root bounds of all meshes, lights and instances and appends it to the local nodes
+	void CreateTopLevelStructure();
+
 	BVH CreateBVH(const MeshData& meshData, uint32_t bvhDepth);
 
+	// Size of the buffer holding the mesh BVHs in the session's node layout
+	size_t GetMeshNodeCount() const;
+
 	void CopyAllVertexAttribs(BVH& bvhStruct, const MeshData& meshData, RenderableType renderableType);
 
 	template <typename T, typename Iter, typename Fn>
-	void CopyVertexAttrib(vkEngine::Buffer<T>& SharedBuffer, vkEngine::Buffer<T>& LocalBuffer,
-		Iter Begin, Iter End, Fn CopyRoutine);
+	void CopyVertexAttrib(vkEngine::Buffer<T>& LocalBuffer, Iter Begin, Iter End, Fn CopyRoutine);
 
 	friend class WavefrontEstimator;
 	friend class Executor;
 };
 
 template <typename T, typename Iter, typename Fn>
-void PH_FLUX_NAMESPACE::TraceSession::CopyVertexAttrib(vkEngine::Buffer<T>& SharedBuffer, 
-	vkEngine::Buffer<T>& LocalBuffer, Iter Begin, Iter End, Fn CopyRoutine)
+void PH_FLUX_NAMESPACE::TraceSession::CopyVertexAttrib(vkEngine::Buffer<T>& LocalBuffer,
+	Iter Begin, Iter End, Fn CopyRoutine)
 {
-	// TODO: CopyVertexAttrib calls vkEngine::CopyBufferRegions internally
-	// This function utilizes GPU to copy from shared buffers to locals
-	// This is inherently slow! This process can be batched together for multiple meshes
-	
-	// The way you can do this is by first letting the shared buffer fill to certain max extent
-	// And then immediately flush it out into the local buffer once it fills to that threshold
+	// The attributes are written straight into the staging ring
+	// Their copies are only recorded, End submits the copies of the whole scope at once
 
 	size_t LocalBufferSize = LocalBuffer.GetSize();
 	size_t HostCount = End - Begin;
@@ -82,24 +92,23 @@ void PH_FLUX_NAMESPACE::TraceSession::CopyVertexAttrib(vkEngine::Buffer<T>& Shar
 	if (HostCount == 0)
 		return;
 
-	SharedBuffer.Clear();
-	SharedBuffer.Resize(HostCount);
-
-	T* BeginDevice = SharedBuffer.MapMemory(HostCount);
-	T* EndDevice = BeginDevice + HostCount;
-
-	CopyRoutine(BeginDevice, EndDevice, &(*Begin), &(*(End - 1)) + 1);
-
-	SharedBuffer.UnmapMemory();
+	// Every reallocation is a blocking copy on the GPU, so the capacity grows geometrically
+	// The copies in flight must land before the old buffer goes away
+	if (LocalBufferSize + HostCount > LocalBuffer.GetCapacity())
+	{
+		mSessionInfo->Staging.WaitIdle();
+		LocalBuffer.Reserve(std::max(LocalBufferSize + HostCount, 2 * LocalBuffer.GetCapacity()));
+	}
 
 	LocalBuffer.Resize(LocalBufferSize + HostCount);
 
-	vk::BufferCopy CopyInfo{};
-	CopyInfo.setSrcOffset(0);
-	CopyInfo.setDstOffset(LocalBufferSize);
-	CopyInfo.setSize(HostCount);
+	auto BeginHost = &(*Begin);
 
-	vkEngine::CopyBufferRegions(LocalBuffer, SharedBuffer, std::vector<vk::BufferCopy>({ CopyInfo }));
+	mSessionInfo->Staging.Stage(LocalBuffer, LocalBufferSize, HostCount,
+		[BeginHost, &CopyRoutine](T* BeginRing, T* EndRing, size_t FirstIndex)
+	{
+		CopyRoutine(BeginRing, EndRing, BeginHost + FirstIndex, BeginHost + FirstIndex + (EndRing - BeginRing));
+	});
 }
 
 PH_END
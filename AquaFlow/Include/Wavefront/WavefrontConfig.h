@@ -5,6 +5,8 @@
 #include "WavefrontWorkflow.h"
 #include "RayGenerationPipeline.h"
 
+#include "../Utils/ThreadPool.h"
+
 AQUA_BEGIN
 PH_BEGIN
 
@@ -41,12 +43,22 @@ struct SessionInfo
 {
 	MeshInfoBuffer MeshInfos;
 	LightInfoBuffer LightInfos;
+	InstanceInfoBuffer InstanceInfos;
 
 	LightPropsBuffer LightPropsInfos;
 
-	GeometryBuffers SharedBuffers;
 	GeometryBuffers LocalBuffers;
 
+	// The geometry of a whole scope goes up through it in a single submission at End
+	vkEngine::StagingRing Staging;
+	// Reached once the geometry of the last scope has landed, the first trace after End waits on it
+	vkEngine::Core::GpuFuture SceneUploads;
+
+	// Root bounds of every submission, the top level structure is built over them
+	std::vector<Box> MeshBounds;
+	std::vector<Box> LightBounds;
+	std::vector<Box> InstanceBounds;
+
 	vkEngine::Buffer<PhysicalCamera> CameraSpecsBuffer;
 	vkEngine::Buffer<ShaderData> ShaderConstData;
 
@@ -61,6 +73,9 @@ struct SessionInfo
 	WavefrontTraceInfo TraceInfo{};
 
 	TraceSessionState State = TraceSessionState::eReset;
+
+	// Shared by all sessions of the estimator to build the BVHs
+	std::shared_ptr<ThreadPool> BuildPool;
 };
 
 struct WavefrontEstimatorCreateInfo
@@ -74,6 +89,15 @@ struct WavefrontEstimatorCreateInfo
 	uint32_t MaterialEvalWorkgroupSize = 256;
 
 	float Tolerence = 0.001f;
+
+	// Woop's watertight triangle test instead of Moller-Trumbore, closes the cracks along shared edges
+	bool WatertightIntersection = false;
+
+	// Layout of the ray buffers, the debug getters of the executor expect the array of structs
+	RayBufferLayout RayLayout = RayBufferLayout::eArrayOfStructs;
+
+	// Threads used for BVH construction (zero picks the hardware concurrency, one builds serially)
+	uint32_t BVH_BuildThreadCount = 0;
 };
 
 template <typename T>
@@ -32,6 +32,7 @@ private:
 	vkEngine::ResourcePool mResourcePool;
 
 	std::shared_ptr<RaySortRecorder> mSortRecorder;
+	std::shared_ptr<ThreadPool> mBuildPool;
 	
 	std::string mShaderFrontEnd;
 	std::string mShaderBackEnd;
@@ -56,10 +57,13 @@ private:
 	MaterialShaderError ImportShaders(std::string& shaderCode);
 
 	vkEngine::PShader GetRayGenerationShader();
-	vkEngine::PShader GetIntersectionShader();
+	vkEngine::PShader GetIntersectionShader(IntersectionQuery query);
 	vkEngine::PShader GetRaySortEpilogueShader(RaySortEvent sortEvent);
 	vkEngine::PShader GetRayRefCounterShader();
-	vkEngine::PShader GetPrefixSumShader();
+	vkEngine::PShader GetPrefixScanShader(PrefixScanStage stage, const PrefixScanInfo& scanInfo);
+	vkEngine::PShader GetRadixSortShader(RadixSortStage stage, const RadixSortInfo& sortInfo);
+	vkEngine::PShader GetRayCompactionShader(RayCompactionStage stage);
+	vkEngine::PShader GetMaterialQueueShader();
 	vkEngine::PShader GetLuminanceMeanShader();
 	vkEngine::PShader GetPostProcessImageShader();
 };
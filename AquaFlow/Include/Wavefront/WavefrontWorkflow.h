@@ -16,6 +16,47 @@ enum class RaySortEvent
 	eFinish                     = 2
 };
 
+enum class RaySortAlgorithm
+{
+	eMergeSort                  = 1, // log2(N) merge passes over the ray references
+	eRadixSort                  = 2, // Three dispatches per digit of the material index
+};
+
+// Dispatches making up a single digit pass of the radix sort
+enum class RadixSortStage
+{
+	eHistogram                  = 0,
+	eScan                       = 1,
+	eScatter                    = 2,
+};
+
+enum class PrefixScanType
+{
+	eExclusive                  = 0, // The first element becomes zero
+	eInclusive                  = 1, // Every element keeps its own value in the sum
+};
+
+// Dispatches making up a prefix scan, only the first one runs for a single tile
+enum class PrefixScanStage
+{
+	eScanTiles                  = 0,
+	eScanTileSums               = 1,
+	eAddTileOffsets             = 2,
+};
+
+// Dispatches of the ray compaction after the shading stage
+enum class RayCompactionStage
+{
+	eCompact                    = 0,
+	eFinalize                   = 1, // Writes the queue of the next bounce
+};
+
+enum class IntersectionQuery
+{
+	eClosestHit                 = 1,
+	eOcclusion                  = 2, // Any hit, stops at the first triangle
+};
+
 enum class PostProcessFlagBits
 {
 	eToneMap                    = 1,
@@ -36,6 +77,7 @@ struct IntersectionPipeline : public vkEngine::ComputePipeline
 
 // Fields...
 	RayBuffer mRays;
+	RayQueueBuffer mRayQueues;
 
 	GeometryBuffers mGeometryBuffers;
 	CollisionInfoBuffer mCollisionInfos;
@@ -43,6 +85,7 @@ struct IntersectionPipeline : public vkEngine::ComputePipeline
 	MeshInfoBuffer mMeshInfos;
 	LightInfoBuffer mLightInfos;
 	LightPropsBuffer mLightProps;
+	InstanceInfoBuffer mInstanceInfos;
 
 	vkEngine::Buffer<WavefrontSceneInfo> mSceneInfo;
 
@@ -63,6 +106,7 @@ struct RaySortEpiloguePipeline : public vkEngine::ComputePipeline
 	CollisionInfoBuffer mCollisionInfos;
 
 	RayRefBuffer mRayRefs;
+	RayQueueBuffer mRayQueues; // The live count bounds both stages
 
 	RaySortEvent mSortingEvent = RaySortEvent::ePrepare;
 
@@ -78,18 +122,32 @@ struct RayRefCounterPipeline : public vkEngine::ComputePipeline
 // Fields...
 	RayRefBuffer mRayRefs;
 	vkEngine::Buffer<uint32_t> mRefCounts;
+	RayQueueBuffer mRayQueues; // Only the references of the live rays are counted
 };
 
-// TODO: Make a proper Prefix summer
-struct PrefixSumPipeline : public vkEngine::ComputePipeline
+struct RadixSortPipeline : public vkEngine::ComputePipeline
 {
-	PrefixSumPipeline() = default;
-	PrefixSumPipeline(const vkEngine::PShader& shader) { this->SetShader(shader); }
+	RadixSortPipeline() = default;
+	RadixSortPipeline(const vkEngine::PShader& shader) { this->SetShader(shader); }
 
 	virtual void UpdateDescriptors() override;
 
 // Fields...
-	vkEngine::Buffer<uint32_t> mRefCounts;
+	RayRefBuffer mRayRefs;
+	vkEngine::Buffer<uint32_t> mGroupCounts;
+	RayQueueBuffer mElementCounts; // The RayCount of the first entry is the sorted length
+};
+
+struct PrefixScanPipeline : public vkEngine::ComputePipeline
+{
+	PrefixScanPipeline() = default;
+	PrefixScanPipeline(const vkEngine::PShader& shader) { this->SetShader(shader); }
+
+	virtual void UpdateDescriptors() override;
+
+// Fields...
+	vkEngine::Buffer<uint32_t> mElements;
+	vkEngine::Buffer<uint32_t> mTileSums;
 };
 
 struct LuminanceMeanPipeline : public vkEngine::ComputePipeline
@@ -103,9 +161,45 @@ struct LuminanceMeanPipeline : public vkEngine::ComputePipeline
 	vkEngine::Image mPixelVariance;
 	vkEngine::Image mPresentable;
 
+	RayBuffer mRays;
+	RayInfoBuffer mRayInfos;
+	RayQueueBuffer mRayQueues;
+	vkEngine::Buffer<WavefrontSceneInfo> mSceneInfo;
+};
+
+struct RayCompactionPipeline : public vkEngine::ComputePipeline
+{
+	RayCompactionPipeline() = default;
+	RayCompactionPipeline(const vkEngine::PShader& shader) { this->SetShader(shader); }
+
+	virtual void UpdateDescriptors() override;
+
+// Fields...
+	RayQueueBuffer mRayQueues;
+
+	// Only bound to the compaction stage, which retires the finished paths
 	RayBuffer mRays;
 	RayInfoBuffer mRayInfos;
 	vkEngine::Buffer<WavefrontSceneInfo> mSceneInfo;
+
+	vkEngine::Image mPixelMean;
+	vkEngine::Image mPresentable;
+
+	RayCompactionStage mStage = RayCompactionStage::eCompact;
+};
+
+// Writes the indirect dispatch and the ray range of every material pipeline
+struct MaterialQueuePipeline : public vkEngine::ComputePipeline
+{
+	MaterialQueuePipeline() = default;
+	MaterialQueuePipeline(const vkEngine::PShader& shader) { this->SetShader(shader); }
+
+	virtual void UpdateDescriptors() override;
+
+// Fields...
+	RayQueueBuffer mRayQueues;
+	MaterialQueueBuffer mMaterialQueues;
+	vkEngine::Buffer<uint32_t> mMaterialOffsets;
 };
 
 struct PostProcessImagePipeline : public vkEngine::ComputePipeline
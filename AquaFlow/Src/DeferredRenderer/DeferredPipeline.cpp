@@ -260,8 +260,7 @@ void AQUA_NAMESPACE::DeferredPipeline::SubmitRenderable(const DeferredRenderable
 
 	cmd.end({});
 
-	uint32_t queueIdx = mDeferredCtx->Exec.SubmitWork(cmd);
-	mDeferredCtx->Exec[queueIdx]->WaitIdle();
+	mDeferredCtx->Exec.SubmitWork(cmd).Wait();
 }
 
 void AQUA_NAMESPACE::DeferredPipeline::SetSampler(const std::string& tag, vkEngine::Core::Ref<vk::Sampler> sampler)
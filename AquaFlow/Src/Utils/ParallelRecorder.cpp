@@ -0,0 +1,32 @@
+#include "Core/Aqpch.h"
+#include "Utils/ParallelRecorder.h"
+
+AQUA_NAMESPACE::ParallelRecorder::ParallelRecorder(std::shared_ptr<ThreadPool> threadPool,
+	const vkEngine::ThreadCommandPools& commandPools, uint32_t familyIndex)
+	: mThreadPool(threadPool), mCommandPools(commandPools), mFamilyIndex(familyIndex)
+{
+	_STL_ASSERT(mThreadPool && mCommandPools, "ParallelRecorder needs a thread pool and the command pools!");
+}
+
+void AQUA_NAMESPACE::ParallelRecorder::Reset()
+{
+	for (const auto& [secondary, allocator] : mRecorded)
+		allocator->Free(secondary);
+
+	mRecorded.clear();
+}
+
+uint32_t AQUA_NAMESPACE::ParallelRecorder::GetChunkCount(uint32_t itemCount, uint32_t threadCount)
+{
+	// Every chunk gets at least sMinChunkSize items
+	return std::min(threadCount, itemCount / sMinChunkSize);
+}
+
+std::pair<uint32_t, uint32_t> AQUA_NAMESPACE::ParallelRecorder::GetChunkRange(
+	uint32_t itemCount, uint32_t chunkCount, uint32_t chunk)
+{
+	uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * chunk / chunkCount);
+	uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(itemCount) * (chunk + 1) / chunkCount);
+
+	return { begin, end };
+}
@@ -0,0 +1,139 @@
+#include "Core/Aqpch.h"
+#include "Utils/ThreadPool.h"
+
+namespace
+{
+	// Identifies the pool and the deque owned by the calling worker thread
+	thread_local const AQUA_NAMESPACE::ThreadPool* sLocalPool = nullptr;
+	thread_local uint32_t sLocalQueueIndex = UINT32_MAX;
+}
+
+AQUA_NAMESPACE::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	mThreadCount = std::max(threadCount, 1u);
+
+	mQueues.reserve(mThreadCount);
+
+	for (uint32_t i = 0; i < mThreadCount; i++)
+		mQueues.emplace_back(std::make_unique<WorkQueue>());
+
+	mWorkers.reserve(mThreadCount);
+
+	for (uint32_t i = 0; i < mThreadCount; i++)
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+AQUA_NAMESPACE::ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock locker(mSleepLock);
+		mShutdown = true;
+	}
+
+	mSleepCondition.notify_all();
+
+	for (auto& worker : mWorkers)
+		worker.join();
+}
+
+void AQUA_NAMESPACE::ThreadPool::Submit(Task&& task)
+{
+	uint32_t QueueIndex = GetLocalQueueIndex();
+
+	if (QueueIndex == UINT32_MAX)
+		QueueIndex = mNextQueue.fetch_add(1, std::memory_order_relaxed) % GetThreadCount();
+
+	{
+		std::scoped_lock locker(mQueues[QueueIndex]->Lock);
+		mQueues[QueueIndex]->Tasks.emplace_back(std::move(task));
+	}
+
+	{
+		std::scoped_lock locker(mSleepLock);
+		mPendingCount.fetch_add(1, std::memory_order_release);
+	}
+
+	mSleepCondition.notify_one();
+}
+
+void AQUA_NAMESPACE::ThreadPool::WorkerLoop(uint32_t index)
+{
+	sLocalPool = this;
+	sLocalQueueIndex = index;
+
+	while (true)
+	{
+		if (TryRunTask())
+			continue;
+
+		std::unique_lock locker(mSleepLock);
+
+		mSleepCondition.wait(locker, [this]()
+		{ return mShutdown || mPendingCount.load(std::memory_order_acquire) > 0; });
+
+		if (mShutdown && mPendingCount.load(std::memory_order_acquire) <= 0)
+			return;
+	}
+}
+
+bool AQUA_NAMESPACE::ThreadPool::TryRunTask()
+{
+	uint32_t QueueIndex = GetLocalQueueIndex();
+
+	Task task;
+
+	if (!TryPop(QueueIndex, task) && !TrySteal(QueueIndex, task))
+		return false;
+
+	mPendingCount.fetch_sub(1, std::memory_order_acq_rel);
+
+	task();
+
+	return true;
+}
+
+bool AQUA_NAMESPACE::ThreadPool::TryPop(uint32_t index, Task& task)
+{
+	if (index == UINT32_MAX)
+		return false;
+
+	WorkQueue& queue = *mQueues[index];
+	std::scoped_lock locker(queue.Lock);
+
+	if (queue.Tasks.empty())
+		return false;
+
+	// Newest task first, it most likely touches the data that is still in cache
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+
+	return true;
+}
+
+bool AQUA_NAMESPACE::ThreadPool::TrySteal(uint32_t index, Task& task)
+{
+	uint32_t ThreadCount = GetThreadCount();
+	uint32_t Start = index == UINT32_MAX ? 0 : index + 1;
+
+	for (uint32_t i = 0; i < ThreadCount; i++)
+	{
+		WorkQueue& queue = *mQueues[(Start + i) % ThreadCount];
+		std::scoped_lock locker(queue.Lock);
+
+		if (queue.Tasks.empty())
+			continue;
+
+		// Oldest task first, those usually carry the largest chunk of work
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+
+		return true;
+	}
+
+	return false;
+}
+
+uint32_t AQUA_NAMESPACE::ThreadPool::GetLocalQueueIndex() const
+{
+	return sLocalPool == this ? sLocalQueueIndex : UINT32_MAX;
+}
@@ -1,6 +1,5 @@
 #include "Core/Aqpch.h"
 #include "Wavefront/BVHFactory.h"
-#include "Utils/BisectionSolver.h"
 
 AQUA_BEGIN
 PH_BEGIN
@@ -14,55 +13,241 @@ glm::vec3 TriangleCentroid(const BVH& bvh, uint32_t i)
 	return (A + B + C) / 3.0f;
 }
 
-// TODO: Very expensive, there should be a way to optimize it
-uint32_t CountTriangles(const BVH& bvh, const Node& node, float lambda, float split, int index)
+float SpatialSplit(const BVH& bvh, CentroidSpan centroids, const Node& node, int index)
 {
-	if (lambda >= 1.0f)
-		return node.EndIndex - node.BeginIndex;
+	return (node.MaxBound[index] - node.MinBound[index]) / 2.0f;
+}
+
+// Object median: the plane passes through the median centroid, so both children get half of the triangles
+float ObjectSplit(const BVH& bvh, CentroidSpan centroids, const Node& node, int index)
+{
+	// Reused between the nodes of a build, the workers each own one
+	thread_local std::vector<float> sCoords;
 
-	if (lambda <= 0.0f)
-		return 0;
+	sCoords.clear();
 
-	glm::vec3 offset = glm::vec3(0.0f);
-	offset[index] = lambda * split;
+	for (uint32_t i = node.BeginIndex; i < node.EndIndex; i++)
+		sCoords.push_back(centroids[i][index]);
 
-	Box box(node.MinBound, node.MinBound + offset);
+	if (sCoords.empty())
+		return SpatialSplit(bvh, centroids, node, index);
 
-	uint32_t count = 0;
+	// Everything strictly below the median goes to the left child
+	auto Median = sCoords.begin() + sCoords.size() / 2;
+	std::nth_element(sCoords.begin(), Median, sCoords.end());
 
-	for (uint32_t begin = node.BeginIndex; begin < node.EndIndex; begin++)
+	return *Median - node.MinBound[index];
+}
+
+float SurfaceArea(const glm::vec3& minBound, const glm::vec3& maxBound)
+{
+	glm::vec3 Span = glm::max(maxBound - minBound, glm::vec3(0.0f));
+
+	return 2.0f * (Span.x * Span.y + Span.y * Span.z + Span.z * Span.x);
+}
+
+struct SAH_Bin
+{
+	glm::vec3 MinBound = glm::vec3(FLT_MAX);
+	glm::vec3 MaxBound = glm::vec3(-FLT_MAX);
+	uint32_t Count = 0;
+
+	void Grow(const glm::vec3& point)
 	{
-		if (box.IsInside(TriangleCentroid(bvh, begin)))
-			count++;
+		MinBound = glm::min(MinBound, point);
+		MaxBound = glm::max(MaxBound, point);
 	}
 
-	return count;
-}
+	void Grow(const SAH_Bin& other)
+	{
+		MinBound = glm::min(MinBound, other.MinBound);
+		MaxBound = glm::max(MaxBound, other.MaxBound);
+		Count += other.Count;
+	}
+
+	float Area() const { return Count == 0 ? 0.0f : SurfaceArea(MinBound, MaxBound); }
+};
 
-float SpatialSplit(const BVH& bvh, const Node& node, int index)
+struct SAH_Candidate
 {
-	return (node.MaxBound[index] - node.MinBound[index]) / 2.0f;
+	float Position = 0.0f;
+	float Cost = FLT_MAX;
+};
+
+// Nodes below this many triangles are reduced on the calling thread
+constexpr uint32_t sReductionGrainSize = 16384;
+
+// Splits [begin, end) into chunks, maps each of them on the pool and folds the partial results in order
+template <typename T, typename MapFn, typename FoldFn>
+T ParallelReduce(ThreadPool* pool, uint32_t begin, uint32_t end, MapFn&& map, FoldFn&& fold)
+{
+	uint32_t Count = end - begin;
+
+	if (!pool || Count < 2 * sReductionGrainSize)
+		return map(begin, end);
+
+	uint32_t ChunkCount = std::min(4 * pool->GetThreadCount(), Count / sReductionGrainSize);
+	uint32_t ChunkSize = (Count + ChunkCount - 1) / ChunkCount;
+
+	std::vector<T> Partials(ChunkCount);
+
+	TaskGroup group(*pool);
+
+	for (uint32_t i = 1; i < ChunkCount; i++)
+	{
+		group.Run([&map, &Partials, begin, end, ChunkSize, i]()
+		{
+			Partials[i] = map(begin + i * ChunkSize, std::min(end, begin + (i + 1) * ChunkSize));
+		});
+	}
+
+	Partials[0] = map(begin, begin + ChunkSize);
+
+	group.Wait();
+
+	T Result = std::move(Partials[0]);
+
+	for (uint32_t i = 1; i < ChunkCount; i++)
+		fold(Result, Partials[i]);
+
+	return Result;
 }
 
-float ObjectSplit(const BVH& bvh, const Node& node, int index)
+// Bins the triangle centroids of the node along every axis in a single sweep and
+// evaluates the cost of each of the (BinCount - 1) planes between the bins
+std::array<SAH_Candidate, 3> EvaluateBinnedSAH(const BVH& bvh, CentroidSpan centroids, const Node& node,
+	const SAH_Parameters& params, ThreadPool* pool = nullptr)
 {
-	// Using bisection method to find the root of this equation
-	// f(lambda) = N(lambda) - No / 2
+	std::array<SAH_Candidate, 3> candidates{};
+
+	const uint32_t BinCount = std::max(params.BinCount, 2u);
+
+	SAH_Bin CentroidBounds = ParallelReduce<SAH_Bin>(pool, node.BeginIndex, node.EndIndex,
+		[&centroids](uint32_t begin, uint32_t end)
+	{
+		SAH_Bin bounds{};
+
+		for (uint32_t i = begin; i < end; i++)
+			bounds.Grow(centroids[i]);
+
+		return bounds;
+	},
+		[](SAH_Bin& result, const SAH_Bin& partial) { result.Grow(partial); });
 
-	fBisectionSolver solver{};
+	glm::vec3 CentroidMin = CentroidBounds.MinBound;
+	glm::vec3 Extent = CentroidBounds.MaxBound - CentroidBounds.MinBound;
 
-	float splitDistance = node.MaxBound[index] - node.MinBound[index];
-	float TriCount = static_cast<float>(node.EndIndex - node.BeginIndex);
+	using AxisBins = std::array<std::vector<SAH_Bin>, 3>;
 
-	solver.SetFunc([&bvh, &node, splitDistance, TriCount, index](float lambda)->float
+	AxisBins Bins = ParallelReduce<AxisBins>(pool, node.BeginIndex, node.EndIndex,
+		[&bvh, &centroids, &CentroidMin, &Extent, BinCount](uint32_t begin, uint32_t end)
 	{
-		return (float) CountTriangles(bvh, node, lambda, splitDistance, index) - (float) TriCount / 2.0f;
+		AxisBins bins;
+
+		for (auto& axisBins : bins)
+			axisBins.resize(BinCount);
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Face& face = bvh.Faces[i];
+			const glm::vec3& Centre = centroids[i];
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (Extent[axis] <= 0.0f)
+					continue;
+
+				float Scale = static_cast<float>(BinCount) / Extent[axis];
+				uint32_t BinIdx = std::min(BinCount - 1,
+					static_cast<uint32_t>((Centre[axis] - CentroidMin[axis]) * Scale));
+
+				SAH_Bin& bin = bins[axis][BinIdx];
+
+				bin.Count++;
+				bin.Grow(bvh.Vertices[face.Indices.x]);
+				bin.Grow(bvh.Vertices[face.Indices.y]);
+				bin.Grow(bvh.Vertices[face.Indices.z]);
+			}
+		}
+
+		return bins;
+	},
+		[BinCount](AxisBins& result, const AxisBins& partial)
+	{
+		for (int axis = 0; axis < 3; axis++)
+			for (uint32_t bin = 0; bin < BinCount; bin++)
+				result[axis][bin].Grow(partial[axis][bin]);
 	});
 
-	solver.SetTolerence(1.5f);
-	float root = solver.Solve(0.0f, 1.0f);
+	float ParentArea = SurfaceArea(node.MinBound, node.MaxBound);
+
+	if (ParentArea <= 0.0f)
+		return candidates;
+
+	std::vector<float> LeftCosts(BinCount - 1);
 
-	return root;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (Extent[axis] <= 0.0f)
+			continue;
+
+		const auto& axisBins = Bins[axis];
+
+		// Sweep from the left, storing area * count of everything before each plane
+		SAH_Bin Accumulated{};
+
+		for (uint32_t plane = 0; plane < BinCount - 1; plane++)
+		{
+			Accumulated.Grow(axisBins[plane]);
+			LeftCosts[plane] = Accumulated.Area() * static_cast<float>(Accumulated.Count);
+		}
+
+		// Sweep from the right and combine both halves
+		Accumulated = SAH_Bin{};
+
+		for (uint32_t plane = BinCount - 1; plane > 0; plane--)
+		{
+			Accumulated.Grow(axisBins[plane]);
+
+			float Cost = params.TraversalCost + params.IntersectionCost *
+				(LeftCosts[plane - 1] + Accumulated.Area() * static_cast<float>(Accumulated.Count)) / ParentArea;
+
+			if (Cost < candidates[axis].Cost)
+			{
+				candidates[axis].Cost = Cost;
+				candidates[axis].Position = CentroidMin[axis] +
+					Extent[axis] * static_cast<float>(plane) / static_cast<float>(BinCount);
+			}
+		}
+	}
+
+	return candidates;
+}
+
+float SAH_SplitWithParams(const BVH& bvh, CentroidSpan centroids, const Node& node, int index,
+	const SAH_Parameters& params, ThreadPool* pool)
+{
+	SAH_Candidate candidate = EvaluateBinnedSAH(bvh, centroids, node, params, pool)[index];
+
+	if (candidate.Cost == FLT_MAX)
+		return SpatialSplit(bvh, centroids, node, index);
+
+	return candidate.Position - node.MinBound[index];
+}
+
+float SAH_Split(const BVH& bvh, CentroidSpan centroids, const Node& node, int index)
+{
+	return SAH_SplitWithParams(bvh, centroids, node, index, SAH_Parameters(), nullptr);
+}
+
+// The factory runs sSAH itself, the split function alone can't see the cost model of the strategy
+bool IsSAH_Split(const SplitFunction& splitFn)
+{
+	using SplitFnPtr = float(*)(const BVH&, CentroidSpan, const Node&, int);
+
+	const SplitFnPtr* Target = splitFn.target<SplitFnPtr>();
+
+	return Target && *Target == &SAH_Split;
 }
 
 PH_END
@@ -74,7 +259,161 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::SplitFunction
 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::SplitFunction
 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::DefaultSplitFn::sObjectSplit = ObjectSplit;
 
-// TODO: We have yet to implement the Surface Area Heuristic (SAH) split
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::SplitFunction
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::DefaultSplitFn::sSAH = SAH_Split;
+
+std::ostream& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::operator<<(std::ostream& stream, const BVHQualityReport& report)
+{
+	stream << "SAH cost: " << report.SAHCost << "\n";
+	stream << "Nodes: " << report.NodeCount << ", Leaves: " << report.LeafCount
+		<< ", Max depth: " << report.MaxDepth << "\n";
+	stream << "Leaf size (avg/max): " << report.AverageLeafSize << "/" << report.MaxLeafSize << "\n";
+	stream << "  Empty: " << report.EmptyLeafCount << "\n";
+
+	for (size_t i = 0; i < report.LeafSizeHistogram.size(); i++)
+	{
+		stream << "  [" << (1u << i) << ", " << (1u << (i + 1)) << "): "
+			<< report.LeafSizeHistogram[i] << "\n";
+	}
+
+	return stream;
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHQualityReport AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHFactory::GenerateQualityReport(const BVH& bvh, const SAH_Parameters& costModel)
+{
+	BVHQualityReport report{};
+
+	if (bvh.Nodes.empty())
+		return report;
+
+	float RootArea = SurfaceArea(bvh.Nodes[0].MinBound, bvh.Nodes[0].MaxBound);
+	RootArea = RootArea > 0.0f ? RootArea : 1.0f;
+
+	uint64_t LeafTriangles = 0;
+
+	// Node index and its depth
+	std::vector<std::pair<uint32_t, uint32_t>> NodeStack;
+	NodeStack.emplace_back(0, 0);
+
+	while (!NodeStack.empty())
+	{
+		auto [NodeIdx, Depth] = NodeStack.back();
+		NodeStack.pop_back();
+
+		const Node& node = bvh.Nodes[NodeIdx];
+		float RelativeArea = SurfaceArea(node.MinBound, node.MaxBound) / RootArea;
+
+		report.NodeCount++;
+		report.MaxDepth = std::max(report.MaxDepth, Depth);
+
+		// Leaves point back at the root
+		if (node.FirstChildIndex == 0)
+		{
+			uint32_t TriCount = node.EndIndex - node.BeginIndex;
+
+			report.SAHCost += costModel.IntersectionCost * static_cast<float>(TriCount) * RelativeArea;
+			report.LeafCount++;
+			report.MaxLeafSize = std::max(report.MaxLeafSize, TriCount);
+
+			LeafTriangles += TriCount;
+
+			if (TriCount == 0)
+			{
+				report.EmptyLeafCount++;
+				continue;
+			}
+
+			uint32_t Bucket = static_cast<uint32_t>(std::log2(TriCount));
+
+			if (report.LeafSizeHistogram.size() <= Bucket)
+				report.LeafSizeHistogram.resize(Bucket + 1, 0);
+
+			report.LeafSizeHistogram[Bucket]++;
+
+			continue;
+		}
+
+		report.SAHCost += costModel.TraversalCost * RelativeArea;
+
+		NodeStack.emplace_back(node.FirstChildIndex, Depth + 1);
+		NodeStack.emplace_back(node.SecondChildIndex, Depth + 1);
+	}
+
+	report.AverageLeafSize = static_cast<float>(LeafTriangles) / static_cast<float>(report.LeafCount);
+
+	return report;
+}
+
+std::vector<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Node> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHFactory::BuildTopLevel(const std::vector<Box>& bounds)
+{
+	uint32_t ItemCount = static_cast<uint32_t>(bounds.size());
+
+	std::vector<uint32_t> Items(ItemCount);
+
+	for (uint32_t i = 0; i < ItemCount; i++)
+		Items[i] = i;
+
+	auto Centre = [&bounds](uint32_t item) { return (bounds[item].Min + bounds[item].Max) / 2.0f; };
+
+	std::vector<Node> Nodes;
+	Nodes.reserve(std::max(2 * ItemCount, 2u) - 1);
+	Nodes.emplace_back();
+
+	// The object count stays in the hundreds, a median split is good enough here
+	std::function<void(uint32_t, uint32_t, uint32_t)> SplitRecursive =
+		[&](uint32_t nodeIndex, uint32_t begin, uint32_t end)
+	{
+		SAH_Bin NodeBounds{};
+		SAH_Bin CentroidBounds{};
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			NodeBounds.Grow(bounds[Items[i]].Min);
+			NodeBounds.Grow(bounds[Items[i]].Max);
+			CentroidBounds.Grow(Centre(Items[i]));
+		}
+
+		Node& node = Nodes[nodeIndex];
+
+		node.MinBound = NodeBounds.MinBound;
+		node.MaxBound = NodeBounds.MaxBound;
+
+		if (end - begin <= 1)
+		{
+			// An empty scene ends up with an empty leaf at the root
+			node.BeginIndex = begin == end ? 0 : Items[begin];
+			node.EndIndex = node.BeginIndex + (end - begin);
+			return;
+		}
+
+		glm::vec3 Extent = CentroidBounds.MaxBound - CentroidBounds.MinBound;
+		int Axis = Extent.x > Extent.y ? (Extent.x > Extent.z ? 0 : 2) : (Extent.y > Extent.z ? 1 : 2);
+
+		uint32_t Mid = (begin + end) / 2;
+
+		std::nth_element(Items.begin() + begin, Items.begin() + Mid, Items.begin() + end,
+			[&Centre, Axis](uint32_t first, uint32_t second)
+		{ return Centre(first)[Axis] < Centre(second)[Axis]; });
+
+		uint32_t FirstChild = static_cast<uint32_t>(Nodes.size());
+
+		node.FirstChildIndex = FirstChild;
+		node.SecondChildIndex = FirstChild + 1;
+		node.SplitAxis = static_cast<uint32_t>(Axis);
+
+		Nodes.emplace_back();
+		Nodes.emplace_back();
+
+		SplitRecursive(FirstChild, begin, Mid);
+		SplitRecursive(FirstChild + 1, Mid, end);
+	};
+
+	SplitRecursive(0, 0, ItemCount);
+
+	return Nodes;
+}
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::Cleanup()
 {
@@ -82,6 +421,38 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::Cleanup()
 
 	mCurrent.Vertices.clear();
 	mCurrent.Faces.clear();
+
+	mCentroids.clear();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::ComputeCentroids()
+{
+	uint32_t FaceCount = static_cast<uint32_t>(mCurrent.Faces.size());
+
+	mCentroids.resize(FaceCount);
+
+	auto Compute = [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			mCentroids[i] = ::AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TriangleCentroid(mCurrent, i);
+	};
+
+	if (!mThreadPool || FaceCount < 2 * sReductionGrainSize)
+	{
+		Compute(0, FaceCount);
+		return;
+	}
+
+	uint32_t ChunkSize = (FaceCount + mThreadPool->GetThreadCount() - 1) / mThreadPool->GetThreadCount();
+
+	TaskGroup group(*mThreadPool);
+
+	for (uint32_t begin = ChunkSize; begin < FaceCount; begin += ChunkSize)
+		group.Run([&Compute, begin, ChunkSize, FaceCount]() { Compute(begin, std::min(FaceCount, begin + ChunkSize)); });
+
+	Compute(0, std::min(FaceCount, ChunkSize));
+
+	group.Wait();
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::Clear()
@@ -97,66 +468,106 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SplitRecursive(Node& parentN
 	if (depth == 0)
 		return;
 
-	auto [leftBox, rightBox] = SplitBox(parentNode);
-	auto [leftChild, rightChild] = MakeChildNodes(parentNode, leftBox, rightBox);
+	SplitPlane plane = GetOptimalSplit(parentNode);
+
+	if (!ShouldSplit(parentNode, plane))
+		return;
+
+	auto [leftChild, rightChild] = MakeChildNodes(parentNode, plane);
 
 	if (leftChild.BeginIndex == leftChild.EndIndex || rightChild.BeginIndex == rightChild.EndIndex)
 		return;
 
-	parentNode.FirstChildIndex = (uint32_t) mCurrent.Nodes.size();
+	parentNode.FirstChildIndex = mNodeCount.fetch_add(2, std::memory_order_relaxed);
 	parentNode.SecondChildIndex = parentNode.FirstChildIndex + 1;
+	parentNode.SplitAxis = static_cast<uint32_t>(plane.Axis);
 
 	uint32_t leftBoxIndex = parentNode.FirstChildIndex;
 	uint32_t secondBoxIndex = parentNode.SecondChildIndex;
 
-	mCurrent.Nodes.emplace_back(leftChild);
-	mCurrent.Nodes.emplace_back(rightChild);
+	mCurrent.Nodes[leftBoxIndex] = leftChild;
+	mCurrent.Nodes[secondBoxIndex] = rightChild;
 
 	// Split the left and right box recursively
+	if (mThreadPool && parentNode.EndIndex - parentNode.BeginIndex >= mTaskGrainSize)
+	{
+		// Both subtrees own disjoint face ranges and nodes, the left one can be stolen by an idle worker
+		TaskGroup group(*mThreadPool);
+
+		group.Run([this, leftBoxIndex, depth]() { SplitRecursive(mCurrent.Nodes[leftBoxIndex], depth - 1); });
+		SplitRecursive(mCurrent.Nodes[secondBoxIndex], depth - 1);
+
+		group.Wait();
+		return;
+	}
+
 	SplitRecursive(mCurrent.Nodes[leftBoxIndex], depth - 1);
 	SplitRecursive(mCurrent.Nodes[secondBoxIndex], depth - 1);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::EncloseIntoBoundingBox(Node& node)
 {
-	glm::vec3 MinBound = { FLT_MAX, FLT_MAX, FLT_MAX };
-	glm::vec3 MaxBound = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
-
-	auto ReplaceMinBound = [](float& MinBound, float VertexComponent)
+	SAH_Bin Bounds = ParallelReduce<SAH_Bin>(mThreadPool.get(), node.BeginIndex, node.EndIndex,
+		[this](uint32_t begin, uint32_t end)
 	{
-		if (MinBound > VertexComponent)
-			MinBound = VertexComponent;
-	};
+		SAH_Bin bounds{};
 
-	auto ReplaceMaxBound = [](float& MaxBound, float VertexComponent)
-	{
-		if (MaxBound < VertexComponent)
-			MaxBound = VertexComponent;
-	};
+		std::for_each(mCurrent.Faces.begin() + begin, mCurrent.Faces.begin() + end,
+			[this, &bounds](const Face& face)
+		{
+			for (int i = 0; i < 3; i++)
+				bounds.Grow(mCurrent.Vertices[face.Indices[i]]);
+		});
 
-	std::for_each(mFaces.begin() + node.BeginIndex, mFaces.begin() + node.EndIndex,
-		[this, &MinBound, &MaxBound, ReplaceMaxBound, ReplaceMinBound](const Face& face)
+		return bounds;
+	},
+		[](SAH_Bin& result, const SAH_Bin& partial) { result.Grow(partial); });
+
+	node.MinBound = Bounds.MinBound - glm::vec3(mTolerence);
+	node.MaxBound = Bounds.MaxBound + glm::vec3(mTolerence);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::ReorderNodes()
+{
+	// Children were allocated in whichever order the workers reached them
+	// Walking the tree again puts every pair right where the serial build would have
+	std::vector<Node> Ordered;
+	Ordered.reserve(mCurrent.Nodes.size());
+	Ordered.push_back(mCurrent.Nodes[0]);
+
+	std::function<void(uint32_t)> PlaceChildren = [this, &Ordered, &PlaceChildren](uint32_t orderedIndex)
 	{
-		for (int i = 0; i < 3; i++)
-		{
-			glm::vec3 Vertex = mVertices[face.Indices[i]];
+		Node& parent = Ordered[orderedIndex];
 
-			ReplaceMinBound(MinBound.x, Vertex.x);
-			ReplaceMinBound(MinBound.y, Vertex.y);
-			ReplaceMinBound(MinBound.z, Vertex.z);
+		if (parent.FirstChildIndex == 0)
+			return;
 
-			ReplaceMaxBound(MaxBound.x, Vertex.x);
-			ReplaceMaxBound(MaxBound.y, Vertex.y);
-			ReplaceMaxBound(MaxBound.z, Vertex.z);
-		}
-	});
+		uint32_t FirstChild = parent.FirstChildIndex;
+		uint32_t SecondChild = parent.SecondChildIndex;
+
+		uint32_t OrderedFirst = static_cast<uint32_t>(Ordered.size());
+
+		parent.FirstChildIndex = OrderedFirst;
+		parent.SecondChildIndex = OrderedFirst + 1;
+
+		Ordered.push_back(mCurrent.Nodes[FirstChild]);
+		Ordered.push_back(mCurrent.Nodes[SecondChild]);
+
+		PlaceChildren(OrderedFirst);
+		PlaceChildren(OrderedFirst + 1);
+	};
 
-	node.MinBound = MinBound - glm::vec3(mTolerence);
-	node.MaxBound = MaxBound + glm::vec3(mTolerence);
+	PlaceChildren(0);
+
+	mCurrent.Nodes = std::move(Ordered);
 }
 
-std::pair<float, int> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::GetOptimalSplit(const Node& node)
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SplitPlane 
+	AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::GetOptimalSplit(const Node& node)
 {
+	if (mStrategy.mUseSAH)
+		return GetOptimalSplitSAH(node);
+
 	// First find the longest axis
 
 	glm::vec3 BoxSpan = node.MaxBound - node.MinBound;
@@ -174,77 +585,73 @@ std::pair<float, int> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::GetOptimalS
 	}
 
 	// We will split along the longest axis
-	float splitPos = mStrategy.mSplit(mCurrent, node, LargestSpanIndex);
+	SplitPlane plane{};
+	plane.Axis = LargestSpanIndex;
+	plane.Position = node.MinBound[LargestSpanIndex] + (IsSAH_Split(mStrategy.mSplit) ?
+		SAH_SplitWithParams(mCurrent, mCentroids, node, LargestSpanIndex, mStrategy.mSAH_Params, mThreadPool.get()) :
+		mStrategy.mSplit(mCurrent, mCentroids, node, LargestSpanIndex));
 
-	return { splitPos, LargestSpanIndex };
+	return plane;
 }
 
-glm::vec3 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::TriangleCentroid(uint32_t i)
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SplitPlane 
+	AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::GetOptimalSplitSAH(const Node& node)
 {
-	glm::vec3 A = mVertices[mFaces[i].Indices.x];
-	glm::vec3 B = mVertices[mFaces[i].Indices.y];
-	glm::vec3 C = mVertices[mFaces[i].Indices.z];
+	auto candidates = EvaluateBinnedSAH(mCurrent, mCentroids, node, mStrategy.mSAH_Params, mThreadPool.get());
 
-	return (A + B + C) / 3.0f;
-}
+	SplitPlane plane{};
 
-std::pair<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Box, AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Box> 
-	AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::SplitBox(const Node& node)
-{
-#if 0
-	glm::vec3 BoxSpan = node.MaxBound - node.MinBound;
-
-	float MaxSpan = 0.0f;
-	int LargetSpanIndex = 0;
-
-	for (int i = 0; i < 3; i++)
+	for (int axis = 0; axis < 3; axis++)
 	{
-		if (MaxSpan < BoxSpan[i])
+		if (candidates[axis].Cost < plane.Cost)
 		{
-			LargetSpanIndex = i;
-			MaxSpan = BoxSpan[i];
+			plane.Axis = axis;
+			plane.Position = candidates[axis].Position;
+			plane.Cost = candidates[axis].Cost;
 		}
 	}
 
-	float HalfMaxSpan = MaxSpan / 2.0f;
-#endif
+	return plane;
+}
+
+bool AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::ShouldSplit(const Node& node, const SplitPlane& plane) const
+{
+	if (!mStrategy.mUseSAH)
+		return true;
 
-	auto [Span, LargestSpanIndex] = GetOptimalSplit(node);
+	// All centroids coincide, no plane can separate them
+	if (plane.Cost == FLT_MAX)
+		return false;
 
-	const glm::vec3 Offset = glm::vec3(mTolerence);
+	uint32_t TriCount = node.EndIndex - node.BeginIndex;
 
-	glm::vec3 MaxBoundForLeftBox = node.MaxBound + Offset;
-	MaxBoundForLeftBox[LargestSpanIndex] -= Span;
+	if (TriCount > mStrategy.mSAH_Params.MaxLeafSize)
+		return true;
 
-	glm::vec3 MinBoundForRightBox = node.MinBound - Offset;
-	MinBoundForRightBox[LargestSpanIndex] += Span;
+	float LeafCost = mStrategy.mSAH_Params.IntersectionCost * static_cast<float>(TriCount);
 
-	return { Box(node.MinBound - Offset, MaxBoundForLeftBox),
-		Box(MinBoundForRightBox, node.MaxBound + Offset) };
+	return plane.Cost < LeafCost;
 }
 
 std::pair<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Node, AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Node> 
 	AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHFactory::MakeChildNodes(
-		const Node& parentNode, const Box& leftBox, const Box& rightBox)
+		const Node& parentNode, const SplitPlane& plane)
 {
 	// Partition the points for spatial coherence
 	uint32_t LeftIndex = parentNode.BeginIndex;
 
 	for (uint32_t i = parentNode.BeginIndex; i < parentNode.EndIndex; i++)
 	{
-		glm::vec3 Centre = TriangleCentroid(i);
-
-		if (leftBox.IsInside(Centre))
+		if (TriangleCentroid(i)[plane.Axis] < plane.Position)
 		{
 			if (i != LeftIndex)
-				std::swap(mFaces[i], mFaces[LeftIndex]);
+			{
+				std::swap(mCurrent.Faces[i], mCurrent.Faces[LeftIndex]);
+				std::swap(mCentroids[i], mCentroids[LeftIndex]);
+			}
 
 			LeftIndex++;
 		}
-		else
-		{
-			_STL_ASSERT(rightBox.IsInside(Centre), "Point found neither in the left or right bounding box!");
-		}
 	}
 
 	// Construct the child bounding boxes
@@ -253,15 +660,11 @@ std::pair<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Node, AQUA_NAMESPACE::PH_FLUX_NAMES
 	leftChild.EndIndex = LeftIndex;
 	leftChild.FirstChildIndex = 0;
 	leftChild.SecondChildIndex = 0;
-	leftChild.MinBound = leftBox.Min;
-	leftChild.MaxBound = leftBox.Max;
 
 	rightChild.BeginIndex = LeftIndex;
 	rightChild.EndIndex = parentNode.EndIndex;
 	rightChild.FirstChildIndex = 0;
 	rightChild.SecondChildIndex = 0;
-	rightChild.MinBound = rightBox.Min;
-	rightChild.MaxBound = rightBox.Max;
 
 	EncloseIntoBoundingBox(leftChild);
 	EncloseIntoBoundingBox(rightChild);
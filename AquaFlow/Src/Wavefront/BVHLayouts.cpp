@@ -0,0 +1,431 @@
+#include "Core/Aqpch.h"
+#include "Wavefront/BVHLayouts.h"
+#include "Wavefront/RayIntersection.h"
+
+#include "glm/gtc/packing.hpp"
+
+AQUA_BEGIN
+PH_BEGIN
+
+// Rounds towards negative (roundUp = false) or positive infinity,
+// so the half precision box always encloses the original one
+uint16_t PackHalfConservative(float value, bool roundUp)
+{
+	uint16_t Half = glm::packHalf1x16(value);
+	float Unpacked = glm::unpackHalf1x16(Half);
+
+	if (roundUp ? Unpacked >= value : Unpacked <= value)
+		return Half;
+
+	bool Negative = (Half & 0x8000) != 0;
+
+	// Step a single ulp in the required direction
+	if (roundUp)
+	{
+		if (Half == 0x8000)
+			return 0x0001;
+
+		return Negative ? Half - 1 : Half + 1;
+	}
+
+	if (Half == 0x0000)
+		return 0x8001;
+
+	return Negative ? Half + 1 : Half - 1;
+}
+
+void PackChildBounds(uint32_t* packed, const Node& child)
+{
+	uint16_t Halves[6];
+
+	for (int i = 0; i < 3; i++)
+	{
+		Halves[i] = PackHalfConservative(child.MinBound[i], false);
+		Halves[i + 3] = PackHalfConservative(child.MaxBound[i], true);
+	}
+
+	for (int i = 0; i < 3; i++)
+		packed[i] = static_cast<uint32_t>(Halves[2 * i]) | (static_cast<uint32_t>(Halves[2 * i + 1]) << 16);
+}
+
+float NodeSurfaceArea(const Node& node)
+{
+	glm::vec3 Extent = node.MaxBound - node.MinBound;
+	return 2.0f * (Extent.x * Extent.y + Extent.y * Extent.z + Extent.z * Extent.x);
+}
+
+PH_END
+AQUA_END
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraversalStats& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	TraversalStats::operator+=(const TraversalStats& other)
+{
+	NodeFetches += other.NodeFetches;
+	BoxTests += other.BoxTests;
+	TriangleTests += other.TriangleTests;
+
+	return *this;
+}
+
+std::ostream& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::operator<<(std::ostream& stream, const TraversalStats& stats)
+{
+	stream << "Node fetches: " << stats.NodeFetches << ", Box tests: " << stats.BoxTests
+		<< ", Triangle tests: " << stats.TriangleTests;
+
+	return stream;
+}
+
+std::vector<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::CompactNode> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHConverter::ToCompact(const BVH& bvh)
+{
+	std::vector<CompactNode> Compact(bvh.Nodes.size());
+
+	for (size_t i = 0; i < bvh.Nodes.size(); i++)
+	{
+		const Node& node = bvh.Nodes[i];
+		CompactNode& compact = Compact[i];
+
+		// Leaves point back at the root
+		if (node.FirstChildIndex == 0)
+		{
+			compact.ChildIndex = node.BeginIndex;
+			compact.TriangleCount = node.EndIndex - node.BeginIndex;
+			continue;
+		}
+
+		_STL_ASSERT(node.SecondChildIndex == node.FirstChildIndex + 1,
+			"The compact layout requires the siblings to be next to each other!");
+
+		PackChildBounds(compact.ChildBounds, bvh.Nodes[node.FirstChildIndex]);
+		PackChildBounds(compact.ChildBounds + 3, bvh.Nodes[node.SecondChildIndex]);
+
+		compact.ChildIndex = node.FirstChildIndex;
+		compact.TriangleCount = CompactNode::sInternalNode;
+	}
+
+	return Compact;
+}
+
+template <uint32_t Width>
+std::vector<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WideNode<Width>> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHConverter::ToWide(const BVH& bvh)
+{
+	static_assert(Width >= 2, "A wide node needs at least two slots!");
+
+	std::vector<WideNode<Width>> Wide;
+
+	if (bvh.Nodes.empty())
+		return Wide;
+
+	// Binary node every wide node has been collapsed from
+	std::vector<uint32_t> Sources{ 0 };
+
+	for (size_t i = 0; i < Sources.size(); i++)
+	{
+		const Node& source = bvh.Nodes[Sources[i]];
+
+		uint32_t Slots[Width];
+		uint32_t SlotCount = 0;
+
+		// Only the root can be a leaf here, it becomes the single slot of the root
+		if (source.FirstChildIndex == 0)
+			Slots[SlotCount++] = Sources[i];
+		else
+		{
+			Slots[SlotCount++] = source.FirstChildIndex;
+			Slots[SlotCount++] = source.SecondChildIndex;
+		}
+
+		while (SlotCount < Width)
+		{
+			// The child most likely to be hit is the one worth flattening
+			uint32_t Opened = Width;
+			float LargestArea = -1.0f;
+
+			for (uint32_t j = 0; j < SlotCount; j++)
+			{
+				const Node& child = bvh.Nodes[Slots[j]];
+
+				if (child.FirstChildIndex != 0 && NodeSurfaceArea(child) > LargestArea)
+				{
+					Opened = j;
+					LargestArea = NodeSurfaceArea(child);
+				}
+			}
+
+			if (Opened == Width)
+				break;
+
+			const Node& opened = bvh.Nodes[Slots[Opened]];
+
+			Slots[Opened] = opened.FirstChildIndex;
+			Slots[SlotCount++] = opened.SecondChildIndex;
+		}
+
+		WideNode<Width> wide{};
+
+		for (uint32_t j = 0; j < SlotCount; j++)
+		{
+			const Node& child = bvh.Nodes[Slots[j]];
+
+			wide.MinX[j] = child.MinBound.x;
+			wide.MinY[j] = child.MinBound.y;
+			wide.MinZ[j] = child.MinBound.z;
+
+			wide.MaxX[j] = child.MaxBound.x;
+			wide.MaxY[j] = child.MaxBound.y;
+			wide.MaxZ[j] = child.MaxBound.z;
+
+			if (child.FirstChildIndex == 0)
+			{
+				wide.ChildIndex[j] = child.BeginIndex;
+				wide.TriangleCount[j] = child.EndIndex - child.BeginIndex;
+				continue;
+			}
+
+			wide.ChildIndex[j] = static_cast<uint32_t>(Sources.size());
+			Sources.push_back(Slots[j]);
+		}
+
+		Wide.push_back(wide);
+	}
+
+	return Wide;
+}
+
+template std::vector<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WideNode<4>> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHConverter::ToWide<4>(const BVH&);
+template std::vector<AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WideNode<8>> AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	BVHConverter::ToWide<8>(const BVH&);
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Box AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHConverter::UnpackChildBounds(
+	const CompactNode& node, uint32_t childIndex)
+{
+	const uint32_t* Packed = node.ChildBounds + 3 * childIndex;
+
+	float Values[6];
+
+	for (int i = 0; i < 3; i++)
+	{
+		Values[2 * i] = glm::unpackHalf1x16(static_cast<uint16_t>(Packed[i] & 0xFFFF));
+		Values[2 * i + 1] = glm::unpackHalf1x16(static_cast<uint16_t>(Packed[i] >> 16));
+	}
+
+	return Box(glm::vec3(Values[0], Values[1], Values[2]), glm::vec3(Values[3], Values[4], Values[5]));
+}
+
+float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::TraceBinary(const Ray& ray, TraversalStats& stats) const
+{
+	return WalkBinary(ray, FLT_MAX, false, stats);
+}
+
+bool AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::OccludedBinary(
+	const Ray& ray, float maxDis, TraversalStats& stats) const
+{
+	return WalkBinary(ray, maxDis, true, stats) < maxDis;
+}
+
+float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::TraceCompact(
+	const std::vector<CompactNode>& nodes, const Ray& ray, TraversalStats& stats) const
+{
+	RayQuery query = MakeRayQuery(ray);
+
+	float ClosestHit = FLT_MAX;
+
+	// Node index and the entry distance of its box
+	std::vector<std::pair<uint32_t, float>> NodeStack;
+	NodeStack.emplace_back(0, 0.0f);
+
+	while (!NodeStack.empty())
+	{
+		auto [NodeIdx, Entry] = NodeStack.back();
+		NodeStack.pop_back();
+
+		// The closest hit might have moved since the push
+		if (Entry > ClosestHit)
+			continue;
+
+		const CompactNode& node = nodes[NodeIdx];
+		stats.NodeFetches++;
+
+		if (node.TriangleCount != CompactNode::sInternalNode)
+		{
+			ClosestHit = IntersectTriangles(query, node.ChildIndex,
+				node.ChildIndex + node.TriangleCount, ClosestHit, stats);
+			continue;
+		}
+
+		Box LeftBox = BVHConverter::UnpackChildBounds(node, 0);
+		Box RightBox = BVHConverter::UnpackChildBounds(node, 1);
+
+		float LeftEntry, RightEntry;
+
+		bool LeftHit = IntersectSlab(query, LeftBox.Min, LeftBox.Max, LeftEntry) && LeftEntry <= ClosestHit;
+		bool RightHit = IntersectSlab(query, RightBox.Min, RightBox.Max, RightEntry) && RightEntry <= ClosestHit;
+
+		stats.BoxTests += 2;
+
+		// The nearer child goes on top of the stack
+		if (LeftHit && RightHit && LeftEntry < RightEntry)
+		{
+			NodeStack.emplace_back(node.ChildIndex + 1, RightEntry);
+			NodeStack.emplace_back(node.ChildIndex, LeftEntry);
+			continue;
+		}
+
+		if (LeftHit)
+			NodeStack.emplace_back(node.ChildIndex, LeftEntry);
+
+		if (RightHit)
+			NodeStack.emplace_back(node.ChildIndex + 1, RightEntry);
+	}
+
+	return ClosestHit;
+}
+
+template <uint32_t Width>
+float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::TraceWide(
+	const std::vector<WideNode<Width>>& nodes, const Ray& ray, TraversalStats& stats) const
+{
+	RayQuery query = MakeRayQuery(ray);
+
+	float ClosestHit = FLT_MAX;
+
+	// Node index and the entry distance of its box
+	std::vector<std::pair<uint32_t, float>> NodeStack;
+	NodeStack.emplace_back(0, 0.0f);
+
+	while (!NodeStack.empty())
+	{
+		auto [NodeIdx, Entry] = NodeStack.back();
+		NodeStack.pop_back();
+
+		if (Entry > ClosestHit)
+			continue;
+
+		const WideNode<Width>& node = nodes[NodeIdx];
+		stats.NodeFetches++;
+
+		size_t PushBase = NodeStack.size();
+
+		// Used slots are packed at the front
+		for (uint32_t i = 0; i < Width && node.ChildIndex[i] != WideNode<Width>::sEmptySlot; i++)
+		{
+			float ChildEntry;
+
+			stats.BoxTests++;
+
+			if (!IntersectSlab(query, glm::vec3(node.MinX[i], node.MinY[i], node.MinZ[i]),
+				glm::vec3(node.MaxX[i], node.MaxY[i], node.MaxZ[i]), ChildEntry) || ChildEntry > ClosestHit)
+				continue;
+
+			if (node.TriangleCount[i] != 0)
+			{
+				ClosestHit = IntersectTriangles(query, node.ChildIndex[i],
+					node.ChildIndex[i] + node.TriangleCount[i], ClosestHit, stats);
+				continue;
+			}
+
+			// Same insertion as the shader, the nearest child ends up on top
+			size_t Slot = NodeStack.size();
+			NodeStack.emplace_back();
+
+			while (Slot > PushBase && NodeStack[Slot - 1].second < ChildEntry)
+			{
+				NodeStack[Slot] = NodeStack[Slot - 1];
+				Slot--;
+			}
+
+			NodeStack[Slot] = { node.ChildIndex[i], ChildEntry };
+		}
+	}
+
+	return ClosestHit;
+}
+
+template float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::TraceWide<4>(
+	const std::vector<WideNode<4>>&, const Ray&, TraversalStats&) const;
+template float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::TraceWide<8>(
+	const std::vector<WideNode<8>>&, const Ray&, TraversalStats&) const;
+
+float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::WalkBinary(
+	const Ray& ray, float maxDis, bool anyHit, TraversalStats& stats) const
+{
+	RayQuery query = MakeRayQuery(ray);
+
+	float ClosestHit = maxDis;
+	float Entry;
+
+	stats.NodeFetches++;
+	stats.BoxTests++;
+
+	if (!IntersectSlab(query, mBVH.Nodes[0].MinBound, mBVH.Nodes[0].MaxBound, Entry) || Entry > ClosestHit)
+		return ClosestHit;
+
+	// Node index and the entry distance of its box
+	std::vector<std::pair<uint32_t, float>> NodeStack;
+	NodeStack.emplace_back(0, Entry);
+
+	while (!NodeStack.empty())
+	{
+		auto [NodeIdx, NodeEntry] = NodeStack.back();
+		NodeStack.pop_back();
+
+		if (NodeEntry > ClosestHit)
+			continue;
+
+		const Node& node = mBVH.Nodes[NodeIdx];
+
+		if (node.FirstChildIndex == 0)
+		{
+			ClosestHit = IntersectTriangles(query, node.BeginIndex, node.EndIndex, ClosestHit, stats);
+
+			if (anyHit && ClosestHit < maxDis)
+				return ClosestHit;
+
+			continue;
+		}
+
+		float FirstEntry, SecondEntry;
+
+		stats.NodeFetches += 2;
+		stats.BoxTests += 2;
+
+		bool PushFirst = IntersectSlab(query, mBVH.Nodes[node.FirstChildIndex].MinBound,
+			mBVH.Nodes[node.FirstChildIndex].MaxBound, FirstEntry) && FirstEntry <= ClosestHit;
+		bool PushSecond = IntersectSlab(query, mBVH.Nodes[node.SecondChildIndex].MinBound,
+			mBVH.Nodes[node.SecondChildIndex].MaxBound, SecondEntry) && SecondEntry <= ClosestHit;
+
+		// Same ordering as the shader, the far child goes first
+		bool SecondNear = ray.Direction[node.SplitAxis] < 0.0f;
+
+		if (SecondNear ? PushFirst : PushSecond)
+			NodeStack.emplace_back(SecondNear ? node.FirstChildIndex : node.SecondChildIndex,
+				SecondNear ? FirstEntry : SecondEntry);
+
+		if (SecondNear ? PushSecond : PushFirst)
+			NodeStack.emplace_back(SecondNear ? node.SecondChildIndex : node.FirstChildIndex,
+				SecondNear ? SecondEntry : FirstEntry);
+	}
+
+	return ClosestHit;
+}
+
+float AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVHTraverser::IntersectTriangles(const RayQuery& ray,
+	uint32_t begin, uint32_t end, float closestHit, TraversalStats& stats) const
+{
+	TriangleHit Hit;
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const Face& face = mBVH.Faces[i];
+
+		stats.TriangleTests++;
+
+		if (IntersectTriangle(ray, mBVH.Vertices[face.Indices.x], mBVH.Vertices[face.Indices.y],
+			mBVH.Vertices[face.Indices.z], closestHit, Hit))
+			closestHit = Hit.Distance;
+	}
+
+	return closestHit;
+}
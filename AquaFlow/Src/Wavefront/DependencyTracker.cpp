@@ -0,0 +1,288 @@
+#include "Core/Aqpch.h"
+#include "Wavefront/DependencyTracker.h"
+
+namespace
+{
+	constexpr vk::AccessFlags sWriteAccess = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite;
+
+	constexpr vk::PipelineStageFlags sTrackedStages = vk::PipelineStageFlagBits::eComputeShader |
+		vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eTransfer;
+
+	constexpr vk::PipelineStageFlagBits sStageBits[] = { vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eDrawIndirect, vk::PipelineStageFlagBits::eTransfer };
+
+	void GetStagesAndAccess(AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyAccess access,
+		vk::PipelineStageFlags& stages, vk::AccessFlags& accessFlags)
+	{
+		using AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyAccess;
+
+		switch (access)
+		{
+			case DependencyAccess::eRead:
+				stages = vk::PipelineStageFlagBits::eComputeShader;
+				accessFlags = vk::AccessFlagBits::eShaderRead;
+				break;
+			case DependencyAccess::eWrite:
+				stages = vk::PipelineStageFlagBits::eComputeShader;
+				accessFlags = vk::AccessFlagBits::eShaderWrite;
+				break;
+			case DependencyAccess::eReadWrite:
+				stages = vk::PipelineStageFlagBits::eComputeShader;
+				accessFlags = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+				break;
+			case DependencyAccess::eIndirectRead:
+				stages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect;
+				accessFlags = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eIndirectCommandRead;
+				break;
+			case DependencyAccess::eIndirectReadWrite:
+				stages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect;
+				accessFlags = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite |
+					vk::AccessFlagBits::eIndirectCommandRead;
+				break;
+			case DependencyAccess::eTransferRead:
+				stages = vk::PipelineStageFlagBits::eTransfer;
+				accessFlags = vk::AccessFlagBits::eTransferRead;
+				break;
+			case DependencyAccess::eTransferWrite:
+				stages = vk::PipelineStageFlagBits::eTransfer;
+				accessFlags = vk::AccessFlagBits::eTransferWrite;
+				break;
+			default:
+				_STL_ASSERT(false, "Invalid dependency access!");
+				break;
+		}
+	}
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::StageDependencies& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	StageDependencies::Add(const vkEngine::Image& image, DependencyAccess access)
+{
+	ResourceAccess resource{};
+	resource.Handle = reinterpret_cast<uint64_t>(static_cast<VkImage>(image.GetNativeHandles().Handle));
+	resource.IsImage = true;
+	resource.ImageRange = image.GetSubresourceRanges().front();
+
+	return AddAccess(resource, access);
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::StageDependencies& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	StageDependencies::Merge(const StageDependencies& other)
+{
+	for (const auto& resource : other.mAccesses)
+	{
+		auto found = std::find_if(mAccesses.begin(), mAccesses.end(), [&resource](const ResourceAccess& curr)
+			{ return curr.Handle == resource.Handle && curr.Offset == resource.Offset && curr.Size == resource.Size; });
+
+		if (found == mAccesses.end())
+		{
+			mAccesses.push_back(resource);
+			continue;
+		}
+
+		found->Stages |= resource.Stages;
+		found->Access |= resource.Access;
+	}
+
+	return *this;
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::StageDependencies& AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	StageDependencies::AddAccess(const ResourceAccess& resource, DependencyAccess access)
+{
+	StageDependencies single;
+	single.mAccesses.push_back(resource);
+
+	GetStagesAndAccess(access, single.mAccesses.back().Stages, single.mAccesses.back().Access);
+
+	// The same range twice in a stage, e.g. read through one binding and written through another
+	return Merge(single);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyTracker::Synchronize(
+	vk::CommandBuffer commandBuffer, const StageDependencies& stage)
+{
+	vk::PipelineStageFlags srcStages;
+	vk::PipelineStageFlags dstStages;
+
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+
+	// Whether the stage got a memory dependency on the resource's last write
+	std::vector<bool> madeVisible(stage.mAccesses.size(), false);
+
+	for (size_t i = 0; i < stage.mAccesses.size(); i++)
+	{
+		const auto& resource = stage.mAccesses[i];
+		const ResourceState& state = mStates[{ resource.Handle, resource.Offset, resource.Size }];
+
+		vk::AccessFlags readAccess = resource.Access & ~sWriteAccess;
+		vk::AccessFlags writeAccess = resource.Access & sWriteAccess;
+
+		vk::PipelineStageFlags waitStages;
+		vk::AccessFlags srcAccess;
+		vk::AccessFlags dstAccess;
+
+		bool Written = static_cast<bool>(state.WriteStages);
+
+		// Read after write, the write must be finished and visible to this stage
+		if (readAccess && Written && (!IsOrdered(state.WriteStages, state.WriteIndex, resource.Stages) ||
+			(state.VisibleStages & resource.Stages) != resource.Stages ||
+			(state.VisibleAccess & readAccess) != readAccess))
+		{
+			waitStages |= state.WriteStages;
+			srcAccess |= state.WriteAccess;
+			dstAccess |= readAccess;
+		}
+
+		if (writeAccess)
+		{
+			// Write after write, ordered is enough once the earlier write was made available
+			if (Written && (!IsOrdered(state.WriteStages, state.WriteIndex, resource.Stages) || !state.VisibleAccess))
+			{
+				waitStages |= state.WriteStages;
+				srcAccess |= state.WriteAccess;
+				dstAccess |= writeAccess;
+			}
+
+			// Write after read, only the execution has to be ordered
+			if (state.ReadStages && !IsOrdered(state.ReadStages, state.ReadIndex, resource.Stages))
+				waitStages |= state.ReadStages;
+		}
+
+		if (!waitStages)
+			continue;
+
+		srcStages |= waitStages;
+		dstStages |= resource.Stages;
+
+		madeVisible[i] = static_cast<bool>(srcAccess);
+
+		// Execution only dependencies don't need a barrier of their own
+		if (!srcAccess)
+			continue;
+
+		if (resource.IsImage)
+		{
+			vk::ImageMemoryBarrier imageBarrier{};
+			imageBarrier.setImage(vk::Image(reinterpret_cast<VkImage>(resource.Handle)));
+			imageBarrier.setOldLayout(vk::ImageLayout::eGeneral);
+			imageBarrier.setNewLayout(vk::ImageLayout::eGeneral);
+			imageBarrier.setSrcAccessMask(srcAccess);
+			imageBarrier.setDstAccessMask(dstAccess);
+			imageBarrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+			imageBarrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+			imageBarrier.setSubresourceRange(resource.ImageRange);
+
+			imageBarriers.push_back(imageBarrier);
+			continue;
+		}
+
+		vk::BufferMemoryBarrier bufferBarrier{};
+		bufferBarrier.setBuffer(vk::Buffer(reinterpret_cast<VkBuffer>(resource.Handle)));
+		bufferBarrier.setOffset(resource.Offset);
+		bufferBarrier.setSize(resource.Size);
+		bufferBarrier.setSrcAccessMask(srcAccess);
+		bufferBarrier.setDstAccessMask(dstAccess);
+		bufferBarrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		bufferBarrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+		bufferBarriers.push_back(bufferBarrier);
+	}
+
+	if (srcStages)
+	{
+		commandBuffer.pipelineBarrier(srcStages, dstStages, vk::DependencyFlags(),
+			{}, bufferBarriers, imageBarriers);
+
+		RecordFences(srcStages, dstStages);
+	}
+
+	for (size_t i = 0; i < stage.mAccesses.size(); i++)
+	{
+		const auto& resource = stage.mAccesses[i];
+		ResourceState& state = mStates[{ resource.Handle, resource.Offset, resource.Size }];
+
+		if (resource.Access & sWriteAccess)
+		{
+			state = {};
+			state.WriteStages = resource.Stages;
+			state.WriteAccess = resource.Access & sWriteAccess;
+			state.WriteIndex = mStageIndex;
+
+			continue;
+		}
+
+		if (madeVisible[i])
+		{
+			state.VisibleStages |= resource.Stages;
+			state.VisibleAccess |= resource.Access;
+		}
+
+		state.ReadStages |= resource.Stages;
+		state.ReadIndex = mStageIndex;
+	}
+
+	mStageIndex++;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyTracker::Flush(vk::CommandBuffer commandBuffer)
+{
+	vk::AccessFlags allAccess = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite |
+		vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eTransferRead |
+		vk::AccessFlagBits::eTransferWrite;
+
+	vk::MemoryBarrier memoryBarrier{};
+	memoryBarrier.setSrcAccessMask(allAccess);
+	memoryBarrier.setDstAccessMask(allAccess);
+
+	commandBuffer.pipelineBarrier(sTrackedStages, sTrackedStages, vk::DependencyFlags(),
+		memoryBarrier, {}, {});
+
+	// Everything is finished and visible, nothing left to wait for
+	mStates.clear();
+	RecordFences(sTrackedStages, sTrackedStages);
+
+	mStageIndex++;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyTracker::Reset()
+{
+	mStates.clear();
+	mFences = {};
+	mStageIndex = 1;
+}
+
+bool AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyTracker::IsOrdered(vk::PipelineStageFlags srcStages,
+	uint64_t srcIndex, vk::PipelineStageFlags dstStages) const
+{
+	// Ordered once every pair of stages had a barrier recorded after the access
+	for (size_t src = 0; src < sStageCount; src++)
+	{
+		if (!(srcStages & sStageBits[src]))
+			continue;
+
+		for (size_t dst = 0; dst < sStageCount; dst++)
+		{
+			if ((dstStages & sStageBits[dst]) && mFences[src][dst] <= srcIndex)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::DependencyTracker::RecordFences(
+	vk::PipelineStageFlags srcStages, vk::PipelineStageFlags dstStages)
+{
+	for (size_t src = 0; src < sStageCount; src++)
+	{
+		if (!(srcStages & sStageBits[src]))
+			continue;
+
+		for (size_t dst = 0; dst < sStageCount; dst++)
+		{
+			if (dstStages & sStageBits[dst])
+				mFences[src][dst] = mStageIndex;
+		}
+	}
+}
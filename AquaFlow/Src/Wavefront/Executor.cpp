@@ -20,60 +20,144 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceResult AQUA_NAMESPACE::PH_FLUX_NAMESPACE
 {
 	// Assuming descriptors have been updated in the PH_FLUX_NAMESPACE::WavefrontEstimator::End() function...
 
+	// Seeds, camera view, tile bounds and frame count, the only values changing between the traces
 	UpdateSceneInfo();
 
+	if (!mExecutorInfo->CreateInfo.ReuseRecording)
+	{
+		// Like the host writes of the scene info, this assumes the previous trace is done
+		if (mExecutorInfo->MaterialRecorder)
+			mExecutorInfo->MaterialRecorder->Reset();
+
+		RecordTrace(commandBuffer);
+	}
+	else
+	{
+		// The tile bounds come from the scene info as well
+		if (!mExecutorInfo->TraceRecordingValid)
+			RecordReusableTrace();
+
+		commandBuffer.executeCommands(mExecutorInfo->TraceRecording);
+	}
+
+	glm::ivec2 TileCounts = GetTileCounts();
+	mExecutorInfo->TileIndex = (mExecutorInfo->TileIndex + 1) % static_cast<uint32_t>(TileCounts.x * TileCounts.y);
+
+	// Every pixel got its sample of this frame
+	return mExecutorInfo->TileIndex == 0 ? TraceResult::eComplete : TraceResult::ePending;
+}
+
+glm::ivec2 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::GetTileCounts() const
+{
+	glm::ivec2 TileSize = mExecutorInfo->CreateInfo.TileSize;
+	return (mExecutorInfo->CreateInfo.TargetResolution + TileSize - 1) / TileSize;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordTrace(vk::CommandBuffer commandBuffer)
+{
+	uint32_t bounceLimit = mExecutorInfo->TracingInfo.MaxBounceLimit;
 	uint32_t pRayCount = static_cast<uint32_t>(mExecutorInfo->Rays.GetSize()) / 2;
-	uint32_t pActiveBuffer = 0;
+	uint32_t pActiveBuffer = mExecutorInfo->FirstActiveBuffer;
 	uint32_t pMaterialCount = static_cast<uint32_t>(mExecutorInfo->MaterialResources.size() + 2);
 	glm::uvec3 rayGroupSize = mExecutorInfo->PipelineResources.RayGenerator.GetWorkGroupSize();
 
 	PostProcessFlags postProcess = PostProcessFlagBits::eToneMap;
 	postProcess |= PostProcessFlagBits::eGammaCorrection;
 
-	glm::uvec3 workGroups = { mExecutorInfo->CreateInfo.TileSize.x / rayGroupSize.x,
-		mExecutorInfo->CreateInfo.TileSize.y / rayGroupSize.y, 1 };
+	glm::uvec3 workGroups = { mExecutorInfo->CreateInfo.TargetResolution.x / rayGroupSize.x,
+		mExecutorInfo->CreateInfo.TargetResolution.y / rayGroupSize.y, 1 };
 
-	uint32_t intersectionWorkgroups = pRayCount / 256;
+	uint32_t rayGenWorkgroups = (pRayCount + rayGroupSize.x - 1) / rayGroupSize.x;
 	uint32_t pBounceIdx = 0;
 
+	// The group counts of the queue are sized for the compactor, the indirect sorting stages share them
+	_STL_ASSERT(!mExecutorInfo->CreateInfo.AllowSorting ||
+		mExecutorInfo->PipelineResources.RaySortPreparer.GetWorkGroupSize().x ==
+		mExecutorInfo->PipelineResources.RayCompactor.GetWorkGroupSize().x,
+		"The ray sorting stages must share the work group size of the ray compactor!");
+
+	// Every ray starts out alive
+	ResetRayQueues(commandBuffer, pRayCount);
+
 	// Can be launched separately...
-	ExecuteRayGenerator(commandBuffer, pActiveBuffer, { intersectionWorkgroups, 1, 1 });
+	ExecuteRayGenerator(commandBuffer, pRayCount, pActiveBuffer, { rayGenWorkgroups, 1, 1 });
 
+	// The russian roulette in the material pipelines ends the paths after the MinBounceLimit
+	// Every bounce is recorded, once the paths ran out the indirect dispatches launch no workgroups
 	// Loop begins here...
-	// TODO: implement Russain Roulette...
-	for (uint32_t i = 0; i < mExecutorInfo->TracingInfo.MaxBounceLimit; i++)
+	for (uint32_t i = 0; i < bounceLimit; i++)
 	{
 		// Intersection stage...
 		// Must be launched separately...
-		ExecuteIntersectionTester(commandBuffer, pRayCount, pActiveBuffer, { intersectionWorkgroups , 1, 1});
+		ExecuteIntersectionTester(commandBuffer, pRayCount, pActiveBuffer);
 
 		if (mExecutorInfo->CreateInfo.AllowSorting)
 		{
 			// This stuff is optional...
-			ExecuteRaySortPreparer(commandBuffer, pRayCount, pActiveBuffer, { intersectionWorkgroups , 1, 1 });
-			ExecuteRayCounter(commandBuffer, pRayCount, pMaterialCount, { intersectionWorkgroups , 1, 1 });
+			// Like the intersection, every sorting stage only runs over the live rays of the queue
+			ExecuteRaySortPreparer(commandBuffer, pRayCount, pActiveBuffer);
+			ExecuteRayCounter(commandBuffer, pRayCount, pMaterialCount);
 
-			uint32_t pRayRefBuffer = mExecutorInfo->PipelineResources.SortRecorder->Run(commandBuffer);
+			uint32_t pRayRefBuffer = ExecuteRaySorter(commandBuffer, pMaterialCount);
 
-			ExecuteRaySortFinisher(commandBuffer, pRayCount,
-				pActiveBuffer, 0, { intersectionWorkgroups , 1, 1 });
+			ExecuteRaySortFinisher(commandBuffer, pRayCount, pActiveBuffer, pRayRefBuffer);
 
 			ExecutePrefixSummer(commandBuffer, pMaterialCount);
 
 			pActiveBuffer = 1 - pActiveBuffer;
 		}
 
+		// Every material only dispatches over its own range of the sorted rays
+		ExecuteMaterialQueueBuilder(commandBuffer, pMaterialCount - 2, mExecutorInfo->CreateInfo.AllowSorting);
+
 		// All material pipelines can be launched together...
-		RecordMaterialPipelines(commandBuffer, pRayCount, pBounceIdx, pActiveBuffer, { intersectionWorkgroups , 1, 1 });
+		RecordMaterialPipelines(commandBuffer, pRayCount, pBounceIdx, pActiveBuffer);
+
+		if (mExecutorInfo->CreateInfo.AllowCompaction)
+		{
+			// Survivors move to the front of the other half...
+			ExecuteRayCompactor(commandBuffer, pRayCount, pActiveBuffer);
+
+			pActiveBuffer = 1 - pActiveBuffer;
+		}
 
 		pBounceIdx++;
 	}
 
 	// Luminance mean calculations and post processing can be done together...
-	RecordLuminanceMean(commandBuffer, pRayCount, pActiveBuffer, intersectionWorkgroups);
+	RecordLuminanceMean(commandBuffer, pRayCount, pActiveBuffer);
 	//RecordPostProcess(commandBuffer, postProcess, workGroups);
 
-	return TraceResult::eUnknownError;
+	// The next ray generation writes the other half, so it can overlap the luminance mean
+	mExecutorInfo->FirstActiveBuffer = 1 - pActiveBuffer;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordReusableTrace()
+{
+	// Whoever invalidated the recording had to wait for the device anyway, the descriptors changed too
+	if (mExecutorInfo->TraceRecording)
+		mExecutorInfo->TraceCommandAllocator.Free(mExecutorInfo->TraceRecording);
+
+	mExecutorInfo->TraceRecording = mExecutorInfo->TraceCommandAllocator.Allocate(vk::CommandBufferLevel::eSecondary);
+
+	// Compute only, no render pass to inherit
+	vk::CommandBufferInheritanceInfo inheritanceInfo{};
+
+	vk::CommandBufferBeginInfo beginInfo{};
+	beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+	beginInfo.setPInheritanceInfo(&inheritanceInfo);
+
+	mExecutorInfo->TraceRecording.begin(beginInfo);
+
+	// Replayed after whatever the caller recorded before, the tracker can't know about any of it
+	mExecutorInfo->Dependencies.Flush(mExecutorInfo->TraceRecording);
+	mExecutorInfo->FirstActiveBuffer = 0;
+
+	RecordTrace(mExecutorInfo->TraceRecording);
+
+	mExecutorInfo->TraceRecording.end();
+
+	mExecutorInfo->TraceRecordingValid = true;
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::SetTraceSession(const TraceSession& traceSession)
@@ -93,26 +177,39 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::SetTraceSession(const TraceSes
 
 	pipelines.IntersectionPipeline.mCollisionInfos = mExecutorInfo->CollisionInfos;
 	pipelines.IntersectionPipeline.mRays = mExecutorInfo->Rays;
+	pipelines.IntersectionPipeline.mRayQueues = mExecutorInfo->RayQueues;
 	pipelines.IntersectionPipeline.mSceneInfo = mExecutorInfo->Scene;
 	pipelines.IntersectionPipeline.mGeometryBuffers = traceSession.mSessionInfo->LocalBuffers;
 	pipelines.IntersectionPipeline.mLightInfos = traceSession.mSessionInfo->LightInfos;
 	pipelines.IntersectionPipeline.mLightProps = traceSession.mSessionInfo->LightPropsInfos;
 	pipelines.IntersectionPipeline.mMeshInfos = traceSession.mSessionInfo->MeshInfos;
-
-	pipelines.PrefixSummer.mRefCounts = mExecutorInfo->RefCounts;
+	pipelines.IntersectionPipeline.mInstanceInfos = traceSession.mSessionInfo->InstanceInfos;
+
+	pipelines.OcclusionPipeline.mCollisionInfos = mExecutorInfo->CollisionInfos;
+	pipelines.OcclusionPipeline.mRays = mExecutorInfo->Rays;
+	pipelines.OcclusionPipeline.mRayQueues = mExecutorInfo->RayQueues;
+	pipelines.OcclusionPipeline.mSceneInfo = mExecutorInfo->Scene;
+	pipelines.OcclusionPipeline.mGeometryBuffers = traceSession.mSessionInfo->LocalBuffers;
+	pipelines.OcclusionPipeline.mLightInfos = traceSession.mSessionInfo->LightInfos;
+	pipelines.OcclusionPipeline.mLightProps = traceSession.mSessionInfo->LightPropsInfos;
+	pipelines.OcclusionPipeline.mMeshInfos = traceSession.mSessionInfo->MeshInfos;
+	pipelines.OcclusionPipeline.mInstanceInfos = traceSession.mSessionInfo->InstanceInfos;
 
 	pipelines.RayRefCounter.mRayRefs = mExecutorInfo->RayRefs;
 	pipelines.RayRefCounter.mRefCounts = mExecutorInfo->RefCounts;
+	pipelines.RayRefCounter.mRayQueues = mExecutorInfo->RayQueues;
 
 	pipelines.RaySortPreparer.mCollisionInfos = mExecutorInfo->CollisionInfos;
 	pipelines.RaySortPreparer.mRayRefs = mExecutorInfo->RayRefs;
 	pipelines.RaySortPreparer.mRays = mExecutorInfo->Rays;
 	pipelines.RaySortPreparer.mRaysInfos = mExecutorInfo->RayInfos;
+	pipelines.RaySortPreparer.mRayQueues = mExecutorInfo->RayQueues;
 
 	pipelines.RaySortFinisher.mRays = mExecutorInfo->Rays;
 	pipelines.RaySortFinisher.mRayRefs = mExecutorInfo->RayRefs;
 	pipelines.RaySortFinisher.mCollisionInfos = mExecutorInfo->CollisionInfos;
 	pipelines.RaySortFinisher.mRaysInfos = mExecutorInfo->RayInfos;
+	pipelines.RaySortFinisher.mRayQueues = mExecutorInfo->RayQueues;
 
 	pipelines.InactiveRayShader.mHandle.mRays = mExecutorInfo->Rays;
 	pipelines.InactiveRayShader.mHandle.mRayInfos = mExecutorInfo->RayInfos;
@@ -120,24 +217,48 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::SetTraceSession(const TraceSes
 	pipelines.InactiveRayShader.mHandle.mGeometry = traceSession.mSessionInfo->LocalBuffers;
 	pipelines.InactiveRayShader.mHandle.mLightInfos = traceSession.mSessionInfo->LightInfos;
 	pipelines.InactiveRayShader.mHandle.mLightProps = traceSession.mSessionInfo->LightPropsInfos;
+	pipelines.InactiveRayShader.mHandle.mMaterialQueues = mExecutorInfo->MaterialQueues;
+
+	pipelines.MaterialQueueBuilder.mRayQueues = mExecutorInfo->RayQueues;
+	pipelines.MaterialQueueBuilder.mMaterialQueues = mExecutorInfo->MaterialQueues;
+	pipelines.MaterialQueueBuilder.mMaterialOffsets = mExecutorInfo->RefCounts;
+
+	pipelines.RayCompactor.mRays = mExecutorInfo->Rays;
+	pipelines.RayCompactor.mRayInfos = mExecutorInfo->RayInfos;
+	pipelines.RayCompactor.mRayQueues = mExecutorInfo->RayQueues;
+	pipelines.RayCompactor.mSceneInfo = mExecutorInfo->Scene;
+	pipelines.RayCompactor.mPixelMean = mExecutorInfo->Target.PixelMean;
+	pipelines.RayCompactor.mPresentable = mExecutorInfo->Target.Presentable;
+
+	pipelines.RayQueueFinalizer.mRayQueues = mExecutorInfo->RayQueues;
 
 	pipelines.LuminanceMean.mPixelMean = mExecutorInfo->Target.PixelMean;
 	pipelines.LuminanceMean.mPixelVariance = mExecutorInfo->Target.PixelVariance;
 	pipelines.LuminanceMean.mPresentable = mExecutorInfo->Target.Presentable;
 	pipelines.LuminanceMean.mRays = mExecutorInfo->Rays;
 	pipelines.LuminanceMean.mRayInfos = mExecutorInfo->RayInfos;
+	pipelines.LuminanceMean.mRayQueues = mExecutorInfo->RayQueues;
 	pipelines.LuminanceMean.mSceneInfo = mExecutorInfo->Scene;
 
 	pipelines.PostProcessor.mPresentable = mExecutorInfo->Target.Presentable;
 
+	mExecutorInfo->Dependencies.Reset();
+	mExecutorInfo->FirstActiveBuffer = 0;
+
 	InvalidateMaterialData();
 
+	mExecutorInfo->TraceRecordingValid = false;
+
 	pipelines.RayGenerator.UpdateDescriptors();
 	pipelines.IntersectionPipeline.UpdateDescriptors();
-	pipelines.PrefixSummer.UpdateDescriptors();
+	pipelines.OcclusionPipeline.UpdateDescriptors();
+	pipelines.PrefixSummer.SetBuffer(mExecutorInfo->RefCounts);
 	pipelines.RayRefCounter.UpdateDescriptors();
 	pipelines.RaySortPreparer.UpdateDescriptors();
 	pipelines.RaySortFinisher.UpdateDescriptors();
+	pipelines.MaterialQueueBuilder.UpdateDescriptors();
+	pipelines.RayCompactor.UpdateDescriptors();
+	pipelines.RayQueueFinalizer.UpdateDescriptors();
 	pipelines.LuminanceMean.UpdateDescriptors();
 	pipelines.PostProcessor.UpdateDescriptors();
 	pipelines.InactiveRayShader.UpdateDescriptors();
@@ -155,112 +276,195 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::SetCameraView(const glm::mat4&
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRayGenerator(vk::CommandBuffer commandBuffer,
-	uint32_t pActiveBuffer, glm::uvec3 workGroups)
+	uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups)
 {
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->Rays, DependencyAccess::eWrite, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eWrite, pActiveBuffer * pRayCount, pRayCount);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
 	mExecutorInfo->PipelineResources.RayGenerator.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.RayGenerator.BindPipeline();
 
-	mExecutorInfo->PipelineResources.RayGenerator.SetShaderConstant(
-		"eCompute.Camera.Index_0", mExecutorInfo->TracingInfo.CameraView);
-	
-	mExecutorInfo->PipelineResources.RayGenerator.SetShaderConstant("eCompute.Camera.Index_1", GetRandomNumber());
-	mExecutorInfo->PipelineResources.RayGenerator.SetShaderConstant("eCompute.Camera.Index_2", pActiveBuffer);
+	// The camera view and the seed are read from the scene info
+	mExecutorInfo->PipelineResources.RayGenerator.SetShaderConstant("eCompute.Camera.Index_0", pRayCount);
+	mExecutorInfo->PipelineResources.RayGenerator.SetShaderConstant("eCompute.Camera.Index_1", pActiveBuffer);
 
 	mExecutorInfo->PipelineResources.RayGenerator.Dispatch(workGroups);
 
-	mExecutorInfo->PipelineResources.RayGenerator.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
-	
 	mExecutorInfo->PipelineResources.RayGenerator.End();
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRaySortFinisher(vk::CommandBuffer commandBuffer,
-	uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t pRayRefBuffer, glm::uvec3 workGroups)
+	uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t pRayRefBuffer)
 {
-	mExecutorInfo->PipelineResources.RaySortFinisher.Begin(commandBuffer);
+	size_t Active = pActiveBuffer * pRayCount;
+	size_t Inactive = (1 - pActiveBuffer) * pRayCount;
+
+	// Gathers the active half into the other one in the sorted order
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->RayRefs, DependencyAccess::eRead)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eRead, Active, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eRead, Active, pRayCount)
+		.Add(mExecutorInfo->CollisionInfos, DependencyAccess::eRead, Active, pRayCount)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eWrite, Inactive, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eWrite, Inactive, pRayCount)
+		.Add(mExecutorInfo->CollisionInfos, DependencyAccess::eWrite, Inactive, pRayCount);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
 
-	mExecutorInfo->PipelineResources.RaySortFinisher.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	mExecutorInfo->PipelineResources.RaySortFinisher.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.RaySortFinisher.BindPipeline();
 	mExecutorInfo->PipelineResources.RaySortFinisher.SetShaderConstant("eCompute.RayData.Index_0", pRayCount);
 	mExecutorInfo->PipelineResources.RaySortFinisher.SetShaderConstant("eCompute.RayData.Index_1", pActiveBuffer);
 	mExecutorInfo->PipelineResources.RaySortFinisher.SetShaderConstant("eCompute.RayData.Index_2", pRayRefBuffer);
 
-	mExecutorInfo->PipelineResources.RaySortFinisher.Dispatch(workGroups);
-
-	mExecutorInfo->PipelineResources.RaySortFinisher.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	mExecutorInfo->PipelineResources.RaySortFinisher.DispatchIndirect(
+		mExecutorInfo->RayQueues.GetNativeHandles().Handle);
 
 	mExecutorInfo->PipelineResources.RaySortFinisher.End();
 }
 
-void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecutePrefixSummer(
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRaySorter(
 	vk::CommandBuffer commandBuffer, uint32_t pMaterialCount)
 {
-	mExecutorInfo->PipelineResources.PrefixSummer.Begin(commandBuffer);
+	auto& pipelines = mExecutorInfo->PipelineResources;
 
-	mExecutorInfo->PipelineResources.PrefixSummer.BindPipeline();
-	mExecutorInfo->PipelineResources.PrefixSummer.SetShaderConstant("eCompute.MetaData.Index_0", pMaterialCount);
+	// The sorters synchronize their own passes, only their first one has to wait
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eRead)
+		.Add(mExecutorInfo->RayRefs, DependencyAccess::eReadWrite);
 
-	mExecutorInfo->PipelineResources.PrefixSummer.Dispatch({ 1, 1, 1 });
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
 
-	mExecutorInfo->PipelineResources.PrefixSummer.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	if (mExecutorInfo->CreateInfo.SortAlgorithm == RaySortAlgorithm::eMergeSort || !pipelines.RadixSorter)
+		return pipelines.SortRecorder->Run(commandBuffer);
 
-	mExecutorInfo->PipelineResources.PrefixSummer.End();
+	// The empty, skybox and light ids all land in the bin right after the last material
+	// Reads the live count of the first queue, the references past it stay unsorted
+	return pipelines.RadixSorter.Run(commandBuffer, pMaterialCount - 1);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecutePrefixSummer(
+	vk::CommandBuffer commandBuffer, uint32_t pMaterialCount)
+{
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RefCounts, DependencyAccess::eReadWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
+	mExecutorInfo->PipelineResources.PrefixSummer.Run(commandBuffer, pMaterialCount, PrefixScanType::eExclusive);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRayCounter(vk::CommandBuffer commandBuffer,
-	uint32_t pRayCount, uint32_t pMaterialCount, glm::uvec3 workGroups)
+	uint32_t pRayCount, uint32_t pMaterialCount)
 {
+	// The counter only adds to the buffer, which still holds the offsets of the previous bounce
+	StageDependencies clearDependencies;
+	clearDependencies.Add(mExecutorInfo->RefCounts, DependencyAccess::eTransferWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, clearDependencies);
+
+	commandBuffer.fillBuffer(mExecutorInfo->RefCounts.GetNativeHandles().Handle, 0, VK_WHOLE_SIZE, 0);
+
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->RayRefs, DependencyAccess::eRead)
+		.Add(mExecutorInfo->RefCounts, DependencyAccess::eReadWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
 	mExecutorInfo->PipelineResources.RayRefCounter.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.RayRefCounter.BindPipeline();
 	mExecutorInfo->PipelineResources.RayRefCounter.SetShaderConstant("eCompute.MetaData.Index_0", pRayCount);
 	mExecutorInfo->PipelineResources.RayRefCounter.SetShaderConstant("eCompute.MetaData.Index_1", pMaterialCount);
 
-	mExecutorInfo->PipelineResources.RayRefCounter.Dispatch(workGroups);
-
-	mExecutorInfo->PipelineResources.RayRefCounter.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	mExecutorInfo->PipelineResources.RayRefCounter.DispatchIndirect(
+		mExecutorInfo->RayQueues.GetNativeHandles().Handle);
 
 	mExecutorInfo->PipelineResources.RayRefCounter.End();
 }
 
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteMaterialQueueBuilder(
+	vk::CommandBuffer commandBuffer, uint32_t pMaterialCount, bool sorted)
+{
+	auto& queueBuilder = mExecutorInfo->PipelineResources.MaterialQueueBuilder;
+
+	uint32_t QueueCount = pMaterialCount + 1;
+	uint32_t WorkGroupSize = queueBuilder.GetWorkGroupSize().x;
+
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eRead)
+		.Add(mExecutorInfo->RefCounts, DependencyAccess::eRead)
+		.Add(mExecutorInfo->MaterialQueues, DependencyAccess::eWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
+	queueBuilder.Begin(commandBuffer);
+
+	queueBuilder.BindPipeline();
+	queueBuilder.SetShaderConstant("eCompute.QueueData.Index_0", pMaterialCount);
+	queueBuilder.SetShaderConstant("eCompute.QueueData.Index_1", static_cast<uint32_t>(sorted));
+
+	queueBuilder.Dispatch({ (QueueCount + WorkGroupSize - 1) / WorkGroupSize, 1, 1 });
+
+	queueBuilder.End();
+}
+
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRaySortPreparer(vk::CommandBuffer commandBuffer,
-	uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups)
+	uint32_t pRayCount, uint32_t pActiveBuffer)
 {
-	mExecutorInfo->PipelineResources.RaySortPreparer.Begin(commandBuffer);
+	auto& preparer = mExecutorInfo->PipelineResources.RaySortPreparer;
+
+	// The merge sort has no live count, it sorts the whole half behind the largest key
+	bool SortsLiveRange = mExecutorInfo->CreateInfo.SortAlgorithm == RaySortAlgorithm::eRadixSort &&
+		mExecutorInfo->PipelineResources.RadixSorter;
+
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eRead, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->RayRefs, DependencyAccess::eWrite);
 
-	mExecutorInfo->PipelineResources.RaySortPreparer.BindPipeline();
-	mExecutorInfo->PipelineResources.RaySortPreparer.SetShaderConstant("eCompute.RayData.Index_0", pRayCount);
-	mExecutorInfo->PipelineResources.RaySortPreparer.SetShaderConstant("eCompute.RayData.Index_1", pActiveBuffer);
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
 
-	mExecutorInfo->PipelineResources.RaySortPreparer.Dispatch(workGroups);
+	preparer.Begin(commandBuffer);
 
-	mExecutorInfo->PipelineResources.RaySortPreparer.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	preparer.BindPipeline();
+	preparer.SetShaderConstant("eCompute.RayData.Index_0", pRayCount);
+	preparer.SetShaderConstant("eCompute.RayData.Index_1", pActiveBuffer);
 
-	mExecutorInfo->PipelineResources.RaySortPreparer.End();
+	if (SortsLiveRange)
+		preparer.DispatchIndirect(mExecutorInfo->RayQueues.GetNativeHandles().Handle);
+	else
+	{
+		uint32_t WorkGroupSize = preparer.GetWorkGroupSize().x;
+		preparer.Dispatch({ (pRayCount + WorkGroupSize - 1) / WorkGroupSize, 1, 1 });
+	}
+
+	preparer.End();
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::StageDependencies AQUA_NAMESPACE::PH_FLUX_NAMESPACE::
+	Executor::GetTesterDependencies(uint32_t pRayCount, uint32_t pActiveBuffer) const
+{
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eReadWrite, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->CollisionInfos, DependencyAccess::eReadWrite, pActiveBuffer * pRayCount, pRayCount);
+
+	return dependencies;
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteIntersectionTester(vk::CommandBuffer commandBuffer,
-	uint32_t pRayCount, uint32_t pActiveBuffer, glm::uvec3 workGroups)
+	uint32_t pRayCount, uint32_t pActiveBuffer)
 {
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, GetTesterDependencies(pRayCount, pActiveBuffer));
+
 	mExecutorInfo->PipelineResources.IntersectionPipeline.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.IntersectionPipeline.BindPipeline();
@@ -270,19 +474,107 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteIntersectionTester(vk::
 	mExecutorInfo->PipelineResources.IntersectionPipeline.SetShaderConstant(
 		"eCompute.RayData.Index_1", pActiveBuffer);
 
-	mExecutorInfo->PipelineResources.IntersectionPipeline.Dispatch(workGroups);
-
-	mExecutorInfo->PipelineResources.IntersectionPipeline.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	mExecutorInfo->PipelineResources.IntersectionPipeline.DispatchIndirect(
+		mExecutorInfo->RayQueues.GetNativeHandles().Handle);
 
 	mExecutorInfo->PipelineResources.IntersectionPipeline.End();
 }
 
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteOcclusionTester(vk::CommandBuffer commandBuffer,
+	uint32_t pRayCount, uint32_t pActiveBuffer)
+{
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, GetTesterDependencies(pRayCount, pActiveBuffer));
+
+	mExecutorInfo->PipelineResources.OcclusionPipeline.Begin(commandBuffer);
+
+	mExecutorInfo->PipelineResources.OcclusionPipeline.BindPipeline();
+	mExecutorInfo->PipelineResources.OcclusionPipeline.SetShaderConstant(
+		"eCompute.RayData.Index_0", pRayCount);
+
+	mExecutorInfo->PipelineResources.OcclusionPipeline.SetShaderConstant(
+		"eCompute.RayData.Index_1", pActiveBuffer);
+
+	mExecutorInfo->PipelineResources.OcclusionPipeline.DispatchIndirect(
+		mExecutorInfo->RayQueues.GetNativeHandles().Handle);
+
+	mExecutorInfo->PipelineResources.OcclusionPipeline.End();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ResetRayQueues(
+	vk::CommandBuffer commandBuffer, uint32_t pRayCount)
+{
+	uint32_t WorkGroupSize = mExecutorInfo->PipelineResources.RayCompactor.GetWorkGroupSize().x;
+
+	RayQueue queues[2]{};
+	queues[0].GroupCountX = (pRayCount + WorkGroupSize - 1) / WorkGroupSize;
+	queues[0].RayCount = pRayCount;
+
+	// The previous trace might still read the queues...
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eTransferWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
+	commandBuffer.updateBuffer(mExecutorInfo->RayQueues.GetNativeHandles().Handle, 0, sizeof(queues), queues);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::ExecuteRayCompactor(
+	vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pActiveBuffer)
+{
+	auto& compactor = mExecutorInfo->PipelineResources.RayCompactor;
+	auto& finalizer = mExecutorInfo->PipelineResources.RayQueueFinalizer;
+
+	size_t Active = pActiveBuffer * pRayCount;
+	size_t Inactive = (1 - pActiveBuffer) * pRayCount;
+
+	// Survivors move into the other half, the finished rays go into the image
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectReadWrite)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eRead, Active, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eRead, Active, pRayCount)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eWrite, Inactive, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eWrite, Inactive, pRayCount)
+		.Add(mExecutorInfo->Target.PixelMean, DependencyAccess::eReadWrite)
+		.Add(mExecutorInfo->Target.Presentable, DependencyAccess::eWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
+	compactor.Begin(commandBuffer);
+
+	compactor.BindPipeline();
+	compactor.SetShaderConstant("eCompute.RayData.Index_0", pRayCount);
+	compactor.SetShaderConstant("eCompute.RayData.Index_1", pActiveBuffer);
+
+	compactor.DispatchIndirect(mExecutorInfo->RayQueues.GetNativeHandles().Handle);
+
+	compactor.End();
+
+	StageDependencies finalizerDependencies;
+	finalizerDependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eReadWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, finalizerDependencies);
+
+	finalizer.Begin(commandBuffer);
+
+	finalizer.BindPipeline();
+	finalizer.Dispatch({ 1, 1, 1 });
+
+	finalizer.End();
+}
+
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordLuminanceMean(vk::CommandBuffer commandBuffer,
-	uint32_t pRayCount, uint32_t pActiveBuffer, uint32_t intersectionWorkgroups)
+	uint32_t pRayCount, uint32_t pActiveBuffer)
 {
+	// Only reads the active half, the ray generation of the next trace can run along in the other one
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->RayQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eRead, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eRead, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->Target.PixelMean, DependencyAccess::eReadWrite)
+		.Add(mExecutorInfo->Target.Presentable, DependencyAccess::eWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
 	mExecutorInfo->PipelineResources.LuminanceMean.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.LuminanceMean.BindPipeline();
@@ -290,12 +582,8 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordLuminanceMean(vk::Comman
 	mExecutorInfo->PipelineResources.LuminanceMean.SetShaderConstant("eCompute.ShaderData.Index_0", pRayCount);
 	mExecutorInfo->PipelineResources.LuminanceMean.SetShaderConstant("eCompute.ShaderData.Index_1", pActiveBuffer);
 
-	mExecutorInfo->PipelineResources.LuminanceMean.Dispatch({ intersectionWorkgroups , 1, 1 });
-
-	mExecutorInfo->PipelineResources.LuminanceMean.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+	mExecutorInfo->PipelineResources.LuminanceMean.DispatchIndirect(
+		mExecutorInfo->RayQueues.GetNativeHandles().Handle);
 
 	mExecutorInfo->PipelineResources.LuminanceMean.End();
 }
@@ -303,37 +591,57 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordLuminanceMean(vk::Comman
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordPostProcess(vk::CommandBuffer commandBuffer,
 	PostProcessFlags postProcess, glm::uvec3 workGroups)
 {
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->Target.Presentable, DependencyAccess::eReadWrite);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
+
 	mExecutorInfo->PipelineResources.PostProcessor.Begin(commandBuffer);
 
 	mExecutorInfo->PipelineResources.PostProcessor.BindPipeline();
 
 	mExecutorInfo->PipelineResources.PostProcessor.SetShaderConstant("eCompute.ShaderData.Index_0",
-		mExecutorInfo->CreateInfo.TileSize.x);
+		mExecutorInfo->CreateInfo.TargetResolution.x);
 
 	mExecutorInfo->PipelineResources.PostProcessor.SetShaderConstant("eCompute.ShaderData.Index_1",
-		mExecutorInfo->CreateInfo.TileSize.y);
+		mExecutorInfo->CreateInfo.TargetResolution.y);
 
 	mExecutorInfo->PipelineResources.PostProcessor.SetShaderConstant("eCompute.ShaderData.Index_2",
 		(uint32_t) (int) postProcess);
 
 	mExecutorInfo->PipelineResources.PostProcessor.Dispatch(workGroups);
 
-	mExecutorInfo->PipelineResources.PostProcessor.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
-
 	mExecutorInfo->PipelineResources.PostProcessor.End();
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::UpdateSceneInfo()
 {
 	WavefrontSceneInfo& sceneInfo = mExecutorInfo->TracingSession.mSessionInfo->SceneData;
+
+	bool Restarted = mExecutorInfo->TracingSession.mSessionInfo->State == TraceSessionState::eReady;
+
+	// A new camera or session starts over from the first tile
+	if (Restarted)
+		mExecutorInfo->TileIndex = 0;
+
+	glm::ivec2 TileSize = mExecutorInfo->CreateInfo.TileSize;
+	glm::ivec2 TileCounts = GetTileCounts();
+	int TileIndex = static_cast<int>(mExecutorInfo->TileIndex);
+	glm::ivec2 Tile = { TileIndex % TileCounts.x, TileIndex / TileCounts.x };
+
+	// The edge tiles reach past the image, the ray generation pads them with inactive rays
 	sceneInfo.ImageResolution = mExecutorInfo->CreateInfo.TargetResolution;
-	sceneInfo.MinBound = { 0, 0 };
-	sceneInfo.MaxBound = mExecutorInfo->CreateInfo.TargetResolution;
-	sceneInfo.FrameCount = mExecutorInfo->TracingSession.mSessionInfo->State == TraceSessionState::eReady ?
-		1 : sceneInfo.FrameCount + 1;
+	sceneInfo.MinBound = Tile * TileSize;
+	sceneInfo.MaxBound = sceneInfo.MinBound + TileSize;
+
+	// Every pixel gets a single sample per frame, so the frame only advances with the first tile
+	if (Restarted)
+		sceneInfo.FrameCount = 1;
+	else if (mExecutorInfo->TileIndex == 0)
+		sceneInfo.FrameCount++;
+
+	sceneInfo.FrameSeed = GetRandomNumber();
+	sceneInfo.CameraView = mExecutorInfo->TracingInfo.CameraView;
 
 	mExecutorInfo->Scene.Clear();
 	mExecutorInfo->Scene << sceneInfo;
@@ -341,9 +649,11 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::UpdateSceneInfo()
 	mExecutorInfo->TracingSession.mSessionInfo->State = TraceSessionState::eTracing;
 
 	ShaderData shaderData{};
-	shaderData.uRayCount = (uint32_t) mExecutorInfo->Rays.GetSize();
+	shaderData.uRayCount = (uint32_t) mExecutorInfo->Rays.GetSize() / 2; // Size of a single half
 	shaderData.uSkyboxColor = glm::vec4(0.0f, 1.0f, 1.0f, 0.0f);
 	shaderData.uSkyboxExists = false;
+	shaderData.uMinBounceLimit = mExecutorInfo->TracingInfo.MinBounceLimit;
+	shaderData.uFrameSeed = GetRandomNumber();
 
 	mExecutorInfo->TracingSession.mSessionInfo->ShaderConstData.Clear();
 	mExecutorInfo->TracingSession.mSessionInfo->ShaderConstData << shaderData;
@@ -365,6 +675,7 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::InvalidateMaterialData()
 		curr.mHandle.mLightInfos = TracingSession.LightInfos;
 		curr.mHandle.mLightProps = TracingSession.LightPropsInfos;
 		curr.mHandle.mShaderData = TracingSession.ShaderConstData;
+		curr.mHandle.mMaterialQueues = mExecutorInfo->MaterialQueues;
 	}
 
 	auto& inactivePipeline = mExecutorInfo->PipelineResources.InactiveRayShader.mHandle;
@@ -376,69 +687,66 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::InvalidateMaterialData()
 	inactivePipeline.mLightInfos = TracingSession.LightInfos;
 	inactivePipeline.mLightProps = TracingSession.LightPropsInfos;
 	inactivePipeline.mShaderData = TracingSession.ShaderConstData;
+	inactivePipeline.mMaterialQueues = mExecutorInfo->MaterialQueues;
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::RecordMaterialPipelines(
-	vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pBounceIdx, uint32_t pActiveBuffer, glm::uvec3 workGroups)
+	vk::CommandBuffer commandBuffer, uint32_t pRayCount, uint32_t pBounceIdx, uint32_t pActiveBuffer)
 {
-#define INACTIVE_MATERIAL 1
+	vk::Buffer materialQueues = mExecutorInfo->MaterialQueues.GetNativeHandles().Handle;
+
+	// Every material shades its own rays, so they all share a single barrier
+	StageDependencies dependencies;
+	dependencies.Add(mExecutorInfo->MaterialQueues, DependencyAccess::eIndirectRead)
+		.Add(mExecutorInfo->CollisionInfos, DependencyAccess::eRead, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->Rays, DependencyAccess::eReadWrite, pActiveBuffer * pRayCount, pRayCount)
+		.Add(mExecutorInfo->RayInfos, DependencyAccess::eReadWrite, pActiveBuffer * pRayCount, pRayCount);
+
+	mExecutorInfo->Dependencies.Synchronize(commandBuffer, dependencies);
 
 	uint32_t MaterialCount = static_cast<uint32_t>(mExecutorInfo->MaterialResources.size());
 
-	for (uint32_t i = 0; i < MaterialCount; i++)
+	// The random engine isn't thread safe, the seeds are drawn up front in the order of the recording
+	std::vector<uint32_t> Seeds(MaterialCount + 1);
+
+	for (auto& seed : Seeds)
+		seed = GetRandomNumber();
+
+	// The last item shades the inactive rays
+	auto recordMaterial = [&](vk::CommandBuffer cmd, uint32_t i)
 	{
-		auto pipeline = mExecutorInfo->MaterialResources[i];
-		uint32_t pMaterialRef = i;
+		bool inactive = i == MaterialCount;
+
+		auto pipeline = inactive ? mExecutorInfo->PipelineResources.InactiveRayShader :
+			mExecutorInfo->MaterialResources[i];
+
+		uint32_t pMaterialRef = inactive ? static_cast<uint32_t>(-1) : i;
 
-		pipeline.Begin(commandBuffer);
+		pipeline.Begin(cmd);
 
 		pipeline.BindPipeline();
 
 		pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_0", pMaterialRef);
 		pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_1", pActiveBuffer);
-		pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_2", GetRandomNumber());
-		//pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_3", pBounceIdx);
+		pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_2", Seeds[i]);
+		pipeline.SetShaderConstant("eCompute.ShaderConstants.Index_3", pBounceIdx);
 
-		pipeline.Dispatch(workGroups);
-
-#if !INACTIVE_MATERIAL
-
-#endif
-
-		pipeline.InsertMemoryBarrier(
-			vk::PipelineStageFlagBits::eComputeShader,
-			vk::PipelineStageFlagBits::eComputeShader,
-			vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-			vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+		// Material i reads the queue i + 1, the first one belongs to the inactive rays
+		pipeline.DispatchIndirect(materialQueues, inactive ? 0 : (i + 1) * sizeof(MaterialQueue));
 
 		pipeline.End();
+	};
 
-		std::vector<ShaderData> shaderData;
-
-		pipeline.mHandle.mShaderData >> shaderData;
+	// Every material records through its own pipeline state, so they can go on separate threads
+	// The reused recording is a secondary buffer itself and can't execute the others
+	if (mExecutorInfo->MaterialRecorder && commandBuffer != mExecutorInfo->TraceRecording)
+	{
+		mExecutorInfo->MaterialRecorder->Record(commandBuffer, MaterialCount + 1, recordMaterial);
+		return;
 	}
 
-#if INACTIVE_MATERIAL
-	auto inactivePipeline = mExecutorInfo->PipelineResources.InactiveRayShader;
-
-	inactivePipeline.Begin(commandBuffer);
-
-	inactivePipeline.BindPipeline();
-
-	inactivePipeline.SetShaderConstant("eCompute.ShaderConstants.Index_0", static_cast<uint32_t>(-1));
-	inactivePipeline.SetShaderConstant("eCompute.ShaderConstants.Index_1", pActiveBuffer);
-
-	inactivePipeline.Dispatch(workGroups);
-
-	inactivePipeline.InsertMemoryBarrier(
-		vk::PipelineStageFlagBits::eComputeShader,
-		vk::PipelineStageFlagBits::eComputeShader,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
-		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
-
-	inactivePipeline.End();
-
-#endif
+	for (uint32_t i = 0; i <= MaterialCount; i++)
+		recordMaterial(commandBuffer, i);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor::UpdateMaterialDescriptors()
@@ -78,6 +78,9 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MaterialPipeline::UpdateDescriptors()
 	storageInfo.Buffer = mHandle.mLightProps.GetNativeHandles().Handle;
 	writer.Update({ 0, 8, 0 }, storageInfo);
 
+	storageInfo.Buffer = mHandle.mMaterialQueues.GetNativeHandles().Handle;
+	writer.Update({ 0, 10, 0 }, storageInfo);
+
 	// Updating the shader constants...
 	vkEngine::UniformBufferWriteInfo uniformInfo{};
 	uniformInfo.Buffer = mHandle.mShaderData.GetNativeHandles().Handle;
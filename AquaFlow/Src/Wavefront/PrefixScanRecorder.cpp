@@ -0,0 +1,85 @@
+#include "Core/Aqpch.h"
+#include "Wavefront/PrefixScanRecorder.h"
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanRecorder::PrefixScanRecorder(const PrefixScanInfo& info,
+	vkEngine::ResourcePool manager, const PrefixScanPipeline& scanTiles,
+	const PrefixScanPipeline& scanTileSums, const PrefixScanPipeline& addTileOffsets)
+	: mInfo(info), mScanTilesPass(scanTiles), mScanTileSumsPass(scanTileSums),
+	mAddTileOffsetsPass(addTileOffsets)
+{
+	_STL_ASSERT(mInfo.WorkGroupSize && (mInfo.WorkGroupSize & (mInfo.WorkGroupSize - 1)) == 0,
+		"The prefix scan work group size must be a power of two!");
+
+	vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer;
+	vk::MemoryPropertyFlags memProps = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+	mTileSums = manager.CreateBuffer<uint32_t>(usage, memProps);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanRecorder::SetBuffer(const vkEngine::Buffer<uint32_t>& buffer)
+{
+	mBuffer = buffer;
+
+	mTileSums.Resize(glm::max(GetTileCount(static_cast<uint32_t>(mBuffer.GetSize())), 1u));
+
+	for (PrefixScanPipeline* pipeline : { &mScanTilesPass, &mScanTileSumsPass, &mAddTileOffsetsPass })
+	{
+		pipeline->mElements = mBuffer;
+		pipeline->mTileSums = mTileSums;
+		pipeline->UpdateDescriptors();
+	}
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanRecorder::Run(
+	vk::CommandBuffer commandBuffer, uint32_t elementCount, PrefixScanType type)
+{
+	_STL_ASSERT(elementCount <= mBuffer.GetSize(), "Prefix scan range exceeds the buffer size!");
+
+	if (elementCount == 0)
+		return;
+
+	uint32_t TileCount = GetTileCount(elementCount);
+	uint32_t pInclusive = static_cast<uint32_t>(type);
+
+	RecordStage(commandBuffer, mScanTilesPass, elementCount, pInclusive, TileCount);
+
+	if (TileCount == 1)
+		return;
+
+	RecordStage(commandBuffer, mScanTileSumsPass, TileCount, 0, 1);
+	RecordStage(commandBuffer, mAddTileOffsetsPass, elementCount, pInclusive, TileCount);
+}
+
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanRecorder::GetTileCount(uint32_t elementCount) const
+{
+	uint32_t TileSize = mInfo.WorkGroupSize * mInfo.ItemsPerThread;
+	return (elementCount + TileSize - 1) / TileSize;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanRecorder::RecordStage(vk::CommandBuffer commandBuffer,
+	PrefixScanPipeline& pipeline, uint32_t pBufferSize, uint32_t pInclusive, uint32_t workGroups)
+{
+	/*   Push constant layout...
+	*
+		layout(push_constant) uniform MetaData
+		{
+			uint pBufferSize;
+			uint pInclusive;
+		};
+	*/
+
+	pipeline.Begin(commandBuffer);
+
+	pipeline.BindPipeline();
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_0", pBufferSize);
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_1", pInclusive);
+
+	pipeline.Dispatch({ workGroups, 1, 1 });
+
+	pipeline.InsertMemoryBarrier(
+		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+
+	pipeline.End();
+}
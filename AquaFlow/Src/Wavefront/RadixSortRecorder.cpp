@@ -0,0 +1,108 @@
+#include "Core/Aqpch.h"
+#include "Wavefront/RadixSortRecorder.h"
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::RadixSortRecorder(const RadixSortInfo& info,
+	vkEngine::ResourcePool manager, const RadixSortPipeline& histogram,
+	const RadixSortPipeline& scan, const RadixSortPipeline& scatter)
+	: mInfo(info), mHistogramPass(histogram), mScanPass(scan), mScatterPass(scatter)
+{
+	_STL_ASSERT(mInfo.WorkGroupSize % 32 == 0, "The radix sort work group size must be a multiple of 32!");
+
+	vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer;
+	vk::MemoryPropertyFlags memProps = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+	mGroupCounts = manager.CreateBuffer<uint32_t>(usage, memProps);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::SetBuffers(
+	const RayRefBuffer& buffer, const RayQueueBuffer& elementCounts)
+{
+	mBuffer = buffer;
+	mElementCounts = elementCounts;
+
+	// Every tile keeps one count per digit, enough for a sort of the whole half
+	uint32_t ElementCount = static_cast<uint32_t>(mBuffer.GetSize() / 2);
+	mGroupCounts.Resize(glm::max((1u << mInfo.RadixBits) * GetTileCount(ElementCount), 1u));
+
+	for (RadixSortPipeline* pipeline : { &mHistogramPass, &mScanPass, &mScatterPass })
+	{
+		pipeline->mRayRefs = mBuffer;
+		pipeline->mGroupCounts = mGroupCounts;
+		pipeline->mElementCounts = mElementCounts;
+		pipeline->UpdateDescriptors();
+	}
+}
+
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::Run(vk::CommandBuffer commandBuffer, uint32_t keyCount)
+{
+	uint32_t Size = static_cast<uint32_t>(mBuffer.GetSize() / 2);
+
+	// The tiles past the element count leave right away
+	uint32_t TileCount = GetTileCount(Size);
+	uint32_t PassCount = GetPassCount(keyCount);
+
+	uint32_t ActiveBuffer = 0;
+
+	for (uint32_t passIdx = 0; passIdx < PassCount; passIdx++)
+	{
+		uint32_t Shift = passIdx * mInfo.RadixBits;
+
+		RecordStage(commandBuffer, mHistogramPass, Size, ActiveBuffer, Shift, keyCount, TileCount);
+		RecordStage(commandBuffer, mScanPass, Size, ActiveBuffer, Shift, keyCount, 1);
+		RecordStage(commandBuffer, mScatterPass, Size, ActiveBuffer, Shift, keyCount, TileCount);
+
+		ActiveBuffer = 1 - ActiveBuffer;
+	}
+
+	return ActiveBuffer;
+}
+
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::GetPassCount(uint32_t keyCount) const
+{
+	// A single key (or none) is sorted already
+	uint32_t PassCount = 0;
+
+	for (uint32_t LargestKey = glm::max(keyCount, 1u) - 1; LargestKey != 0; LargestKey >>= mInfo.RadixBits)
+		PassCount++;
+
+	return PassCount;
+}
+
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::GetTileCount(uint32_t elementCount) const
+{
+	uint32_t TileSize = mInfo.WorkGroupSize * mInfo.ItemsPerThread;
+	return (elementCount + TileSize - 1) / TileSize;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortRecorder::RecordStage(vk::CommandBuffer commandBuffer,
+	RadixSortPipeline& pipeline, uint32_t pBufferSize, uint32_t pActiveBuffer,
+	uint32_t pShift, uint32_t pKeyCount, uint32_t workGroups)
+{
+	/*   Push constant layout...
+	*
+		layout(push_constant) uniform MetaData
+		{
+			uint pBufferSize;
+			uint pActiveBuffer;
+			uint pShift;
+			uint pKeyCount;
+		};
+	*/
+
+	pipeline.Begin(commandBuffer);
+
+	pipeline.BindPipeline();
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_0", pBufferSize);
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_1", pActiveBuffer);
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_2", pShift);
+	pipeline.SetShaderConstant("eCompute.MetaData.Index_3", pKeyCount);
+
+	pipeline.Dispatch({ workGroups, 1, 1 });
+
+	pipeline.InsertMemoryBarrier(
+		vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead,
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead);
+
+	pipeline.End();
+}
@@ -0,0 +1,787 @@
+#include "Core/Aqpch.h"
+#include "Wavefront/ReferenceTracer.h"
+#include "Wavefront/RayIntersection.h"
+
+#include "Wavefront/BVHFactory.h"
+
+AQUA_BEGIN
+PH_BEGIN
+
+// Material references and ray states shared with the shaders
+constexpr uint32_t sEmptyMaterialID = uint32_t(-1);
+constexpr uint32_t sSkyboxMaterialID = uint32_t(-2);
+constexpr uint32_t sLightMaterialID = uint32_t(-3);
+constexpr uint32_t sRR_CutoffConst = uint32_t(-4);
+
+constexpr float sPi = 3.14159265358979323846f;
+
+// Same generator as Random.glsl, so the camera rays match the GPU ones bit for bit
+float GetRandom(uint32_t& state)
+{
+	state *= state * 747796405u + 2891336453u;
+	uint32_t Result = ((state >> ((state >> 28) + 4)) ^ state) * 277803737u;
+	Result = (Result >> 22) ^ Result;
+	return static_cast<float>(Result / 4294967295.0);
+}
+
+// HashCombine of BSDF_Samplers.glsl
+uint32_t CombineRandomSeeds(uint32_t seed1, uint32_t seed2)
+{
+	uint32_t Combined = seed1;
+	Combined ^= seed2 + 0x9e3779b9u + (Combined << 6) + (Combined >> 2);
+
+	if (Combined == 0)
+		Combined = 0x9e3770b9u;
+
+	Combined *= Combined * 747796405u + 2891336453u;
+	uint32_t Result = ((Combined >> ((Combined >> 28) + 4)) ^ Combined) * 277803737u;
+	return (Result >> 22) ^ Result;
+}
+
+glm::vec2 SampleOnUnitDisk(uint32_t& state)
+{
+	float Radius = GetRandom(state);
+	float Theta = 2.0f * sPi * GetRandom(state);
+
+	return Radius * glm::vec2(std::cos(Theta), std::sin(Theta));
+}
+
+// Tangent frame built exactly like in Random.glsl
+glm::mat3 MakeTangentFrame(const glm::vec3& normal)
+{
+	glm::vec3 Tangent = std::abs(normal.x) > std::abs(normal.z) ?
+		glm::normalize(glm::vec3(normal.z, 0.0f, -normal.x)) :
+		glm::normalize(glm::vec3(0.0f, -normal.z, normal.y));
+
+	return glm::mat3(Tangent, glm::cross(normal, Tangent), normal);
+}
+
+glm::vec3 SampleCosineWeighted(const glm::vec3& normal, uint32_t& state)
+{
+	float U = GetRandom(state);
+	float V = GetRandom(state);
+	float Phi = U * 2.0f * sPi;
+	float SinTheta = std::sqrt(1.0f - V);
+
+	return glm::normalize(MakeTangentFrame(normal) *
+		glm::vec3(SinTheta * std::cos(Phi), SinTheta * std::sin(Phi), std::sqrt(V)));
+}
+
+// Heitz's visible normal sampling, mirrors SampleHalfVecGGXVNDF_Distribution
+glm::vec3 SampleHalfVecGGXVNDF(const glm::vec3& view, const glm::vec3& normal, float alpha, uint32_t& state)
+{
+	float U1 = GetRandom(state);
+	float U2 = GetRandom(state);
+
+	glm::mat3 TBN = MakeTangentFrame(normal);
+	glm::vec3 ViewLocal = glm::transpose(TBN) * view;
+
+	glm::vec3 StretchedView = glm::normalize(glm::vec3(alpha * ViewLocal.x, alpha * ViewLocal.y, ViewLocal.z));
+
+	glm::vec3 T1 = StretchedView.z < 0.999f ?
+		glm::normalize(glm::cross(StretchedView, glm::vec3(0.0f, 0.0f, 1.0f))) : glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec3 T2 = glm::cross(T1, StretchedView);
+
+	float A = 1.0f / (1.0f + StretchedView.z);
+	float R = std::sqrt(U1);
+	float Phi = U2 < A ? U2 / A * sPi : sPi * (1.0f + (U2 - A) / (1.0f - A));
+	float P1 = R * std::cos(Phi);
+	float P2 = R * std::sin(Phi) * (U2 < A ? 1.0f : StretchedView.z);
+
+	glm::vec3 HalfVec = P1 * T1 + P2 * T2 + std::sqrt(std::max(0.0f, 1.0f - P1 * P1 - P2 * P2)) * StretchedView;
+	HalfVec = glm::normalize(glm::vec3(alpha * HalfVec.x, alpha * HalfVec.y, std::max(0.0f, HalfVec.z)));
+
+	return glm::normalize(TBN * HalfVec);
+}
+
+float DistributionGGX(float NdotH, float alpha)
+{
+	float Alpha2 = alpha * alpha;
+	float Denom = NdotH * NdotH * (Alpha2 - 1.0f) + 1.0f;
+
+	return Alpha2 / (sPi * Denom * Denom);
+}
+
+// Smith masking of a single direction, the one the visible normals are distributed by
+float MaskingGGX(float NdotX, float alpha)
+{
+	float Alpha2 = alpha * alpha;
+	return 2.0f * NdotX / (NdotX + std::sqrt(Alpha2 + (1.0f - Alpha2) * NdotX * NdotX));
+}
+
+struct SurfaceSample
+{
+	glm::vec3 Direction = glm::vec3(0.0f);
+
+	// BSDF times the cosine over the pdf
+	glm::vec3 Weight = glm::vec3(0.0f);
+
+	bool IsInvalid = true;
+};
+
+// Lambert plus GGX Cook-Torrance reflection, the lobe is picked with the same split as
+// GetDiffuseSpecularSamplingSeparation and the weight uses the pdf of the whole mixture
+// Transmission isn't modelled, the reference only covers opaque surfaces
+SurfaceSample SampleCookTorrance(const Material& material, const glm::vec3& view,
+	const glm::vec3& normal, uint32_t& state)
+{
+	SurfaceSample sample;
+
+	float Alpha = glm::clamp(material.Roughness, 1.0e-3f, 1.0f);
+	float Metallic = glm::clamp(material.Metallic, 0.0f, 1.0f);
+
+	float DiffuseProb = glm::clamp((material.Roughness * material.Roughness +
+		1.0f - Metallic * Metallic) / 2.0f, 0.0f, 1.0f);
+
+	float NdotV = std::max(glm::dot(normal, view), 1.0e-6f);
+
+	if (GetRandom(state) < DiffuseProb)
+		sample.Direction = SampleCosineWeighted(normal, state);
+	else
+		sample.Direction = glm::reflect(-view, SampleHalfVecGGXVNDF(view, normal, Alpha, state));
+
+	float NdotL = glm::dot(normal, sample.Direction);
+
+	if (NdotL <= 0.0f)
+		return sample;
+
+	glm::vec3 HalfVec = glm::normalize(view + sample.Direction);
+	float NdotH = std::max(glm::dot(normal, HalfVec), 0.0f);
+	float VdotH = std::max(glm::dot(view, HalfVec), 0.0f);
+
+	float Reflectivity = (material.RefractiveIndex - 1.0f) / (material.RefractiveIndex + 1.0f);
+	glm::vec3 F0 = glm::mix(glm::vec3(Reflectivity * Reflectivity), material.Albedo, Metallic);
+	glm::vec3 Fresnel = F0 + (1.0f - F0) * std::pow(1.0f - VdotH, 5.0f);
+
+	float D = DistributionGGX(NdotH, Alpha);
+	float MaskingV = MaskingGGX(NdotV, Alpha);
+
+	glm::vec3 Specular = Fresnel * D * MaskingV * MaskingGGX(NdotL, Alpha) / (4.0f * NdotV * NdotL);
+	glm::vec3 Diffuse = (1.0f - Fresnel) * (1.0f - Metallic) * material.Albedo / sPi;
+
+	float Pdf = DiffuseProb * NdotL / sPi + (1.0f - DiffuseProb) * D * MaskingV / (4.0f * NdotV);
+
+	if (Pdf <= 0.0f)
+		return sample;
+
+	sample.Weight = (Diffuse + Specular) * NdotL / Pdf;
+	sample.IsInvalid = false;
+
+	return sample;
+}
+
+// Closest hit against a single mesh, children are visited front to back like in FindCollisionNode
+bool IntersectMesh(CollisionInfo& closestHit, const BVH& mesh, const RayQuery& ray, float tolerence)
+{
+	float Entry = 0.0f;
+
+	if (!IntersectSlab(ray, mesh.Nodes[0].MinBound, mesh.Nodes[0].MaxBound, Entry) || Entry > closestHit.RayDis)
+		return false;
+
+	bool FoundCloser = false;
+
+	uint32_t StackIndices[64];
+	float StackDis[64];
+	uint32_t StackPtr = 0;
+
+	StackIndices[StackPtr] = 0;
+	StackDis[StackPtr++] = Entry;
+
+	while (StackPtr != 0)
+	{
+		--StackPtr;
+
+		if (StackDis[StackPtr] > closestHit.RayDis)
+			continue;
+
+		const Node& Current = mesh.Nodes[StackIndices[StackPtr]];
+
+		if (Current.FirstChildIndex == 0)
+		{
+			for (uint32_t i = Current.BeginIndex; i < Current.EndIndex; i++)
+			{
+				const glm::uvec4& Indices = mesh.Faces[i].Indices;
+
+				TriangleHit Hit;
+
+				if (!IntersectTriangle(ray, mesh.Vertices[Indices.x], mesh.Vertices[Indices.y],
+					mesh.Vertices[Indices.z], closestHit.RayDis, Hit, tolerence))
+					continue;
+
+				closestHit.RayDis = Hit.Distance;
+				closestHit.bCoords = Hit.bCoords;
+				closestHit.Normal = Hit.Normal;
+				closestHit.NormalInverted = 1.0f;
+				closestHit.IntersectionPoint = ray.Origin + Hit.Distance * ray.Direction;
+				closestHit.PrimitiveID = i;
+				closestHit.MaterialIndex = mesh.Faces[i].MaterialRef;
+				closestHit.HitOccured = true;
+
+				FoundCloser = true;
+			}
+
+			continue;
+		}
+
+		uint32_t Near = Current.FirstChildIndex;
+		uint32_t Far = Current.SecondChildIndex;
+
+		if (ray.Direction[Current.SplitAxis] < 0.0f)
+			std::swap(Near, Far);
+
+		float NearEntry = 0.0f, FarEntry = 0.0f;
+
+		bool NearHit = IntersectSlab(ray, mesh.Nodes[Near].MinBound, mesh.Nodes[Near].MaxBound, NearEntry) &&
+			NearEntry <= closestHit.RayDis;
+		bool FarHit = IntersectSlab(ray, mesh.Nodes[Far].MinBound, mesh.Nodes[Far].MaxBound, FarEntry) &&
+			FarEntry <= closestHit.RayDis;
+
+		_STL_ASSERT(StackPtr + 2 <= 64, "The BVH is deeper than the reference traversal stack!");
+
+		if (FarHit)
+		{
+			StackIndices[StackPtr] = Far;
+			StackDis[StackPtr++] = FarEntry;
+		}
+
+		if (NearHit)
+		{
+			StackIndices[StackPtr] = Near;
+			StackDis[StackPtr++] = NearEntry;
+		}
+	}
+
+	return FoundCloser;
+}
+
+double ReferenceTraceStats::GetTotalSeconds() const
+{
+	return GenerationSeconds + IntersectionSeconds + ShadingSeconds + AccumulationSeconds;
+}
+
+double ReferenceTraceStats::GetRaysPerSecond() const
+{
+	double Seconds = GetTotalSeconds();
+	return Seconds > 0.0 ? static_cast<double>(RayCount) / Seconds : 0.0;
+}
+
+double ReferenceTraceStats::GetRaysPerSecondPerCore() const
+{
+	return GetRaysPerSecond() / std::max(ThreadCount, 1u);
+}
+
+std::ostream& operator<<(std::ostream& stream, const ReferenceTraceStats& stats)
+{
+	stream << "Rays: " << stats.RayCount << ", Threads: " << stats.ThreadCount << "\n";
+	stream << "Generation: " << stats.GenerationSeconds * 1000.0 << " ms, ";
+	stream << "Intersection: " << stats.IntersectionSeconds * 1000.0 << " ms, ";
+	stream << "Shading: " << stats.ShadingSeconds * 1000.0 << " ms, ";
+	stream << "Accumulation: " << stats.AccumulationSeconds * 1000.0 << " ms\n";
+	stream << "Rays per second: " << stats.GetRaysPerSecond();
+	stream << " (" << stats.GetRaysPerSecondPerCore() << " per core)";
+
+	return stream;
+}
+
+PH_END
+AQUA_END
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::ReferenceTracer(const ReferenceTracerCreateInfo& createInfo)
+	: mCreateInfo(createInfo)
+{
+	if (mCreateInfo.ThreadCount == 0)
+		mCreateInfo.ThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	// The calling thread joins the workers in every stage
+	if (mCreateInfo.ThreadCount > 1)
+		mThreadPool = std::make_shared<ThreadPool>(mCreateInfo.ThreadCount - 1);
+
+	ResetImage();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::Begin(const WavefrontTraceInfo& beginInfo)
+{
+	_STL_ASSERT(!mOpenScope, "Begin method can't be called twice without calling End in between!");
+
+	mTraceInfo = beginInfo;
+
+	mMeshes.clear();
+	mRenderables.clear();
+	mLights.clear();
+	mInstances.clear();
+	mObjectBounds.clear();
+	mTopLevel.clear();
+
+	mOpenScope = true;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::SubmitRenderable(const MeshData& meshData)
+{
+	_STL_ASSERT(mOpenScope, "SubmitRenderable method requires an open scope!");
+
+	mRenderables.push_back(BuildMesh(meshData));
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::SubmitLightSrc(const MeshData& meshData,
+	const glm::vec3& lightIntensity)
+{
+	_STL_ASSERT(mOpenScope, "SubmitLightSrc method requires an open scope!");
+
+	LightSource light;
+	light.MeshIndex = BuildMesh(meshData);
+	light.Color = lightIntensity;
+
+	mLights.push_back(light);
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MeshHandle AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::CreateMeshHandle(
+	const MeshData& meshData)
+{
+	_STL_ASSERT(mOpenScope, "CreateMeshHandle method requires an open scope!");
+
+	// The root index of the handle is the mesh index here
+	MeshHandle handle{};
+	handle.RootIndex = BuildMesh(meshData);
+	handle.MinBound = mMeshes[handle.RootIndex].Nodes[0].MinBound;
+	handle.MaxBound = mMeshes[handle.RootIndex].Nodes[0].MaxBound;
+
+	return handle;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::SubmitInstance(const MeshHandle& mesh,
+	const glm::mat4& transform, uint32_t materialIndex)
+{
+	_STL_ASSERT(mOpenScope, "SubmitInstance method requires an open scope!");
+
+	InstanceInfo instanceInfo{};
+	instanceInfo.ObjectToWorld = transform;
+	instanceInfo.WorldToObject = glm::inverse(transform);
+	instanceInfo.RootIndex = mesh.RootIndex;
+	instanceInfo.MaterialIndex = materialIndex;
+
+	mInstances.push_back(instanceInfo);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::End()
+{
+	_STL_ASSERT(mOpenScope, "End method requires an open scope!");
+
+	for (uint32_t meshIndex : mRenderables)
+		mObjectBounds.emplace_back(mMeshes[meshIndex].Nodes[0].MinBound, mMeshes[meshIndex].Nodes[0].MaxBound);
+
+	for (const auto& light : mLights)
+		mObjectBounds.emplace_back(mMeshes[light.MeshIndex].Nodes[0].MinBound,
+			mMeshes[light.MeshIndex].Nodes[0].MaxBound);
+
+	for (const auto& instance : mInstances)
+	{
+		const Node& Root = mMeshes[instance.RootIndex].Nodes[0];
+
+		glm::vec3 MinBound = glm::vec3(FLT_MAX);
+		glm::vec3 MaxBound = glm::vec3(-FLT_MAX);
+
+		for (int i = 0; i < 8; i++)
+		{
+			glm::vec3 Corner;
+			Corner.x = (i & 1) ? Root.MaxBound.x : Root.MinBound.x;
+			Corner.y = (i & 2) ? Root.MaxBound.y : Root.MinBound.y;
+			Corner.z = (i & 4) ? Root.MaxBound.z : Root.MinBound.z;
+
+			Corner = glm::vec3(instance.ObjectToWorld * glm::vec4(Corner, 1.0f));
+
+			MinBound = glm::min(MinBound, Corner);
+			MaxBound = glm::max(MaxBound, Corner);
+		}
+
+		mObjectBounds.emplace_back(MinBound, MaxBound);
+	}
+
+	if (!mObjectBounds.empty())
+		mTopLevel = BVHFactory::BuildTopLevel(mObjectBounds);
+
+	mOpenScope = false;
+
+	ResetImage();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::SetCameraView(const glm::mat4& view)
+{
+	mTraceInfo.CameraView = view;
+	ResetImage();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::SetCameraSpecs(const PhysicalCamera& camera)
+{
+	mTraceInfo.CameraSpecs = camera;
+	ResetImage();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::ResetImage()
+{
+	glm::ivec2 Resolution = mCreateInfo.TargetResolution;
+
+	mMeanImage.assign(static_cast<size_t>(Resolution.x) * Resolution.y, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	mFrameCount = 0;
+
+	// Restarting the sequence keeps the images reproducible
+	mRandomEngine.seed(0);
+}
+
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTraceStats AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::Trace(
+	uint32_t frameCount)
+{
+	_STL_ASSERT(!mOpenScope, "Trace method can't be called within an open scope!");
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	auto Elapsed = [](Clock::time_point begin)
+	{
+		return std::chrono::duration<double>(Clock::now() - begin).count();
+	};
+
+	ReferenceTraceStats stats;
+	stats.ThreadCount = mCreateInfo.ThreadCount;
+
+	size_t PixelCount = mMeanImage.size();
+
+	mRays.resize(PixelCount);
+	mRayInfos.resize(PixelCount);
+	mCollisionInfos.resize(PixelCount);
+
+	for (uint32_t frameIdx = 0; frameIdx < frameCount; frameIdx++)
+	{
+		mFrameCount++;
+
+		auto Begin = Clock::now();
+		GenerateRays(mRandomEngine());
+		stats.GenerationSeconds += Elapsed(Begin);
+
+		for (uint32_t bounceIdx = 0; bounceIdx < mTraceInfo.MaxBounceLimit; bounceIdx++)
+		{
+			Begin = Clock::now();
+			uint64_t ActiveCount = IntersectRays();
+			stats.IntersectionSeconds += Elapsed(Begin);
+
+			if (ActiveCount == 0)
+				break;
+
+			stats.RayCount += ActiveCount;
+
+			Begin = Clock::now();
+			ShadeRays(bounceIdx, mRandomEngine());
+			stats.ShadingSeconds += Elapsed(Begin);
+		}
+
+		Begin = Clock::now();
+		AccumulateLuminance();
+		stats.AccumulationSeconds += Elapsed(Begin);
+	}
+
+	return stats;
+}
+
+uint32_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::BuildMesh(const MeshData& meshData)
+{
+	// Same build settings as TraceSession::CreateBVH
+	BVHFactory bvhFactory;
+
+	SplitStrategy strategy{};
+	strategy.mSplit = BVHFactory::DefaultSplitFn::sSAH;
+	strategy.mUseSAH = true;
+
+	bvhFactory.SetSplitStrategy(strategy);
+	bvhFactory.SetDepth(mCreateInfo.BVH_Depth);
+	bvhFactory.SetThreadPool(mThreadPool);
+
+	mMeshes.emplace_back(bvhFactory.Build(meshData.aPositions.begin(), meshData.aPositions.end(),
+		meshData.aFaces.begin(), meshData.aFaces.end()));
+
+	return static_cast<uint32_t>(mMeshes.size() - 1);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::GenerateRays(uint32_t frameSeed)
+{
+	glm::ivec2 Resolution = mCreateInfo.TargetResolution;
+	const PhysicalCamera& Camera = mTraceInfo.CameraSpecs;
+
+	glm::vec3 CameraPosition = glm::vec3(glm::inverse(mTraceInfo.CameraView) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	glm::mat3 CameraToWorld = glm::transpose(glm::mat3(mTraceInfo.CameraView));
+
+	ParallelFor(static_cast<uint32_t>(mRays.size()), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			glm::uvec2 Position = glm::uvec2(i % Resolution.x, i / Resolution.x);
+
+			uint32_t RandomSeed = Position.x * frameSeed + Position.y * (Position.x + frameSeed) + frameSeed;
+
+			if (RandomSeed == 0)
+				RandomSeed = 87129283;
+
+			glm::vec2 UV = glm::vec2(Position) / glm::vec2(Resolution) * 2.0f - 1.0f;
+			UV.y = -UV.y;
+
+			glm::vec3 Origin = glm::vec3(0.0f);
+			glm::vec3 Direction = glm::normalize(glm::vec3(UV * Camera.SensorSize, Camera.FocalLength));
+
+			if (Camera.ApertureSize > 0.0f)
+			{
+				glm::vec2 LensSample = SampleOnUnitDisk(RandomSeed);
+				glm::vec3 NewOrigin = Camera.ApertureSize * glm::vec3(LensSample, 0.0f) * 1.0e-3f;
+
+				glm::vec3 FocalPoint = Direction * (Camera.FocalDistance / Direction.z);
+
+				Direction = glm::normalize(FocalPoint - NewOrigin);
+				Origin = NewOrigin;
+			}
+
+			Ray& ray = mRays[i];
+			ray.Origin = CameraPosition + Origin;
+			ray.Direction = CameraToWorld * Direction;
+			ray.MaterialIndex = sEmptyMaterialID;
+			ray.Active = 0;
+
+			RayInfo& rayInfo = mRayInfos[i];
+			rayInfo.ImageCoordinate = Position;
+			rayInfo.Luminance = glm::vec4(1.0f);
+			rayInfo.Throughput = glm::vec4(1.0f);
+		}
+	});
+}
+
+uint64_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::IntersectRays()
+{
+	std::atomic<uint64_t> ActiveCount = 0;
+
+	ParallelFor(static_cast<uint32_t>(mRays.size()), [&](uint32_t begin, uint32_t end)
+	{
+		uint64_t LocalCount = 0;
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Ray& ray = mRays[i];
+
+			if (ray.Active != 0)
+				continue;
+
+			CollisionInfo& ClosestHit = mCollisionInfos[i];
+			CheckForRayCollisions(ClosestHit, ray);
+
+			if (!ClosestHit.HitOccured)
+				ray.MaterialIndex = sSkyboxMaterialID;
+			else
+				ray.MaterialIndex = ClosestHit.IsLightSrc ? sLightMaterialID : ClosestHit.MaterialIndex;
+
+			LocalCount++;
+		}
+
+		ActiveCount += LocalCount;
+	});
+
+	return ActiveCount.load();
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::ShadeRays(uint32_t bounceIdx, uint32_t bounceSeed)
+{
+	bool ApplyRoulette = bounceIdx + 1 >= mTraceInfo.MinBounceLimit;
+
+	ParallelFor(static_cast<uint32_t>(mRays.size()), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Ray& ray = mRays[i];
+
+			if (ray.Active != 0)
+				continue;
+
+			const CollisionInfo& Collision = mCollisionInfos[i];
+			RayInfo& rayInfo = mRayInfos[i];
+
+			if (ray.MaterialIndex == sSkyboxMaterialID)
+			{
+				ray.Active = sSkyboxMaterialID;
+				continue;
+			}
+
+			if (ray.MaterialIndex == sLightMaterialID)
+			{
+				rayInfo.Luminance *= glm::vec4(mLights[Collision.MaterialIndex].Color, 1.0f);
+				ray.Active = sLightMaterialID;
+				continue;
+			}
+
+			uint32_t RandomSeed = CombineRandomSeeds(i, bounceSeed);
+
+			Material material = ray.MaterialIndex < mMaterials.size() ? mMaterials[ray.MaterialIndex] : Material();
+			SurfaceSample sample = SampleCookTorrance(material, -ray.Direction, Collision.Normal, RandomSeed);
+
+			if (sample.IsInvalid)
+			{
+				rayInfo.Luminance = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				ray.Active = sEmptyMaterialID;
+				continue;
+			}
+
+			rayInfo.Luminance *= glm::vec4(sample.Weight, 1.0f);
+
+			// Survival follows the path throughput, so the estimate stays unbiased
+			if (ApplyRoulette)
+			{
+				float Survival = std::min(std::max(std::max(rayInfo.Luminance.r, rayInfo.Luminance.g),
+					rayInfo.Luminance.b), 1.0f);
+
+				if (GetRandom(RandomSeed) >= Survival)
+				{
+					ray.Active = sRR_CutoffConst;
+					continue;
+				}
+
+				rayInfo.Luminance /= glm::vec4(glm::vec3(Survival), 1.0f);
+			}
+
+			ray.Origin = Collision.IntersectionPoint + Collision.Normal * mCreateInfo.Tolerence;
+			ray.Direction = sample.Direction;
+		}
+	});
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::AccumulateLuminance()
+{
+	uint32_t Width = static_cast<uint32_t>(mCreateInfo.TargetResolution.x);
+	float FrameCount = static_cast<float>(mFrameCount);
+
+	ParallelFor(static_cast<uint32_t>(mRays.size()), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const RayInfo& rayInfo = mRayInfos[i];
+
+			glm::vec3 IncomingLight = mRays[i].Active == sLightMaterialID ?
+				glm::vec3(rayInfo.Luminance) : glm::vec3(0.0f);
+
+			glm::vec4& Mean = mMeanImage[rayInfo.ImageCoordinate.y * Width + rayInfo.ImageCoordinate.x];
+
+			glm::vec3 ExistingColor = glm::vec3(Mean);
+			Mean = glm::vec4(ExistingColor + (IncomingLight - ExistingColor) / FrameCount, 1.0f);
+		}
+	});
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::CheckForRayCollisions(
+	CollisionInfo& closestHit, const Ray& ray) const
+{
+	closestHit = CollisionInfo{};
+	closestHit.RayDis = FLT_MAX;
+	closestHit.MaterialIndex = sSkyboxMaterialID;
+	closestHit.HitOccured = false;
+	closestHit.IsLightSrc = false;
+
+	if (mTopLevel.empty())
+		return;
+
+	RayQuery query = MakeRayQuery(ray);
+
+	float Entry = 0.0f;
+
+	if (!IntersectSlab(query, mTopLevel[0].MinBound, mTopLevel[0].MaxBound, Entry))
+		return;
+
+	uint32_t StackIndices[64];
+	float StackDis[64];
+	uint32_t StackPtr = 0;
+
+	StackIndices[StackPtr] = 0;
+	StackDis[StackPtr++] = Entry;
+
+	while (StackPtr != 0)
+	{
+		--StackPtr;
+
+		if (StackDis[StackPtr] > closestHit.RayDis)
+			continue;
+
+		const Node& Current = mTopLevel[StackIndices[StackPtr]];
+
+		if (Current.FirstChildIndex == 0)
+		{
+			for (uint32_t i = Current.BeginIndex; i < Current.EndIndex; i++)
+				TestObjectCollisions(closestHit, ray, i);
+
+			continue;
+		}
+
+		uint32_t Near = Current.FirstChildIndex;
+		uint32_t Far = Current.SecondChildIndex;
+
+		if (query.Direction[Current.SplitAxis] < 0.0f)
+			std::swap(Near, Far);
+
+		float NearEntry = 0.0f, FarEntry = 0.0f;
+
+		bool NearHit = IntersectSlab(query, mTopLevel[Near].MinBound, mTopLevel[Near].MaxBound, NearEntry) &&
+			NearEntry <= closestHit.RayDis;
+		bool FarHit = IntersectSlab(query, mTopLevel[Far].MinBound, mTopLevel[Far].MaxBound, FarEntry) &&
+			FarEntry <= closestHit.RayDis;
+
+		if (FarHit)
+		{
+			StackIndices[StackPtr] = Far;
+			StackDis[StackPtr++] = FarEntry;
+		}
+
+		if (NearHit)
+		{
+			StackIndices[StackPtr] = Near;
+			StackDis[StackPtr++] = NearEntry;
+		}
+	}
+}
+
+bool AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ReferenceTracer::TestObjectCollisions(
+	CollisionInfo& closestHit, const Ray& ray, uint32_t objectIndex) const
+{
+	uint32_t RenderableCount = static_cast<uint32_t>(mRenderables.size());
+	uint32_t SceneObjectCount = RenderableCount + static_cast<uint32_t>(mLights.size());
+
+	if (objectIndex < RenderableCount)
+	{
+		bool FoundCloser = IntersectMesh(closestHit, mMeshes[mRenderables[objectIndex]],
+			MakeRayQuery(ray), mCreateInfo.Tolerence);
+
+		closestHit.IsLightSrc = FoundCloser ? false : closestHit.IsLightSrc;
+		return FoundCloser;
+	}
+
+	if (objectIndex < SceneObjectCount)
+	{
+		uint32_t LightIndex = objectIndex - RenderableCount;
+
+		if (!IntersectMesh(closestHit, mMeshes[mLights[LightIndex].MeshIndex],
+			MakeRayQuery(ray), mCreateInfo.Tolerence))
+			return false;
+
+		// The light shader looks its color up through the material index
+		closestHit.MaterialIndex = LightIndex;
+		closestHit.IsLightSrc = true;
+		return true;
+	}
+
+	const InstanceInfo& instance = mInstances[objectIndex - SceneObjectCount];
+
+	// The direction stays unnormalized, so ray distances mean the same in both spaces
+	Ray LocalRay = ray;
+	LocalRay.Origin = glm::vec3(instance.WorldToObject * glm::vec4(ray.Origin, 1.0f));
+	LocalRay.Direction = glm::vec3(instance.WorldToObject * glm::vec4(ray.Direction, 0.0f));
+
+	if (!IntersectMesh(closestHit, mMeshes[instance.RootIndex], MakeRayQuery(LocalRay), mCreateInfo.Tolerence))
+		return false;
+
+	glm::mat3 NormalTransform = glm::transpose(glm::mat3(instance.WorldToObject));
+
+	closestHit.IntersectionPoint = ray.Origin + closestHit.RayDis * ray.Direction;
+	closestHit.Normal = glm::normalize(NormalTransform * closestHit.Normal);
+	closestHit.MaterialIndex = instance.MaterialIndex;
+	closestHit.IsLightSrc = false;
+
+	return true;
+}
@@ -2,6 +2,7 @@
 #include "Wavefront/TraceSession.h"
 
 #include "Wavefront/BVHFactory.h"
+#include "Wavefront/BVHLayouts.h"
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::Begin(const WavefrontTraceInfo& beginInfo)
 {
@@ -16,6 +17,8 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::Begin(const WavefrontTrace
 	mSessionInfo->SceneData.ResetImage = 1;
 	mSessionInfo->SceneData.MeshCount = 0;
 	mSessionInfo->SceneData.LightCount = 0;
+	mSessionInfo->SceneData.InstanceCount = 0;
+	mSessionInfo->SceneData.NodeLayout = static_cast<uint32_t>(beginInfo.NodeLayout);
 
 	mSessionInfo->State = TraceSessionState::eOpenScope;
 
@@ -29,13 +32,15 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::SubmitRenderable(const Mes
 
 	auto bvhStruct = std::move(CreateBVH(meshData, bvhDepth));
 
-	size_t NodeCount = mSessionInfo->LocalBuffers.Nodes.GetSize();
+	size_t NodeCount = GetMeshNodeCount();
+
+	mSessionInfo->MeshBounds.emplace_back(bvhStruct.Nodes[0].MinBound, bvhStruct.Nodes[0].MaxBound);
 
 	CopyAllVertexAttribs(bvhStruct, meshData, RenderableType::eObject);
 
 	MeshInfo meshInfo{};
 	meshInfo.BeginIndex = static_cast<uint32_t>(NodeCount);
-	meshInfo.EndIndex = static_cast<uint32_t>(mSessionInfo->LocalBuffers.Nodes.GetSize());
+	meshInfo.EndIndex = static_cast<uint32_t>(GetMeshNodeCount());
 
 	mSessionInfo->MeshInfos << std::vector<MeshInfo>({ meshInfo });
 }
@@ -48,7 +53,9 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::SubmitLightSrc(const MeshD
 
 	auto bvhStruct = std::move(CreateBVH(meshData, bvhDepth));
 
-	size_t NodeCount = mSessionInfo->LocalBuffers.Nodes.GetSize();
+	size_t NodeCount = GetMeshNodeCount();
+
+	mSessionInfo->LightBounds.emplace_back(bvhStruct.Nodes[0].MinBound, bvhStruct.Nodes[0].MaxBound);
 
 	CopyAllVertexAttribs(bvhStruct, meshData, RenderableType::eLightSrc);
 
@@ -59,12 +66,47 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::SubmitLightSrc(const MeshD
 
 	LightInfo lightInfo{};
 	lightInfo.BeginIndex = static_cast<uint32_t>(NodeCount);
-	lightInfo.EndIndex = static_cast<uint32_t>(mSessionInfo->SharedBuffers.Nodes.GetSize());
+	lightInfo.EndIndex = static_cast<uint32_t>(GetMeshNodeCount());
 	lightInfo.LightPropIndex = static_cast<uint32_t>(mSessionInfo->LightPropsInfos.GetSize() - 1);
 
 	mSessionInfo->LightInfos << std::vector<LightInfo>({ lightInfo });
 }
 
+AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MeshHandle AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CreateMeshHandle(
+	const MeshData& meshData, uint32_t bvhDepth)
+{
+	_STL_ASSERT(mSessionInfo->State == TraceSessionState::eOpenScope,
+		"CreateMeshHandle method requires the WavefrontEstimator to be in eOpenScope state!");
+
+	auto bvhStruct = std::move(CreateBVH(meshData, bvhDepth));
+
+	MeshHandle handle{};
+	handle.RootIndex = static_cast<uint32_t>(GetMeshNodeCount());
+	handle.MinBound = bvhStruct.Nodes[0].MinBound;
+	handle.MaxBound = bvhStruct.Nodes[0].MaxBound;
+
+	CopyAllVertexAttribs(bvhStruct, meshData, RenderableType::eObject);
+
+	return handle;
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::SubmitInstance(const MeshHandle& mesh,
+	const glm::mat4& transform, uint32_t materialIndex)
+{
+	_STL_ASSERT(mSessionInfo->State == TraceSessionState::eOpenScope,
+		"SubmitInstance method requires the WavefrontEstimator to be in eOpenScope state!");
+
+	InstanceInfo instanceInfo{};
+	instanceInfo.ObjectToWorld = transform;
+	instanceInfo.WorldToObject = glm::inverse(transform);
+	instanceInfo.RootIndex = mesh.RootIndex;
+	instanceInfo.MaterialIndex = materialIndex;
+
+	mSessionInfo->InstanceInfos << instanceInfo;
+
+	mSessionInfo->InstanceBounds.push_back(Box(mesh.MinBound, mesh.MaxBound).Transform(transform));
+}
+
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::End()
 {
 	_STL_ASSERT(mSessionInfo->State == TraceSessionState::eOpenScope,
@@ -72,12 +114,13 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::End()
 
 	mSessionInfo->SceneData.MeshCount = static_cast<uint32_t>(mSessionInfo->MeshInfos.GetSize());
 	mSessionInfo->SceneData.LightCount = static_cast<uint32_t>(mSessionInfo->LightInfos.GetSize());
+	mSessionInfo->SceneData.InstanceCount = static_cast<uint32_t>(mSessionInfo->InstanceInfos.GetSize());
 
-	// TODO: Move the shared buffer into the local buffer data
-	// For now, it has been done in submit functions...
-
+	CreateTopLevelStructure();
 	UpdateSceneBuffers();
 
+	// Every copy of the scope goes out in one submission, the host doesn't wait for it to land
+	mSessionInfo->SceneUploads = mSessionInfo->Staging.Flush();
 
 	mSessionInfo->State = TraceSessionState::eReady;
 }
@@ -121,21 +164,25 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::Cleanup()
 {
 	mSessionInfo->ActiveBuffer = 0;
 
+	// The staged batches land in order, so the copies still in flight can't overwrite the next scope
+	mSessionInfo->Staging.Flush();
+
 	mSessionInfo->LocalBuffers.Vertices.Clear();
 	mSessionInfo->LocalBuffers.Faces.Clear();
 	mSessionInfo->LocalBuffers.Normals.Clear();
 	mSessionInfo->LocalBuffers.TexCoords.Clear();
 	mSessionInfo->LocalBuffers.Nodes.Clear();
-
-	mSessionInfo->SharedBuffers.Vertices.Clear();
-	mSessionInfo->SharedBuffers.Faces.Clear();
-	mSessionInfo->SharedBuffers.Normals.Clear();
-	mSessionInfo->SharedBuffers.TexCoords.Clear();
-	mSessionInfo->SharedBuffers.Nodes.Clear();
+	mSessionInfo->LocalBuffers.CompactNodes.Clear();
+	mSessionInfo->LocalBuffers.WideNodes.Clear();
 
 	mSessionInfo->MeshInfos.Clear();
 	mSessionInfo->LightInfos.Clear();
 	mSessionInfo->LightPropsInfos.Clear();
+	mSessionInfo->InstanceInfos.Clear();
+
+	mSessionInfo->MeshBounds.clear();
+	mSessionInfo->LightBounds.clear();
+	mSessionInfo->InstanceBounds.clear();
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::UpdateSceneBuffers()
@@ -144,17 +191,52 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::UpdateSceneBuffers()
 	mSessionInfo->CameraSpecsBuffer << mSessionInfo->CameraSpecs;
 }
 
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CreateTopLevelStructure()
+{
+	// Meshes take the first leaf indices, the lights and instances follow them
+	std::vector<Box> Bounds = mSessionInfo->MeshBounds;
+	Bounds.insert(Bounds.end(), mSessionInfo->LightBounds.begin(), mSessionInfo->LightBounds.end());
+	Bounds.insert(Bounds.end(), mSessionInfo->InstanceBounds.begin(), mSessionInfo->InstanceBounds.end());
+
+	std::vector<Node> TopLevelNodes = BVHFactory::BuildTopLevel(Bounds);
+
+	size_t NodeCount = mSessionInfo->LocalBuffers.Nodes.GetSize();
+
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.Nodes,
+		TopLevelNodes.begin(), TopLevelNodes.end(),
+		[NodeCount](Node* BeginDevice, Node* EndDevice,
+			Node* BeginHost, Node* EndHost)
+	{
+		while (BeginDevice != EndDevice)
+		{
+			*BeginDevice = *BeginHost;
+
+			// Leaf ranges index the objects, only the child links need the offset
+			BeginDevice->FirstChildIndex += static_cast<uint32_t>(NodeCount);
+			BeginDevice->SecondChildIndex += static_cast<uint32_t>(NodeCount);
+
+			BeginDevice++;
+			BeginHost++;
+		}
+	});
+
+	mSessionInfo->SceneData.TopLevelRoot = static_cast<uint32_t>(NodeCount);
+}
+
 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVH AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CreateBVH(
 	const MeshData& meshData, uint32_t bvhDepth)
 {
 	// TODO: Here, we could use GPU to create BVH tree and store it ahead of time!
 	BVHFactory bvhFactory;
 
+	// The depth only acts as a safety cap, leaves are decided by the SAH cost
 	SplitStrategy strategy{};
-	strategy.mSplit = BVHFactory::DefaultSplitFn::sSpatialSplit;
+	strategy.mSplit = BVHFactory::DefaultSplitFn::sSAH;
+	strategy.mUseSAH = true;
 
 	bvhFactory.SetSplitStrategy(strategy);
 	bvhFactory.SetDepth(bvhDepth);
+	bvhFactory.SetThreadPool(mSessionInfo->BuildPool);
 
 	BVH bvhStruct = bvhFactory.Build(meshData.aPositions.begin(), meshData.aPositions.end(),
 		meshData.aFaces.begin(), meshData.aFaces.end());
@@ -162,14 +244,27 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::BVH AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceS
 	return bvhStruct;
 }
 
+size_t AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::GetMeshNodeCount() const
+{
+	switch (static_cast<BVHNodeLayout>(mSessionInfo->SceneData.NodeLayout))
+	{
+		case BVHNodeLayout::eCompact:
+			return mSessionInfo->LocalBuffers.CompactNodes.GetSize();
+		case BVHNodeLayout::eWide:
+			return mSessionInfo->LocalBuffers.WideNodes.GetSize();
+		default:
+			return mSessionInfo->LocalBuffers.Nodes.GetSize();
+	}
+}
+
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CopyAllVertexAttribs(BVH& bvhStruct,
 	const MeshData& meshData, RenderableType renderableType)
 {
 	size_t VertexCount = mSessionInfo->LocalBuffers.Vertices.GetSize();
 	size_t FaceCount = mSessionInfo->LocalBuffers.Faces.GetSize();
-	size_t NodeCount = mSessionInfo->LocalBuffers.Nodes.GetSize();
+	size_t NodeCount = GetMeshNodeCount();
 
-	CopyVertexAttrib(mSessionInfo->SharedBuffers.Vertices, mSessionInfo->LocalBuffers.Vertices,
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.Vertices,
 		bvhStruct.Vertices.begin(), bvhStruct.Vertices.end(),
 		[](glm::vec4* BeginDevice, glm::vec4* EndDevice,
 			glm::vec3* BeginHost, glm::vec3* EndHost)
@@ -183,7 +278,7 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CopyAllVertexAttribs(BVH&
 		}
 	});
 
-	CopyVertexAttrib(mSessionInfo->SharedBuffers.Normals, mSessionInfo->LocalBuffers.Normals,
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.Normals,
 		meshData.aNormals.begin(), meshData.aNormals.end(),
 		[](glm::vec4* BeginDevice, glm::vec4* EndDevice,
 			const glm::vec3* BeginHost, const glm::vec3* EndHost)
@@ -197,7 +292,7 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CopyAllVertexAttribs(BVH&
 		}
 	});
 
-	CopyVertexAttrib(mSessionInfo->SharedBuffers.TexCoords, mSessionInfo->LocalBuffers.TexCoords,
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.TexCoords,
 		meshData.aTexCoords.begin(), meshData.aTexCoords.end(),
 		[](glm::vec2* BeginDevice, glm::vec2* EndDevice,
 			const glm::vec3* BeginHost, const glm::vec3* EndHost)
@@ -211,7 +306,7 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CopyAllVertexAttribs(BVH&
 		}
 	});
 
-	CopyVertexAttrib(mSessionInfo->SharedBuffers.Faces, mSessionInfo->LocalBuffers.Faces,
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.Faces,
 		bvhStruct.Faces.begin(), bvhStruct.Faces.end(),
 		[VertexCount, renderableType](Face* BeginDevice, Face* EndDevice,
 			Face* BeginHost, Face* EndHost)
@@ -230,7 +325,62 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession::CopyAllVertexAttribs(BVH&
 		}
 	});
 
-	CopyVertexAttrib(mSessionInfo->SharedBuffers.Nodes, mSessionInfo->LocalBuffers.Nodes,
+	if (static_cast<BVHNodeLayout>(mSessionInfo->SceneData.NodeLayout) == BVHNodeLayout::eCompact)
+	{
+		std::vector<CompactNode> CompactNodes = BVHConverter::ToCompact(bvhStruct);
+
+		CopyVertexAttrib(mSessionInfo->LocalBuffers.CompactNodes,
+			CompactNodes.begin(), CompactNodes.end(),
+			[FaceCount, NodeCount](CompactNode* BeginDevice, CompactNode* EndDevice,
+				CompactNode* BeginHost, CompactNode* EndHost)
+		{
+			while (BeginDevice != EndDevice)
+			{
+				*BeginDevice = *BeginHost;
+
+				// Leaves index the faces, internal nodes their left child
+				BeginDevice->ChildIndex += static_cast<uint32_t>(
+					BeginHost->TriangleCount == CompactNode::sInternalNode ? NodeCount : FaceCount);
+
+				BeginDevice++;
+				BeginHost++;
+			}
+		});
+
+		return;
+	}
+
+	if (static_cast<BVHNodeLayout>(mSessionInfo->SceneData.NodeLayout) == BVHNodeLayout::eWide)
+	{
+		std::vector<GPUWideNode> WideNodes = BVHConverter::ToWide<GPUWideNode::sWidth>(bvhStruct);
+
+		CopyVertexAttrib(mSessionInfo->LocalBuffers.WideNodes,
+			WideNodes.begin(), WideNodes.end(),
+			[FaceCount, NodeCount](GPUWideNode* BeginDevice, GPUWideNode* EndDevice,
+				GPUWideNode* BeginHost, GPUWideNode* EndHost)
+		{
+			while (BeginDevice != EndDevice)
+			{
+				*BeginDevice = *BeginHost;
+
+				for (uint32_t i = 0; i < GPUWideNode::sWidth; i++)
+				{
+					if (BeginHost->ChildIndex[i] == GPUWideNode::sEmptySlot)
+						continue;
+
+					BeginDevice->ChildIndex[i] += static_cast<uint32_t>(
+						BeginHost->TriangleCount[i] == 0 ? NodeCount : FaceCount);
+				}
+
+				BeginDevice++;
+				BeginHost++;
+			}
+		});
+
+		return;
+	}
+
+	CopyVertexAttrib(mSessionInfo->LocalBuffers.Nodes,
 		bvhStruct.Nodes.begin(), bvhStruct.Nodes.end(),
 		[FaceCount, NodeCount](Node* BeginDevice, Node* EndDevice,
 			Node* BeginHost, Node* EndHost)
@@ -11,6 +11,12 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::WavefrontEstimator(
 	mPipelineBuilder = mCreateInfo.Context.MakePipelineBuilder();
 	mResourcePool = mCreateInfo.Context.CreateResourcePool();
 
+	uint32_t BuildThreadCount = mCreateInfo.BVH_BuildThreadCount == 0 ?
+		std::thread::hardware_concurrency() : mCreateInfo.BVH_BuildThreadCount;
+
+	if (BuildThreadCount > 1)
+		mBuildPool = std::make_shared<ThreadPool>(BuildThreadCount);
+
 	RetrieveFrontAndBackEndShaders();
 }
 
@@ -20,6 +26,7 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::TraceSession AQUA_NAMESPACE::PH_FLUX_NAMESPAC
 	TraceSession traceSession{};
 
 	traceSession.mSessionInfo = std::make_shared<SessionInfo>();
+	traceSession.mSessionInfo->BuildPool = mBuildPool;
 
 	CreateTraceBuffers(*traceSession.mSessionInfo);
 
@@ -50,6 +57,7 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MaterialPipeline AQUA_NAMESPACE::PH_FLUX_NAME
 	shader.AddMacro("SKYBOX_MATERIAL_ID", std::to_string(static_cast<int>(-2)));
 	shader.AddMacro("LIGHT_MATERIAL_ID", std::to_string(static_cast<int>(-3)));
 	shader.AddMacro("RR_CUTOFF_CONST", std::to_string(static_cast<int>(-4)));
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
 
 	vkEngine::OptimizerFlag flag = vkEngine::OptimizerFlag::eO3;
 
@@ -66,6 +74,10 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MaterialPipeline AQUA_NAMESPACE::PH_FLUX_NAME
 AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::
 	CreateExecutor(const ExecutorCreateInfo& createInfo)
 {
+	_STL_ASSERT(createInfo.TileSize.x > 0 && createInfo.TileSize.y > 0, "Invalid tile size!");
+	_STL_ASSERT((createInfo.TileSize.x * createInfo.TileSize.y) % mCreateInfo.IntersectionWorkgroupSize == 0,
+		"The tile area must be a multiple of the intersection workgroup size!");
+
 	Executor executor{};
 
 	executor.mExecutorInfo = std::make_shared<ExecutionInfo>();
@@ -75,6 +87,20 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::Executor AQUA_NAMESPACE::PH_FLUX_NAMESPACE::W
 	CreateExecutorBuffers(*executor.mExecutorInfo, createInfo);
 	CreateExecutorImages(*executor.mExecutorInfo, createInfo);
 
+	// Secondary command buffers have to come from the family of the primary ones
+	if (createInfo.ReuseRecording)
+		executor.mExecutorInfo->TraceCommandAllocator = mCreateInfo.Context.CreateCommandPools()[createInfo.QueueFamilyIndex];
+
+	// Every recording thread gets its own transient pools, the buffers only live for a single trace
+	if (createInfo.RecordThreadCount > 1)
+	{
+		vkEngine::Context context = mCreateInfo.Context;
+		vkEngine::ThreadCommandPools commandPools([context]() { return context.CreateCommandPools(true); });
+
+		executor.mExecutorInfo->MaterialRecorder = std::make_shared<ParallelRecorder>(
+			std::make_shared<ThreadPool>(createInfo.RecordThreadCount - 1), commandPools, createInfo.QueueFamilyIndex);
+	}
+
 	return executor;
 }
 
@@ -95,16 +121,38 @@ AQUA_NAMESPACE::PH_FLUX_NAMESPACE::ExecutionPipelines AQUA_NAMESPACE::PH_FLUX_NA
 	ExecutionPipelines pipelines;
 
 	pipelines.SortRecorder = std::make_shared<SortRecorder<uint32_t>>(mPipelineBuilder, mResourcePool);
+	pipelines.SortRecorder->InvalidateSorterPipeline(mCreateInfo.IntersectionWorkgroupSize);
+
+	RadixSortInfo radixSortInfo{};
+	radixSortInfo.WorkGroupSize = mCreateInfo.IntersectionWorkgroupSize;
+
+	pipelines.RadixSorter = RadixSortRecorder(radixSortInfo, mResourcePool,
+		mPipelineBuilder.BuildComputePipeline<RadixSortPipeline>(GetRadixSortShader(RadixSortStage::eHistogram, radixSortInfo)),
+		mPipelineBuilder.BuildComputePipeline<RadixSortPipeline>(GetRadixSortShader(RadixSortStage::eScan, radixSortInfo)),
+		mPipelineBuilder.BuildComputePipeline<RadixSortPipeline>(GetRadixSortShader(RadixSortStage::eScatter, radixSortInfo)));
+
+	PrefixScanInfo prefixScanInfo{};
+	prefixScanInfo.WorkGroupSize = mCreateInfo.IntersectionWorkgroupSize;
+
+	pipelines.PrefixSummer = PrefixScanRecorder(prefixScanInfo, mResourcePool,
+		mPipelineBuilder.BuildComputePipeline<PrefixScanPipeline>(GetPrefixScanShader(PrefixScanStage::eScanTiles, prefixScanInfo)),
+		mPipelineBuilder.BuildComputePipeline<PrefixScanPipeline>(GetPrefixScanShader(PrefixScanStage::eScanTileSums, prefixScanInfo)),
+		mPipelineBuilder.BuildComputePipeline<PrefixScanPipeline>(GetPrefixScanShader(PrefixScanStage::eAddTileOffsets, prefixScanInfo)));
 
 	//mRayRefs = mPipelineResources.SortRecorder->GetBuffer();
 
 	pipelines.RayGenerator = mPipelineBuilder.BuildComputePipeline<RayGenerationPipeline>(GetRayGenerationShader());
-	pipelines.IntersectionPipeline = mPipelineBuilder.BuildComputePipeline<IntersectionPipeline>(GetIntersectionShader());
+	pipelines.IntersectionPipeline = mPipelineBuilder.BuildComputePipeline<IntersectionPipeline>(GetIntersectionShader(IntersectionQuery::eClosestHit));
+	pipelines.OcclusionPipeline = mPipelineBuilder.BuildComputePipeline<IntersectionPipeline>(GetIntersectionShader(IntersectionQuery::eOcclusion));
 	pipelines.RaySortPreparer = mPipelineBuilder.BuildComputePipeline<RaySortEpiloguePipeline>(GetRaySortEpilogueShader(RaySortEvent::ePrepare));
 	pipelines.RaySortFinisher = mPipelineBuilder.BuildComputePipeline<RaySortEpiloguePipeline>(GetRaySortEpilogueShader(RaySortEvent::eFinish));
+	pipelines.RaySortFinisher.mSortingEvent = RaySortEvent::eFinish;
 	pipelines.RayRefCounter = mPipelineBuilder.BuildComputePipeline<RayRefCounterPipeline>(GetRayRefCounterShader());
-	pipelines.PrefixSummer = mPipelineBuilder.BuildComputePipeline<PrefixSumPipeline>(GetPrefixSumShader());
 	pipelines.InactiveRayShader = CreateMaterialPipeline(inactiveMaterialInfo);
+	pipelines.MaterialQueueBuilder = mPipelineBuilder.BuildComputePipeline<MaterialQueuePipeline>(GetMaterialQueueShader());
+	pipelines.RayCompactor = mPipelineBuilder.BuildComputePipeline<RayCompactionPipeline>(GetRayCompactionShader(RayCompactionStage::eCompact));
+	pipelines.RayQueueFinalizer = mPipelineBuilder.BuildComputePipeline<RayCompactionPipeline>(GetRayCompactionShader(RayCompactionStage::eFinalize));
+	pipelines.RayQueueFinalizer.mStage = RayCompactionStage::eFinalize;
 	pipelines.LuminanceMean = mPipelineBuilder.BuildComputePipeline<LuminanceMeanPipeline>(GetLuminanceMeanShader());
 	pipelines.PostProcessor = mPipelineBuilder.BuildComputePipeline<PostProcessImagePipeline>(GetPostProcessImageShader());
 
@@ -116,14 +164,9 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::CreateTraceBuffers(S
 	vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer;
 	vk::MemoryPropertyFlags memProps = vk::MemoryPropertyFlagBits::eHostCoherent;
 
-	session.SharedBuffers.Vertices = mResourcePool.CreateBuffer<glm::vec4>(usage, memProps);
-	session.SharedBuffers.Faces = mResourcePool.CreateBuffer<Face>(usage, memProps);
-	session.SharedBuffers.TexCoords = mResourcePool.CreateBuffer<glm::vec2>(usage, memProps);
-	session.SharedBuffers.Normals = mResourcePool.CreateBuffer<glm::vec4>(usage, memProps);
-	session.SharedBuffers.Nodes = mResourcePool.CreateBuffer<Node>(usage, memProps);
-
 	session.MeshInfos = mResourcePool.CreateBuffer<MeshInfo>(usage, memProps);
 	session.LightInfos = mResourcePool.CreateBuffer<LightInfo>(usage, memProps);
+	session.InstanceInfos = mResourcePool.CreateBuffer<InstanceInfo>(usage, memProps);
 	session.LightPropsInfos = mResourcePool.CreateBuffer<LightProperties>(usage, memProps);
 
 	memProps = vk::MemoryPropertyFlagBits::eDeviceLocal;
@@ -133,6 +176,10 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::CreateTraceBuffers(S
 	session.LocalBuffers.TexCoords = mResourcePool.CreateBuffer<glm::vec2>(usage, memProps);
 	session.LocalBuffers.Normals = mResourcePool.CreateBuffer<glm::vec4>(usage, memProps);
 	session.LocalBuffers.Nodes = mResourcePool.CreateBuffer<Node>(usage, memProps);
+	session.LocalBuffers.CompactNodes = mResourcePool.CreateBuffer<CompactNode>(usage, memProps);
+	session.LocalBuffers.WideNodes = mResourcePool.CreateBuffer<GPUWideNode>(usage, memProps);
+
+	session.Staging = mResourcePool.CreateStagingRing();
 
 	// SceneInfo and physical camera buffer is a uniform and should be host coherent...
 	usage = vk::BufferUsageFlagBits::eUniformBuffer;
@@ -164,7 +211,23 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::CreateExecutorBuffer
 
 	executionInfo.RefCounts = mResourcePool.CreateBuffer<uint32_t>(usage, memProps);
 
-	uint32_t RayCount = executorInfo.TargetResolution.x * executorInfo.TargetResolution.y;
+	// Read by the shaders and vkCmdDispatchIndirect
+	executionInfo.RayQueues = mResourcePool.CreateBuffer<RayQueue>(
+		usage | vk::BufferUsageFlagBits::eIndirectBuffer, memProps);
+
+	executionInfo.RayQueues.Resize(2);
+
+	// Sorts the live rays of the first queue only
+	executionInfo.PipelineResources.RadixSorter.SetBuffers(executionInfo.RayRefs, executionInfo.RayQueues);
+
+	executionInfo.MaterialQueues = mResourcePool.CreateBuffer<MaterialQueue>(
+		usage | vk::BufferUsageFlagBits::eIndirectBuffer, memProps);
+
+	// Only the inactive ray shader until the materials are set
+	executionInfo.MaterialQueues.Resize(1);
+
+	// A single tile at a time, the memory doesn't grow with the target resolution
+	uint32_t RayCount = executorInfo.TileSize.x * executorInfo.TileSize.y;
 
 	executionInfo.Rays.Resize(2 * RayCount);
 	executionInfo.RayInfos.Resize(2 * RayCount);
@@ -180,7 +243,8 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::CreateExecutorImages
 	ExecutionInfo& executionInfo, const ExecutorCreateInfo& executorInfo)
 {
 	vkEngine::ImageCreateInfo imageInfo{};
-	imageInfo.Extent = vk::Extent3D(executorInfo.TileSize.x, executorInfo.TileSize.y, 1);
+	// Every tile accumulates into its own region of the full images
+	imageInfo.Extent = vk::Extent3D(executorInfo.TargetResolution.x, executorInfo.TargetResolution.y, 1);
 	imageInfo.Format = vk::Format::eR32G32B32A32Sfloat;
 	imageInfo.MemProps = vk::MemoryPropertyFlagBits::eDeviceLocal;
 	imageInfo.Type = vk::ImageType::e2D;
@@ -221,6 +285,7 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::RetrieveFrontAndBack
 	AddText(mShaderFrontEnd, GetShaderDirectory() + "BSDFs/CommonBSDF.glsl");
 	AddText(mShaderFrontEnd, GetShaderDirectory() + "BSDFs/BSDF_Samplers.glsl");
 	AddText(mShaderFrontEnd, GetShaderDirectory() + "MaterialShaders/ShaderFrontEnd.glsl");
+	AddText(mShaderFrontEnd, GetShaderDirectory() + "Wavefront/RayStreams.glsl");
 	AddText(mShaderFrontEnd, GetShaderDirectory() + "BSDFs/Utils.glsl");
 
 	/* TODO: This is temporary, should be dealt by an import system */
@@ -296,6 +361,8 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRayG
 	vkEngine::PShader shader{};
 
 	shader.AddMacro("WORKGROUP_SIZE", std::to_string(mCreateInfo.RayGenWorkgroupSize.x));
+	shader.AddMacro("EMPTY_MATERIAL_ID", std::to_string(static_cast<int>(-1)));
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
 
 	shader.SetFilepath("eCompute", GetShaderDirectory() + "Wavefront/RayGeneration.comp", vkEngine::OptimizerFlag::eO3);
 
@@ -307,7 +374,7 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRayG
 	return shader;
 }
 
-vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetIntersectionShader()
+vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetIntersectionShader(IntersectionQuery query)
 {
 	vkEngine::PShader shader;
 
@@ -315,6 +382,10 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetInte
 	shader.AddMacro("TOLERENCE", std::to_string(mCreateInfo.Tolerence));
 	shader.AddMacro("MAX_DIS", std::to_string(FLT_MAX));
 	shader.AddMacro("FLT_MAX", std::to_string(FLT_MAX));
+	shader.AddMacro("BVH_WIDTH", std::to_string(GPUWideNode::sWidth));
+	shader.AddMacro("OCCLUSION_QUERY", query == IntersectionQuery::eOcclusion ? "1" : "0");
+	shader.AddMacro("WATERTIGHT_INTERSECTION", mCreateInfo.WatertightIntersection ? "1" : "0");
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
 
 	shader.SetFilepath("eCompute", GetShaderDirectory() + "Wavefront/Intersection.glsl",
 		OPTIMIZE_INTERSECTION == 1 ?
@@ -335,6 +406,7 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRayS
 	vkEngine::PShader shader;
 
 	shader.AddMacro("WORKGROUP_SIZE", std::to_string(mCreateInfo.IntersectionWorkgroupSize));
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
 
 	std::string shaderPath;
 
@@ -381,13 +453,76 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRayR
 	return shader;
 }
 
-vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetPrefixSumShader()
+vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetPrefixScanShader(
+	PrefixScanStage stage, const PrefixScanInfo& scanInfo)
+{
+	vkEngine::PShader shader;
+
+	shader.AddMacro("WORKGROUP_SIZE", std::to_string(scanInfo.WorkGroupSize));
+	shader.AddMacro("ITEMS_PER_THREAD", std::to_string(scanInfo.ItemsPerThread));
+	shader.AddMacro("PREFIX_SCAN_STAGE", std::to_string(static_cast<uint32_t>(stage)));
+
+	shader.SetFilepath("eCompute", GetShaderDirectory() + "Utils/PrefixScan.glsl");
+
+	auto Errors = shader.CompileShaders();
+
+	CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+
+	auto ErrorInfos = checker.GetErrors(Errors);
+	checker.AssertOnError(ErrorInfos);
+
+	return shader;
+}
+
+vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRadixSortShader(
+	RadixSortStage stage, const RadixSortInfo& sortInfo)
+{
+	vkEngine::PShader shader;
+
+	shader.AddMacro("WORKGROUP_SIZE", std::to_string(sortInfo.WorkGroupSize));
+	shader.AddMacro("ITEMS_PER_THREAD", std::to_string(sortInfo.ItemsPerThread));
+	shader.AddMacro("RADIX_BITS", std::to_string(sortInfo.RadixBits));
+	shader.AddMacro("RADIX_SORT_STAGE", std::to_string(static_cast<uint32_t>(stage)));
+
+	shader.SetFilepath("eCompute", GetShaderDirectory() + "Utils/RadixSort.glsl");
+
+	auto Errors = shader.CompileShaders();
+
+	CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+
+	auto ErrorInfos = checker.GetErrors(Errors);
+	checker.AssertOnError(ErrorInfos);
+
+	return shader;
+}
+
+vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetRayCompactionShader(RayCompactionStage stage)
 {
 	vkEngine::PShader shader;
 
 	shader.AddMacro("WORKGROUP_SIZE", std::to_string(mCreateInfo.IntersectionWorkgroupSize));
-	shader.SetFilepath("eCompute", GetShaderDirectory() + "Utils/PrefixSum.glsl");
-	
+	shader.AddMacro("RAY_COMPACTION_STAGE", std::to_string(static_cast<uint32_t>(stage)));
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
+
+	shader.SetFilepath("eCompute", GetShaderDirectory() + "Wavefront/CompactRays.glsl");
+
+	auto Errors = shader.CompileShaders();
+
+	CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+
+	auto ErrorInfos = checker.GetErrors(Errors);
+	checker.AssertOnError(ErrorInfos);
+
+	return shader;
+}
+
+vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetMaterialQueueShader()
+{
+	vkEngine::PShader shader;
+
+	shader.AddMacro("WORKGROUP_SIZE", std::to_string(mCreateInfo.IntersectionWorkgroupSize));
+	shader.SetFilepath("eCompute", GetShaderDirectory() + "Wavefront/BuildMaterialQueues.glsl");
+
 	auto Errors = shader.CompileShaders();
 
 	CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
@@ -403,6 +538,7 @@ vkEngine::PShader AQUA_NAMESPACE::PH_FLUX_NAMESPACE::WavefrontEstimator::GetLumi
 	vkEngine::PShader shader;
 
 	shader.AddMacro("WORKGROUP_SIZE", std::to_string(mCreateInfo.IntersectionWorkgroupSize));
+	shader.AddMacro("RAY_SOA_LAYOUT", mCreateInfo.RayLayout == RayBufferLayout::eStructOfArrays ? "1" : "0");
 	shader.SetFilepath("eCompute", GetShaderDirectory() + "Wavefront/LuminanceMean.glsl");
 	
 	auto Errors = shader.CompileShaders();
@@ -22,6 +22,11 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::IntersectionPipeline::UpdateDescriptors(
 
 	writer.Update({ 0, 2, 0 }, collisionInfo);
 
+	vkEngine::StorageBufferWriteInfo rayQueues{};
+	rayQueues.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 5, 0 }, rayQueues);
+
 	vkEngine::UniformBufferWriteInfo sceneInfo{};
 	sceneInfo.Buffer = mSceneInfo.GetNativeHandles().Handle;
 
@@ -76,6 +81,21 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::IntersectionPipeline::UpdateGeometryBuff
 		LightInfo sLightInfos[];
 	};
 
+	layout(std430, set = 1, binding = 11) readonly buffer InstanceInfoBuffer
+	{
+		InstanceInfo sInstanceInfos[];
+	};
+
+	layout(std430, set = 1, binding = 12) readonly buffer CompactNodeBuffer
+	{
+		CompactNode sCompactNodes[];
+	};
+
+	layout(std430, set = 1, binding = 13) readonly buffer WideNodeBuffer
+	{
+		WideNode sWideNodes[];
+	};
+
 */
 
 	vkEngine::StorageBufferWriteInfo storageInfo{};
@@ -97,6 +117,12 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::IntersectionPipeline::UpdateGeometryBuff
 	storageInfo.Buffer = mGeometryBuffers.Nodes.GetNativeHandles().Handle;
 	writer.Update({ 1, 4, 0 }, storageInfo);
 
+	storageInfo.Buffer = mGeometryBuffers.CompactNodes.GetNativeHandles().Handle;
+	writer.Update({ 1, 12, 0 }, storageInfo);
+
+	storageInfo.Buffer = mGeometryBuffers.WideNodes.GetNativeHandles().Handle;
+	writer.Update({ 1, 13, 0 }, storageInfo);
+
 	// Meta data about vertices and light sources
 	storageInfo.Buffer = mLightProps.GetNativeHandles().Handle;
 	//writer.Update({ 1, 6, 0 }, storageInfo);
@@ -106,6 +132,9 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::IntersectionPipeline::UpdateGeometryBuff
 
 	storageInfo.Buffer = mLightInfos.GetNativeHandles().Handle;
 	writer.Update({ 1, 8, 0 }, storageInfo);
+
+	storageInfo.Buffer = mInstanceInfos.GetNativeHandles().Handle;
+	writer.Update({ 1, 11, 0 }, storageInfo);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RaySortEpiloguePipeline::UpdateDescriptors()
@@ -123,6 +152,11 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RaySortEpiloguePipeline::UpdateDescripto
 		writer.Update({ 0, 4, 0 }, collisionInfo);
 	}
 
+	vkEngine::StorageBufferWriteInfo rayQueues{};
+	rayQueues.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 5, 0 }, rayQueues);
+
 	vkEngine::StorageBufferWriteInfo rayBufferWrite{};
 	rayBufferWrite.Buffer = mRays.GetNativeHandles().Handle;
 
@@ -147,16 +181,46 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RayRefCounterPipeline::UpdateDescriptors
 	counts.Buffer = mRefCounts.GetNativeHandles().Handle;
 
 	writer.Update({ 0, 1, 0 }, counts);
+
+	vkEngine::StorageBufferWriteInfo rayQueues{};
+	rayQueues.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 2, 0 }, rayQueues);
 }
 
-void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixSumPipeline::UpdateDescriptors()
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RadixSortPipeline::UpdateDescriptors()
 {
 	vkEngine::DescriptorWriter& writer = this->GetDescriptorWriter();
 
+	vkEngine::StorageBufferWriteInfo rayRefs{};
+	rayRefs.Buffer = mRayRefs.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 0, 0 }, rayRefs);
+
 	vkEngine::StorageBufferWriteInfo counts{};
-	counts.Buffer = mRefCounts.GetNativeHandles().Handle;
+	counts.Buffer = mGroupCounts.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 1, 0 }, counts);
+
+	vkEngine::StorageBufferWriteInfo elementCounts{};
+	elementCounts.Buffer = mElementCounts.GetNativeHandles().Handle;
 
-	writer.Update({ 0, 0, 0 }, counts);
+	writer.Update({ 0, 2, 0 }, elementCounts);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PrefixScanPipeline::UpdateDescriptors()
+{
+	vkEngine::DescriptorWriter& writer = this->GetDescriptorWriter();
+
+	vkEngine::StorageBufferWriteInfo elements{};
+	elements.Buffer = mElements.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 0, 0 }, elements);
+
+	vkEngine::StorageBufferWriteInfo tileSums{};
+	tileSums.Buffer = mTileSums.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 1, 0 }, tileSums);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::LuminanceMeanPipeline::UpdateDescriptors()
@@ -184,10 +248,70 @@ void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::LuminanceMeanPipeline::UpdateDescriptors
 
 	writer.Update({ 0, 4, 0 }, rayInfos);
 
+	rayInfos.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 5, 0 }, rayInfos);
+
+	vkEngine::UniformBufferWriteInfo sceneInfo{};
+	sceneInfo.Buffer = mSceneInfo.GetNativeHandles().Handle;
+
+	writer.Update({ 1, 9, 0 }, sceneInfo);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::RayCompactionPipeline::UpdateDescriptors()
+{
+	vkEngine::DescriptorWriter& writer = this->GetDescriptorWriter();
+
+	vkEngine::StorageBufferWriteInfo rayQueues{};
+	rayQueues.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 5, 0 }, rayQueues);
+
+	if (mStage == RayCompactionStage::eFinalize)
+		return;
+
+	vkEngine::StorageBufferWriteInfo rayBuffers{};
+	rayBuffers.Buffer = mRays.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 0, 0 }, rayBuffers);
+
+	rayBuffers.Buffer = mRayInfos.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 4, 0 }, rayBuffers);
+
 	vkEngine::UniformBufferWriteInfo sceneInfo{};
 	sceneInfo.Buffer = mSceneInfo.GetNativeHandles().Handle;
 
 	writer.Update({ 1, 9, 0 }, sceneInfo);
+
+	vkEngine::StorageImageWriteInfo mean{};
+	mean.ImageLayout = vk::ImageLayout::eGeneral;
+
+	mean.ImageView = mPresentable.GetIdentityImageView();
+	writer.Update({ 2, 0, 0 }, mean);
+
+	mean.ImageView = mPixelMean.GetIdentityImageView();
+	writer.Update({ 2, 1, 0 }, mean);
+}
+
+void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::MaterialQueuePipeline::UpdateDescriptors()
+{
+	vkEngine::DescriptorWriter& writer = this->GetDescriptorWriter();
+
+	vkEngine::StorageBufferWriteInfo rayQueues{};
+	rayQueues.Buffer = mRayQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 5, 0 }, rayQueues);
+
+	vkEngine::StorageBufferWriteInfo materialQueues{};
+	materialQueues.Buffer = mMaterialQueues.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 6, 0 }, materialQueues);
+
+	vkEngine::StorageBufferWriteInfo materialOffsets{};
+	materialOffsets.Buffer = mMaterialOffsets.GetNativeHandles().Handle;
+
+	writer.Update({ 0, 7, 0 }, materialOffsets);
 }
 
 void AQUA_NAMESPACE::PH_FLUX_NAMESPACE::PostProcessImagePipeline::UpdateDescriptors()
@@ -0,0 +1,70 @@
+#include "TestFramework.h"
+#include <cstring>
+
+namespace
+{
+	uint32_t sFailedChecks = 0;
+}
+
+std::vector<Tests::TestCase>& Tests::GetRegistry()
+{
+	// Constructed on first use, the registrars run during static initialization
+	static std::vector<TestCase> registry;
+	return registry;
+}
+
+void Tests::ReportFailure(const char* file, int line, const std::string& message)
+{
+	std::cerr << "    " << file << "(" << line << "): CHECK failed: " << message << std::endl;
+	sFailedChecks++;
+}
+
+// Usage: Tests [--bench] [--device] [name filter]
+// --bench adds the benchmarks, --device adds the tests that need a Vulkan device
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+	bool runDeviceTests = false;
+	std::string filter;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+			runBenchmarks = true;
+		else if (std::strcmp(argv[i], "--device") == 0)
+			runDeviceTests = true;
+		else
+			filter = argv[i];
+	}
+
+	uint32_t runCount = 0;
+	uint32_t failedCount = 0;
+
+	for (const auto& test : Tests::GetRegistry())
+	{
+		if (test.Kind == Tests::TestKind::eBenchmark && !runBenchmarks)
+			continue;
+
+		if (test.Kind == Tests::TestKind::eDevice && !runDeviceTests)
+			continue;
+
+		if (!filter.empty() && test.Name.find(filter) == std::string::npos)
+			continue;
+
+		std::cout << "[ RUN  ] " << test.Name << std::endl;
+
+		uint32_t failedBefore = sFailedChecks;
+		double elapsed = Tests::MeasureMs(test.Body);
+		bool passed = sFailedChecks == failedBefore;
+
+		std::cout << (passed ? "[ OK   ] " : "[ FAIL ] ") << test.Name
+			<< " (" << std::round(elapsed) << " ms)" << std::endl;
+
+		runCount++;
+		failedCount += passed ? 0 : 1;
+	}
+
+	std::cout << runCount - failedCount << "/" << runCount << " tests passed" << std::endl;
+
+	return static_cast<int>(failedCount);
+}
@@ -0,0 +1,473 @@
+#include "TestFramework.h"
+
+#include "Memory/MemoryAllocator.h"
+
+#include <map>
+#include <random>
+
+using namespace vkEngine::Core;
+
+namespace
+{
+	constexpr vk::DeviceSize sKiB = 1024;
+	constexpr vk::DeviceSize sMiB = 1024 * 1024;
+
+	// Memory types of the fake device
+	constexpr uint32_t sDeviceLocalType = 0;
+	constexpr uint32_t sHostCoherentType = 1;
+	constexpr uint32_t sHostCachedType = 2;
+
+	// Hands out made up handles and counts the blocks the allocator holds on to
+	class FakeBlockBackend : public MemoryBlockBackend
+	{
+	public:
+		FakeBlockBackend()
+		{
+			mMemoryProperties.memoryHeapCount = 2;
+			mMemoryProperties.memoryHeaps[0].size = 1024 * sMiB;
+			mMemoryProperties.memoryHeaps[1].size = 4 * sMiB;
+
+			mMemoryProperties.memoryTypeCount = 3;
+
+			mMemoryProperties.memoryTypes[sDeviceLocalType].propertyFlags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+			mMemoryProperties.memoryTypes[sDeviceLocalType].heapIndex = 0;
+
+			mMemoryProperties.memoryTypes[sHostCoherentType].propertyFlags =
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			mMemoryProperties.memoryTypes[sHostCoherentType].heapIndex = 1;
+
+			mMemoryProperties.memoryTypes[sHostCachedType].propertyFlags =
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached;
+			mMemoryProperties.memoryTypes[sHostCachedType].heapIndex = 1;
+		}
+
+		vk::DeviceMemory AllocateBlock(uint32_t memoryTypeIndex, vk::DeviceSize size) override
+		{
+			VkDeviceMemory handle = reinterpret_cast<VkDeviceMemory>(static_cast<uintptr_t>(mNextHandle++));
+
+			mBlocks[handle] = { memoryTypeIndex, size, {} };
+			AllocateCount++;
+
+			return vk::DeviceMemory(handle);
+		}
+
+		void FreeBlock(vk::DeviceMemory memory) override
+		{
+			CHECK(mBlocks.erase(static_cast<VkDeviceMemory>(memory)) == 1);
+		}
+
+		void* MapBlock(vk::DeviceMemory memory) override
+		{
+			Block& block = mBlocks.at(static_cast<VkDeviceMemory>(memory));
+			block.Storage.resize(block.Size);
+
+			return block.Storage.data();
+		}
+
+		void UnmapBlock(vk::DeviceMemory memory) override
+		{
+			mBlocks.at(static_cast<VkDeviceMemory>(memory)).Storage.clear();
+		}
+
+		const vk::PhysicalDeviceMemoryProperties& GetMemoryProperties() const override { return mMemoryProperties; }
+		vk::DeviceSize GetNonCoherentAtomSize() const override { return 256; }
+
+		size_t GetLiveBlockCount() const { return mBlocks.size(); }
+
+		uint32_t GetBlockType(vk::DeviceMemory memory) const
+		{
+			return mBlocks.at(static_cast<VkDeviceMemory>(memory)).MemoryTypeIndex;
+		}
+
+		const void* GetMappedBase(vk::DeviceMemory memory) const
+		{
+			return mBlocks.at(static_cast<VkDeviceMemory>(memory)).Storage.data();
+		}
+
+		size_t AllocateCount = 0;
+
+	private:
+		struct Block
+		{
+			uint32_t MemoryTypeIndex = 0;
+			vk::DeviceSize Size = 0;
+			std::vector<uint8_t> Storage;
+		};
+
+		vk::PhysicalDeviceMemoryProperties mMemoryProperties{};
+		std::map<VkDeviceMemory, Block> mBlocks;
+		uintptr_t mNextHandle = 0x1000;
+	};
+
+	std::shared_ptr<MemoryAllocator> MakeAllocator(std::shared_ptr<FakeBlockBackend> backend,
+		MemoryAllocatorMode mode = MemoryAllocatorMode::eTLSF, vk::DeviceSize blockSize = sMiB)
+	{
+		MemoryAllocatorCreateInfo createInfo{};
+		createInfo.Backend = backend;
+		createInfo.Mode = mode;
+		createInfo.BlockSize = blockSize;
+
+		return std::make_shared<MemoryAllocator>(createInfo);
+	}
+
+	vk::MemoryRequirements MakeRequirements(vk::DeviceSize size, vk::DeviceSize alignment, uint32_t typeBits = ~0u)
+	{
+		vk::MemoryRequirements memReq{};
+		memReq.size = size;
+		memReq.alignment = alignment;
+		memReq.memoryTypeBits = typeBits;
+
+		return memReq;
+	}
+
+	bool IsAligned(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return value % alignment == 0;
+	}
+}
+
+TEST_CASE(TLSF_SplitAndMerge)
+{
+	TLSF_Heap heap(4 * sKiB);
+
+	// Four quarters fill the heap exactly
+	std::vector<SubAllocation> quarters;
+
+	for (int i = 0; i < 4; i++)
+	{
+		auto allocation = heap.Allocate(sKiB, 1);
+		CHECK(allocation.has_value());
+
+		if (allocation)
+			quarters.push_back(*allocation);
+	}
+
+	if (quarters.size() != 4)
+		return;
+
+	CHECK_EQ(heap.GetUsedSize(), 4 * sKiB);
+	CHECK(!heap.Allocate(1, 1).has_value());
+
+	// Two neighbouring quarters merge, so half the heap fits where they were
+	std::sort(quarters.begin(), quarters.end(),
+		[](const SubAllocation& lhs, const SubAllocation& rhs) { return lhs.Offset < rhs.Offset; });
+
+	heap.Free(quarters[1].Range);
+	CHECK(!heap.Allocate(2 * sKiB, 1).has_value());
+
+	heap.Free(quarters[2].Range);
+
+	auto half = heap.Allocate(2 * sKiB, 1);
+	CHECK(half.has_value());
+
+	if (half)
+	{
+		CHECK_EQ(half->Offset, quarters[1].Offset);
+		heap.Free(half->Range);
+	}
+
+	// Freeing the outer quarters merges them with the free middle from both sides
+	heap.Free(quarters[0].Range);
+	heap.Free(quarters[3].Range);
+
+	CHECK(heap.IsEmpty());
+	CHECK_EQ(heap.GetUsedSize(), 0u);
+
+	auto whole = heap.Allocate(4 * sKiB, 1);
+	CHECK(whole.has_value() && whole->Offset == 0);
+}
+
+TEST_CASE(TLSF_AlignmentPadding)
+{
+	TLSF_Heap heap(4 * sKiB);
+
+	auto unaligned = heap.Allocate(100, 1);
+	auto aligned = heap.Allocate(64, 256);
+
+	CHECK(unaligned.has_value() && unaligned->Offset == 0);
+	CHECK(aligned.has_value() && aligned->Offset == 256);
+
+	// The padding isn't counted as used and stays available
+	CHECK_EQ(heap.GetUsedSize(), 164u);
+
+	auto padding = heap.Allocate(150, 1);
+	CHECK(padding.has_value() && padding->Offset >= 100 && padding->Offset + 150 <= 256);
+
+	for (const auto& allocation : { unaligned, aligned, padding })
+	{
+		if (allocation)
+			heap.Free(allocation->Range);
+	}
+
+	CHECK(heap.IsEmpty());
+	CHECK(heap.Allocate(4 * sKiB, 1).has_value());
+}
+
+// Random traffic never hands out overlapping or misaligned ranges, and the heap coalesces fully at the end
+TEST_CASE(TLSF_RandomTrafficCoalesces)
+{
+	const vk::DeviceSize heapSize = 16 * sMiB;
+	TLSF_Heap heap(heapSize);
+
+	std::mt19937 engine(29);
+	std::uniform_int_distribution<vk::DeviceSize> size(1, 64 * sKiB);
+	std::uniform_int_distribution<uint32_t> alignmentLog2(0, 12);
+	std::bernoulli_distribution allocate(0.6);
+
+	// Offset of every live range to its allocation
+	std::map<vk::DeviceSize, SubAllocation> live;
+	vk::DeviceSize usedSize = 0;
+
+	uint32_t overlapCount = 0;
+	uint32_t misalignedCount = 0;
+
+	for (uint32_t step = 0; step < 20000; step++)
+	{
+		if (allocate(engine) || live.empty())
+		{
+			vk::DeviceSize alignment = vk::DeviceSize(1) << alignmentLog2(engine);
+			auto allocation = heap.Allocate(size(engine), alignment);
+
+			if (!allocation)
+				continue;
+
+			misalignedCount += IsAligned(allocation->Offset, alignment) ? 0 : 1;
+
+			auto next = live.lower_bound(allocation->Offset);
+
+			if (next != live.end() && next->first < allocation->Offset + allocation->Size)
+				overlapCount++;
+
+			if (next != live.begin() && std::prev(next)->second.Offset + std::prev(next)->second.Size > allocation->Offset)
+				overlapCount++;
+
+			live[allocation->Offset] = *allocation;
+			usedSize += allocation->Size;
+			continue;
+		}
+
+		auto victim = std::next(live.begin(), std::uniform_int_distribution<size_t>(0, live.size() - 1)(engine));
+
+		heap.Free(victim->second.Range);
+		usedSize -= victim->second.Size;
+		live.erase(victim);
+	}
+
+	CHECK_EQ(overlapCount, 0u);
+	CHECK_EQ(misalignedCount, 0u);
+	CHECK_EQ(heap.GetUsedSize(), usedSize);
+	CHECK_EQ(heap.GetAllocationCount(), live.size());
+
+	for (const auto& [offset, allocation] : live)
+		heap.Free(allocation.Range);
+
+	CHECK(heap.IsEmpty());
+
+	auto whole = heap.Allocate(heapSize, 1);
+	CHECK(whole.has_value() && whole->Offset == 0);
+}
+
+TEST_CASE(LinearArena_AllocateAndReset)
+{
+	LinearArena arena(sKiB);
+
+	auto first = arena.Allocate(10, 1);
+	auto second = arena.Allocate(10, 64);
+
+	CHECK(first.has_value() && first->Offset == 0);
+	CHECK(second.has_value() && second->Offset == 64);
+	CHECK(!arena.Allocate(sKiB, 1).has_value());
+
+	arena.Reset();
+
+	CHECK(arena.IsEmpty());
+	CHECK_EQ(arena.GetUsedSize(), 0u);
+	CHECK(arena.Allocate(sKiB, 1).has_value());
+}
+
+// A full block sends the next request to a new block, freeing it gives the block back
+TEST_CASE(MemoryAllocator_NewBlockWhenFull)
+{
+	auto backend = std::make_shared<FakeBlockBackend>();
+
+	{
+		auto allocator = MakeAllocator(backend);
+		auto memReq = MakeRequirements(256 * sKiB, 256);
+
+		std::vector<MemoryAllocation> allocations;
+
+		for (int i = 0; i < 4; i++)
+			allocations.push_back(allocator->Allocate(memReq, vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+		CHECK_EQ(allocator->GetStats().BlockCount, 1u);
+		CHECK_EQ(allocator->GetStats().UsedBytes, sMiB);
+
+		allocations.push_back(allocator->Allocate(memReq, vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+		MemoryAllocatorStats stats = allocator->GetStats();
+
+		CHECK_EQ(stats.BlockCount, 2u);
+		CHECK_EQ(stats.AllocationCount, 5u);
+		CHECK_EQ(stats.BlockBytes, 2 * sMiB);
+		CHECK(allocations[4].Handle != allocations[0].Handle);
+
+		for (const auto& allocation : allocations)
+			CHECK(IsAligned(allocation.Offset, 256) && backend->GetBlockType(allocation.Handle) == sDeviceLocalType);
+
+		// The emptied block goes back, the last one of the pool stays around
+		allocator->Free(allocations[4]);
+		CHECK_EQ(allocator->GetStats().BlockCount, 1u);
+
+		for (int i = 0; i < 4; i++)
+			allocator->Free(allocations[i]);
+
+		stats = allocator->GetStats();
+
+		CHECK_EQ(stats.BlockCount, 1u);
+		CHECK_EQ(stats.AllocationCount, 0u);
+		CHECK_EQ(backend->GetLiveBlockCount(), 1u);
+	}
+
+	CHECK_EQ(backend->GetLiveBlockCount(), 0u);
+}
+
+TEST_CASE(MemoryAllocator_DedicatedBlocks)
+{
+	auto backend = std::make_shared<FakeBlockBackend>();
+	auto allocator = MakeAllocator(backend);
+
+	// Above half a block
+	MemoryAllocation large = allocator->Allocate(MakeRequirements(600 * sKiB, 256), vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	MemoryAllocatorStats stats = allocator->GetStats();
+
+	CHECK_EQ(stats.DedicatedBlockCount, 1u);
+	CHECK_EQ(stats.BlockBytes, 600 * sKiB);
+	CHECK_EQ(large.Offset, 0u);
+
+	allocator->Free(large);
+
+	CHECK_EQ(allocator->GetStats().BlockCount, 0u);
+	CHECK_EQ(backend->GetLiveBlockCount(), 0u);
+}
+
+TEST_CASE(MemoryAllocator_HostVisibleBlocks)
+{
+	auto backend = std::make_shared<FakeBlockBackend>();
+	auto allocator = MakeAllocator(backend);
+
+	// The 4 MB heap caps the blocks to 512 KB
+	MemoryAllocation coherent = allocator->Allocate(MakeRequirements(100, 4),
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	CHECK_EQ(backend->GetBlockType(coherent.Handle), sHostCoherentType);
+	CHECK_EQ(allocator->GetStats().BlockBytes, 512 * sKiB);
+	CHECK(coherent.MappedData == static_cast<const uint8_t*>(backend->GetMappedBase(coherent.Handle)) + coherent.Offset);
+
+	// The non coherent ranges are padded to whole atoms, so flushing one never touches the others
+	MemoryAllocation first = allocator->Allocate(MakeRequirements(100, 4, 1u << sHostCachedType),
+		vk::MemoryPropertyFlagBits::eHostVisible);
+	MemoryAllocation second = allocator->Allocate(MakeRequirements(100, 4, 1u << sHostCachedType),
+		vk::MemoryPropertyFlagBits::eHostVisible);
+
+	CHECK_EQ(backend->GetBlockType(first.Handle), sHostCachedType);
+	CHECK(IsAligned(first.Offset, 256) && IsAligned(second.Offset, 256));
+	CHECK(first.Size == 256 && second.Size == 256);
+	CHECK(second.MappedData == static_cast<const uint8_t*>(backend->GetMappedBase(second.Handle)) + second.Offset);
+
+	for (const auto& allocation : { coherent, first, second })
+		allocator->Free(allocation);
+}
+
+TEST_CASE(MemoryAllocator_LinearReset)
+{
+	auto backend = std::make_shared<FakeBlockBackend>();
+	auto allocator = MakeAllocator(backend, MemoryAllocatorMode::eLinear);
+
+	auto memReq = MakeRequirements(300 * sKiB, 256);
+
+	// The fourth range no longer fits into the first block
+	for (int i = 0; i < 4; i++)
+		allocator->Free(allocator->Allocate(memReq, vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+	// Freeing a linear range gives nothing back until the reset
+	CHECK_EQ(allocator->GetStats().BlockCount, 2u);
+	CHECK_EQ(allocator->GetStats().UsedBytes, 1200 * sKiB);
+
+	allocator->Reset();
+
+	CHECK_EQ(allocator->GetStats().UsedBytes, 0u);
+
+	MemoryAllocation rewound = allocator->Allocate(memReq, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+	CHECK_EQ(rewound.Offset, 0u);
+	CHECK_EQ(allocator->GetStats().BlockCount, 2u);
+}
+
+BENCHMARK(MemoryAllocator_AllocFreeThroughput)
+{
+	constexpr uint32_t sLiveCount = 4096;
+	constexpr uint32_t sOperationCount = 1000000;
+
+	std::mt19937 engine(31);
+	std::uniform_int_distribution<vk::DeviceSize> size(256, 64 * sKiB);
+	std::uniform_int_distribution<uint32_t> slot(0, sLiveCount - 1);
+
+	std::vector<vk::DeviceSize> sizes(sOperationCount);
+	std::vector<uint32_t> slots(sOperationCount);
+
+	for (uint32_t i = 0; i < sOperationCount; i++)
+	{
+		sizes[i] = size(engine);
+		slots[i] = slot(engine);
+	}
+
+	// Replaces a random live range with a new one, every operation is a free and an allocation
+	{
+		TLSF_Heap heap(1024 * sMiB);
+		std::vector<std::optional<SubAllocation>> live(sLiveCount);
+
+		double elapsed = Tests::MeasureMs([&]()
+		{
+			for (uint32_t i = 0; i < sOperationCount; i++)
+			{
+				auto& entry = live[slots[i]];
+
+				if (entry)
+					heap.Free(entry->Range);
+
+				entry = heap.Allocate(sizes[i], 256);
+			}
+		});
+
+		std::cout << "    TLSF_Heap: " << sOperationCount / elapsed / 1000.0 << " M alloc/free pairs per second" << std::endl;
+	}
+
+	{
+		auto backend = std::make_shared<FakeBlockBackend>();
+		auto allocator = MakeAllocator(backend, MemoryAllocatorMode::eTLSF, 64 * sMiB);
+		std::vector<std::optional<MemoryAllocation>> live(sLiveCount);
+
+		double elapsed = Tests::MeasureMs([&]()
+		{
+			for (uint32_t i = 0; i < sOperationCount; i++)
+			{
+				auto& entry = live[slots[i]];
+
+				if (entry)
+					allocator->Free(*entry);
+
+				entry = allocator->Allocate(MakeRequirements(sizes[i], 256), vk::MemoryPropertyFlagBits::eDeviceLocal);
+			}
+		});
+
+		std::cout << "    MemoryAllocator: " << sOperationCount / elapsed / 1000.0 << " M alloc/free pairs per second, "
+			<< backend->AllocateCount << " blocks drawn from the backend" << std::endl;
+
+		for (auto& entry : live)
+		{
+			if (entry)
+				allocator->Free(*entry);
+		}
+	}
+}
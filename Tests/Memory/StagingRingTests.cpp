@@ -0,0 +1,90 @@
+#include "TestFramework.h"
+#include "TestDevice.h"
+
+#include "Memory/ResourcePool.h"
+
+#include <numeric>
+
+namespace
+{
+	// Small enough that the uploads below wrap around the ring and get split into pieces
+	constexpr vk::DeviceSize sRingCapacity = 64 * 1024;
+
+	vkEngine::Buffer<uint32_t> CreateHostBuffer(const vkEngine::ResourcePool& resourcePool, size_t size)
+	{
+		// Host visible so the test can fill and read it back directly
+		vkEngine::Buffer<uint32_t> buffer = resourcePool.CreateBuffer<uint32_t>(vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+		buffer.Resize(size);
+
+		return buffer;
+	}
+
+	std::vector<uint32_t> MakeValues(size_t size, uint32_t first)
+	{
+		std::vector<uint32_t> values(size);
+		std::iota(values.begin(), values.end(), first);
+
+		return values;
+	}
+}
+
+// Without a transfer only family (lavapipe) the copies run on the owner family, the results must not differ
+DEVICE_TEST(StagingRing_UploadsMatchHost)
+{
+	vkEngine::Context context = Tests::GetTestDevice().Context;
+	vkEngine::ResourcePool resourcePool = context.CreateResourcePool();
+
+	vkEngine::StagingRing ring = resourcePool.CreateStagingRing(sRingCapacity);
+
+	std::cout << "    " << (ring.UsesTransferFamily() ? "transfer only family" : "single family fallback") << std::endl;
+
+	// Four times the ring, so the later pieces have to wait for the earlier batches to give their space back
+	size_t size = 4 * sRingCapacity / sizeof(uint32_t) + 17;
+
+	vkEngine::Buffer<uint32_t> first = CreateHostBuffer(resourcePool, size);
+	vkEngine::Buffer<uint32_t> second = CreateHostBuffer(resourcePool, size);
+
+	std::vector<uint32_t> expectedFirst = MakeValues(size, 0);
+	std::vector<uint32_t> expectedSecond(size, 0xdeadbeef);
+
+	// The middle of the second buffer is staged, its ends must survive the ownership transfers
+	second.Clear();
+	second << expectedSecond;
+
+	size_t middleBegin = size / 3;
+	std::vector<uint32_t> middle = MakeValues(size / 3, 1u << 24);
+
+	std::copy(middle.begin(), middle.end(), expectedSecond.begin() + middleBegin);
+
+	ring.Upload(first, expectedFirst.begin(), expectedFirst.end());
+	ring.Upload(second, middle.begin(), middle.end(), middleBegin);
+	ring.Flush();
+
+	// Overwrites a range of the batch still in flight, the later flush has to land last
+	std::vector<uint32_t> overwrite = MakeValues(1000, 1u << 28);
+
+	std::copy(overwrite.begin(), overwrite.end(), expectedFirst.begin() + 123);
+
+	ring.Upload(first, overwrite.begin(), overwrite.end(), 123);
+
+	vkEngine::Core::GpuFuture landed = ring.Flush();
+
+	CHECK(landed.Wait());
+	CHECK_EQ(ring.GetPendingCopyCount(), size_t(0));
+
+	std::vector<uint32_t> resultFirst(size);
+	std::vector<uint32_t> resultSecond(size);
+
+	first.FetchMemory(resultFirst.begin(), resultFirst.end());
+	second.FetchMemory(resultSecond.begin(), resultSecond.end());
+
+	bool firstMatches = resultFirst == expectedFirst;
+	bool secondMatches = resultSecond == expectedSecond;
+
+	CHECK(firstMatches);
+	CHECK(secondMatches);
+
+	ring.WaitIdle();
+}
@@ -0,0 +1,219 @@
+#include "TestFramework.h"
+#include "TestDevice.h"
+
+#include "Core/Utils/DeviceCreation.h"
+
+#include <thread>
+
+using namespace vkEngine::Core;
+
+namespace
+{
+	constexpr std::chrono::milliseconds sShortWait(20);
+
+	// Queue, executor and pools of the compute family, plus a timeline the host signals to hold work back
+	struct QueueFixture
+	{
+		vkEngine::Context Context;
+		uint32_t FamilyIndex = 0;
+
+		Executor Worker;
+		vkEngine::CommandPools CommandPools;
+
+		vk::Device Device;
+		vk::Semaphore Gate;
+	};
+
+	QueueFixture CreateQueueFixture()
+	{
+		QueueFixture fixture;
+
+		fixture.Context = Tests::GetTestDevice().Context;
+		fixture.FamilyIndex = fixture.Context.GetQueueManager()->FindOptimalQueueFamilyIndex(vk::QueueFlagBits::eCompute);
+
+		fixture.Worker = fixture.Context.FetchExecutor(fixture.FamilyIndex, vkEngine::QueueAccessType::eWorker);
+		fixture.CommandPools = fixture.Context.CreateCommandPools(true);
+
+		fixture.Device = *fixture.Context.GetHandle();
+		fixture.Gate = Utils::CreateTimelineSemaphore(fixture.Device, 0);
+
+		return fixture;
+	}
+
+	// Empty submission that can't start before the host opens the gate
+	GpuFuture SubmitGated(const QueueFixture& fixture)
+	{
+		vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+		uint64_t waitValue = 1;
+
+		vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.setWaitSemaphoreValues(waitValue);
+
+		vk::SubmitInfo submitInfo{};
+		submitInfo.setWaitSemaphores(fixture.Gate);
+		submitInfo.setWaitDstStageMask(waitStage);
+		submitInfo.setPNext(&timelineInfo);
+
+		return fixture.Worker[0]->Submit(submitInfo);
+	}
+
+	void OpenGate(const QueueFixture& fixture)
+	{
+		vk::SemaphoreSignalInfo signalInfo{};
+		signalInfo.setSemaphore(fixture.Gate);
+		signalInfo.setValue(1);
+
+		fixture.Device.signalSemaphore(signalInfo);
+	}
+
+	void DestroyQueueFixture(const QueueFixture& fixture)
+	{
+		fixture.Worker.WaitIdle();
+		fixture.Device.destroySemaphore(fixture.Gate);
+	}
+}
+
+// The lock is held through the submit, so the values of the threads interleave without gaps or repeats
+DEVICE_TEST(Queue_SubmitValuesIncreaseAcrossThreads)
+{
+	QueueFixture fixture = CreateQueueFixture();
+
+	Ref<Queue> queue = fixture.Worker[0];
+
+	constexpr size_t sThreadCount = 4;
+	constexpr size_t sSubmitCount = 250;
+
+	uint64_t firstValue = queue->GetLastSubmission().GetValue() + 1;
+
+	std::vector<std::vector<uint64_t>> values(sThreadCount);
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < sThreadCount; i++)
+	{
+		threads.emplace_back([&queue, &threadValues = values[i]]()
+		{
+			for (size_t j = 0; j < sSubmitCount; j++)
+				threadValues.push_back(queue->Submit(vk::SubmitInfo()).GetValue());
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	std::vector<uint64_t> allValues;
+
+	for (const auto& threadValues : values)
+	{
+		bool increasing = std::adjacent_find(threadValues.begin(), threadValues.end(),
+			[](uint64_t lhs, uint64_t rhs) { return lhs >= rhs; }) == threadValues.end();
+
+		CHECK(increasing);
+
+		allValues.insert(allValues.end(), threadValues.begin(), threadValues.end());
+	}
+
+	std::sort(allValues.begin(), allValues.end());
+
+	CHECK_EQ(allValues.front(), firstValue);
+	CHECK_EQ(allValues.back(), firstValue + sThreadCount * sSubmitCount - 1);
+	CHECK(std::adjacent_find(allValues.begin(), allValues.end()) == allValues.end());
+
+	CHECK(queue->WaitIdle());
+	CHECK_EQ(queue->GetPendingCount(), uint64_t(0));
+
+	DestroyQueueFixture(fixture);
+}
+
+DEVICE_TEST(GpuFuture_ReadyOnlyOnceReached)
+{
+	QueueFixture fixture = CreateQueueFixture();
+
+	// An empty future counts as complete
+	GpuFuture empty;
+
+	CHECK(empty.IsReady());
+	CHECK(empty.Wait());
+
+	GpuFuture gated = SubmitGated(fixture);
+
+	CHECK(gated);
+	CHECK(!gated.IsReady());
+	CHECK(!gated.Wait(sShortWait));
+	CHECK(fixture.Worker[0]->GetPendingCount() > 0);
+
+	OpenGate(fixture);
+
+	CHECK(gated.Wait());
+	CHECK(gated.IsReady());
+
+	DestroyQueueFixture(fixture);
+}
+
+// The second submission waits on the first on the device, the host only waits at the very end
+DEVICE_TEST(Executor_SubmitWorkChainsOnFutures)
+{
+	QueueFixture fixture = CreateQueueFixture();
+
+	vkEngine::ResourcePool resourcePool = fixture.Context.CreateResourcePool();
+
+	// Host visible so the test can read it back directly
+	vkEngine::Buffer<uint32_t> buffer = resourcePool.CreateBuffer<uint32_t>(vk::BufferUsageFlagBits::eStorageBuffer,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	buffer.Resize(1024);
+
+	const vkEngine::CommandBufferAllocator& commandPool = fixture.CommandPools[fixture.FamilyIndex];
+
+	GpuFuture gated = SubmitGated(fixture);
+
+	vk::CommandBuffer commandBuffer = commandPool.BeginOneTimeCommands();
+	commandBuffer.fillBuffer(buffer.GetNativeHandles().Handle, 0, VK_WHOLE_SIZE, 42);
+
+	GpuFuture filled = commandPool.EndOneTimeCommandsAsync(commandBuffer, fixture.Worker, { gated });
+
+	CHECK(!filled.Wait(sShortWait));
+
+	OpenGate(fixture);
+
+	CHECK(filled.Wait());
+	CHECK(gated.IsReady());
+
+	std::vector<uint32_t> result(1024);
+	buffer.FetchMemory(result.begin(), result.end());
+
+	bool allFilled = std::all_of(result.begin(), result.end(), [](uint32_t value) { return value == 42; });
+	CHECK(allFilled);
+
+	DestroyQueueFixture(fixture);
+}
+
+DEVICE_TEST(CommandBufferAllocator_AllocateFreesRetiredBuffers)
+{
+	QueueFixture fixture = CreateQueueFixture();
+
+	const vkEngine::CommandBufferAllocator& commandPool = fixture.CommandPools[fixture.FamilyIndex];
+
+	GpuFuture gated = SubmitGated(fixture);
+
+	vk::CommandBuffer retired = commandPool.BeginOneTimeCommands();
+	GpuFuture future = commandPool.EndOneTimeCommandsAsync(retired, fixture.Worker, { gated });
+
+	CHECK_EQ(commandPool.GetRetiringCount(), size_t(1));
+
+	// Still pending, the allocation has to leave it alone
+	vk::CommandBuffer first = commandPool.Allocate();
+
+	CHECK_EQ(commandPool.GetRetiringCount(), size_t(1));
+
+	OpenGate(fixture);
+	CHECK(future.Wait());
+
+	vk::CommandBuffer second = commandPool.Allocate();
+
+	CHECK_EQ(commandPool.GetRetiringCount(), size_t(0));
+
+	commandPool.Free(first);
+	commandPool.Free(second);
+
+	DestroyQueueFixture(fixture);
+}
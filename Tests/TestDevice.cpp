@@ -0,0 +1,60 @@
+#include "TestDevice.h"
+
+namespace
+{
+	constexpr int sWindowSize = 256;
+
+	std::unique_ptr<Tests::TestDevice> CreateTestDevice()
+	{
+		auto device = std::make_unique<Tests::TestDevice>();
+
+		WindowProps props{};
+		props.name = "Tests";
+		props.width = sWindowSize;
+		props.height = sWindowSize;
+		props.vSync = false;
+
+		device->Window = std::make_unique<WindowsWindow>(props);
+
+		device->InstanceMenagerie = std::make_shared<vkEngine::InstanceMenagerie>(
+			std::vector<const char*>{}, std::vector<const char*>{});
+
+		vkEngine::InstanceCreateInfo instanceInfo{};
+		instanceInfo.AppName = "Tests";
+		instanceInfo.EngineName = "vkEngine";
+		instanceInfo.AppVersion = { 1, 0, 0 };
+		instanceInfo.EngineVersion = { 1, 0, 0 };
+
+		device->Instance = device->InstanceMenagerie->Create(instanceInfo);
+
+		auto [result, surface] = device->InstanceMenagerie->CreateSurface(
+			device->Instance, device->Window->GetNativeHandle());
+
+		_STL_ASSERT(result == vk::Result::eSuccess, "Could not create a surface!");
+
+		device->Surface = surface;
+		device->PhysicalDevices = std::make_shared<vkEngine::PhysicalDeviceMenagerie>(device->Instance);
+
+		vkEngine::ContextCreateInfo contextInfo{};
+		contextInfo.DeviceCapabilities =
+			vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer;
+
+		contextInfo.PhysicalDevice = (*device->PhysicalDevices)[0];
+		contextInfo.RequiredFeatures = contextInfo.PhysicalDevice.Features;
+
+		contextInfo.SwapchainInfo.Width = sWindowSize;
+		contextInfo.SwapchainInfo.Height = sWindowSize;
+		contextInfo.SwapchainInfo.PresentMode = vk::PresentModeKHR::eFifo;
+		contextInfo.SwapchainInfo.Surface = device->Surface;
+
+		device->Context = vkEngine::Context(contextInfo);
+
+		return device;
+	}
+}
+
+Tests::TestDevice& Tests::GetTestDevice()
+{
+	static std::unique_ptr<TestDevice> device = CreateTestDevice();
+	return *device;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "Device/Context.h"
+#include "Instance/InstanceMenagerie.h"
+#include "Window/GLFW_Window.h"
+
+namespace Tests
+{
+	// Vulkan context of the device tests, created the first time a test asks for it
+	// The engine always creates the device with a swapchain, so a small window comes along
+	struct TestDevice
+	{
+		std::unique_ptr<WindowsWindow> Window;
+
+		std::shared_ptr<vkEngine::InstanceMenagerie> InstanceMenagerie;
+		vkEngine::Core::Ref<vk::Instance> Instance;
+		vkEngine::Core::Ref<vk::SurfaceKHR> Surface;
+		std::shared_ptr<vkEngine::PhysicalDeviceMenagerie> PhysicalDevices;
+
+		vkEngine::Context Context;
+	};
+
+	TestDevice& GetTestDevice();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal self registering test harness
+// Unit tests run on the host by default, benchmarks and the device tests only when asked for
+namespace Tests
+{
+	enum class TestKind
+	{
+		eUnit,
+		eBenchmark,
+		eDevice,
+	};
+
+	struct TestCase
+	{
+		std::string Name;
+		TestKind Kind = TestKind::eUnit;
+		std::function<void()> Body;
+	};
+
+	std::vector<TestCase>& GetRegistry();
+
+	// Counts the failed checks of the running test
+	void ReportFailure(const char* file, int line, const std::string& message);
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestKind kind, void(*body)())
+		{
+			GetRegistry().push_back({ name, kind, body });
+		}
+	};
+
+	// Wall clock time of a callable in milliseconds
+	template <typename Fn>
+	double MeasureMs(Fn&& fn)
+	{
+		auto begin = std::chrono::high_resolution_clock::now();
+		fn();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+}
+
+#define TESTS_REGISTER(name, kind)                                                   \
+	static void name();                                                              \
+	static const Tests::TestRegistrar name##_Registrar(#name, kind, &name);          \
+	static void name()
+
+#define TEST_CASE(name)        TESTS_REGISTER(name, Tests::TestKind::eUnit)
+#define BENCHMARK(name)        TESTS_REGISTER(name, Tests::TestKind::eBenchmark)
+#define DEVICE_TEST(name)      TESTS_REGISTER(name, Tests::TestKind::eDevice)
+
+#define CHECK(expr)                                                                  \
+	do { if (!(expr)) Tests::ReportFailure(__FILE__, __LINE__, #expr); } while (false)
+
+#define CHECK_EQ(lhs, rhs)                                                           \
+	do                                                                               \
+	{                                                                                \
+		auto checkLhs = (lhs);                                                       \
+		auto checkRhs = (rhs);                                                       \
+		if (!(checkLhs == checkRhs))                                                 \
+		{                                                                            \
+			std::ostringstream checkStream;                                          \
+			checkStream << #lhs " == " #rhs " (" << checkLhs << " vs " << checkRhs << ")"; \
+			Tests::ReportFailure(__FILE__, __LINE__, checkStream.str());             \
+		}                                                                            \
+	} while (false)
+
+#define CHECK_NEAR(lhs, rhs, eps)                                                    \
+	do                                                                               \
+	{                                                                                \
+		double checkLhs = static_cast<double>(lhs);                                  \
+		double checkRhs = static_cast<double>(rhs);                                  \
+		if (!(std::abs(checkLhs - checkRhs) <= (eps)))                               \
+		{                                                                            \
+			std::ostringstream checkStream;                                          \
+			checkStream << #lhs " ~= " #rhs " (" << checkLhs << " vs " << checkRhs << ")"; \
+			Tests::ReportFailure(__FILE__, __LINE__, checkStream.str());             \
+		}                                                                            \
+	} while (false)
@@ -0,0 +1,93 @@
+#include "TestFramework.h"
+#include "TestDevice.h"
+
+#include "Utils/ParallelRecorder.h"
+#include "Utils/CompilerErrorChecker.h"
+
+using namespace AquaFlow;
+
+namespace
+{
+	constexpr uint32_t sDispatchCount = 1000;
+	constexpr uint32_t sRepeatCount = 20;
+
+	const char* sEmptyShader = R"(
+#version 440
+
+layout(local_size_x = 64) in;
+
+void main() {}
+)";
+}
+
+// Records the dispatches the way the executor records its materials, one pipeline per item
+// Nothing is submitted, only the CPU side of the recording is measured
+DEVICE_TEST(ParallelRecorder_RecordDispatchesByThreadCount)
+{
+	vkEngine::Context context = Tests::GetTestDevice().Context;
+	uint32_t familyIndex = context.GetQueueManager()->FindOptimalQueueFamilyIndex(vk::QueueFlagBits::eCompute);
+
+	vkEngine::PShader shader{};
+	shader.SetShader("eCompute", sEmptyShader);
+
+	CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+	checker.AssertOnError(shader.CompileShaders());
+
+	// Pipelines keep their recording state, every item needs one of its own to record concurrently
+	vkEngine::PipelineBuilder builder = context.MakePipelineBuilder();
+	std::vector<vkEngine::ComputePipeline> pipelines;
+
+	for (uint32_t i = 0; i < sDispatchCount; i++)
+		pipelines.push_back(builder.BuildComputePipeline<vkEngine::ComputePipeline>(shader));
+
+	auto recordDispatch = [&pipelines](vk::CommandBuffer cmd, uint32_t index)
+	{
+		vkEngine::ComputePipeline& pipeline = pipelines[index];
+
+		pipeline.Begin(cmd);
+		pipeline.BindPipeline();
+		pipeline.Dispatch({ 1, 1, 1 });
+		pipeline.End();
+	};
+
+	vkEngine::CommandPools primaryPools = context.CreateCommandPools(true);
+
+	double serialMs = 0.0;
+
+	for (uint32_t threadCount : { 1u, 4u, 8u })
+	{
+		// The pool always has a worker, so the single thread baseline records straight into the primary buffer
+		vkEngine::ThreadCommandPools commandPools([context]() { return context.CreateCommandPools(true); });
+		ParallelRecorder recorder(std::make_shared<ThreadPool>(threadCount - 1), commandPools, familyIndex);
+
+		double totalMs = 0.0;
+
+		for (uint32_t repeat = 0; repeat < sRepeatCount; repeat++)
+		{
+			vk::CommandBuffer primary = primaryPools[familyIndex].BeginOneTimeCommands();
+
+			totalMs += Tests::MeasureMs([&]()
+			{
+				if (threadCount > 1)
+				{
+					recorder.Record(primary, sDispatchCount, recordDispatch);
+					return;
+				}
+
+				for (uint32_t i = 0; i < sDispatchCount; i++)
+					recordDispatch(primary, i);
+			});
+
+			primary.end();
+
+			primaryPools[familyIndex].Free(primary);
+			recorder.Reset();
+		}
+
+		double averageMs = totalMs / sRepeatCount;
+		serialMs = threadCount == 1 ? averageMs : serialMs;
+
+		std::cout << "    " << threadCount << " threads: " << averageMs << " ms per " << sDispatchCount
+			<< " dispatches (" << serialMs / averageMs << "x)" << std::endl;
+	}
+}
@@ -0,0 +1,100 @@
+#include "TestFramework.h"
+
+#include "Utils/ParallelRecorder.h"
+
+#include <numeric>
+
+using namespace AquaFlow;
+
+TEST_CASE(ParallelRecorder_ShortListsRecordInline)
+{
+	constexpr uint32_t sMinChunkSize = ParallelRecorder::sMinChunkSize;
+
+	for (uint32_t threadCount : { 1u, 2u, 4u, 8u, 9u })
+	{
+		// Splitting needs a full chunk for every secondary buffer
+		for (uint32_t itemCount = 0; itemCount < 2 * sMinChunkSize; itemCount++)
+			CHECK(ParallelRecorder::GetChunkCount(itemCount, threadCount) <= 1);
+
+		CHECK_EQ(ParallelRecorder::GetChunkCount(2 * sMinChunkSize, threadCount), std::min(threadCount, 2u));
+		CHECK_EQ(ParallelRecorder::GetChunkCount(1000, threadCount), threadCount);
+	}
+
+	CHECK_EQ(ParallelRecorder::GetChunkCount(1000, 1), 1u);
+}
+
+// The chunks cover the items once, in order, with no chunk below the minimum size
+TEST_CASE(ParallelRecorder_ChunksPartitionInOrder)
+{
+	for (uint32_t threadCount = 1; threadCount <= 9; threadCount++)
+	{
+		for (uint32_t itemCount = 0; itemCount <= 1100; itemCount++)
+		{
+			uint32_t chunkCount = ParallelRecorder::GetChunkCount(itemCount, threadCount);
+
+			if (chunkCount <= 1)
+				continue;
+
+			uint32_t next = 0;
+			uint32_t minSize = UINT32_MAX;
+			uint32_t maxSize = 0;
+
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				auto [begin, end] = ParallelRecorder::GetChunkRange(itemCount, chunkCount, chunk);
+
+				CHECK_EQ(begin, next);
+
+				minSize = std::min(minSize, end - begin);
+				maxSize = std::max(maxSize, end - begin);
+				next = end;
+			}
+
+			CHECK_EQ(next, itemCount);
+			CHECK(minSize >= ParallelRecorder::sMinChunkSize);
+			CHECK(maxSize - minSize <= 1);
+		}
+	}
+}
+
+// Same slot scheme as ParallelRecorder::Record: the chunks finish in any order,
+// but the slots are replayed in chunk order, so the items come out in the serial order
+TEST_CASE(ParallelRecorder_ReplayKeepsItemOrder)
+{
+	constexpr uint32_t sItemCount = 1000;
+
+	for (uint32_t threadCount : { 1u, 4u, 8u })
+	{
+		ThreadPool pool(threadCount - 1);
+
+		uint32_t chunkCount = ParallelRecorder::GetChunkCount(sItemCount, threadCount);
+		std::vector<std::vector<uint32_t>> slots(chunkCount);
+
+		{
+			TaskGroup group(pool);
+
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				group.Run([&slots, chunkCount, chunk]()
+				{
+					auto [begin, end] = ParallelRecorder::GetChunkRange(sItemCount, chunkCount, chunk);
+
+					for (uint32_t i = begin; i < end; i++)
+						slots[chunk].push_back(i);
+				});
+			}
+
+			group.Wait();
+		}
+
+		std::vector<uint32_t> replayed;
+
+		for (const auto& slot : slots)
+			replayed.insert(replayed.end(), slot.begin(), slot.end());
+
+		std::vector<uint32_t> serial(sItemCount);
+		std::iota(serial.begin(), serial.end(), 0);
+
+		CHECK(replayed == serial);
+	}
+}
@@ -0,0 +1,196 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+
+#include "Wavefront/BVHFactory.h"
+
+#include <numeric>
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+using namespace Tests;
+
+namespace
+{
+	std::vector<SplitStrategy> GetStrategies()
+	{
+		SplitStrategy sah{ BVHFactory::DefaultSplitFn::sSAH };
+		sah.mUseSAH = true;
+
+		return { SplitStrategy{ BVHFactory::DefaultSplitFn::sSpatialSplit }, sah };
+	}
+
+	BVH BuildSoup(const TriangleSoup& soup, const SplitStrategy& strategy,
+		std::shared_ptr<ThreadPool> pool, uint32_t grainSize)
+	{
+		BVHFactory factory;
+		factory.SetSplitStrategy(strategy);
+		factory.SetThreadPool(pool);
+		factory.SetTaskGrainSize(grainSize);
+
+		return factory.Build(soup.Vertices.begin(), soup.Vertices.end(), soup.Faces.begin(), soup.Faces.end());
+	}
+
+	// A dense cluster in one corner of a sparse soup, the midpoint splits waste most of their nodes on the empty space
+	TriangleSoup MakeSkewedSoup()
+	{
+		TriangleSoup soup = MakeTriangleSoup(2000, 17, 50.0f);
+		TriangleSoup cluster = MakeTriangleSoup(20000, 19, 2.0f);
+
+		uint32_t vertexOffset = static_cast<uint32_t>(soup.Vertices.size());
+		uint32_t faceOffset = static_cast<uint32_t>(soup.Faces.size());
+
+		for (const auto& vertex : cluster.Vertices)
+			soup.Vertices.push_back(vertex + glm::vec3(40.0f));
+
+		for (Face face : cluster.Faces)
+		{
+			face.Indices += glm::uvec4(vertexOffset, vertexOffset, vertexOffset, 0);
+			face.FaceID += faceOffset;
+
+			soup.Faces.push_back(face);
+		}
+
+		return soup;
+	}
+
+	bool SameNode(const Node& lhs, const Node& rhs)
+	{
+		return lhs.MinBound == rhs.MinBound && lhs.MaxBound == rhs.MaxBound &&
+			lhs.BeginIndex == rhs.BeginIndex && lhs.EndIndex == rhs.EndIndex &&
+			lhs.FirstChildIndex == rhs.FirstChildIndex && lhs.SecondChildIndex == rhs.SecondChildIndex &&
+			lhs.SplitAxis == rhs.SplitAxis;
+	}
+}
+
+// The pool must not change the tree, only the time it takes to build it
+TEST_CASE(BVHFactory_ParallelBuildMatchesSerial)
+{
+	TriangleSoup soup = MakeTriangleSoup(20000, 7);
+
+	for (const auto& strategy : GetStrategies())
+	{
+		BVH serial = BuildSoup(soup, strategy, nullptr, 4096);
+		BVHQualityReport serialReport = BVHFactory::GenerateQualityReport(serial);
+
+		for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+		{
+			// A small grain size pushes most of the tree through the pool
+			BVH parallel = BuildSoup(soup, strategy, std::make_shared<ThreadPool>(threadCount), 64);
+			BVHQualityReport parallelReport = BVHFactory::GenerateQualityReport(parallel);
+
+			CHECK_EQ(parallel.Nodes.size(), serial.Nodes.size());
+			CHECK_EQ(parallelReport.NodeCount, serialReport.NodeCount);
+			CHECK_EQ(parallelReport.LeafCount, serialReport.LeafCount);
+			CHECK_EQ(parallelReport.MaxDepth, serialReport.MaxDepth);
+			CHECK_EQ(parallelReport.SAHCost, serialReport.SAHCost);
+
+			if (parallel.Nodes.size() != serial.Nodes.size())
+				continue;
+
+			uint32_t mismatchCount = 0;
+
+			for (size_t i = 0; i < serial.Nodes.size(); i++)
+				mismatchCount += SameNode(serial.Nodes[i], parallel.Nodes[i]) ? 0 : 1;
+
+			CHECK_EQ(mismatchCount, 0u);
+
+			bool sameFaceOrder = std::equal(serial.Faces.begin(), serial.Faces.end(), parallel.Faces.begin(),
+				[](const Face& lhs, const Face& rhs) { return lhs.FaceID == rhs.FaceID; });
+
+			CHECK(sameFaceOrder);
+		}
+	}
+}
+
+TEST_CASE(BVHFactory_LeavesCoverEveryFace)
+{
+	TriangleSoup soup = MakeTriangleSoup(5000, 11);
+
+	for (const auto& strategy : GetStrategies())
+	{
+		BVH bvh = BuildSoup(soup, strategy, std::make_shared<ThreadPool>(4), 64);
+
+		std::vector<uint32_t> coverage(bvh.Faces.size(), 0);
+
+		for (const auto& node : bvh.Nodes)
+		{
+			if (node.FirstChildIndex != 0)
+				continue;
+
+			for (uint32_t i = node.BeginIndex; i < node.EndIndex; i++)
+				coverage[i]++;
+		}
+
+		CHECK(std::all_of(coverage.begin(), coverage.end(), [](uint32_t count) { return count == 1; }));
+		CHECK_EQ(BVHFactory::GenerateQualityReport(bvh).EmptyLeafCount, 0u);
+	}
+}
+
+// The reason for the SAH strategy, checked on the numbers of the quality report
+TEST_CASE(BVHFactory_SAHBeatsSpatialOnSkewedDensity)
+{
+	TriangleSoup soup = MakeSkewedSoup();
+
+	std::vector<BVHQualityReport> reports;
+
+	for (const auto& strategy : GetStrategies())
+	{
+		BVH bvh = BuildSoup(soup, strategy, nullptr, 4096);
+		BVHQualityReport report = BVHFactory::GenerateQualityReport(bvh);
+
+		uint32_t histogramLeaves = std::accumulate(report.LeafSizeHistogram.begin(),
+			report.LeafSizeHistogram.end(), 0u);
+
+		CHECK_EQ(histogramLeaves + report.EmptyLeafCount, report.LeafCount);
+		CHECK_EQ(report.NodeCount, 2 * report.LeafCount - 1);
+
+		reports.push_back(report);
+	}
+
+	CHECK(reports[1].SAHCost < reports[0].SAHCost);
+
+	if (reports[1].SAHCost >= reports[0].SAHCost)
+		std::cerr << "    SAH cost " << reports[1].SAHCost << ", spatial cost " << reports[0].SAHCost << std::endl;
+}
+
+// sSAH on its own only picks the plane, it has to use the bins of the strategy all the same
+TEST_CASE(BVHFactory_SAHSplitUsesStrategyParams)
+{
+	TriangleSoup soup = MakeSkewedSoup();
+
+	std::vector<BVH> trees;
+
+	for (uint32_t binCount : { 2u, 64u })
+	{
+		SplitStrategy strategy{ BVHFactory::DefaultSplitFn::sSAH };
+		strategy.mSAH_Params.BinCount = binCount;
+
+		trees.push_back(BuildSoup(soup, strategy, nullptr, 4096));
+	}
+
+	bool sameTree = trees[0].Nodes.size() == trees[1].Nodes.size() && std::equal(trees[0].Nodes.begin(),
+		trees[0].Nodes.end(), trees[1].Nodes.begin(), SameNode);
+
+	CHECK(!sameTree);
+}
+
+BENCHMARK(BVHFactory_BuildTimeByThreadCount)
+{
+	TriangleSoup soup = MakeTriangleSoup(500000, 3);
+
+	for (const auto& strategy : GetStrategies())
+	{
+		double serialMs = Tests::MeasureMs([&]() { BuildSoup(soup, strategy, nullptr, 4096); });
+
+		std::cout << "    " << (strategy.mUseSAH ? "SAH" : "Spatial") << " serial: " << serialMs << " ms" << std::endl;
+
+		for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+		{
+			auto pool = std::make_shared<ThreadPool>(threadCount);
+			double parallelMs = Tests::MeasureMs([&]() { BuildSoup(soup, strategy, pool, 4096); });
+
+			std::cout << "    " << (strategy.mUseSAH ? "SAH" : "Spatial") << " " << threadCount << " threads: "
+				<< parallelMs << " ms (" << serialMs / parallelMs << "x)" << std::endl;
+		}
+	}
+}
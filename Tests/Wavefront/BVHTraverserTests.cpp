@@ -0,0 +1,175 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+
+#include "Wavefront/BVHFactory.h"
+#include "Wavefront/BVHLayouts.h"
+#include "Wavefront/RayIntersection.h"
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+using namespace Tests;
+
+namespace
+{
+	float TraceBruteForce(const BVH& bvh, const Ray& ray)
+	{
+		RayQuery query = MakeRayQuery(ray);
+
+		float closestHit = FLT_MAX;
+
+		for (const auto& face : bvh.Faces)
+		{
+			TriangleHit hit;
+
+			if (IntersectTriangle(query, bvh.Vertices[face.Indices.x], bvh.Vertices[face.Indices.y],
+				bvh.Vertices[face.Indices.z], closestHit, hit))
+				closestHit = hit.Distance;
+		}
+
+		return closestHit;
+	}
+}
+
+// The shadow ray walk must agree with the closest hit one: occluded exactly when the closest hit is nearer than maxDis
+TEST_CASE(BVHTraverser_OcclusionMatchesClosestHit)
+{
+	TriangleSoup soup = MakeTriangleSoup(4000, 17);
+
+	SplitStrategy sah{ BVHFactory::DefaultSplitFn::sSAH };
+	sah.mUseSAH = true;
+
+	for (const auto& strategy : { SplitStrategy{ BVHFactory::DefaultSplitFn::sSpatialSplit }, sah })
+	{
+		BVHFactory factory;
+		factory.SetSplitStrategy(strategy);
+
+		BVH bvh = factory.Build(soup.Vertices.begin(), soup.Vertices.end(), soup.Faces.begin(), soup.Faces.end());
+		BVHTraverser traverser(bvh);
+
+		std::vector<Ray> rays = MakeRandomRays(4000, 19);
+
+		std::mt19937 engine(23);
+		std::uniform_real_distribution<float> distance(0.0f, 30.0f);
+
+		TraversalStats closestStats;
+		TraversalStats occludedStats;
+
+		uint32_t hitCount = 0;
+		uint32_t occludedCount = 0;
+		uint32_t mismatchCount = 0;
+		uint32_t bruteForceMismatchCount = 0;
+
+		for (const auto& ray : rays)
+		{
+			float maxDis = distance(engine);
+
+			float closestHit = traverser.TraceBinary(ray, closestStats);
+			bool occluded = traverser.OccludedBinary(ray, maxDis, occludedStats);
+
+			hitCount += closestHit < FLT_MAX ? 1 : 0;
+			occludedCount += occluded ? 1 : 0;
+			mismatchCount += occluded == (closestHit < maxDis) ? 0 : 1;
+			bruteForceMismatchCount += closestHit == TraceBruteForce(bvh, ray) ? 0 : 1;
+		}
+
+		// Both outcomes have to show up, otherwise the comparison says nothing
+		CHECK(occludedCount > 0);
+		CHECK(occludedCount < hitCount);
+
+		CHECK_EQ(mismatchCount, 0u);
+		CHECK_EQ(bruteForceMismatchCount, 0u);
+
+		// The any hit walk never does more work than the closest hit one
+		CHECK(occludedStats.TriangleTests <= closestStats.TriangleTests);
+		CHECK(occludedStats.NodeFetches <= closestStats.NodeFetches);
+	}
+}
+
+// The half precision bounds only ever grow the boxes and the wide nodes keep the binary leaves,
+// so every layout finds exactly the same hits
+TEST_CASE(BVHTraverser_LayoutsMatchBinary)
+{
+	TriangleSoup soup = MakeTriangleSoup(4000, 29);
+
+	BVHFactory factory;
+	BVH bvh = factory.Build(soup.Vertices.begin(), soup.Vertices.end(), soup.Faces.begin(), soup.Faces.end());
+
+	BVHTraverser traverser(bvh);
+
+	std::vector<CompactNode> compact = BVHConverter::ToCompact(bvh);
+	std::vector<WideNode<4>> wide4 = BVHConverter::ToWide<4>(bvh);
+	std::vector<WideNode<8>> wide8 = BVHConverter::ToWide<8>(bvh);
+
+	CHECK_EQ(compact.size(), bvh.Nodes.size());
+	CHECK(wide8.size() <= wide4.size());
+	CHECK(wide4.size() < bvh.Nodes.size());
+
+	TraversalStats stats;
+
+	uint32_t hitCount = 0;
+	uint32_t mismatchCount = 0;
+
+	for (const auto& ray : MakeRandomRays(4000, 31))
+	{
+		float bruteForce = TraceBruteForce(bvh, ray);
+
+		hitCount += bruteForce < FLT_MAX ? 1 : 0;
+
+		bool match = traverser.TraceBinary(ray, stats) == bruteForce &&
+			traverser.TraceCompact(compact, ray, stats) == bruteForce &&
+			traverser.TraceWide(wide4, ray, stats) == bruteForce &&
+			traverser.TraceWide(wide8, ray, stats) == bruteForce;
+
+		mismatchCount += match ? 0 : 1;
+	}
+
+	CHECK(hitCount > 0);
+	CHECK_EQ(mismatchCount, 0u);
+}
+
+// Footprint of each layout and the node fetches a ray pays for it
+BENCHMARK(BVHTraverser_LayoutFootprint)
+{
+	TriangleSoup soup = MakeTriangleSoup(200000, 37);
+
+	BVHFactory factory;
+	BVH bvh = factory.Build(soup.Vertices.begin(), soup.Vertices.end(), soup.Faces.begin(), soup.Faces.end());
+
+	BVHTraverser traverser(bvh);
+	std::vector<Ray> rays = MakeRandomRays(100000, 41);
+
+	auto Report = [&rays](const char* name, size_t bytes, const TraversalStats& stats, double ms)
+		{
+			double rayCount = static_cast<double>(rays.size());
+
+			std::cout << "    " << name << ": " << bytes / 1024 << " KiB, "
+				<< stats.NodeFetches / rayCount << " node fetches, " << stats.BoxTests / rayCount << " box tests and "
+				<< stats.TriangleTests / rayCount << " triangle tests per ray, " << 1.0e6 * ms / rayCount << " ns per ray" << std::endl;
+		};
+
+	TraversalStats binaryStats;
+	double binaryMs = MeasureMs([&]() { for (const auto& ray : rays) traverser.TraceBinary(ray, binaryStats); });
+
+	Report("Binary", bvh.Nodes.size() * sizeof(Node), binaryStats, binaryMs);
+
+	std::vector<CompactNode> compact = BVHConverter::ToCompact(bvh);
+
+	TraversalStats compactStats;
+	double compactMs = MeasureMs([&]() { for (const auto& ray : rays) traverser.TraceCompact(compact, ray, compactStats); });
+
+	Report("Compact", compact.size() * sizeof(CompactNode), compactStats, compactMs);
+
+	std::vector<WideNode<4>> wide4 = BVHConverter::ToWide<4>(bvh);
+
+	TraversalStats wide4Stats;
+	double wide4Ms = MeasureMs([&]() { for (const auto& ray : rays) traverser.TraceWide(wide4, ray, wide4Stats); });
+
+	Report("Wide4", wide4.size() * sizeof(WideNode<4>), wide4Stats, wide4Ms);
+
+	std::vector<WideNode<8>> wide8 = BVHConverter::ToWide<8>(bvh);
+
+	TraversalStats wide8Stats;
+	double wide8Ms = MeasureMs([&]() { for (const auto& ray : rays) traverser.TraceWide(wide8, ray, wide8Stats); });
+
+	Report("Wide8", wide8.size() * sizeof(WideNode<8>), wide8Stats, wide8Ms);
+}
@@ -0,0 +1,109 @@
+#include "TestFramework.h"
+#include "TestDevice.h"
+
+#include "Wavefront/PrefixScanRecorder.h"
+#include "Wavefront/WavefrontEstimator.h"
+#include "Utils/CompilerErrorChecker.h"
+
+#include <numeric>
+#include <random>
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+
+namespace
+{
+	// Same shader setup as WavefrontEstimator::GetPrefixScanShader
+	PrefixScanPipeline BuildScanStage(const vkEngine::PipelineBuilder& builder, PrefixScanStage stage, const PrefixScanInfo& scanInfo)
+	{
+		vkEngine::PShader shader;
+
+		shader.AddMacro("WORKGROUP_SIZE", std::to_string(scanInfo.WorkGroupSize));
+		shader.AddMacro("ITEMS_PER_THREAD", std::to_string(scanInfo.ItemsPerThread));
+		shader.AddMacro("PREFIX_SCAN_STAGE", std::to_string(static_cast<uint32_t>(stage)));
+
+		shader.SetFilepath("eCompute", WavefrontEstimator::GetShaderDirectory() + "Utils/PrefixScan.glsl");
+
+		CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+		checker.AssertOnError(shader.CompileShaders());
+
+		return builder.BuildComputePipeline<PrefixScanPipeline>(shader);
+	}
+
+	std::vector<uint32_t> MakeCounts(uint32_t size, uint32_t seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<uint32_t> count(0, 16);
+
+		std::vector<uint32_t> values(size);
+
+		for (auto& value : values)
+			value = count(engine);
+
+		return values;
+	}
+}
+
+// Runs the scan shaders on the device over the sizes the host mirror in PrefixScanTests.cpp covers
+DEVICE_TEST(PrefixScanRecorder_MatchesStdScan)
+{
+	vkEngine::Context context = Tests::GetTestDevice().Context;
+	uint32_t familyIndex = context.GetQueueManager()->FindOptimalQueueFamilyIndex(vk::QueueFlagBits::eCompute);
+
+	vkEngine::ResourcePool resourcePool = context.CreateResourcePool();
+	vkEngine::PipelineBuilder builder = context.MakePipelineBuilder();
+	vkEngine::CommandPools commandPools = context.CreateCommandPools(true);
+
+	PrefixScanInfo scanInfo{};
+
+	PrefixScanRecorder recorder(scanInfo, resourcePool,
+		BuildScanStage(builder, PrefixScanStage::eScanTiles, scanInfo),
+		BuildScanStage(builder, PrefixScanStage::eScanTileSums, scanInfo),
+		BuildScanStage(builder, PrefixScanStage::eAddTileOffsets, scanInfo));
+
+	// Host visible so the test can fill and read it back directly
+	vkEngine::Buffer<uint32_t> elements = resourcePool.CreateBuffer<uint32_t>(
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	uint32_t tileSize = scanInfo.WorkGroupSize * scanInfo.ItemsPerThread;
+
+	std::vector<uint32_t> sizes = { 1, 255, 256, 257, tileSize - 1, tileSize, tileSize + 1,
+		tileSize * tileSize - 1, tileSize * tileSize + 1, 1u << 20 };
+
+	for (uint32_t size : sizes)
+	{
+		std::vector<uint32_t> input = MakeCounts(size, size);
+
+		for (PrefixScanType type : { PrefixScanType::eExclusive, PrefixScanType::eInclusive })
+		{
+			std::vector<uint32_t> expected(size);
+
+			if (type == PrefixScanType::eExclusive)
+				std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+			else
+				std::inclusive_scan(input.begin(), input.end(), expected.begin());
+
+			elements.Clear();
+			elements << input;
+
+			recorder.SetBuffer(elements);
+
+			vk::CommandBuffer commandBuffer = commandPools[familyIndex].BeginOneTimeCommands();
+			recorder.Run(commandBuffer, size, type);
+
+			commandPools[familyIndex].EndOneTimeCommands(commandBuffer,
+				context.FetchExecutor(familyIndex, vkEngine::QueueAccessType::eWorker));
+
+			std::vector<uint32_t> result;
+			elements >> result;
+
+			bool match = result == expected;
+			CHECK(match);
+
+			if (!match)
+				std::cerr << "    " << (type == PrefixScanType::eExclusive ? "exclusive" : "inclusive")
+					<< ", size " << size << std::endl;
+		}
+	}
+}
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+
+#include <numeric>
+#include <random>
+
+// Host mirror of Shaders/Utils/PrefixScan.glsl, dispatched the way PrefixScanRecorder::Run does it
+// The invocations of a workgroup run one after the other between the barriers
+namespace
+{
+	struct HostPrefixScan
+	{
+		uint32_t WorkGroupSize = 256;
+		uint32_t ItemsPerThread = 4;
+
+		uint32_t GetTileSize() const { return WorkGroupSize * ItemsPerThread; }
+
+		uint32_t GetTileCount(uint32_t elementCount) const
+		{
+			return (elementCount + GetTileSize() - 1) / GetTileSize();
+		}
+
+		// Blelloch scan of one value per invocation, same up and down sweep as ScanWorkGroup
+		std::vector<uint32_t> ScanWorkGroup(std::vector<uint32_t> scan, uint32_t& total) const
+		{
+			for (uint32_t stride = 1; stride < WorkGroupSize; stride <<= 1)
+			{
+				for (uint32_t localIdx = 0; localIdx < WorkGroupSize; localIdx++)
+				{
+					uint32_t idx = (localIdx + 1) * 2 * stride - 1;
+
+					if (idx < WorkGroupSize)
+						scan[idx] += scan[idx - stride];
+				}
+			}
+
+			total = scan[WorkGroupSize - 1];
+			scan[WorkGroupSize - 1] = 0;
+
+			for (uint32_t stride = WorkGroupSize / 2; stride > 0; stride >>= 1)
+			{
+				for (uint32_t localIdx = 0; localIdx < WorkGroupSize; localIdx++)
+				{
+					uint32_t idx = (localIdx + 1) * 2 * stride - 1;
+
+					if (idx < WorkGroupSize)
+					{
+						uint32_t left = scan[idx - stride];
+						scan[idx - stride] = scan[idx];
+						scan[idx] += left;
+					}
+				}
+			}
+
+			return scan;
+		}
+
+		uint32_t ScanTile(std::vector<uint32_t>& array, uint32_t bufferSize,
+			uint32_t tileBegin, uint32_t carry, bool inclusive) const
+		{
+			std::vector<uint32_t> values(GetTileSize(), 0);
+			std::vector<uint32_t> threadSums(WorkGroupSize, 0);
+
+			for (uint32_t localIdx = 0; localIdx < WorkGroupSize; localIdx++)
+			{
+				for (uint32_t i = 0; i < ItemsPerThread; i++)
+				{
+					uint32_t idx = tileBegin + localIdx * ItemsPerThread + i;
+					uint32_t& value = values[localIdx * ItemsPerThread + i];
+
+					value = idx < bufferSize ? array[idx] : 0;
+					threadSums[localIdx] += value;
+				}
+			}
+
+			uint32_t tileSum;
+			std::vector<uint32_t> prefixes = ScanWorkGroup(threadSums, tileSum);
+
+			for (uint32_t localIdx = 0; localIdx < WorkGroupSize; localIdx++)
+			{
+				uint32_t prefix = carry + prefixes[localIdx];
+
+				for (uint32_t i = 0; i < ItemsPerThread; i++)
+				{
+					uint32_t idx = tileBegin + localIdx * ItemsPerThread + i;
+					uint32_t value = values[localIdx * ItemsPerThread + i];
+
+					if (idx < bufferSize)
+						array[idx] = inclusive ? prefix + value : prefix;
+
+					prefix += value;
+				}
+			}
+
+			return tileSum;
+		}
+
+		void Run(std::vector<uint32_t>& elements, bool inclusive) const
+		{
+			uint32_t elementCount = static_cast<uint32_t>(elements.size());
+			uint32_t tileCount = GetTileCount(elementCount);
+
+			// PrefixScanRecorder sizes the tile sums to at least one element
+			std::vector<uint32_t> tileSums(std::max(tileCount, 1u), 0);
+
+			// Stage 0
+			for (uint32_t workGroup = 0; workGroup < tileCount; workGroup++)
+				tileSums[workGroup] = ScanTile(elements, elementCount, workGroup * GetTileSize(), 0, inclusive);
+
+			if (tileCount <= 1)
+				return;
+
+			// Stage 1, a single workgroup walks over the tile sums
+			uint32_t carry = 0;
+
+			for (uint32_t tileBegin = 0; tileBegin < tileCount; tileBegin += GetTileSize())
+				carry += ScanTile(tileSums, tileCount, tileBegin, carry, false);
+
+			// Stage 2
+			for (uint32_t workGroup = 1; workGroup < tileCount; workGroup++)
+			{
+				for (uint32_t i = 0; i < GetTileSize(); i++)
+				{
+					uint32_t idx = workGroup * GetTileSize() + i;
+
+					if (idx < elementCount)
+						elements[idx] += tileSums[workGroup];
+				}
+			}
+		}
+	};
+
+	std::vector<uint32_t> MakeCounts(uint32_t size, uint32_t seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<uint32_t> count(0, 16);
+
+		std::vector<uint32_t> values(size);
+
+		for (auto& value : values)
+			value = count(engine);
+
+		return values;
+	}
+}
+
+TEST_CASE(PrefixScan_MatchesStdScan)
+{
+	// The default configuration, a single thread per element and one with wide threads
+	std::vector<HostPrefixScan> configs = { { 256, 4 }, { 64, 1 }, { 32, 8 } };
+
+	for (const auto& scan : configs)
+	{
+		uint32_t tileSize = scan.GetTileSize();
+
+		std::vector<uint32_t> sizes = { 1, 255, 256, 257, tileSize - 1, tileSize, tileSize + 1,
+			tileSize * tileSize - 1, tileSize * tileSize + 1, 1u << 20 };
+
+		for (uint32_t size : sizes)
+		{
+			std::vector<uint32_t> input = MakeCounts(size, size);
+
+			std::vector<uint32_t> expected(size);
+			std::vector<uint32_t> result = input;
+
+			std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+			scan.Run(result, false);
+
+			bool exclusiveMatch = result == expected;
+
+			std::inclusive_scan(input.begin(), input.end(), expected.begin());
+			result = input;
+			scan.Run(result, true);
+
+			bool inclusiveMatch = result == expected;
+
+			CHECK(exclusiveMatch);
+			CHECK(inclusiveMatch);
+
+			if (!exclusiveMatch || !inclusiveMatch)
+				std::cerr << "    work group " << scan.WorkGroupSize << ", items " << scan.ItemsPerThread
+					<< ", size " << size << std::endl;
+		}
+	}
+}
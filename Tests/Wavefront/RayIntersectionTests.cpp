@@ -0,0 +1,368 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+
+#include "Wavefront/RayIntersection.h"
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+using namespace Tests;
+
+namespace
+{
+	// The tests as they were before the ray query, kept here to compare against
+
+	bool LegacyIntersectBox(const Ray& ray, const glm::vec3& minBound, const glm::vec3& maxBound, float& entry)
+	{
+		glm::vec3 InvDir = 1.0f / ray.Direction;
+
+		glm::vec3 T0 = (minBound - ray.Origin) * InvDir;
+		glm::vec3 T1 = (maxBound - ray.Origin) * InvDir;
+
+		glm::vec3 TNear = glm::min(T0, T1);
+		glm::vec3 TFar = glm::max(T0, T1);
+
+		float Enter = std::max(std::max(TNear.x, TNear.y), TNear.z);
+		float Exit = std::min(std::min(TFar.x, TFar.y), TFar.z);
+
+		entry = std::max(Enter, 0.0f);
+
+		return Enter < Exit && Exit > 0.0f;
+	}
+
+	// Normalizes the normal and fills the hit before deciding whether it's accepted
+	bool LegacyIntersectTriangle(const Ray& ray, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C,
+		float maxDis, TriangleHit& hit)
+	{
+		glm::vec3 E1 = B - A;
+		glm::vec3 E2 = C - A;
+
+		glm::vec3 Normal = glm::normalize(glm::cross(E1, E2));
+
+		glm::vec3 H = glm::cross(ray.Direction, E2);
+		float Determinant = glm::dot(E1, H);
+
+		float DeterminantInv = 1.0f / Determinant;
+
+		glm::vec3 T = ray.Origin - A;
+		glm::vec3 Q = glm::cross(T, E1);
+
+		float U = glm::dot(T, H) * DeterminantInv;
+		float V = glm::dot(ray.Direction, Q) * DeterminantInv;
+		float Alpha = glm::dot(E2, Q) * DeterminantInv;
+
+		TriangleHit Candidate;
+		Candidate.Distance = Alpha;
+		Candidate.bCoords = glm::vec3(1.0f - U - V, U, V);
+		Candidate.Normal = glm::dot(Normal, ray.Direction) < 0.0f ? Normal : -Normal;
+
+		if (!(U >= 0.0f && V >= 0.0f && U + V <= 1.0f && Alpha > 0.0f && Alpha < maxDis &&
+			std::abs(Determinant) > FLT_EPSILON))
+			return false;
+
+		hit = Candidate;
+		return true;
+	}
+
+	struct Triangle
+	{
+		glm::vec3 A, B, C;
+	};
+
+	// Rays aimed close to each triangle so that both hits and near misses show up
+	void MakeAimedPairs(uint32_t count, uint32_t seed, std::vector<Ray>& rays, std::vector<Triangle>& triangles)
+	{
+		TriangleSoup soup = MakeTriangleSoup(count, seed);
+		rays = MakeRandomRays(count, seed + 1);
+
+		std::mt19937 engine(seed + 2);
+		std::uniform_real_distribution<float> weight(-0.2f, 1.2f);
+
+		triangles.resize(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Face& face = soup.Faces[i];
+
+			Triangle& triangle = triangles[i];
+			triangle = { soup.Vertices[face.Indices.x], soup.Vertices[face.Indices.y], soup.Vertices[face.Indices.z] };
+
+			float U = weight(engine);
+			float V = weight(engine);
+
+			glm::vec3 Target = triangle.A + U * (triangle.B - triangle.A) + V * (triangle.C - triangle.A);
+			rays[i].Direction = glm::normalize(Target - rays[i].Origin);
+		}
+	}
+}
+
+// Multiplying by the stored reciprocal is the same float operation the division did
+TEST_CASE(RayIntersection_SlabMatchesDivision)
+{
+	std::vector<Ray> rays = MakeRandomRays(200000, 5);
+
+	std::mt19937 engine(7);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> extent(0.0f, 4.0f);
+
+	uint32_t hitCount = 0;
+	uint32_t mismatchCount = 0;
+
+	for (const auto& ray : rays)
+	{
+		glm::vec3 minBound(position(engine), position(engine), position(engine));
+		glm::vec3 maxBound = minBound + glm::vec3(extent(engine), extent(engine), extent(engine));
+
+		float legacyEntry = 0.0f;
+		float entry = 0.0f;
+
+		bool legacyHit = LegacyIntersectBox(ray, minBound, maxBound, legacyEntry);
+		bool hit = IntersectSlab(MakeRayQuery(ray), minBound, maxBound, entry);
+
+		hitCount += hit ? 1 : 0;
+		mismatchCount += legacyHit == hit && (!hit || legacyEntry == entry) ? 0 : 1;
+	}
+
+	CHECK(hitCount > 0);
+	CHECK_EQ(mismatchCount, 0u);
+}
+
+// Deferring the normal and rejecting early must not change a single accepted hit
+TEST_CASE(RayIntersection_TriangleMatchesEagerNormal)
+{
+	std::vector<Ray> rays;
+	std::vector<Triangle> triangles;
+
+	MakeAimedPairs(200000, 11, rays, triangles);
+
+	std::mt19937 engine(13);
+	std::uniform_real_distribution<float> distance(0.0f, 40.0f);
+
+	uint32_t hitCount = 0;
+	uint32_t mismatchCount = 0;
+
+	for (size_t i = 0; i < rays.size(); i++)
+	{
+		const Triangle& triangle = triangles[i];
+		float maxDis = distance(engine);
+
+		TriangleHit legacy;
+		TriangleHit current;
+
+		bool legacyHit = LegacyIntersectTriangle(rays[i], triangle.A, triangle.B, triangle.C, maxDis, legacy);
+		bool hit = IntersectTriangle(MakeRayQuery(rays[i]), triangle.A, triangle.B, triangle.C, maxDis, current);
+
+		hitCount += hit ? 1 : 0;
+
+		if (legacyHit != hit)
+		{
+			mismatchCount++;
+			continue;
+		}
+
+		if (hit && (legacy.Distance != current.Distance || legacy.bCoords != current.bCoords ||
+			legacy.Normal != current.Normal))
+			mismatchCount++;
+	}
+
+	CHECK(hitCount > 0);
+	CHECK(hitCount < rays.size());
+	CHECK_EQ(mismatchCount, 0u);
+}
+
+// Rays through the shared diagonal of a quad have to hit at least one half, away from the edges
+// the watertight test agrees with Moller-Trumbore
+TEST_CASE(RayIntersection_WatertightClosesSharedEdge)
+{
+	std::vector<Ray> rays = MakeRandomRays(200000, 29);
+
+	std::mt19937 engine(31);
+	std::uniform_real_distribution<float> corner(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> along(0.0f, 1.0f);
+	std::uniform_real_distribution<float> inside(0.05f, 0.9f);
+
+	uint32_t mollerLeakCount = 0;
+	uint32_t watertightLeakCount = 0;
+
+	uint32_t interiorCount = 0;
+	uint32_t interiorMismatchCount = 0;
+
+	for (const auto& sample : rays)
+	{
+		glm::vec3 P0(corner(engine), corner(engine), corner(engine));
+		glm::vec3 P1(corner(engine), corner(engine), corner(engine));
+		glm::vec3 P2(corner(engine), corner(engine), corner(engine));
+		glm::vec3 P3 = P0 + P2 - P1;
+
+		// P0 and P2 form the diagonal, both halves wind the same way
+		Ray ray = sample;
+		ray.Direction = glm::normalize(glm::mix(P0, P2, along(engine)) - ray.Origin);
+
+		RayQuery query = MakeRayQuery(ray);
+		TriangleHit hit;
+
+		bool mollerHit = IntersectTriangle(query, P0, P1, P2, FLT_MAX, hit) ||
+			IntersectTriangle(query, P0, P2, P3, FLT_MAX, hit);
+
+		bool watertightHit = IntersectTriangleWatertight(query, P0, P1, P2, FLT_MAX, hit) ||
+			IntersectTriangleWatertight(query, P0, P2, P3, FLT_MAX, hit);
+
+		// Rays behind their origin or grazing the quad's plane miss legitimately
+		glm::vec3 Normal = glm::normalize(glm::cross(P1 - P0, P2 - P0));
+		bool inFront = glm::dot(glm::mix(P0, P2, 0.5f) - ray.Origin, ray.Direction) > 0.0f &&
+			std::abs(glm::dot(Normal, ray.Direction)) > 1.0e-3f;
+
+		if (!inFront)
+			continue;
+
+		mollerLeakCount += mollerHit ? 0 : 1;
+		watertightLeakCount += watertightHit ? 0 : 1;
+
+		// A second ray through the interior of the first half
+		float U = inside(engine);
+		float V = inside(engine) * (0.95f - U);
+
+		ray.Direction = glm::normalize(P0 + U * (P1 - P0) + V * (P2 - P0) - ray.Origin);
+		query = MakeRayQuery(ray);
+
+		// Near grazing the distance itself is ill conditioned
+		if (std::abs(glm::dot(Normal, ray.Direction)) < 0.05f)
+			continue;
+
+		TriangleHit moller;
+		TriangleHit watertight;
+
+		bool interiorMollerHit = IntersectTriangle(query, P0, P1, P2, FLT_MAX, moller);
+		bool interiorWatertightHit = IntersectTriangleWatertight(query, P0, P1, P2, FLT_MAX, watertight);
+
+		if (!interiorMollerHit && !interiorWatertightHit)
+			continue;
+
+		interiorCount++;
+
+		if (interiorMollerHit != interiorWatertightHit ||
+			std::abs(moller.Distance - watertight.Distance) > 1.0e-4f * moller.Distance ||
+			glm::dot(moller.Normal, watertight.Normal) < 0.9999f)
+			interiorMismatchCount++;
+	}
+
+	std::cout << "    Rays slipping through the shared edge, Moller-Trumbore: " << mollerLeakCount
+		<< ", watertight: " << watertightLeakCount << std::endl;
+
+	CHECK_EQ(watertightLeakCount, 0u);
+
+	CHECK(interiorCount > 0);
+	CHECK_EQ(interiorMismatchCount, 0u);
+}
+
+BENCHMARK(RayIntersection_TestThroughput)
+{
+	// Every ray is tested against a run of primitives, the way a leaf or a node's children are
+	constexpr uint32_t sRayCount = 4096;
+	constexpr uint32_t sPrimitiveCount = 256;
+
+	std::vector<Ray> rays = MakeRandomRays(sRayCount, 37);
+
+	std::vector<Ray> aimedRays;
+	std::vector<Triangle> triangles;
+
+	MakeAimedPairs(sPrimitiveCount, 41, aimedRays, triangles);
+
+	std::mt19937 engine(43);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> extent(0.0f, 4.0f);
+
+	std::vector<std::pair<glm::vec3, glm::vec3>> boxes(sPrimitiveCount);
+
+	for (auto& [minBound, maxBound] : boxes)
+	{
+		minBound = glm::vec3(position(engine), position(engine), position(engine));
+		maxBound = minBound + glm::vec3(extent(engine), extent(engine), extent(engine));
+	}
+
+	double testCount = static_cast<double>(sRayCount) * sPrimitiveCount;
+
+	// The hit counts keep the loops from being optimized away
+	auto Report = [testCount](const char* name, double ms, uint32_t hitCount)
+		{
+			std::cout << "    " << name << ": " << 1.0e6 * ms / testCount << " ns per test ("
+				<< hitCount << " hits)" << std::endl;
+		};
+
+	uint32_t hitCount = 0;
+
+	double legacyBoxMs = MeasureMs([&]()
+		{
+			for (const auto& ray : rays)
+				for (const auto& [minBound, maxBound] : boxes)
+				{
+					float entry;
+					hitCount += LegacyIntersectBox(ray, minBound, maxBound, entry) ? 1 : 0;
+				}
+		});
+
+	Report("Box, dividing", legacyBoxMs, hitCount);
+	hitCount = 0;
+
+	double slabMs = MeasureMs([&]()
+		{
+			for (const auto& ray : rays)
+			{
+				RayQuery query = MakeRayQuery(ray);
+
+				for (const auto& [minBound, maxBound] : boxes)
+				{
+					float entry;
+					hitCount += IntersectSlab(query, minBound, maxBound, entry) ? 1 : 0;
+				}
+			}
+		});
+
+	Report("Box, reciprocal", slabMs, hitCount);
+	hitCount = 0;
+
+	double legacyTriangleMs = MeasureMs([&]()
+		{
+			for (const auto& ray : rays)
+				for (const auto& triangle : triangles)
+				{
+					TriangleHit hit;
+					hitCount += LegacyIntersectTriangle(ray, triangle.A, triangle.B, triangle.C, FLT_MAX, hit) ? 1 : 0;
+				}
+		});
+
+	Report("Triangle, eager normal", legacyTriangleMs, hitCount);
+	hitCount = 0;
+
+	double triangleMs = MeasureMs([&]()
+		{
+			for (const auto& ray : rays)
+			{
+				RayQuery query = MakeRayQuery(ray);
+
+				for (const auto& triangle : triangles)
+				{
+					TriangleHit hit;
+					hitCount += IntersectTriangle(query, triangle.A, triangle.B, triangle.C, FLT_MAX, hit) ? 1 : 0;
+				}
+			}
+		});
+
+	Report("Triangle, deferred normal", triangleMs, hitCount);
+	hitCount = 0;
+
+	double watertightMs = MeasureMs([&]()
+		{
+			for (const auto& ray : rays)
+			{
+				RayQuery query = MakeRayQuery(ray);
+
+				for (const auto& triangle : triangles)
+				{
+					TriangleHit hit;
+					hitCount += IntersectTriangleWatertight(query, triangle.A, triangle.B, triangle.C, FLT_MAX, hit) ? 1 : 0;
+				}
+			}
+		});
+
+	Report("Triangle, watertight", watertightMs, hitCount);
+}
@@ -0,0 +1,242 @@
+#include "TestFramework.h"
+#include "TestDevice.h"
+
+#include "Wavefront/RadixSortRecorder.h"
+#include "Wavefront/WavefrontEstimator.h"
+#include "Utils/CompilerErrorChecker.h"
+
+#include <random>
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+
+namespace
+{
+	// Same shader setup as WavefrontEstimator::GetRadixSortShader
+	RadixSortPipeline BuildSortStage(const vkEngine::PipelineBuilder& builder, RadixSortStage stage, const RadixSortInfo& sortInfo)
+	{
+		vkEngine::PShader shader;
+
+		shader.AddMacro("WORKGROUP_SIZE", std::to_string(sortInfo.WorkGroupSize));
+		shader.AddMacro("ITEMS_PER_THREAD", std::to_string(sortInfo.ItemsPerThread));
+		shader.AddMacro("RADIX_BITS", std::to_string(sortInfo.RadixBits));
+		shader.AddMacro("RADIX_SORT_STAGE", std::to_string(static_cast<uint32_t>(stage)));
+
+		shader.SetFilepath("eCompute", WavefrontEstimator::GetShaderDirectory() + "Utils/RadixSort.glsl");
+
+		CompileErrorChecker checker("Logging/ShaderFails/Shader.glsl");
+		checker.AssertOnError(shader.CompileShaders());
+
+		return builder.BuildComputePipeline<RadixSortPipeline>(shader);
+	}
+
+	// Both ray sorters, set up the way WavefrontEstimator::CreatePipelines does it
+	struct RaySorters
+	{
+		vkEngine::Context Context;
+		uint32_t FamilyIndex = 0;
+
+		vkEngine::CommandPools CommandPools;
+
+		std::shared_ptr<RaySortRecorder> MergeSorter;
+		RadixSortRecorder RadixSorter;
+
+		// Host visible so the tests can fill and read them back directly
+		RayRefBuffer Refs;
+		RayRefBuffer MergeOutput;
+		RayQueueBuffer ElementCounts;
+	};
+
+	RaySorters CreateRaySorters()
+	{
+		RaySorters sorters;
+
+		sorters.Context = Tests::GetTestDevice().Context;
+		sorters.FamilyIndex = sorters.Context.GetQueueManager()->FindOptimalQueueFamilyIndex(vk::QueueFlagBits::eCompute);
+		sorters.CommandPools = sorters.Context.CreateCommandPools(true);
+
+		vkEngine::ResourcePool resourcePool = sorters.Context.CreateResourcePool();
+		vkEngine::PipelineBuilder builder = sorters.Context.MakePipelineBuilder();
+
+		sorters.MergeSorter = std::make_shared<RaySortRecorder>(builder, resourcePool);
+		sorters.MergeSorter->InvalidateSorterPipeline(256);
+
+		RadixSortInfo sortInfo{};
+
+		sorters.RadixSorter = RadixSortRecorder(sortInfo, resourcePool,
+			BuildSortStage(builder, RadixSortStage::eHistogram, sortInfo),
+			BuildSortStage(builder, RadixSortStage::eScan, sortInfo),
+			BuildSortStage(builder, RadixSortStage::eScatter, sortInfo));
+
+		vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer;
+		vk::MemoryPropertyFlags memProps = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+		sorters.Refs = resourcePool.CreateBuffer<RayRef>(usage, memProps);
+		sorters.MergeOutput = resourcePool.CreateBuffer<RayRef>(usage, memProps);
+		sorters.ElementCounts = resourcePool.CreateBuffer<RayQueue>(usage, memProps);
+
+		return sorters;
+	}
+
+	// Sorts the first elementCount references of the half and returns them, the merge sort always sorts the whole half
+	// Only the sort itself is timed, the uploads and readbacks are left out
+	std::vector<RayRef> SortRefs(RaySorters& sorters, RaySortAlgorithm algorithm, const std::vector<RayRef>& half,
+		uint32_t elementCount, uint32_t keyCount, double& elapsedMs)
+	{
+		uint32_t halfSize = static_cast<uint32_t>(half.size());
+
+		const vkEngine::CommandBufferAllocator& commandPool = sorters.CommandPools[sorters.FamilyIndex];
+		vkEngine::Core::Executor executor = sorters.Context.FetchExecutor(sorters.FamilyIndex, vkEngine::QueueAccessType::eWorker);
+
+		sorters.Refs.Clear();
+		sorters.Refs << half;
+
+		std::vector<RayRef> sorted(elementCount);
+
+		if (algorithm == RaySortAlgorithm::eMergeSort)
+		{
+			sorters.MergeSorter->ResizeBuffer(2 * halfSize);
+			sorters.MergeSorter->SetBuffer(sorters.Refs);
+
+			vk::CommandBuffer commandBuffer = commandPool.BeginOneTimeCommands();
+			uint32_t activeBuffer = sorters.MergeSorter->Run(commandBuffer);
+
+			elapsedMs = Tests::MeasureMs([&]() { commandPool.EndOneTimeCommands(commandBuffer, executor); });
+
+			sorters.MergeOutput.Resize(halfSize);
+			sorters.MergeSorter->CopyOutput(sorters.MergeOutput, activeBuffer);
+			sorters.MergeOutput.FetchMemory(sorted.begin(), sorted.end());
+
+			return sorted;
+		}
+
+		RayQueue elementQueue{};
+		elementQueue.RayCount = elementCount;
+
+		sorters.ElementCounts.Clear();
+		sorters.ElementCounts << elementQueue;
+
+		sorters.Refs.Resize(2 * halfSize);
+		sorters.RadixSorter.SetBuffers(sorters.Refs, sorters.ElementCounts);
+
+		vk::CommandBuffer commandBuffer = commandPool.BeginOneTimeCommands();
+		uint32_t activeBuffer = sorters.RadixSorter.Run(commandBuffer, keyCount);
+
+		elapsedMs = Tests::MeasureMs([&]() { commandPool.EndOneTimeCommands(commandBuffer, executor); });
+
+		sorters.Refs.FetchMemory(sorted.begin(), sorted.end(), activeBuffer * halfSize);
+
+		return sorted;
+	}
+
+	// Keys spread over [0, keyCount + 8), so a few of them land past the last material like the inactive rays do
+	std::vector<RayRef> MakeRayRefs(uint32_t size, uint32_t keyCount, uint32_t seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<uint32_t> key(0, keyCount + 7);
+
+		std::vector<RayRef> refs(size);
+
+		for (uint32_t i = 0; i < size; i++)
+			refs[i] = { key(engine), i };
+
+		return refs;
+	}
+
+	// The radix sort files every key at or above keyCount under keyCount - 1
+	std::vector<RayRef> SortOnHost(const std::vector<RayRef>& half, uint32_t elementCount, uint32_t keyCount, bool clampKeys)
+	{
+		std::vector<RayRef> sorted(half.begin(), half.begin() + elementCount);
+
+		auto SortKey = [keyCount, clampKeys](const RayRef& ref)
+			{ return clampKeys ? std::min(ref.CompareElem, keyCount - 1) : ref.CompareElem; };
+
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[&SortKey](const RayRef& lhs, const RayRef& rhs) { return SortKey(lhs) < SortKey(rhs); });
+
+		return sorted;
+	}
+}
+
+// Both sorters against std::stable_sort, equal keys have to keep the order of their ray indices
+DEVICE_TEST(RaySort_MatchesStableSort)
+{
+	RaySorters sorters = CreateRaySorters();
+
+	uint32_t tileSize = sorters.RadixSorter.GetInfo().WorkGroupSize * sorters.RadixSorter.GetInfo().ItemsPerThread;
+
+	std::vector<uint32_t> sizes = { 1, 1000, tileSize - 1, tileSize, tileSize + 1, 3 * tileSize + 17, 100003, 1u << 20 };
+
+	// One, two and three digit passes
+	std::vector<uint32_t> keyCounts = { 5, 300, 70000 };
+
+	for (RaySortAlgorithm algorithm : { RaySortAlgorithm::eMergeSort, RaySortAlgorithm::eRadixSort })
+	{
+		bool radixSort = algorithm == RaySortAlgorithm::eRadixSort;
+
+		for (uint32_t keyCount : keyCounts)
+		{
+			for (uint32_t size : sizes)
+			{
+				// The radix sort only sorts the live front of the half, the rest is left as it is
+				uint32_t halfSize = radixSort ? size + 517 : size;
+
+				std::vector<RayRef> half = MakeRayRefs(halfSize, keyCount, size ^ keyCount);
+				std::vector<RayRef> expected = SortOnHost(half, size, keyCount, radixSort);
+
+				double elapsedMs;
+				std::vector<RayRef> sorted = SortRefs(sorters, algorithm, half, size, keyCount, elapsedMs);
+
+				uint32_t mismatchCount = 0;
+
+				for (uint32_t i = 0; i < size; i++)
+				{
+					bool match = sorted[i].CompareElem == expected[i].CompareElem &&
+						sorted[i].ElemIdx == expected[i].ElemIdx;
+
+					mismatchCount += match ? 0 : 1;
+				}
+
+				CHECK_EQ(mismatchCount, 0u);
+
+				if (mismatchCount != 0)
+					std::cerr << "    " << (radixSort ? "radix" : "merge") << " sort, "
+						<< keyCount << " keys, size " << size << std::endl;
+			}
+		}
+	}
+}
+
+BENCHMARK(RaySort_SortTimeByRayCount)
+{
+	RaySorters sorters = CreateRaySorters();
+
+	// A handful of materials plus the ids of the inactive rays
+	constexpr uint32_t sKeyCount = 64;
+	constexpr uint32_t sRepeatCount = 5;
+
+	for (uint32_t rayCount = 1u << 14; rayCount <= 1u << 22; rayCount <<= 2)
+	{
+		std::vector<RayRef> half = MakeRayRefs(rayCount, sKeyCount, rayCount);
+
+		std::cout << "    " << rayCount << " rays:";
+
+		for (RaySortAlgorithm algorithm : { RaySortAlgorithm::eMergeSort, RaySortAlgorithm::eRadixSort })
+		{
+			double totalMs = 0.0;
+
+			for (uint32_t repeat = 0; repeat < sRepeatCount; repeat++)
+			{
+				double elapsedMs;
+				SortRefs(sorters, algorithm, half, rayCount, sKeyCount, elapsedMs);
+
+				totalMs += elapsedMs;
+			}
+
+			std::cout << (algorithm == RaySortAlgorithm::eMergeSort ? " merge " : ", radix ")
+				<< totalMs / sRepeatCount << " ms";
+		}
+
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,162 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+
+#include "Wavefront/ReferenceTracer.h"
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+using namespace Tests;
+
+namespace
+{
+	// Closed cube around the origin, the camera of an identity view sits in its center
+	MeshData MakeEnclosure(float halfExtent)
+	{
+		MeshData enclosure;
+
+		for (int i = 0; i < 8; i++)
+		{
+			enclosure.aPositions.emplace_back((i & 1) ? halfExtent : -halfExtent,
+				(i & 2) ? halfExtent : -halfExtent, (i & 4) ? halfExtent : -halfExtent);
+		}
+
+		// Two triangles per side, the corners of each side listed around its perimeter
+		const uint32_t sides[6][4] = {
+			{ 0, 1, 3, 2 }, { 4, 5, 7, 6 },
+			{ 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+			{ 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+		};
+
+		for (const auto& side : sides)
+		{
+			Face first{};
+			first.Indices = glm::uvec4(side[0], side[1], side[2], 0);
+			first.FaceID = static_cast<uint32_t>(enclosure.aFaces.size());
+			enclosure.aFaces.push_back(first);
+
+			Face second{};
+			second.Indices = glm::uvec4(side[0], side[2], side[3], 0);
+			second.FaceID = static_cast<uint32_t>(enclosure.aFaces.size());
+			enclosure.aFaces.push_back(second);
+		}
+
+		return enclosure;
+	}
+
+	// A lit enclosure with a soup of rough and glossy triangles in front of the camera
+	void SubmitLitSoup(ReferenceTracer& tracer)
+	{
+		TriangleSoup soup = MakeTriangleSoup(2000, 43, 4.0f);
+
+		MeshData soupMesh;
+		soupMesh.aPositions = soup.Vertices;
+		soupMesh.aFaces = soup.Faces;
+
+		for (auto& face : soupMesh.aFaces)
+			face.MaterialRef = face.FaceID % 3;
+
+		WavefrontTraceInfo traceInfo{};
+		traceInfo.CameraView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 8.0f));
+		traceInfo.MaxBounceLimit = 6;
+
+		tracer.Begin(traceInfo);
+		tracer.SubmitRenderable(soupMesh);
+		tracer.SubmitLightSrc(MakeEnclosure(15.0f), glm::vec3(1.0f, 0.9f, 0.7f));
+		tracer.End();
+
+		Material diffuse{};
+		diffuse.Albedo = glm::vec3(0.8f, 0.3f, 0.3f);
+		diffuse.Metallic = 0.0f;
+		diffuse.Roughness = 1.0f;
+
+		Material glossy{};
+		glossy.Albedo = glm::vec3(0.9f);
+		glossy.Metallic = 1.0f;
+		glossy.Roughness = 0.2f;
+
+		tracer.SetMaterials({ diffuse, glossy, Material() });
+	}
+
+	ReferenceTracerCreateInfo MakeCreateInfo(uint32_t threadCount, glm::ivec2 resolution)
+	{
+		ReferenceTracerCreateInfo createInfo{};
+		createInfo.TargetResolution = resolution;
+		createInfo.ThreadCount = threadCount;
+
+		// Small batches so that every stage really is split across the threads
+		createInfo.BatchSize = 256;
+
+		return createInfo;
+	}
+}
+
+// Every ray draws from its own seed, so the image can't depend on which thread traced it
+TEST_CASE(ReferenceTracer_ThreadCountDoesNotChangeImage)
+{
+	std::vector<glm::vec4> singleThreaded;
+
+	for (uint32_t threadCount : { 1u, 3u, 8u })
+	{
+		ReferenceTracer tracer(MakeCreateInfo(threadCount, { 64, 48 }));
+
+		SubmitLitSoup(tracer);
+		ReferenceTraceStats stats = tracer.Trace(4);
+
+		CHECK_EQ(stats.ThreadCount, threadCount);
+		CHECK_EQ(tracer.GetFrameCount(), 4u);
+
+		const std::vector<glm::vec4>& image = tracer.GetMeanImage();
+
+		if (singleThreaded.empty())
+		{
+			singleThreaded = image;
+
+			// Some paths have to reach the light, otherwise the comparison says little
+			bool anyLit = std::any_of(image.begin(), image.end(), [](const glm::vec4& pixel) { return pixel.r > 0.0f; });
+			CHECK(anyLit);
+
+			continue;
+		}
+
+		bool identical = image == singleThreaded;
+		CHECK(identical);
+	}
+}
+
+// Every camera ray ends on the light at its first hit, so each pixel is exactly the light color
+TEST_CASE(ReferenceTracer_EmissiveEnclosureShowsLightColor)
+{
+	glm::vec3 lightColor(0.25f, 0.5f, 2.0f);
+
+	ReferenceTracer tracer(MakeCreateInfo(4, { 32, 32 }));
+
+	tracer.Begin(WavefrontTraceInfo());
+	tracer.SubmitLightSrc(MakeEnclosure(5.0f), lightColor);
+	tracer.End();
+
+	ReferenceTraceStats stats = tracer.Trace(3);
+
+	// A single intersection per ray and frame
+	CHECK_EQ(stats.RayCount, 3ull * 32 * 32);
+
+	uint32_t mismatchCount = 0;
+
+	for (const auto& pixel : tracer.GetMeanImage())
+		mismatchCount += glm::vec3(pixel) == lightColor && pixel.a == 1.0f ? 0 : 1;
+
+	CHECK_EQ(mismatchCount, 0u);
+}
+
+BENCHMARK(ReferenceTracer_RaysPerSecondByThreadCount)
+{
+	for (uint32_t threadCount : { 1u, 2u, 4u, 8u })
+	{
+		ReferenceTracer tracer(MakeCreateInfo(threadCount, { 256, 256 }));
+		SubmitLitSoup(tracer);
+
+		ReferenceTraceStats stats = tracer.Trace(2);
+
+		std::cout << "    " << threadCount << " threads: " << stats.GetRaysPerSecond() / 1.0e6 << " M rays/s ("
+			<< stats.GetRaysPerSecondPerCore() / 1.0e6 << " M per core)" << std::endl;
+	}
+}
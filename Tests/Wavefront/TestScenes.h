@@ -0,0 +1,58 @@
+#pragma once
+#include "Wavefront/RayTracingStructures.h"
+
+namespace Tests
+{
+	// Small random triangles scattered through a cube, a worst case for the spatial splits
+	struct TriangleSoup
+	{
+		std::vector<glm::vec3> Vertices;
+		std::vector<AquaFlow::Face> Faces;
+	};
+
+	inline TriangleSoup MakeTriangleSoup(uint32_t triangleCount, uint32_t seed, float extent = 10.0f)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+
+		TriangleSoup soup;
+		soup.Vertices.reserve(3 * triangleCount);
+		soup.Faces.reserve(triangleCount);
+
+		for (uint32_t i = 0; i < triangleCount; i++)
+		{
+			glm::vec3 center(position(engine), position(engine), position(engine));
+
+			for (int corner = 0; corner < 3; corner++)
+				soup.Vertices.push_back(center + glm::vec3(offset(engine), offset(engine), offset(engine)));
+
+			AquaFlow::Face face{};
+			face.Indices = glm::uvec4(3 * i, 3 * i + 1, 3 * i + 2, 0);
+			face.FaceID = i;
+
+			soup.Faces.push_back(face);
+		}
+
+		return soup;
+	}
+
+	// Rays starting anywhere around the soup, pointing in random directions
+	inline std::vector<AquaFlow::PhFlux::Ray> MakeRandomRays(uint32_t rayCount, uint32_t seed, float extent = 12.0f)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::normal_distribution<float> direction;
+
+		std::vector<AquaFlow::PhFlux::Ray> rays(rayCount);
+
+		for (auto& ray : rays)
+		{
+			ray.Origin = glm::vec3(position(engine), position(engine), position(engine));
+			ray.Direction = glm::normalize(glm::vec3(direction(engine), direction(engine), direction(engine)));
+			ray.Active = 1;
+		}
+
+		return rays;
+	}
+}
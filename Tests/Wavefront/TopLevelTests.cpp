@@ -0,0 +1,284 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+
+#include "Wavefront/BVHFactory.h"
+#include "Wavefront/BVHLayouts.h"
+#include "Wavefront/RayIntersection.h"
+
+using namespace AquaFlow;
+using namespace AquaFlow::PhFlux;
+using namespace Tests;
+
+namespace
+{
+	// N copies of one mesh, set up the way TraceSession::SubmitInstance does it
+	struct InstancedScene
+	{
+		BVH Mesh;
+		std::vector<InstanceInfo> Instances;
+		std::vector<Box> InstanceBounds;
+		std::vector<Node> TopLevel;
+	};
+
+	glm::mat4 MakeRandomTransform(std::mt19937& engine)
+	{
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+		std::uniform_real_distribution<float> scale(0.25f, 2.0f);
+		std::normal_distribution<float> axis;
+
+		glm::vec3 rotationAxis = glm::normalize(glm::vec3(axis(engine), axis(engine), axis(engine)));
+
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(engine), position(engine), position(engine)));
+		transform = glm::rotate(transform, angle(engine), rotationAxis);
+
+		return glm::scale(transform, glm::vec3(scale(engine), scale(engine), scale(engine)));
+	}
+
+	InstancedScene MakeInstancedScene(uint32_t instanceCount, uint32_t seed)
+	{
+		TriangleSoup soup = MakeTriangleSoup(2000, seed, 2.0f);
+
+		BVHFactory factory;
+
+		InstancedScene scene;
+		scene.Mesh = factory.Build(soup.Vertices.begin(), soup.Vertices.end(), soup.Faces.begin(), soup.Faces.end());
+
+		Box meshBounds(scene.Mesh.Nodes[0].MinBound, scene.Mesh.Nodes[0].MaxBound);
+		std::mt19937 engine(seed);
+
+		for (uint32_t i = 0; i < instanceCount; i++)
+		{
+			InstanceInfo instance{};
+			instance.ObjectToWorld = MakeRandomTransform(engine);
+			instance.WorldToObject = glm::inverse(instance.ObjectToWorld);
+			instance.MaterialIndex = i;
+
+			scene.Instances.push_back(instance);
+			scene.InstanceBounds.push_back(meshBounds.Transform(instance.ObjectToWorld));
+		}
+
+		scene.TopLevel = BVHFactory::BuildTopLevel(scene.InstanceBounds);
+
+		return scene;
+	}
+
+	bool Encloses(const Node& outer, const glm::vec3& minBound, const glm::vec3& maxBound)
+	{
+		return glm::all(glm::lessThanEqual(outer.MinBound, minBound)) &&
+			glm::all(glm::greaterThanEqual(outer.MaxBound, maxBound));
+	}
+
+	// Walks the top level tree and traces the mesh in the object space of every instance it reaches
+	float TraceInstanced(const InstancedScene& scene, const Ray& ray)
+	{
+		RayQuery query = MakeRayQuery(ray);
+		BVHTraverser traverser(scene.Mesh);
+		TraversalStats stats;
+
+		float closestHit = FLT_MAX;
+
+		std::vector<uint32_t> nodeStack = { 0 };
+
+		while (!nodeStack.empty())
+		{
+			const Node& node = scene.TopLevel[nodeStack.back()];
+			nodeStack.pop_back();
+
+			float entry;
+
+			if (!IntersectSlab(query, node.MinBound, node.MaxBound, entry) || entry > closestHit)
+				continue;
+
+			if (node.FirstChildIndex != 0)
+			{
+				nodeStack.push_back(node.FirstChildIndex);
+				nodeStack.push_back(node.SecondChildIndex);
+				continue;
+			}
+
+			for (uint32_t i = node.BeginIndex; i < node.EndIndex; i++)
+			{
+				const InstanceInfo& instance = scene.Instances[i];
+
+				// The direction is left unnormalized, so the hit distances carry over to world space
+				Ray localRay = ray;
+				localRay.Origin = glm::vec3(instance.WorldToObject * glm::vec4(ray.Origin, 1.0f));
+				localRay.Direction = glm::vec3(instance.WorldToObject * glm::vec4(ray.Direction, 0.0f));
+
+				closestHit = std::min(closestHit, traverser.TraceBinary(localRay, stats));
+			}
+		}
+
+		return closestHit;
+	}
+
+	// Every triangle of every instance, moved to world space
+	float TraceBruteForce(const InstancedScene& scene, const Ray& ray)
+	{
+		RayQuery query = MakeRayQuery(ray);
+
+		float closestHit = FLT_MAX;
+
+		for (const auto& instance : scene.Instances)
+		{
+			for (const auto& face : scene.Mesh.Faces)
+			{
+				glm::vec3 A = glm::vec3(instance.ObjectToWorld * glm::vec4(scene.Mesh.Vertices[face.Indices.x], 1.0f));
+				glm::vec3 B = glm::vec3(instance.ObjectToWorld * glm::vec4(scene.Mesh.Vertices[face.Indices.y], 1.0f));
+				glm::vec3 C = glm::vec3(instance.ObjectToWorld * glm::vec4(scene.Mesh.Vertices[face.Indices.z], 1.0f));
+
+				TriangleHit hit;
+
+				if (IntersectTriangle(query, A, B, C, closestHit, hit))
+					closestHit = hit.Distance;
+			}
+		}
+
+		return closestHit;
+	}
+}
+
+TEST_CASE(TopLevel_InstanceTransforms)
+{
+	InstancedScene scene = MakeInstancedScene(64, 5);
+
+	for (size_t i = 0; i < scene.Instances.size(); i++)
+	{
+		const InstanceInfo& instance = scene.Instances[i];
+
+		glm::mat4 identity = instance.WorldToObject * instance.ObjectToWorld;
+
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+				CHECK_NEAR(identity[column][row], column == row ? 1.0f : 0.0f, 1e-4);
+		}
+
+		// The bounds hold every vertex of the instance, not just the corners of the mesh bounds
+		const Box& bounds = scene.InstanceBounds[i];
+		uint32_t outsideCount = 0;
+
+		for (const auto& vertex : scene.Mesh.Vertices)
+		{
+			glm::vec3 world = glm::vec3(instance.ObjectToWorld * glm::vec4(vertex, 1.0f));
+
+			bool inside = glm::all(glm::lessThanEqual(bounds.Min - 1e-4f, world)) &&
+				glm::all(glm::lessThanEqual(world, bounds.Max + 1e-4f));
+
+			outsideCount += inside ? 0 : 1;
+		}
+
+		CHECK_EQ(outsideCount, 0u);
+	}
+}
+
+TEST_CASE(TopLevel_EveryInstanceInOneLeaf)
+{
+	for (uint32_t instanceCount : { 1u, 2u, 3u, 64u, 1000u })
+	{
+		InstancedScene scene = MakeInstancedScene(instanceCount, instanceCount);
+		const auto& nodes = scene.TopLevel;
+
+		CHECK_EQ(nodes.size(), static_cast<size_t>(2 * instanceCount - 1));
+
+		std::vector<uint32_t> leafCount(instanceCount, 0);
+
+		for (const auto& node : nodes)
+		{
+			if (node.FirstChildIndex == 0)
+			{
+				CHECK_EQ(node.EndIndex - node.BeginIndex, 1u);
+
+				leafCount[node.BeginIndex]++;
+
+				// One instance per leaf, so the leaf is exactly the instance bounds
+				const Box& bounds = scene.InstanceBounds[node.BeginIndex];
+				CHECK(node.MinBound == bounds.Min && node.MaxBound == bounds.Max);
+				continue;
+			}
+
+			const Node& first = nodes[node.FirstChildIndex];
+			const Node& second = nodes[node.SecondChildIndex];
+
+			CHECK(Encloses(node, first.MinBound, first.MaxBound));
+			CHECK(Encloses(node, second.MinBound, second.MaxBound));
+		}
+
+		CHECK(std::all_of(leafCount.begin(), leafCount.end(), [](uint32_t count) { return count == 1; }));
+	}
+}
+
+TEST_CASE(TopLevel_InstancedHitsMatchBruteForce)
+{
+	InstancedScene scene = MakeInstancedScene(16, 9);
+
+	std::mt19937 engine(13);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::normal_distribution<float> direction;
+
+	uint32_t hitCount = 0;
+	uint32_t mismatchCount = 0;
+
+	for (uint32_t i = 0; i < 2000; i++)
+	{
+		Ray ray{};
+		ray.Origin = glm::vec3(position(engine), position(engine), position(engine));
+
+		// Aimed at a random instance, most rays would miss the sparse scene otherwise
+		const Box& target = scene.InstanceBounds[i % scene.InstanceBounds.size()];
+		glm::vec3 jitter = glm::vec3(direction(engine), direction(engine), direction(engine));
+
+		ray.Direction = glm::normalize((target.Min + target.Max) / 2.0f + jitter - ray.Origin);
+		ray.Active = 1;
+
+		float instanced = TraceInstanced(scene, ray);
+		float bruteForce = TraceBruteForce(scene, ray);
+
+		hitCount += bruteForce < FLT_MAX ? 1 : 0;
+
+		bool match = instanced == bruteForce ||
+			(instanced < FLT_MAX && bruteForce < FLT_MAX && std::abs(instanced - bruteForce) <= 1e-3f * bruteForce);
+
+		mismatchCount += match ? 0 : 1;
+	}
+
+	CHECK(hitCount > 0);
+	CHECK_EQ(mismatchCount, 0u);
+}
+
+// Top level build and trace cost from 1 to 1024 instances of the same mesh
+BENCHMARK(TopLevel_TraceTimeByInstanceCount)
+{
+	// The same rays for every scene, crossing the volume the instances are scattered through
+	std::mt19937 engine(17);
+	std::uniform_real_distribution<float> origin(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> target(-50.0f, 50.0f);
+
+	std::vector<Ray> rays(20000);
+
+	for (auto& ray : rays)
+	{
+		ray.Origin = glm::vec3(origin(engine), origin(engine), origin(engine));
+		ray.Direction = glm::normalize(glm::vec3(target(engine), target(engine), target(engine)) - ray.Origin);
+		ray.Active = 1;
+	}
+
+	for (uint32_t instanceCount = 1; instanceCount <= 1024; instanceCount *= 2)
+	{
+		InstancedScene scene = MakeInstancedScene(instanceCount, 23);
+
+		double buildMs = MeasureMs([&]() { scene.TopLevel = BVHFactory::BuildTopLevel(scene.InstanceBounds); });
+
+		uint32_t hitCount = 0;
+
+		double traceMs = MeasureMs([&]()
+			{
+				for (const auto& ray : rays)
+					hitCount += TraceInstanced(scene, ray) < FLT_MAX ? 1 : 0;
+			});
+
+		std::cout << "    " << instanceCount << " instances: top level build " << buildMs << " ms, "
+			<< 1.0e6 * traceMs / rays.size() << " ns per ray (" << hitCount << " hits)" << std::endl;
+	}
+}
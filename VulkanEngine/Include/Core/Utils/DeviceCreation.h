@@ -41,6 +41,7 @@ vk::Flags<VulkanFlagBits> ChainFlagsTogether(const std::set<VulkanFlagBits>& fla
 
 // Sync Stuff...
 vk::Semaphore CreateSemaphore(vk::Device device);
+vk::Semaphore CreateTimelineSemaphore(vk::Device device, uint64_t initialValue);
 vk::Fence CreateFence(vk::Device device, bool Signaled);
 
 VK_UTILS_END
@@ -12,12 +12,33 @@ struct ImageLayoutInfo
 
 VK_CORE_BEGIN
 
+class MemoryAllocator;
+
+// Device memory range a resource is bound to
+struct MemoryAllocation
+{
+	vk::DeviceMemory Handle;
+	vk::DeviceSize Offset = 0;
+	vk::DeviceSize Size = 0;
+
+	// Start of the range in the persistently mapped block, nullptr if the block isn't host visible
+	void* MappedData = nullptr;
+
+	// Empty for the dedicated vkAllocateMemory allocations
+	std::shared_ptr<MemoryAllocator> Allocator;
+	uint32_t Block = 0;
+	uint32_t Range = 0;
+};
+
 // Buffer structs
 struct BufferConfig
 {
 	vk::Device LogicalDevice;
 	vk::PhysicalDevice PhysicalDevice;
 
+	// The buffer gets a memory of its own when there is no allocator
+	std::shared_ptr<MemoryAllocator> Allocator;
+
 	mutable uint32_t ResourceOwner = 0;
 
 	vk::BufferUsageFlags Usage = vk::BufferUsageFlagBits::eVertexBuffer;
@@ -29,7 +50,7 @@ struct BufferConfig
 struct Buffer
 {
 	vk::Buffer Handle{};
-	vk::DeviceMemory Memory{};
+	MemoryAllocation Memory{};
 	vk::MemoryRequirements MemReq{};
 
 	size_t ElemCount = 0;
@@ -57,6 +78,9 @@ struct ImageConfig
 	vk::Device LogicalDevice;
 	vk::PhysicalDevice PhysicalDevice;
 
+	// The image gets a memory of its own when there is no allocator
+	std::shared_ptr<MemoryAllocator> Allocator;
+
 	mutable uint32_t ResourceOwner = 0;
 
 	vk::ImageType Type = vk::ImageType::e2D;
@@ -96,7 +120,7 @@ struct ImageViewInfo
 struct Image
 {
 	vk::Image Handle;
-	vk::DeviceMemory Memory;
+	MemoryAllocation Memory;
 	vk::MemoryRequirements MemReq;
 
 	ImageConfig Config;
@@ -133,6 +157,13 @@ uint32_t FindMemoryTypeIndex(vk::PhysicalDevice device,
 vk::DeviceMemory AllocateMemory(const vk::MemoryRequirements& memReq, vk::MemoryPropertyFlags props, 
 	vk::Device logicalDevice, vk::PhysicalDevice physicalDevice);
 
+// Sub allocates through the allocator if there is one, otherwise falls back to a dedicated allocation
+MemoryAllocation AllocateMemory(const vk::MemoryRequirements& memReq, vk::MemoryPropertyFlags props,
+	vk::Device logicalDevice, vk::PhysicalDevice physicalDevice,
+	const std::shared_ptr<MemoryAllocator>& allocator, bool optimalImage);
+
+void FreeMemory(vk::Device logicalDevice, const MemoryAllocation& allocation);
+
 // Buffer functionality
 
 Buffer CreateBuffer(BufferConfig& bufferInput);
@@ -40,9 +40,12 @@
 #include <initializer_list>
 #include <deque>
 #include <queue>
+#include <optional>
 
 // algorithms
 #include <algorithm>
 #include <functional>
 #include <memory>
 #include <exception>
+#include <limits>
+#include <bit>
@@ -158,25 +158,34 @@ void Buffer<T>::FetchMemory(Iter Begin, Iter End, size_t Offset)
 template<typename T>
 T* Buffer<T>::MapMemory(size_t Count, size_t Offset) const
 {
-	return (T*) mChunk.Device->mapMemory(mChunk.BufferHandles->Memory,
-		Offset * sizeof(T), Count * sizeof(T));
+	const Core::MemoryAllocation& Memory = mChunk.BufferHandles->Memory;
+
+	// The host visible blocks of the allocator stay mapped
+	if (Memory.MappedData)
+		return (T*) (static_cast<uint8_t*>(Memory.MappedData) + Offset * sizeof(T));
+
+	return (T*) mChunk.Device->mapMemory(Memory.Handle,
+		Memory.Offset + Offset * sizeof(T), Count * sizeof(T));
 }
 
 template<typename T>
 void Buffer<T>::UnmapMemory() const
 {
-	mChunk.Device->unmapMemory(mChunk.BufferHandles->Memory);
+	const Core::MemoryAllocation& Memory = mChunk.BufferHandles->Memory;
 
-	if (mChunk.BufferHandles->Config.MemProps & vk::MemoryPropertyFlagBits::eHostCoherent)
-		return;
+	// Synchronize manually in case the underlying memory isn't HostCoherent, while it's still mapped
+	if (!(mChunk.BufferHandles->Config.MemProps & vk::MemoryPropertyFlagBits::eHostCoherent))
+	{
+		vk::MappedMemoryRange range{};
+		range.setMemory(Memory.Handle);
+		range.setOffset(Memory.Offset);
+		range.setSize(Memory.Size);
 
-	// Synchronize manually in case the underlying memory isn't HostCoherent
-	vk::MappedMemoryRange range{};
-	range.setMemory(mChunk.BufferHandles->Memory);
-	range.setOffset(0);
-	range.setSize(mChunk.BufferHandles->ElemCount);
+		mChunk.Device->flushMappedMemoryRanges(range);
+	}
 
-	mChunk.Device->flushMappedMemoryRanges(range);
+	if (!Memory.MappedData)
+		mChunk.Device->unmapMemory(Memory.Handle);
 }
 
 template<typename T>
@@ -548,8 +557,14 @@ void Buffer<bool>::FetchMemory(Iter Begin, Iter End, size_t Offset /*= 0*/)
 template<typename T>
 T* Buffer<bool>::MapMemory(size_t Count, size_t Offset) const
 {
-	return (T*) mChunk.Device->mapMemory(mChunk.BufferHandles->Memory,
-		Offset * sizeof(T), Count * sizeof(T));
+	const Core::MemoryAllocation& Memory = mChunk.BufferHandles->Memory;
+
+	// The host visible blocks of the allocator stay mapped
+	if (Memory.MappedData)
+		return (T*) (static_cast<uint8_t*>(Memory.MappedData) + Offset * sizeof(T));
+
+	return (T*) mChunk.Device->mapMemory(Memory.Handle,
+		Memory.Offset + Offset * sizeof(T), Count * sizeof(T));
 }
 
 VK_END
\ No newline at end of file
@@ -40,6 +40,7 @@ public:
 	std::vector<vk::ImageSubresourceLayers> GetSubresourceLayers() const;
 
 	vk::ImageView GetIdentityImageView() const { return mChunk->ImageHandles.IdentityView; }
+	const Core::Image& GetNativeHandles() const { return mChunk->ImageHandles; }
 
 	explicit operator bool() const { return static_cast<bool>(mChunk); }
 
@@ -0,0 +1,132 @@
+#pragma once
+#include "../Core/Config.h"
+#include "../Core/Ref.h"
+#include "../Core/Utils/MemoryUtils.h"
+#include "SubAllocators.h"
+
+VK_BEGIN
+VK_CORE_BEGIN
+
+// Where the allocator gets its blocks from, a fake backend lets the allocator logic run on the host
+class MemoryBlockBackend
+{
+public:
+	virtual ~MemoryBlockBackend() = default;
+
+	virtual vk::DeviceMemory AllocateBlock(uint32_t memoryTypeIndex, vk::DeviceSize size) = 0;
+	virtual void FreeBlock(vk::DeviceMemory memory) = 0;
+
+	// Only called for the host visible memory types
+	virtual void* MapBlock(vk::DeviceMemory memory) = 0;
+	virtual void UnmapBlock(vk::DeviceMemory memory) = 0;
+
+	virtual const vk::PhysicalDeviceMemoryProperties& GetMemoryProperties() const = 0;
+	virtual vk::DeviceSize GetNonCoherentAtomSize() const = 0;
+};
+
+class DeviceMemoryBackend : public MemoryBlockBackend
+{
+public:
+	DeviceMemoryBackend(Core::Ref<vk::Device> device, vk::PhysicalDevice physicalDevice);
+
+	vk::DeviceMemory AllocateBlock(uint32_t memoryTypeIndex, vk::DeviceSize size) override;
+	void FreeBlock(vk::DeviceMemory memory) override;
+
+	void* MapBlock(vk::DeviceMemory memory) override;
+	void UnmapBlock(vk::DeviceMemory memory) override;
+
+	const vk::PhysicalDeviceMemoryProperties& GetMemoryProperties() const override { return mMemoryProperties; }
+	vk::DeviceSize GetNonCoherentAtomSize() const override { return mNonCoherentAtomSize; }
+
+private:
+	Core::Ref<vk::Device> mDevice;
+
+	vk::PhysicalDeviceMemoryProperties mMemoryProperties;
+	vk::DeviceSize mNonCoherentAtomSize = 1;
+};
+
+enum class MemoryAllocatorMode
+{
+	eTLSF                = 0, // ranges are freed one by one
+	eLinear              = 1, // per frame scratch, the ranges come back all at once in Reset
+};
+
+struct MemoryAllocatorCreateInfo
+{
+	std::shared_ptr<MemoryBlockBackend> Backend;
+	MemoryAllocatorMode Mode = MemoryAllocatorMode::eTLSF;
+
+	// Capped to an eighth of the memory heap, requests above half a block get a block of their own
+	vk::DeviceSize BlockSize = 64 * 1024 * 1024;
+};
+
+struct MemoryAllocatorStats
+{
+	size_t BlockCount = 0;
+	size_t DedicatedBlockCount = 0;
+	size_t AllocationCount = 0;
+
+	vk::DeviceSize BlockBytes = 0;
+	vk::DeviceSize UsedBytes = 0;
+};
+
+// Draws large blocks per memory type and hands out aligned ranges of them
+// The resources keep the allocator alive through their MemoryAllocation
+class MemoryAllocator : public std::enable_shared_from_this<MemoryAllocator>
+{
+public:
+	explicit MemoryAllocator(const MemoryAllocatorCreateInfo& createInfo);
+	~MemoryAllocator();
+
+	MemoryAllocator(const MemoryAllocator&) = delete;
+	MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+	// Optimal tiling images get blocks of their own, so bufferImageGranularity never comes into play
+	MemoryAllocation Allocate(const vk::MemoryRequirements& memReq,
+		vk::MemoryPropertyFlags memProps, bool optimalImage = false);
+
+	void Free(const MemoryAllocation& allocation);
+
+	// Rewinds the blocks of a linear allocator, the device must be done with all of its resources
+	void Reset();
+
+	MemoryAllocatorStats GetStats() const;
+	MemoryAllocatorMode GetMode() const { return mCreateInfo.Mode; }
+
+private:
+	struct MemoryBlock
+	{
+		vk::DeviceMemory Memory;
+		vk::DeviceSize Size = 0;
+		void* MappedData = nullptr;
+
+		uint32_t Pool = 0;
+		bool Dedicated = false;
+
+		TLSF_Heap Heap;
+		LinearArena Arena;
+	};
+
+	MemoryAllocatorCreateInfo mCreateInfo;
+
+	// Block indices, two pools per memory type (buffers and linear images, optimal images)
+	std::vector<std::vector<uint32_t>> mPools;
+
+	std::vector<MemoryBlock> mBlocks;
+	std::vector<uint32_t> mUnusedBlocks;
+
+	mutable std::mutex mLock;
+
+private:
+	// Helper functions...
+	uint32_t FindMemoryTypeIndex(uint32_t memoryTypeBits, vk::MemoryPropertyFlags memProps) const;
+	vk::DeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+
+	uint32_t CreateBlock(uint32_t pool, vk::DeviceSize size, bool dedicated);
+	void DestroyBlock(uint32_t block);
+
+	std::optional<SubAllocation> AllocateFromBlock(MemoryBlock& block, vk::DeviceSize size, vk::DeviceSize alignment);
+};
+
+VK_CORE_END
+VK_END
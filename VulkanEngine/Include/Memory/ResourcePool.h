@@ -2,6 +2,8 @@
 #include "MemoryConfig.h"
 #include "Buffer.h"
 #include "Image.h"
+#include "MemoryAllocator.h"
+#include "StagingRing.h"
 #include "../Process/Commands.h"
 
 VK_BEGIN
@@ -22,6 +24,20 @@ public:
 
 	SamplerCache CreateSamplerCache() const;
 
+	// Copies into the buffers owned by dstFamilyIndex, the buffers of the pool start out on family zero
+	TransferExecutor CreateTransferExecutor(uint32_t dstFamilyIndex = 0) const
+	{ return { mQueueManager, mBufferCommandPools, dstFamilyIndex }; }
+
+	// Uploads into the buffers owned by familyIndex, through the transfer only family when there is one
+	StagingRing CreateStagingRing(vk::DeviceSize capacity = 64 * 1024 * 1024, uint32_t familyIndex = 0) const;
+
+	// Same pool with the memory drawn from a linear arena, for the per frame scratch resources
+	// Nothing comes back until ResetScratch, which must wait for the device to be done with them
+	ResourcePool CreateScratchPool(vk::DeviceSize blockSize = 16 * 1024 * 1024) const;
+	void ResetScratch() const { mAllocator->Reset(); }
+
+	Core::MemoryAllocatorStats GetMemoryStats() const { return mAllocator->GetStats(); }
+
 	std::shared_ptr<const QueueManager> GetQueueManager() const { return mQueueManager; }
 
 	explicit operator bool() const { return static_cast<bool>(mDevice); }
@@ -35,9 +51,50 @@ private:
 
 	std::shared_ptr<const QueueManager> mQueueManager;
 
+	// Every buffer and image of the pool binds at an offset of its blocks
+	std::shared_ptr<Core::MemoryAllocator> mAllocator;
+
 	friend class Context;
 };
 
+inline VK_NAMESPACE::ResourcePool VK_NAMESPACE::ResourcePool::CreateScratchPool(vk::DeviceSize blockSize) const
+{
+	Core::MemoryAllocatorCreateInfo allocatorInfo{};
+	allocatorInfo.Backend = std::make_shared<Core::DeviceMemoryBackend>(mDevice, mPhysicalDevice.Handle);
+	allocatorInfo.Mode = Core::MemoryAllocatorMode::eLinear;
+	allocatorInfo.BlockSize = blockSize;
+
+	ResourcePool scratchPool = *this;
+	scratchPool.mAllocator = std::make_shared<Core::MemoryAllocator>(allocatorInfo);
+
+	return scratchPool;
+}
+
+inline VK_NAMESPACE::StagingRing VK_NAMESPACE::ResourcePool::CreateStagingRing(
+	vk::DeviceSize capacity, uint32_t familyIndex) const
+{
+	_STL_ASSERT(capacity > 0, "StagingRing capacity must be non zero!");
+
+	StagingRing stagingRing;
+	stagingRing.mData = std::make_shared<Core::StagingRingData>();
+
+	Core::StagingRingData& ring = *stagingRing.mData;
+
+	ring.RingBuffer = CreateBuffer<uint8_t>(vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+	ring.RingBuffer.Resize(capacity);
+
+	// Mapped once for the lifetime of the ring
+	ring.MappedData = ring.RingBuffer.MapMemory(capacity);
+
+	ring.Capacity = capacity;
+	ring.FamilyIndex = familyIndex;
+	ring.Transfer = CreateTransferExecutor(familyIndex);
+
+	return stagingRing;
+}
+
 template <typename T>
 VK_NAMESPACE::Buffer<T> VK_NAMESPACE::ResourcePool::CreateBuffer(
 	vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memProps) const
@@ -56,6 +113,7 @@ VK_NAMESPACE::Buffer<T> VK_NAMESPACE::ResourcePool::CreateBuffer(
 
 	Config.MemProps = memProps;
 	Config.TypeSize = sizeof(T);
+	Config.Allocator = mAllocator;
 
 	// Creating an empty buffer
 	Chunk.BufferHandles = Core::CreateRef(vkEngine::Core::Buffer(),
@@ -64,7 +122,7 @@ VK_NAMESPACE::Buffer<T> VK_NAMESPACE::ResourcePool::CreateBuffer(
 		if (buffer.Handle)
 		{
 			Device->destroyBuffer(buffer.Handle);
-			Device->freeMemory(buffer.Memory);
+			Core::Utils::FreeMemory(*Device, buffer.Memory);
 		}
 	});
 
@@ -0,0 +1,133 @@
+#pragma once
+#include "Buffer.h"
+#include "../Process/TransferExecutor.h"
+
+VK_BEGIN
+VK_CORE_BEGIN
+
+// Copy recorded at flush time, so a Resize of the destination in between lands on the new handle
+struct StagingCopy
+{
+	Ref<Buffer> Destination;
+	vk::BufferCopy Region;
+};
+
+// Submitted copies, their ring space comes back once the submission completes
+struct StagingBatch
+{
+	GpuFuture Completion;
+
+	uint64_t RingEnd = 0;
+};
+
+struct StagingRingData
+{
+	// The copies in flight still read the ring buffer
+	~StagingRingData();
+
+	VK_NAMESPACE::Buffer<uint8_t> RingBuffer;
+	uint8_t* MappedData = nullptr;
+
+	vk::DeviceSize Capacity = 0;
+	uint32_t FamilyIndex = 0;
+
+	// Runs the copies on the transfer only family if there is one
+	TransferExecutor Transfer;
+
+	// Monotonic positions, the ring offset is the position modulo the capacity
+	uint64_t Head = 0;
+	uint64_t Tail = 0;
+
+	std::vector<StagingCopy> PendingCopies;
+	std::deque<StagingBatch> Batches;
+};
+
+VK_CORE_END
+
+// Persistently mapped upload buffer, sub allocated linearly as a ring
+// Uploads only write the ring and queue a copy region, Flush submits all of them in one batch
+// Not thread safe, a ring is filled and flushed from one thread at a time
+class StagingRing
+{
+public:
+	StagingRing() = default;
+
+	template <typename T, typename Iter>
+	void Upload(Buffer<T>& dst, Iter Begin, Iter End, size_t dstOffset = 0);
+
+	// The fill routine writes the elements [firstIndex, firstIndex + (end - begin)) straight into the ring
+	// Uploads larger than the ring are handed to it in pieces
+	template <typename T, typename Fn>
+	void Stage(Buffer<T>& dst, size_t dstOffset, size_t count, Fn&& fillRoutine);
+
+	// Submits all the pending copies as one batch, wait blocks until they have landed
+	// The returned future is for the destination family work that consumes the uploads
+	// Batches land in the order they were flushed in, later uploads to a range overwrite earlier ones
+	Core::GpuFuture Flush(bool wait = false);
+	void WaitIdle();
+
+	size_t GetPendingCopyCount() const;
+	vk::DeviceSize GetCapacity() const { return mData->Capacity; }
+	uint32_t GetFamilyIndex() const { return mData->FamilyIndex; }
+	bool UsesTransferFamily() const { return mData->Transfer.IsDedicated(); }
+
+	explicit operator bool() const { return static_cast<bool>(mData); }
+
+private:
+	std::shared_ptr<Core::StagingRingData> mData;
+
+	friend class ResourcePool;
+
+private:
+	// Helper functions...
+	uint8_t* Allocate(vk::DeviceSize size, vk::DeviceSize& ringOffset);
+	void AddCopy(const Core::Ref<Core::Buffer>& dst, vk::DeviceSize ringOffset,
+		vk::DeviceSize dstOffset, vk::DeviceSize size);
+
+	Core::GpuFuture FlushPending(bool wait);
+	void Recycle(bool waitOldest);
+};
+
+template <typename T, typename Iter>
+void StagingRing::Upload(Buffer<T>& dst, Iter Begin, Iter End, size_t dstOffset)
+{
+	std::span range(Begin, End - Begin);
+
+	static_assert(std::ranges::contiguous_range<decltype(range)>,
+		"vkEngine::StagingRing::Upload only accepts contiguous memory");
+
+	const T* HostData = range.data();
+
+	Stage(dst, dstOffset, range.size(), [HostData](T* BeginRing, T* EndRing, size_t FirstIndex)
+	{
+		std::memcpy(BeginRing, HostData + FirstIndex, (EndRing - BeginRing) * sizeof(T));
+	});
+}
+
+template <typename T, typename Fn>
+void StagingRing::Stage(Buffer<T>& dst, size_t dstOffset, size_t count, Fn&& fillRoutine)
+{
+	_STL_ASSERT(dst.GetCapacity() >= dstOffset + count, "StagingRing::Stage writes past the buffer capacity!");
+	_STL_ASSERT(dst.GetBufferConfig().ResourceOwner == mData->FamilyIndex,
+		"The destination buffer must be owned by the family of the staging ring!");
+
+	size_t ChunkCount = std::max<size_t>(mData->Capacity / sizeof(T), 1);
+
+	_STL_ASSERT(ChunkCount * sizeof(T) <= mData->Capacity, "The staging ring can't hold a single element!");
+
+	Core::Ref<Core::Buffer> Destination = dst.GetBufferChunk().BufferHandles;
+
+	for (size_t First = 0; First < count; First += ChunkCount)
+	{
+		size_t Count = std::min(ChunkCount, count - First);
+
+		vk::DeviceSize RingOffset = 0;
+		T* RingData = reinterpret_cast<T*>(Allocate(Count * sizeof(T), RingOffset));
+
+		fillRoutine(RingData, RingData + Count, First);
+
+		AddCopy(Destination, RingOffset, (dstOffset + First) * sizeof(T), Count * sizeof(T));
+	}
+}
+
+VK_END
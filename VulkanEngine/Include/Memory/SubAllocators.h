@@ -0,0 +1,111 @@
+#pragma once
+#include "../Core/Config.h"
+
+VK_BEGIN
+VK_CORE_BEGIN
+
+// Range handed out by the sub allocators, Range identifies it when freeing
+struct SubAllocation
+{
+	vk::DeviceSize Offset = 0;
+	vk::DeviceSize Size = 0;
+	uint32_t Range = 0;
+};
+
+// Two level segregated fit allocator over a single block
+// Allocation and free are O(1) and neighbouring free ranges are merged right away
+class TLSF_Heap
+{
+public:
+	TLSF_Heap() : TLSF_Heap(0) {}
+	explicit TLSF_Heap(vk::DeviceSize size);
+
+	std::optional<SubAllocation> Allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+	void Free(uint32_t range);
+
+	vk::DeviceSize GetSize() const { return mSize; }
+	vk::DeviceSize GetUsedSize() const { return mUsedSize; }
+	size_t GetAllocationCount() const { return mAllocationCount; }
+
+	bool IsEmpty() const { return mAllocationCount == 0; }
+
+private:
+	// Sixteen lists per power of two
+	static constexpr uint32_t sSecondLevelLog2 = 4;
+	static constexpr uint32_t sSecondLevelCount = 1 << sSecondLevelLog2;
+	static constexpr uint32_t sFirstLevelCount = 64 - sSecondLevelLog2 + 1;
+
+	static constexpr uint32_t sNullRange = std::numeric_limits<uint32_t>::max();
+
+	struct Range
+	{
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Size = 0;
+
+		// Neighbours in the block
+		uint32_t PrevPhysical = sNullRange;
+		uint32_t NextPhysical = sNullRange;
+
+		// Neighbours in the free list
+		uint32_t PrevFree = sNullRange;
+		uint32_t NextFree = sNullRange;
+
+		bool IsFree = false;
+	};
+
+	vk::DeviceSize mSize = 0;
+	vk::DeviceSize mUsedSize = 0;
+	size_t mAllocationCount = 0;
+
+	std::vector<Range> mRanges;
+	std::vector<uint32_t> mUnusedRanges;
+
+	uint64_t mFirstLevelBitmap = 0;
+	std::array<uint32_t, sFirstLevelCount> mSecondLevelBitmaps{};
+	std::array<std::array<uint32_t, sSecondLevelCount>, sFirstLevelCount> mFreeLists{};
+
+private:
+	// Helper functions...
+	static void MapSize(vk::DeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	uint32_t FindFreeRange(vk::DeviceSize size) const;
+	// Walks the list of the exact size class, picks up the ranges the rounded up search skips
+	uint32_t FindFittingRange(vk::DeviceSize size, vk::DeviceSize alignment) const;
+
+	void InsertFreeRange(uint32_t range);
+	void RemoveFreeRange(uint32_t range);
+
+	uint32_t CreateRange(const Range& range);
+	void DestroyRange(uint32_t range);
+
+	// Splits off the tail of the range past size, the tail isn't in any free list yet
+	uint32_t SplitRange(uint32_t range, vk::DeviceSize size);
+	void MergeWithNext(uint32_t range);
+};
+
+// Bump allocator over a single block, nothing is freed until the whole arena is reset
+class LinearArena
+{
+public:
+	LinearArena() = default;
+	explicit LinearArena(vk::DeviceSize size)
+		: mSize(size) {}
+
+	std::optional<SubAllocation> Allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+	void Reset() { mHead = 0; mAllocationCount = 0; }
+
+	vk::DeviceSize GetSize() const { return mSize; }
+	vk::DeviceSize GetUsedSize() const { return mHead; }
+	size_t GetAllocationCount() const { return mAllocationCount; }
+
+	bool IsEmpty() const { return mAllocationCount == 0; }
+
+private:
+	vk::DeviceSize mSize = 0;
+	vk::DeviceSize mHead = 0;
+	size_t mAllocationCount = 0;
+};
+
+VK_CORE_END
+VK_END
@@ -33,6 +33,10 @@ public:
 	// Async Dispatch...
 	void Dispatch(const glm::uvec3& workGroups);
 
+	// Reads the workgroup counts from a vk::DispatchIndirectCommand at the given byte offset
+	// The buffer must be created with vk::BufferUsageFlagBits::eIndirectBuffer
+	void DispatchIndirect(vk::Buffer buffer, vk::DeviceSize offset = 0);
+
 	virtual void End();
 
 	virtual const PShader& GetShader() const override { return mShader; }
@@ -110,6 +114,18 @@ inline void BasicComputePipeline<BasePipeline>::Dispatch(const glm::uvec3& WorkG
 	commandBuffer.dispatch(WorkGroups.x, WorkGroups.y, WorkGroups.z);
 }
 
+template<typename BasePipeline>
+inline void BasicComputePipeline<BasePipeline>::DispatchIndirect(vk::Buffer buffer, vk::DeviceSize offset)
+{
+	vk::CommandBuffer commandBuffer = ((BasePipeline*) this)->GetCommandBuffer();
+
+	if (!mHandles->SetCache.empty())
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+			mHandles->LayoutData.Layout, 0, mHandles->SetCache, nullptr);
+
+	commandBuffer.dispatchIndirect(buffer, offset);
+}
+
 template<typename BasePipeline>
 inline void BasicComputePipeline<BasePipeline>::End()
 {
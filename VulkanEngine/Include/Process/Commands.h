@@ -19,11 +19,23 @@ public:
 
 	void EndOneTimeCommands(vk::CommandBuffer CmdBuffer, Core::Executor Executor) const;
 
+	// Doesn't wait for the work, the buffer is freed by a later Allocate once the future is reached
+	Core::GpuFuture EndOneTimeCommandsAsync(vk::CommandBuffer CmdBuffer, Core::Executor Executor,
+		const std::vector<Core::GpuFuture>& waitFor = {}) const;
+
 	vk::CommandBuffer Allocate(vk::CommandBufferLevel level =
 		vk::CommandBufferLevel::ePrimary) const;
 
+	// Secondary buffer ready for recording, replayed by a primary one of the same family through executeCommands
+	// The default inheritance info suits the commands outside of a render pass
+	vk::CommandBuffer BeginSecondaryCommands(const vk::CommandBufferInheritanceInfo& inheritanceInfo = {},
+		vk::CommandBufferUsageFlags usage = vk::CommandBufferUsageFlagBits::eOneTimeSubmit) const;
+
 	void Free(vk::CommandBuffer CmdBuffer) const;
 
+	// One time buffers of EndOneTimeCommandsAsync that haven't been freed yet
+	size_t GetRetiringCount() const;
+
 	const CommandPools* GetPoolManager() const { return mParentReservoir; }
 	uint32_t GetFamilyIndex() const { return mFamilyIndex; }
 
@@ -50,6 +62,8 @@ private:
 	mutable std::shared_ptr<Core::CommandBufferSet> mAllocatedInstances = nullptr;
 #endif
 
+	void FreeRetired() const;
+
 	void AddInstanceDebug(vk::CommandBuffer CmdBuffer) const;
 	void RemoveInstanceDebug(vk::CommandBuffer CmdBuffer) const;
 
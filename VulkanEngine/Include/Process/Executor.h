@@ -7,24 +7,23 @@
 VK_BEGIN
 VK_CORE_BEGIN
 
+// Spreads the work over the queues of a family, each submission goes to the queue with the least work pending
 class Executor
 {
 public:
 	Executor() = default;
 
-	uint32_t SubmitWork(const vk::SubmitInfo& submitInfo,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	GpuFuture SubmitWork(const vk::SubmitInfo& submitInfo) const;
+	GpuFuture SubmitWork(vk::CommandBuffer cmdBuffer) const;
 
-	uint32_t SubmitWork(vk::CommandBuffer cmdBuffer,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	// The command buffer starts at waitStage once all the futures are reached, without stalling the host
+	GpuFuture SubmitWork(vk::CommandBuffer cmdBuffer, const std::vector<GpuFuture>& waitFor,
+		vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands) const;
 
-	uint32_t SubmitWorkRange(const vk::SubmitInfo* begin, const vk::SubmitInfo* end,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	GpuFuture SubmitWorkRange(const vk::SubmitInfo* begin, const vk::SubmitInfo* end) const;
+	GpuFuture SubmitWorkRange(vk::CommandBuffer* begin, vk::CommandBuffer* end) const;
 
-	uint32_t SubmitWorkRange(vk::CommandBuffer* begin, vk::CommandBuffer* end,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
-
-	bool WaitIdle(std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	bool WaitIdle(std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
 
 	uint32_t GetFamilyIndex() const { return mFamilyData->Index; }
 	size_t GetWorkerQueueCount() const { return mFamilyData->Queues.size() - mFamilyData->WorkerBeginIndex; }
@@ -45,40 +44,10 @@ private:
 	Executor(const QueueFamily* familyData, QueueAccessType accessType)
 		: mFamilyData(familyData), mAccessType(accessType) {}
 
-	template <typename Fn> 
-	uint32_t TraverseIdleQueues(size_t begin, size_t end, std::chrono::nanoseconds timeOut, Fn fn) const;
-
-	uint32_t SubmitToQueuesRange(size_t begin, size_t end, 
-		std::chrono::nanoseconds timeOut, const vk::SubmitInfo& submitInfo) const;
-
-	uint32_t SubmitToQueuesRange(size_t begin, size_t end, std::chrono::nanoseconds timeOut,
-		const vk::SubmitInfo* submitBegin, const vk::SubmitInfo* submitEnd) const;
+	// Queues of the family this executor may submit to
+	std::pair<size_t, size_t> GetQueueRange() const;
+	const Ref<Queue>& FindLeastBusyQueue() const;
 };
 
-template <typename Fn> 
-uint32_t Executor::TraverseIdleQueues(size_t begin, size_t end,
-	std::chrono::nanoseconds timeOut, Fn fn) const
-{
-	const auto& queueFamily = *mFamilyData;
-
-	while (true)
-	{
-		std::unique_lock locker(queueFamily.NotifierMutex);
-
-		for (size_t Curr = begin; Curr < end; Curr++)
-		{
-			if (fn(queueFamily.Queues[Curr]))
-				return static_cast<uint32_t>(Curr);
-		}
-
-		std::cv_status status = queueFamily.IdleNotifier.wait_for(locker, timeOut);
-
-		if (status == std::cv_status::timeout)
-			return -1;
-	}
-
-	return -1;
-}
-
 VK_CORE_END
 VK_END
@@ -0,0 +1,36 @@
+#pragma once
+#include "../Core/Config.h"
+
+VK_BEGIN
+VK_CORE_BEGIN
+
+class Queue;
+
+// Value on the timeline semaphore of a queue, reached once the submission that signals it is done
+// An empty future counts as complete
+class GpuFuture
+{
+public:
+	GpuFuture() = default;
+
+	bool Wait(std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
+	bool IsReady() const;
+
+	vk::Semaphore GetSemaphore() const { return mTimeline; }
+	uint64_t GetValue() const { return mValue; }
+
+	explicit operator bool() const { return static_cast<bool>(mTimeline); }
+
+private:
+	vk::Device mDevice;
+	vk::Semaphore mTimeline;
+	uint64_t mValue = 0;
+
+	GpuFuture(vk::Device device, vk::Semaphore timeline, uint64_t value)
+		: mDevice(device), mTimeline(timeline), mValue(value) {}
+
+	friend class Queue;
+};
+
+VK_CORE_END
+VK_END
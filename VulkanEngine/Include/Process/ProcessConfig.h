@@ -2,6 +2,7 @@
 // Vulkan configuration and queue structures...
 #include "../Core/Config.h"
 #include "../Core/Ref.h"
+#include "GpuFuture.h"
 
 VK_BEGIN
 class QueueManager;
@@ -24,9 +25,6 @@ struct QueueFamily
 	size_t WorkerBeginIndex = -1;
 	vk::QueueFlags Capabilities;
 
-	mutable std::condition_variable IdleNotifier;
-	mutable std::mutex NotifierMutex;
-
 	std::vector<Core::Ref<Queue>> Queues;
 };
 
@@ -34,6 +32,9 @@ struct QueueWaitingPoint
 {
 	vk::Semaphore WaitSemaphore{};
 	vk::PipelineStageFlags WaitDst{};
+
+	// Only read for timeline semaphores
+	uint64_t WaitValue = 0;
 };
 
 struct CommandPoolData
@@ -41,6 +42,9 @@ struct CommandPoolData
 	vk::CommandPool Handle;
 	std::mutex Lock;
 
+	// One time command buffers submitted asynchronously, freed once their submission completes
+	std::vector<std::pair<vk::CommandBuffer, GpuFuture>> Retiring;
+
 	CommandPoolData() = default;
 
 	CommandPoolData(const CommandPoolData& Other)
@@ -22,6 +22,9 @@ public:
 	Core::Executor FetchExecutor(uint32_t familyIndex, QueueAccessType accessType) const;
 
 	uint32_t FindOptimalQueueFamilyIndex(vk::QueueFlagBits flag) const;
+
+	// Family that can do nothing but transfers and sparse binding, -1 if the device hasn't got one
+	uint32_t FindTransferOnlyFamilyIndex() const;
 	vk::QueueFlags GetFamilyCapabilities(uint32_t index) const 
 	{ return mQueues.at(index).Capabilities; }
 
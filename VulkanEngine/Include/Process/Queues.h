@@ -8,7 +8,8 @@ class Context;
 
 VK_CORE_BEGIN
 
-// Thin wrapper over vk::Queue and it's corresponding vk::Fence
+// Thin wrapper over vk::Queue and it's timeline semaphore
+// Every submission signals the next value of the timeline, so submitting never waits on the host
 // Thread safe
 class Queue
 {
@@ -19,36 +20,38 @@ public:
 	Queue(const Queue& Other);
 	Queue& operator=(const Queue& Other);
 
-	bool Submit(vk::CommandBuffer buffer, 
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
+	GpuFuture Submit(vk::CommandBuffer buffer) const;
 
-	bool Submit(vk::Semaphore signalSemaphore, vk::CommandBuffer buffer,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	GpuFuture Submit(vk::Semaphore signalSemaphore, vk::CommandBuffer buffer) const;
 
-	bool Submit(const QueueWaitingPoint& waitPoint, vk::Semaphore signalSemaphore, 
-		vk::CommandBuffer buffer, std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max());
+	GpuFuture Submit(const QueueWaitingPoint& waitPoint, vk::Semaphore signalSemaphore, 
+		vk::CommandBuffer buffer) const;
 
-	bool Submit(const vk::SubmitInfo& submitInfo,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
+	GpuFuture Submit(const vk::SubmitInfo& submitInfo) const;
 
-	bool SubmitRange(vk::CommandBuffer* Begin, vk::CommandBuffer* End, 
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
-	bool SubmitRange(const vk::SubmitInfo* Begin, const vk::SubmitInfo* End, 
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
+	GpuFuture SubmitRange(vk::CommandBuffer* Begin, vk::CommandBuffer* End) const;
+	GpuFuture SubmitRange(const vk::SubmitInfo* Begin, const vk::SubmitInfo* End) const;
 
-	bool BindSparse(const vk::BindSparseInfo& bindSparseInfo,
-		std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
+	GpuFuture BindSparse(const vk::BindSparseInfo& bindSparseInfo) const;
 
 	vk::Result PresentKHR(const vk::PresentInfoKHR& presentInfo) const;
 
+	// Waits for everything submitted so far
 	bool WaitIdle(std::chrono::nanoseconds timeOut = std::chrono::nanoseconds::max()) const;
 
+	// Submissions the device hasn't finished yet
+	uint64_t GetPendingCount() const;
+	GpuFuture GetLastSubmission() const;
+
 	QueueFamily* GetQueueFamilyInfo() const { return mFamilyInfo; }
 	uint32_t GetQueueIndex() const { return mQueueIndex; }
 
 private:
 	vk::Queue mHandle;
-	vk::Fence mFence;
+	vk::Semaphore mTimeline;
+
+	// Last value handed to a submission
+	mutable uint64_t mSubmittedValue = 0;
 
 	uint32_t mQueueIndex = -1;
 	QueueFamily* mFamilyInfo  = nullptr;
@@ -56,10 +59,10 @@ private:
 	mutable std::mutex mLock;
 	vk::Device mDevice;
 
-	Queue(vk::Queue handle, vk::Fence fence, uint32_t queueIndex, vk::Device device)
-		: mHandle(handle), mFence(fence), mQueueIndex(queueIndex), mDevice(device) {}
+	Queue(vk::Queue handle, vk::Semaphore timeline, uint32_t queueIndex, vk::Device device)
+		: mHandle(handle), mTimeline(timeline), mQueueIndex(queueIndex), mDevice(device) {}
 
-	vk::Result WaitIdleAsync(uint64_t timeout) const;
+	GpuFuture SubmitBatches(std::vector<vk::SubmitInfo>& submitInfos) const;
 
 	friend class Context;
 	friend class QueueManager;
@@ -17,6 +17,10 @@ public:
 	template<typename Fn>
 	void InvokeOneTimeProcess(uint32_t index, Fn&& fn) const;
 
+	// Returns as soon as the work is submitted
+	template<typename Fn>
+	Core::GpuFuture InvokeOneTimeProcessAsync(uint32_t index, Fn&& fn) const;
+
 	template <typename Fn>
 	void InvokeProcess(uint32_t index, Fn&& fn) const;
 
@@ -54,8 +58,7 @@ void VK_NAMESPACE::RecordableResource::InvokeProcess(uint32_t index, Fn&& fn) co
 	auto executor = mQueueManager->FetchExecutor(index, QueueAccessType::eWorker);
 	auto cmdBuf = mCommandPools[index].Allocate();
 
-	auto queue = executor.SubmitWork(fn(cmdBuf));
-	executor[queue]->WaitIdle();
+	executor.SubmitWork(fn(cmdBuf)).Wait();
 
 	mCommandPools[index].Free(cmdBuf);
 }
@@ -72,4 +75,16 @@ void VK_NAMESPACE::RecordableResource::InvokeOneTimeProcess(uint32_t index, Fn&&
 	mCommandPools[index].EndOneTimeCommands(cmdBuf, executor);
 }
 
+template<typename Fn>
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::RecordableResource::InvokeOneTimeProcessAsync(
+	uint32_t index, Fn&& fn) const
+{
+	auto executor = mQueueManager->FetchExecutor(index, QueueAccessType::eWorker);
+	auto cmdBuf = mCommandPools[index].BeginOneTimeCommands();
+
+	fn(cmdBuf);
+
+	return mCommandPools[index].EndOneTimeCommandsAsync(cmdBuf, executor);
+}
+
 VK_END
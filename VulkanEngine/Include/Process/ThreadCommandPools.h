@@ -0,0 +1,43 @@
+#pragma once
+#include "Commands.h"
+
+VK_BEGIN
+
+using CommandPoolsFactory = std::function<CommandPools()>;
+
+VK_CORE_BEGIN
+
+struct ThreadCommandPoolsData
+{
+	CommandPoolsFactory Factory;
+
+	std::mutex Lock;
+	std::unordered_map<std::thread::id, CommandPools> Pools;
+};
+
+VK_CORE_END
+
+// Vulkan wants a command pool and the buffers recorded from it to be used by one thread at a time
+// Every thread asking for a pool gets its own set, created through the factory the first time
+// Meant for long lived threads, the sets live as long as the registry does
+class ThreadCommandPools
+{
+public:
+	ThreadCommandPools() = default;
+	explicit ThreadCommandPools(CommandPoolsFactory&& factory);
+
+	// The pools of the calling thread
+	const CommandPools& GetThreadPools() const;
+
+	const CommandBufferAllocator& operator[](uint32_t familyIndex) const
+		{ return GetThreadPools()[familyIndex]; }
+
+	size_t GetThreadCount() const;
+
+	explicit operator bool() const { return static_cast<bool>(mRegistry); }
+
+private:
+	std::shared_ptr<Core::ThreadCommandPoolsData> mRegistry;
+};
+
+VK_END
@@ -0,0 +1,90 @@
+#pragma once
+#include "Commands.h"
+#include "QueueManager.h"
+
+VK_BEGIN
+
+// Runs copies on a transfer only family when the device has one, so large uploads don't hold up the compute queues
+// The written buffers stay owned by the destination family, the ownership goes over and back around every batch
+// Without a transfer only family the copies run on the destination family itself, with the same results
+class TransferExecutor
+{
+public:
+	TransferExecutor() = default;
+
+	// recordFn(cmd) records the copies into the buffers of writtenBuffers
+	// The destination family work that waits on the returned future sees the written data
+	template <typename Fn>
+	Core::GpuFuture Submit(Fn&& recordFn, const std::vector<Core::Ref<Core::Buffer>>& writtenBuffers,
+		const std::vector<Core::GpuFuture>& waitFor = {}) const;
+
+	bool IsDedicated() const { return mTransferFamily != mDstFamily; }
+
+	uint32_t GetTransferFamilyIndex() const { return mTransferFamily; }
+	uint32_t GetDstFamilyIndex() const { return mDstFamily; }
+
+	explicit operator bool() const { return static_cast<bool>(mQueueManager); }
+
+private:
+	QueueManagerRef mQueueManager;
+	CommandPools mCommandPools;
+
+	uint32_t mTransferFamily = -1;
+	uint32_t mDstFamily = -1;
+
+	friend class ResourcePool;
+
+private:
+	TransferExecutor(QueueManagerRef queueManager, const CommandPools& commandPools, uint32_t dstFamilyIndex);
+
+	// Helper functions...
+	void RecordRelease(vk::CommandBuffer cmdBuffer, const std::vector<Core::Ref<Core::Buffer>>& buffers,
+		uint32_t srcFamily, uint32_t dstFamily) const;
+	void RecordAcquire(vk::CommandBuffer cmdBuffer, const std::vector<Core::Ref<Core::Buffer>>& buffers,
+		uint32_t srcFamily, uint32_t dstFamily) const;
+
+	Core::GpuFuture ReleaseToTransfer(const std::vector<Core::Ref<Core::Buffer>>& buffers,
+		const std::vector<Core::GpuFuture>& waitFor) const;
+	Core::GpuFuture AcquireFromTransfer(const std::vector<Core::Ref<Core::Buffer>>& buffers,
+		const Core::GpuFuture& copied) const;
+
+	Core::GpuFuture EndCommands(vk::CommandBuffer cmdBuffer, uint32_t familyIndex,
+		const std::vector<Core::GpuFuture>& waitFor) const;
+};
+
+template <typename Fn>
+Core::GpuFuture TransferExecutor::Submit(Fn&& recordFn, const std::vector<Core::Ref<Core::Buffer>>& writtenBuffers,
+	const std::vector<Core::GpuFuture>& waitFor) const
+{
+	if (!IsDedicated())
+	{
+		vk::CommandBuffer cmdBuffer = mCommandPools[mDstFamily].BeginOneTimeCommands();
+
+		recordFn(cmdBuffer);
+
+		// Same family, a plain barrier makes the copies visible to the work submitted after them
+		vk::MemoryBarrier barrier{};
+		barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+		barrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+
+		cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+			vk::PipelineStageFlagBits::eAllCommands, {}, barrier, nullptr, nullptr);
+
+		return EndCommands(cmdBuffer, mDstFamily, waitFor);
+	}
+
+	// The destination family gives the buffers up first, so the contents outside the copies survive
+	Core::GpuFuture released = ReleaseToTransfer(writtenBuffers, waitFor);
+
+	vk::CommandBuffer cmdBuffer = mCommandPools[mTransferFamily].BeginOneTimeCommands();
+
+	RecordAcquire(cmdBuffer, writtenBuffers, mDstFamily, mTransferFamily);
+	recordFn(cmdBuffer);
+	RecordRelease(cmdBuffer, writtenBuffers, mTransferFamily, mDstFamily);
+
+	Core::GpuFuture copied = EndCommands(cmdBuffer, mTransferFamily, { released });
+
+	return AcquireFromTransfer(writtenBuffers, copied);
+}
+
+VK_END
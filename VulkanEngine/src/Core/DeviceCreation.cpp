@@ -45,6 +45,12 @@ vk::Device VK_NAMESPACE::VK_CORE::VK_UTILS::CreateDevice(const DeviceCreateInfo&
 
 	RawCreateInfo.pEnabledFeatures = &createInfo.RequiredFeatures;
 
+	// Every queue tracks its submissions on a timeline semaphore
+	vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+	timelineFeatures.setTimelineSemaphore(VK_TRUE);
+
+	RawCreateInfo.setPNext(&timelineFeatures);
+
 	RawCreateInfo.pQueueCreateInfos = infos.data();
 	RawCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(infos.size());
 
@@ -78,3 +84,15 @@ vk::Semaphore VK_NAMESPACE::VK_CORE::VK_UTILS::CreateSemaphore(vk::Device device
 {
 	return device.createSemaphore({});
 }
+
+vk::Semaphore VK_NAMESPACE::VK_CORE::VK_UTILS::CreateTimelineSemaphore(vk::Device device, uint64_t initialValue)
+{
+	vk::SemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.setSemaphoreType(vk::SemaphoreType::eTimeline);
+	typeInfo.setInitialValue(initialValue);
+
+	vk::SemaphoreCreateInfo info{};
+	info.setPNext(&typeInfo);
+
+	return device.createSemaphore(info);
+}
@@ -1,4 +1,5 @@
 #include "Core/Utils/MemoryUtils.h"
+#include "Memory/MemoryAllocator.h"
 
 struct MemoryUtilsHelper {
 	std::unordered_map<VkImageLayout, VkAccessFlags> mAccessFlagsByImageLayout;
@@ -136,9 +137,9 @@ VK_NAMESPACE::VK_CORE::Buffer VK_NAMESPACE::VK_CORE::VK_UTILS::CreateBuffer(Buff
 	bufferInput.ElemCount = memReq.size / bufferInput.TypeSize;
 
 	auto Memory = AllocateMemory(memReq, bufferInput.MemProps, 
-		bufferInput.LogicalDevice, bufferInput.PhysicalDevice);
+		bufferInput.LogicalDevice, bufferInput.PhysicalDevice, bufferInput.Allocator, false);
 
-	bufferInput.LogicalDevice.bindBufferMemory(Handle, Memory, 0);
+	bufferInput.LogicalDevice.bindBufferMemory(Handle, Memory.Handle, Memory.Offset);
 
 	return { Handle, Memory, memReq, bufferInput.ElemCount, bufferInput };
 }
@@ -155,6 +156,32 @@ vk::DeviceMemory VK_NAMESPACE::VK_CORE::VK_UTILS::AllocateMemory(
 	return logicalDevice.allocateMemory(allocInfo);
 }
 
+VK_NAMESPACE::VK_CORE::MemoryAllocation VK_NAMESPACE::VK_CORE::VK_UTILS::AllocateMemory(
+	const vk::MemoryRequirements& memReq, vk::MemoryPropertyFlags props,
+	vk::Device logicalDevice, vk::PhysicalDevice physicalDevice,
+	const std::shared_ptr<MemoryAllocator>& allocator, bool optimalImage)
+{
+	if (allocator)
+		return allocator->Allocate(memReq, props, optimalImage);
+
+	MemoryAllocation allocation{};
+	allocation.Handle = AllocateMemory(memReq, props, logicalDevice, physicalDevice);
+	allocation.Size = memReq.size;
+
+	return allocation;
+}
+
+void VK_NAMESPACE::VK_CORE::VK_UTILS::FreeMemory(vk::Device logicalDevice, const MemoryAllocation& allocation)
+{
+	if (allocation.Allocator)
+	{
+		allocation.Allocator->Free(allocation);
+		return;
+	}
+
+	logicalDevice.freeMemory(allocation.Handle);
+}
+
 void VK_NAMESPACE::VK_CORE::VK_UTILS::RecordBufferTransferBarrier(const BufferOwnershipTransferInfo& barrierInfo)
 {
 	vk::BufferMemoryBarrier barrier{};
@@ -290,10 +317,10 @@ VK_NAMESPACE::VK_CORE::Image VK_NAMESPACE::VK_CORE::VK_UTILS::CreateImage(ImageC
 	vk::Image image = config.LogicalDevice.createImage(createInfo);
 	vk::MemoryRequirements memreq = config.LogicalDevice.getImageMemoryRequirements(image);
 
-	vk::DeviceMemory Memory = AllocateMemory(memreq, config.MemProps,
-		config.LogicalDevice, config.PhysicalDevice);
+	MemoryAllocation Memory = AllocateMemory(memreq, config.MemProps, config.LogicalDevice,
+		config.PhysicalDevice, config.Allocator, config.Tiling == vk::ImageTiling::eOptimal);
 
-	config.LogicalDevice.bindImageMemory(image, Memory, 0);
+	config.LogicalDevice.bindImageMemory(image, Memory.Handle, Memory.Offset);
 
 	ImageViewInfo viewInfo{};
 	viewInfo.Format = config.Format;
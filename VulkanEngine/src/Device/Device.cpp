@@ -36,12 +36,12 @@ VK_NAMESPACE::Device::Device(const DeviceCreateInfo& info)
 
 		for (size_t i = 0; i < Count; i++)
 		{
-			auto Fence = mHandle->createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
+			auto Timeline = Core::Utils::CreateTimelineSemaphore(*mHandle, 0);
 			Core::Queue Queue(mHandle->getQueue(index, static_cast<uint32_t>(i)),
-				Fence, static_cast<uint32_t>(i), *mHandle);
+				Timeline, static_cast<uint32_t>(i), *mHandle);
 
 			FamilyRef.emplace_back(Queue, [Device](Core::Queue queue)
-				{ Device->destroyFence(queue.mFence); });
+				{ Device->destroySemaphore(queue.mTimeline); });
 		}
 	}
 
@@ -135,6 +135,11 @@ VK_NAMESPACE::MemoryResourceManager VK_NAMESPACE::Device::MakeMemoryResourceMana
 	manager.mImageProcessHandler = MakeProcessManager(true);
 	manager.mQueueManager = mQueueManager;
 
+	Core::MemoryAllocatorCreateInfo allocatorInfo{};
+	allocatorInfo.Backend = std::make_shared<Core::DeviceMemoryBackend>(mHandle, mDeviceInfo.PhysicalDevice.Handle);
+
+	manager.mAllocator = std::make_shared<Core::MemoryAllocator>(allocatorInfo);
+
 	return manager;
 }
 
@@ -126,7 +126,7 @@ void VK_NAMESPACE::Swapchain::InsertImageHandle(Image& image,
 	handles.Config.Usage = vk::ImageUsageFlagBits::eColorAttachment;
 
 	handles.IdentityView = viewHandle;
-	handles.Memory = nullptr;
+	handles.Memory = {};
 	handles.MemReq = vk::MemoryRequirements();
 
 	auto SwapchainHandle = mHandle;
@@ -0,0 +1,288 @@
+#include "Memory/MemoryAllocator.h"
+
+namespace
+{
+	vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	constexpr uint32_t sPoolsPerMemoryType = 2;
+}
+
+VK_NAMESPACE::VK_CORE::DeviceMemoryBackend::DeviceMemoryBackend(
+	Core::Ref<vk::Device> device, vk::PhysicalDevice physicalDevice)
+	: mDevice(device)
+{
+	mMemoryProperties = physicalDevice.getMemoryProperties();
+	mNonCoherentAtomSize = physicalDevice.getProperties().limits.nonCoherentAtomSize;
+}
+
+vk::DeviceMemory VK_NAMESPACE::VK_CORE::DeviceMemoryBackend::AllocateBlock(
+	uint32_t memoryTypeIndex, vk::DeviceSize size)
+{
+	vk::MemoryAllocateInfo allocInfo{};
+	allocInfo.setAllocationSize(size);
+	allocInfo.setMemoryTypeIndex(memoryTypeIndex);
+
+	return mDevice->allocateMemory(allocInfo);
+}
+
+void VK_NAMESPACE::VK_CORE::DeviceMemoryBackend::FreeBlock(vk::DeviceMemory memory)
+{
+	mDevice->freeMemory(memory);
+}
+
+void* VK_NAMESPACE::VK_CORE::DeviceMemoryBackend::MapBlock(vk::DeviceMemory memory)
+{
+	return mDevice->mapMemory(memory, 0, VK_WHOLE_SIZE);
+}
+
+void VK_NAMESPACE::VK_CORE::DeviceMemoryBackend::UnmapBlock(vk::DeviceMemory memory)
+{
+	mDevice->unmapMemory(memory);
+}
+
+VK_NAMESPACE::VK_CORE::MemoryAllocator::MemoryAllocator(const MemoryAllocatorCreateInfo& createInfo)
+	: mCreateInfo(createInfo)
+{
+	_STL_ASSERT(mCreateInfo.Backend, "MemoryAllocator needs a block backend!");
+	_STL_ASSERT(mCreateInfo.BlockSize > 0, "MemoryAllocator block size must be non zero!");
+
+	mPools.resize(mCreateInfo.Backend->GetMemoryProperties().memoryTypeCount * sPoolsPerMemoryType);
+}
+
+VK_NAMESPACE::VK_CORE::MemoryAllocator::~MemoryAllocator()
+{
+	// Every resource holds a reference, so all the blocks are free by now
+	for (uint32_t block = 0; block < mBlocks.size(); block++)
+	{
+		if (mBlocks[block].Memory)
+			DestroyBlock(block);
+	}
+}
+
+VK_NAMESPACE::VK_CORE::MemoryAllocation VK_NAMESPACE::VK_CORE::MemoryAllocator::Allocate(
+	const vk::MemoryRequirements& memReq, vk::MemoryPropertyFlags memProps, bool optimalImage)
+{
+	uint32_t memoryTypeIndex = FindMemoryTypeIndex(memReq.memoryTypeBits, memProps);
+
+	_STL_ASSERT(memoryTypeIndex != static_cast<uint32_t>(-1), "No memory type satisfies the requested properties!");
+
+	vk::MemoryPropertyFlags typeProps =
+		mCreateInfo.Backend->GetMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+
+	vk::DeviceSize size = memReq.size;
+	vk::DeviceSize alignment = std::max<vk::DeviceSize>(memReq.alignment, 1);
+
+	// Flushing the non coherent ranges must not touch the neighbours
+	if ((typeProps & vk::MemoryPropertyFlagBits::eHostVisible) &&
+		!(typeProps & vk::MemoryPropertyFlagBits::eHostCoherent))
+	{
+		vk::DeviceSize atomSize = mCreateInfo.Backend->GetNonCoherentAtomSize();
+
+		alignment = std::max(alignment, atomSize);
+		size = AlignUp(size, atomSize);
+	}
+
+	uint32_t pool = memoryTypeIndex * sPoolsPerMemoryType + (optimalImage ? 1 : 0);
+	vk::DeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+	std::scoped_lock locker(mLock);
+
+	uint32_t block = static_cast<uint32_t>(-1);
+	std::optional<SubAllocation> range;
+
+	if (size > blockSize / 2)
+	{
+		block = CreateBlock(pool, size, true);
+		range = SubAllocation{ 0, size, 0 };
+	}
+
+	for (size_t i = 0; !range && i < mPools[pool].size(); i++)
+	{
+		block = mPools[pool][i];
+		range = AllocateFromBlock(mBlocks[block], size, alignment);
+	}
+
+	if (!range)
+	{
+		block = CreateBlock(pool, blockSize, false);
+		range = AllocateFromBlock(mBlocks[block], size, alignment);
+	}
+
+	MemoryAllocation allocation{};
+	allocation.Handle = mBlocks[block].Memory;
+	allocation.Offset = range->Offset;
+	allocation.Size = size;
+	allocation.Allocator = shared_from_this();
+	allocation.Block = block;
+	allocation.Range = range->Range;
+
+	if (mBlocks[block].MappedData)
+		allocation.MappedData = static_cast<uint8_t*>(mBlocks[block].MappedData) + range->Offset;
+
+	return allocation;
+}
+
+void VK_NAMESPACE::VK_CORE::MemoryAllocator::Free(const MemoryAllocation& allocation)
+{
+	std::scoped_lock locker(mLock);
+
+	MemoryBlock& block = mBlocks[allocation.Block];
+
+	_STL_ASSERT(block.Memory == allocation.Handle, "Freeing an allocation of another allocator!");
+
+	if (block.Dedicated)
+	{
+		DestroyBlock(allocation.Block);
+		return;
+	}
+
+	// The linear ranges come back in Reset
+	if (mCreateInfo.Mode == MemoryAllocatorMode::eLinear)
+		return;
+
+	block.Heap.Free(allocation.Range);
+
+	// Keeping the last block of the pool around, so an alloc/free pair doesn't hit the driver every time
+	auto& poolBlocks = mPools[block.Pool];
+
+	if (!block.Heap.IsEmpty() || poolBlocks.size() == 1)
+		return;
+
+	DestroyBlock(allocation.Block);
+}
+
+void VK_NAMESPACE::VK_CORE::MemoryAllocator::Reset()
+{
+	std::scoped_lock locker(mLock);
+
+	for (auto& block : mBlocks)
+		block.Arena.Reset();
+}
+
+VK_NAMESPACE::VK_CORE::MemoryAllocatorStats VK_NAMESPACE::VK_CORE::MemoryAllocator::GetStats() const
+{
+	std::scoped_lock locker(mLock);
+
+	MemoryAllocatorStats stats{};
+
+	for (const auto& block : mBlocks)
+	{
+		if (!block.Memory)
+			continue;
+
+		stats.BlockCount++;
+		stats.BlockBytes += block.Size;
+
+		if (block.Dedicated)
+		{
+			stats.DedicatedBlockCount++;
+			stats.AllocationCount++;
+			stats.UsedBytes += block.Size;
+			continue;
+		}
+
+		bool isLinear = mCreateInfo.Mode == MemoryAllocatorMode::eLinear;
+
+		stats.AllocationCount += isLinear ? block.Arena.GetAllocationCount() : block.Heap.GetAllocationCount();
+		stats.UsedBytes += isLinear ? block.Arena.GetUsedSize() : block.Heap.GetUsedSize();
+	}
+
+	return stats;
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::MemoryAllocator::FindMemoryTypeIndex(
+	uint32_t memoryTypeBits, vk::MemoryPropertyFlags memProps) const
+{
+	const auto& deviceMemProps = mCreateInfo.Backend->GetMemoryProperties();
+
+	for (uint32_t i = 0; i < deviceMemProps.memoryTypeCount; i++)
+	{
+		bool supported = memoryTypeBits & (1 << i);
+		bool sufficient = (deviceMemProps.memoryTypes[i].propertyFlags & memProps) == memProps;
+
+		if (supported && sufficient)
+			return i;
+	}
+
+	return -1;
+}
+
+vk::DeviceSize VK_NAMESPACE::VK_CORE::MemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+	const auto& deviceMemProps = mCreateInfo.Backend->GetMemoryProperties();
+	uint32_t heapIndex = deviceMemProps.memoryTypes[memoryTypeIndex].heapIndex;
+
+	// Small heaps such as the 256 MB host visible device local one shouldn't go to a handful of blocks
+	return std::min(mCreateInfo.BlockSize, deviceMemProps.memoryHeaps[heapIndex].size / 8);
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::MemoryAllocator::CreateBlock(uint32_t pool, vk::DeviceSize size, bool dedicated)
+{
+	uint32_t memoryTypeIndex = pool / sPoolsPerMemoryType;
+
+	MemoryBlock block{};
+	block.Memory = mCreateInfo.Backend->AllocateBlock(memoryTypeIndex, size);
+	block.Size = size;
+	block.Pool = pool;
+	block.Dedicated = dedicated;
+
+	// Nothing is sub allocated from the dedicated blocks
+	if (!dedicated && mCreateInfo.Mode == MemoryAllocatorMode::eTLSF)
+		block.Heap = TLSF_Heap(size);
+
+	if (!dedicated && mCreateInfo.Mode == MemoryAllocatorMode::eLinear)
+		block.Arena = LinearArena(size);
+
+	// Host visible blocks stay mapped for their whole lifetime, a memory object can only be mapped once
+	if (mCreateInfo.Backend->GetMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags &
+		vk::MemoryPropertyFlagBits::eHostVisible)
+		block.MappedData = mCreateInfo.Backend->MapBlock(block.Memory);
+
+	uint32_t index = static_cast<uint32_t>(mBlocks.size());
+
+	if (mUnusedBlocks.empty())
+		mBlocks.push_back(std::move(block));
+	else
+	{
+		index = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+
+		mBlocks[index] = std::move(block);
+	}
+
+	if (!dedicated)
+		mPools[pool].push_back(index);
+
+	return index;
+}
+
+void VK_NAMESPACE::VK_CORE::MemoryAllocator::DestroyBlock(uint32_t block)
+{
+	MemoryBlock& memoryBlock = mBlocks[block];
+
+	if (memoryBlock.MappedData)
+		mCreateInfo.Backend->UnmapBlock(memoryBlock.Memory);
+
+	mCreateInfo.Backend->FreeBlock(memoryBlock.Memory);
+
+	auto& poolBlocks = mPools[memoryBlock.Pool];
+	auto found = std::find(poolBlocks.begin(), poolBlocks.end(), block);
+
+	if (found != poolBlocks.end())
+		poolBlocks.erase(found);
+
+	memoryBlock = {};
+	mUnusedBlocks.push_back(block);
+}
+
+std::optional<VK_NAMESPACE::VK_CORE::SubAllocation> VK_NAMESPACE::VK_CORE::MemoryAllocator::AllocateFromBlock(
+	MemoryBlock& block, vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	if (mCreateInfo.Mode == MemoryAllocatorMode::eLinear)
+		return block.Arena.Allocate(size, alignment);
+
+	return block.Heap.Allocate(size, alignment);
+}
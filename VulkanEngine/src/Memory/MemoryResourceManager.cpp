@@ -19,6 +19,7 @@ VK_NAMESPACE::Image VK_NAMESPACE::MemoryResourceManager::CreateImage(const Image
 	config.Tiling = info.Tiling;
 	config.Type = info.Type;
 	config.MemProps = info.MemProps;
+	config.Allocator = mAllocator;
 	config.Usage = info.Usage | vk::ImageUsageFlagBits::eTransferSrc
 		| vk::ImageUsageFlagBits::eTransferDst;
 
@@ -31,7 +32,7 @@ VK_NAMESPACE::Image VK_NAMESPACE::MemoryResourceManager::CreateImage(const Image
 	Core::Ref<Core::ImageChunk> chunkRef = Core::CreateRef(chunk, 
 		[](const Core::ImageChunk handles)
 	{
-		handles.Device->freeMemory(handles.ImageHandles.Memory);
+		Core::Utils::FreeMemory(*handles.Device, handles.ImageHandles.Memory);
 		handles.Device->destroyImage(handles.ImageHandles.Handle);
 		handles.Device->destroyImageView(handles.ImageHandles.IdentityView);
 	});
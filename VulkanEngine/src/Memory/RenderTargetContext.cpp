@@ -115,7 +115,7 @@ VK_NAMESPACE::VK_CORE::Ref<VK_NAMESPACE::VK_CORE::ImageChunk> VK_NAMESPACE::Rend
 
 	return Core::CreateRef(chunk, [Device](const Core::ImageChunk& handles)
 	{
-		Device->freeMemory(handles.ImageHandles.Memory);
+		Core::Utils::FreeMemory(*Device, handles.ImageHandles.Memory);
 		Device->destroyImage(handles.ImageHandles.Handle);
 		Device->destroyImageView(handles.ImageHandles.IdentityView);
 	});
@@ -0,0 +1,182 @@
+#include "Memory/StagingRing.h"
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Enough for any element type that is staged through the ring
+	constexpr uint64_t sStagingAlignment = 16;
+}
+
+VK_NAMESPACE::VK_CORE::StagingRingData::~StagingRingData()
+{
+	for (auto& batch : Batches)
+		batch.Completion.Wait();
+}
+
+size_t VK_NAMESPACE::StagingRing::GetPendingCopyCount() const
+{
+	return mData->PendingCopies.size();
+}
+
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::StagingRing::Flush(bool wait /*= false*/)
+{
+	return FlushPending(wait);
+}
+
+void VK_NAMESPACE::StagingRing::WaitIdle()
+{
+	while (!mData->Batches.empty())
+		Recycle(true);
+}
+
+uint8_t* VK_NAMESPACE::StagingRing::Allocate(vk::DeviceSize size, vk::DeviceSize& ringOffset)
+{
+	Core::StagingRingData& ring = *mData;
+
+	_STL_ASSERT(size <= ring.Capacity, "StagingRing allocation is larger than the ring!");
+
+	while (true)
+	{
+		Recycle(false);
+
+		// Nothing in flight, starting over at the front of the ring
+		if (ring.Head == ring.Tail)
+			ring.Head = ring.Tail = AlignUp(ring.Head, ring.Capacity);
+
+		uint64_t Begin = AlignUp(ring.Head, sStagingAlignment);
+
+		// Ranges never wrap around the end, the rest of the ring is skipped instead
+		if (Begin % ring.Capacity + size > ring.Capacity)
+			Begin = AlignUp(Begin, ring.Capacity);
+
+		if (Begin + size - ring.Tail <= ring.Capacity)
+		{
+			ring.Head = Begin + size;
+			ringOffset = Begin % ring.Capacity;
+
+			return ring.MappedData + ringOffset;
+		}
+
+		// The ring is full, the pending copies might be the ones holding on to it
+		if (!ring.PendingCopies.empty())
+			FlushPending(false);
+
+		Recycle(true);
+	}
+}
+
+void VK_NAMESPACE::StagingRing::AddCopy(const Core::Ref<Core::Buffer>& dst, vk::DeviceSize ringOffset,
+	vk::DeviceSize dstOffset, vk::DeviceSize size)
+{
+	auto& pendingCopies = mData->PendingCopies;
+
+	// Consecutive pieces of the same upload become one region
+	if (!pendingCopies.empty())
+	{
+		Core::StagingCopy& last = pendingCopies.back();
+
+		bool sameBuffer = &(*last.Destination) == &(*dst);
+		bool contiguous = last.Region.srcOffset + last.Region.size == ringOffset &&
+			last.Region.dstOffset + last.Region.size == dstOffset;
+
+		if (sameBuffer && contiguous)
+		{
+			last.Region.size += size;
+			return;
+		}
+	}
+
+	vk::BufferCopy region{};
+	region.setSrcOffset(ringOffset);
+	region.setDstOffset(dstOffset);
+	region.setSize(size);
+
+	pendingCopies.push_back({ dst, region });
+}
+
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::StagingRing::FlushPending(bool wait)
+{
+	Core::StagingRingData& ring = *mData;
+
+	if (ring.PendingCopies.empty())
+	{
+		Core::GpuFuture lastBatch = ring.Batches.empty() ? Core::GpuFuture() : ring.Batches.back().Completion;
+
+		if (wait)
+			WaitIdle();
+
+		return lastBatch;
+	}
+
+	std::vector<Core::Ref<Core::Buffer>> writtenBuffers;
+
+	for (const auto& copy : ring.PendingCopies)
+	{
+		auto found = std::find_if(writtenBuffers.begin(), writtenBuffers.end(),
+			[&copy](const Core::Ref<Core::Buffer>& buffer) { return &(*buffer) == &(*copy.Destination); });
+
+		if (found == writtenBuffers.end())
+			writtenBuffers.push_back(copy.Destination);
+	}
+
+	vk::Buffer srcBuffer = ring.RingBuffer.GetNativeHandles().Handle;
+
+	// The batches may go to different queues, each one starts after the previous so the later copy of a range wins
+	std::vector<Core::GpuFuture> waitFor;
+
+	if (!ring.Batches.empty())
+		waitFor.push_back(ring.Batches.back().Completion);
+
+	Core::GpuFuture completion = ring.Transfer.Submit([&ring, srcBuffer](vk::CommandBuffer cmdBuffer)
+	{
+		std::vector<vk::BufferCopy> regions;
+
+		// One vkCmdCopyBuffer per run of regions going into the same buffer
+		for (size_t i = 0; i < ring.PendingCopies.size(); i++)
+		{
+			const Core::StagingCopy& copy = ring.PendingCopies[i];
+			regions.push_back(copy.Region);
+
+			bool lastOfRun = i + 1 == ring.PendingCopies.size() ||
+				&(*ring.PendingCopies[i + 1].Destination) != &(*copy.Destination);
+
+			if (!lastOfRun)
+				continue;
+
+			cmdBuffer.copyBuffer(srcBuffer, copy.Destination->Handle, regions);
+			regions.clear();
+		}
+	}, writtenBuffers, waitFor);
+
+	ring.Batches.push_back({ completion, ring.Head });
+	ring.PendingCopies.clear();
+
+	if (wait)
+		WaitIdle();
+
+	return completion;
+}
+
+void VK_NAMESPACE::StagingRing::Recycle(bool waitOldest)
+{
+	Core::StagingRingData& ring = *mData;
+
+	while (!ring.Batches.empty())
+	{
+		Core::StagingBatch& oldest = ring.Batches.front();
+
+		bool completed = waitOldest ? oldest.Completion.Wait() : oldest.Completion.IsReady();
+
+		if (!completed)
+			return;
+
+		ring.Tail = oldest.RingEnd;
+
+		ring.Batches.pop_front();
+		waitOldest = false;
+	}
+}
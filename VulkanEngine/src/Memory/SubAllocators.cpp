@@ -0,0 +1,279 @@
+#include "Memory/SubAllocators.h"
+
+namespace
+{
+	vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+VK_NAMESPACE::VK_CORE::TLSF_Heap::TLSF_Heap(vk::DeviceSize size)
+	: mSize(size)
+{
+	for (auto& secondLevel : mFreeLists)
+		secondLevel.fill(sNullRange);
+
+	if (size == 0)
+		return;
+
+	Range whole{};
+	whole.Size = size;
+	whole.IsFree = true;
+
+	InsertFreeRange(CreateRange(whole));
+}
+
+std::optional<VK_NAMESPACE::VK_CORE::SubAllocation> VK_NAMESPACE::VK_CORE::TLSF_Heap::Allocate(
+	vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	size = std::max<vk::DeviceSize>(size, 1);
+	alignment = std::max<vk::DeviceSize>(alignment, 1);
+
+	// Any range of the found list fits the request after the worst case padding
+	uint32_t found = FindFreeRange(size + alignment - 1);
+
+	// Otherwise a smaller range might still fit, like the tail filling up the rest of a block
+	if (found == sNullRange)
+		found = FindFittingRange(size, alignment);
+
+	if (found == sNullRange)
+		return std::nullopt;
+
+	RemoveFreeRange(found);
+
+	vk::DeviceSize padding = AlignUp(mRanges[found].Offset, alignment) - mRanges[found].Offset;
+
+	// The padding stays free, its physical neighbour before can't be free or it would have been merged
+	if (padding > 0)
+	{
+		uint32_t aligned = SplitRange(found, padding);
+		InsertFreeRange(found);
+
+		found = aligned;
+	}
+
+	if (mRanges[found].Size > size)
+		InsertFreeRange(SplitRange(found, size));
+
+	mRanges[found].IsFree = false;
+
+	mUsedSize += size;
+	mAllocationCount++;
+
+	return SubAllocation{ mRanges[found].Offset, size, found };
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::Free(uint32_t range)
+{
+	_STL_ASSERT(range < mRanges.size() && !mRanges[range].IsFree, "Freeing an invalid TLSF range!");
+
+	mRanges[range].IsFree = true;
+
+	mUsedSize -= mRanges[range].Size;
+	mAllocationCount--;
+
+	uint32_t next = mRanges[range].NextPhysical;
+
+	if (next != sNullRange && mRanges[next].IsFree)
+	{
+		RemoveFreeRange(next);
+		MergeWithNext(range);
+	}
+
+	uint32_t prev = mRanges[range].PrevPhysical;
+
+	if (prev != sNullRange && mRanges[prev].IsFree)
+	{
+		RemoveFreeRange(prev);
+		MergeWithNext(prev);
+
+		range = prev;
+	}
+
+	InsertFreeRange(range);
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::MapSize(vk::DeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	if (size < sSecondLevelCount)
+	{
+		firstLevel = 0;
+		secondLevel = static_cast<uint32_t>(size);
+		return;
+	}
+
+	uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+
+	firstLevel = msb - sSecondLevelLog2 + 1;
+	secondLevel = static_cast<uint32_t>(size >> (msb - sSecondLevelLog2)) ^ sSecondLevelCount;
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::TLSF_Heap::FindFreeRange(vk::DeviceSize size) const
+{
+	// Rounding up to the next list, so the first range there is large enough
+	if (size >= sSecondLevelCount)
+	{
+		uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		size += (vk::DeviceSize(1) << (msb - sSecondLevelLog2)) - 1;
+	}
+
+	uint32_t firstLevel, secondLevel;
+	MapSize(size, firstLevel, secondLevel);
+
+	if (firstLevel >= sFirstLevelCount)
+		return sNullRange;
+
+	uint32_t secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+
+	if (secondLevelMap == 0)
+	{
+		uint64_t firstLevelMap = firstLevel + 1 < 64 ? mFirstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+
+		if (firstLevelMap == 0)
+			return sNullRange;
+
+		firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+		secondLevelMap = mSecondLevelBitmaps[firstLevel];
+	}
+
+	secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+
+	return mFreeLists[firstLevel][secondLevel];
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::TLSF_Heap::FindFittingRange(vk::DeviceSize size, vk::DeviceSize alignment) const
+{
+	uint32_t firstLevel, secondLevel;
+	MapSize(size, firstLevel, secondLevel);
+
+	if (firstLevel >= sFirstLevelCount)
+		return sNullRange;
+
+	for (uint32_t range = mFreeLists[firstLevel][secondLevel]; range != sNullRange; range = mRanges[range].NextFree)
+	{
+		vk::DeviceSize padding = AlignUp(mRanges[range].Offset, alignment) - mRanges[range].Offset;
+
+		if (mRanges[range].Size >= size + padding)
+			return range;
+	}
+
+	return sNullRange;
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::InsertFreeRange(uint32_t range)
+{
+	uint32_t firstLevel, secondLevel;
+	MapSize(mRanges[range].Size, firstLevel, secondLevel);
+
+	uint32_t head = mFreeLists[firstLevel][secondLevel];
+
+	mRanges[range].IsFree = true;
+	mRanges[range].PrevFree = sNullRange;
+	mRanges[range].NextFree = head;
+
+	if (head != sNullRange)
+		mRanges[head].PrevFree = range;
+
+	mFreeLists[firstLevel][secondLevel] = range;
+
+	mFirstLevelBitmap |= uint64_t(1) << firstLevel;
+	mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::RemoveFreeRange(uint32_t range)
+{
+	uint32_t firstLevel, secondLevel;
+	MapSize(mRanges[range].Size, firstLevel, secondLevel);
+
+	uint32_t prev = mRanges[range].PrevFree;
+	uint32_t next = mRanges[range].NextFree;
+
+	if (prev != sNullRange)
+		mRanges[prev].NextFree = next;
+
+	if (next != sNullRange)
+		mRanges[next].PrevFree = prev;
+
+	if (mFreeLists[firstLevel][secondLevel] == range)
+		mFreeLists[firstLevel][secondLevel] = next;
+
+	if (mFreeLists[firstLevel][secondLevel] == sNullRange)
+	{
+		mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+
+		if (mSecondLevelBitmaps[firstLevel] == 0)
+			mFirstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+	}
+
+	mRanges[range].PrevFree = sNullRange;
+	mRanges[range].NextFree = sNullRange;
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::TLSF_Heap::CreateRange(const Range& range)
+{
+	if (mUnusedRanges.empty())
+	{
+		mRanges.push_back(range);
+		return static_cast<uint32_t>(mRanges.size() - 1);
+	}
+
+	uint32_t index = mUnusedRanges.back();
+	mUnusedRanges.pop_back();
+
+	mRanges[index] = range;
+	return index;
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::DestroyRange(uint32_t range)
+{
+	mRanges[range] = {};
+	mUnusedRanges.push_back(range);
+}
+
+uint32_t VK_NAMESPACE::VK_CORE::TLSF_Heap::SplitRange(uint32_t range, vk::DeviceSize size)
+{
+	Range tail{};
+	tail.Offset = mRanges[range].Offset + size;
+	tail.Size = mRanges[range].Size - size;
+	tail.PrevPhysical = range;
+	tail.NextPhysical = mRanges[range].NextPhysical;
+	tail.IsFree = true;
+
+	// CreateRange may grow mRanges, so no references are held across it
+	uint32_t tailIndex = CreateRange(tail);
+
+	if (tail.NextPhysical != sNullRange)
+		mRanges[tail.NextPhysical].PrevPhysical = tailIndex;
+
+	mRanges[range].Size = size;
+	mRanges[range].NextPhysical = tailIndex;
+
+	return tailIndex;
+}
+
+void VK_NAMESPACE::VK_CORE::TLSF_Heap::MergeWithNext(uint32_t range)
+{
+	uint32_t next = mRanges[range].NextPhysical;
+
+	mRanges[range].Size += mRanges[next].Size;
+	mRanges[range].NextPhysical = mRanges[next].NextPhysical;
+
+	if (mRanges[next].NextPhysical != sNullRange)
+		mRanges[mRanges[next].NextPhysical].PrevPhysical = range;
+
+	DestroyRange(next);
+}
+
+std::optional<VK_NAMESPACE::VK_CORE::SubAllocation> VK_NAMESPACE::VK_CORE::LinearArena::Allocate(
+	vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	vk::DeviceSize offset = AlignUp(mHead, std::max<vk::DeviceSize>(alignment, 1));
+
+	if (offset + size > mSize)
+		return std::nullopt;
+
+	mHead = offset + size;
+
+	return SubAllocation{ offset, size, static_cast<uint32_t>(mAllocationCount++) };
+}
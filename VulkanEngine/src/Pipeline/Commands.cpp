@@ -26,12 +26,24 @@ void VK_NAMESPACE::CommandBufferAllocator::EndOneTimeCommands(
 	vk::SubmitInfo submitInfo{};
 	submitInfo.setCommandBuffers(CmdBuffer);
 
-	auto QueueIndex = Executor.SubmitWork(submitInfo);
-	Executor[QueueIndex]->WaitIdle();
+	Executor.SubmitWork(submitInfo).Wait();
 
 	Free(CmdBuffer);
 }
 
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::CommandBufferAllocator::EndOneTimeCommandsAsync(
+	vk::CommandBuffer CmdBuffer, Core::Executor Executor, const std::vector<Core::GpuFuture>& waitFor) const
+{
+	CmdBuffer.end();
+
+	Core::GpuFuture Future = Executor.SubmitWork(CmdBuffer, waitFor);
+
+	std::scoped_lock locker(mCommandPool->Lock);
+	mCommandPool->Retiring.emplace_back(CmdBuffer, Future);
+
+	return Future;
+}
+
 vk::CommandBuffer VK_NAMESPACE::CommandBufferAllocator::Allocate(
 	vk::CommandBufferLevel level /*= vk::CommandBufferLevel::ePrimary*/) const
 {
@@ -40,6 +52,8 @@ vk::CommandBuffer VK_NAMESPACE::CommandBufferAllocator::Allocate(
 	allocInfo.setCommandBufferCount(1);
 	allocInfo.setLevel(level);
 
+	FreeRetired();
+
 	vk::CommandBuffer CmdBuffer;
 
 	{
@@ -52,6 +66,21 @@ vk::CommandBuffer VK_NAMESPACE::CommandBufferAllocator::Allocate(
 	return CmdBuffer;
 }
 
+vk::CommandBuffer VK_NAMESPACE::CommandBufferAllocator::BeginSecondaryCommands(
+	const vk::CommandBufferInheritanceInfo& inheritanceInfo /*= {}*/,
+	vk::CommandBufferUsageFlags usage /*= vk::CommandBufferUsageFlagBits::eOneTimeSubmit*/) const
+{
+	vk::CommandBuffer buffer = Allocate(vk::CommandBufferLevel::eSecondary);
+
+	vk::CommandBufferBeginInfo beginInfo{};
+	beginInfo.setFlags(usage);
+	beginInfo.setPInheritanceInfo(&inheritanceInfo);
+
+	buffer.begin(beginInfo);
+
+	return buffer;
+}
+
 void VK_NAMESPACE::CommandBufferAllocator::Free(vk::CommandBuffer CmdBuffer) const
 {
 	RemoveInstanceDebug(CmdBuffer);
@@ -60,6 +89,34 @@ void VK_NAMESPACE::CommandBufferAllocator::Free(vk::CommandBuffer CmdBuffer) con
 	mDevice->freeCommandBuffers(mCommandPool->Handle, CmdBuffer);
 }
 
+size_t VK_NAMESPACE::CommandBufferAllocator::GetRetiringCount() const
+{
+	std::scoped_lock locker(mCommandPool->Lock);
+	return mCommandPool->Retiring.size();
+}
+
+void VK_NAMESPACE::CommandBufferAllocator::FreeRetired() const
+{
+	std::vector<vk::CommandBuffer> Finished;
+
+	{
+		std::scoped_lock locker(mCommandPool->Lock);
+
+		auto& Retiring = mCommandPool->Retiring;
+
+		auto Pending = std::partition(Retiring.begin(), Retiring.end(),
+			[](const auto& retired) { return !retired.second.IsReady(); });
+
+		for (auto It = Pending; It != Retiring.end(); It++)
+			Finished.push_back(It->first);
+
+		Retiring.erase(Pending, Retiring.end());
+	}
+
+	for (auto CmdBuffer : Finished)
+		Free(CmdBuffer);
+}
+
 void VK_NAMESPACE::CommandBufferAllocator::AddInstanceDebug(vk::CommandBuffer CmdBuffer) const
 {
 #if _DEBUG
@@ -126,7 +183,13 @@ VK_NAMESPACE::Core::Ref<VK_NAMESPACE::Core::CommandPoolData>
 	Pool.Handle = Handle;
 
 	return Core::CreateRef(Pool, [Device](const Core::CommandPoolData& PoolData)
-	{ Device->destroyCommandPool(PoolData.Handle); });
+	{
+		// The asynchronous one time commands may still be executing
+		for (const auto& [CmdBuffer, Future] : PoolData.Retiring)
+			Future.Wait();
+
+		Device->destroyCommandPool(PoolData.Handle);
+	});
 }
 
 VK_NAMESPACE::Core::Ref<VK_NAMESPACE::Core::CommandPoolData> 
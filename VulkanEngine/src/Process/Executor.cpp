@@ -1,81 +1,72 @@
 #include "Process/Executor.h"
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitWork(
-	const vk::SubmitInfo& submitInfo, std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Executor::SubmitWork(
+	const vk::SubmitInfo& submitInfo) const
 {
-	switch (mAccessType)
-	{
-		case QueueAccessType::eGeneric:
-			return SubmitToQueuesRange(
-				0, mFamilyData->Queues.size(), timeOut, submitInfo);
-		case QueueAccessType::eWorker:
-			return SubmitToQueuesRange(
-				mFamilyData->WorkerBeginIndex, mFamilyData->Queues.size(), timeOut, submitInfo);
-		default:
-			return -1;
-	}
+	return FindLeastBusyQueue()->Submit(submitInfo);
 }
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitWork(vk::CommandBuffer cmdBuffer,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Executor::SubmitWork(vk::CommandBuffer cmdBuffer) const
 {
 	vk::SubmitInfo submitInfo{};
 	submitInfo.setCommandBuffers(cmdBuffer);
 
-	return SubmitWork(submitInfo, timeOut);
+	return SubmitWork(submitInfo);
 }
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitWorkRange(const vk::SubmitInfo* begin, const vk::SubmitInfo* end,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Executor::SubmitWork(vk::CommandBuffer cmdBuffer,
+	const std::vector<GpuFuture>& waitFor, vk::PipelineStageFlags waitStage /*= eAllCommands*/) const
 {
-	switch (mAccessType)
+	std::vector<vk::Semaphore> waitSemaphores;
+	std::vector<uint64_t> waitValues;
+	std::vector<vk::PipelineStageFlags> waitStages;
+
+	for (const auto& future : waitFor)
 	{
-		case QueueAccessType::eGeneric:
-			return SubmitToQueuesRange(
-				0, mFamilyData->Queues.size(), timeOut, begin, end);
-		case QueueAccessType::eWorker:
-			return SubmitToQueuesRange(
-				mFamilyData->WorkerBeginIndex, mFamilyData->Queues.size(), timeOut, begin, end);
-		default:
-			return -1;
+		// Empty futures are complete already
+		if (!future)
+			continue;
+
+		waitSemaphores.push_back(future.GetSemaphore());
+		waitValues.push_back(future.GetValue());
+		waitStages.push_back(waitStage);
 	}
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.setWaitSemaphoreValues(waitValues);
+
+	vk::SubmitInfo submitInfo{};
+	submitInfo.setCommandBuffers(cmdBuffer);
+	submitInfo.setWaitSemaphores(waitSemaphores);
+	submitInfo.setWaitDstStageMask(waitStages);
+	submitInfo.setPNext(&timelineInfo);
+
+	return SubmitWork(submitInfo);
 }
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitWorkRange(
-	vk::CommandBuffer* begin, vk::CommandBuffer* end, 
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Executor::SubmitWorkRange(
+	const vk::SubmitInfo* begin, const vk::SubmitInfo* end) const
 {
-	std::vector<vk::SubmitInfo> submitInfos(end - begin);
-
-	for (auto& info : submitInfos)
-		info.setCommandBuffers(*(begin++));
+	return FindLeastBusyQueue()->SubmitRange(begin, end);
+}
 
-	return SubmitWorkRange(submitInfos.begin()._Unwrapped(), submitInfos.end()._Unwrapped(), timeOut);
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Executor::SubmitWorkRange(
+	vk::CommandBuffer* begin, vk::CommandBuffer* end) const
+{
+	return FindLeastBusyQueue()->SubmitRange(begin, end);
 }
 
 bool VK_NAMESPACE::VK_CORE::Executor::WaitIdle(
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
 {
+	auto [begin, end] = GetQueueRange();
+
 	bool AllIdle = true;
 
-	auto CheckIdle = [&AllIdle, timeOut](Ref<Queue> queue)
-	{
-		if (!queue->WaitIdle(timeOut))
-			AllIdle &= false;
-	};
+	for (size_t i = begin; i < end; i++)
+		AllIdle &= mFamilyData->Queues[i]->WaitIdle(timeOut);
 
-	switch (mAccessType)
-	{
-		case QueueAccessType::eGeneric:
-			std::for_each(mFamilyData->Queues.begin(), mFamilyData->Queues.end(), CheckIdle);
-			return AllIdle;
-		case QueueAccessType::eWorker:
-			std::for_each(mFamilyData->Queues.begin() + mFamilyData->WorkerBeginIndex, 
-				mFamilyData->Queues.end(), CheckIdle);
-			return AllIdle;
-		default:
-			return false;
-	}
+	return AllIdle;
 }
 
 bool VK_NAMESPACE::VK_CORE::Executor::operator==(const Executor& Other) const
@@ -83,33 +74,37 @@ bool VK_NAMESPACE::VK_CORE::Executor::operator==(const Executor& Other) const
 	return (mFamilyData == Other.mFamilyData) && (mAccessType == Other.mAccessType);
 }
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitToQueuesRange(
-	size_t begin, size_t end, std::chrono::nanoseconds timeOut, const vk::SubmitInfo& submitInfo) const
+std::pair<size_t, size_t> VK_NAMESPACE::VK_CORE::Executor::GetQueueRange() const
 {
-	const auto& queueFamily = *mFamilyData;
+	size_t queueCount = mFamilyData->Queues.size();
 
-	return TraverseIdleQueues(begin, end, timeOut,
-		[this, submitInfo](const Core::Ref<Core::Queue>& queue)
-	{
-		if (queue->Submit(submitInfo, std::chrono::nanoseconds(0)))
-			return true;
+	// A family with a single queue (lavapipe) has no workers, the generic queue does the work then
+	if (mAccessType == QueueAccessType::eWorker && mFamilyData->WorkerBeginIndex < queueCount)
+		return { mFamilyData->WorkerBeginIndex, queueCount };
 
-		return false;
-	});
+	return { 0, queueCount };
 }
 
-uint32_t VK_NAMESPACE::VK_CORE::Executor::SubmitToQueuesRange(
-	size_t begin, size_t end, std::chrono::nanoseconds timeOut,
-	const vk::SubmitInfo* submitBegin, const vk::SubmitInfo* submitEnd) const
+const VK_NAMESPACE::VK_CORE::Ref<VK_NAMESPACE::VK_CORE::Queue>&
+	VK_NAMESPACE::VK_CORE::Executor::FindLeastBusyQueue() const
 {
-	const auto& queueFamily = *mFamilyData;
+	auto [begin, end] = GetQueueRange();
+
+	_STL_ASSERT(begin < end, "Executor has no queues to submit to!");
+
+	size_t leastBusy = begin;
+	uint64_t minPending = std::numeric_limits<uint64_t>::max();
 
-	return TraverseIdleQueues(begin, end, timeOut,
-		[this, submitBegin, submitEnd](const Core::Ref<Core::Queue>& queue)
+	for (size_t i = begin; i < end && minPending != 0; i++)
 	{
-		if (queue->SubmitRange(submitBegin, submitEnd, std::chrono::nanoseconds(0)))
-			return true;
+		uint64_t pending = mFamilyData->Queues[i]->GetPendingCount();
+
+		if (pending < minPending)
+		{
+			leastBusy = i;
+			minPending = pending;
+		}
+	}
 
-		return false;
-	});
+	return mFamilyData->Queues[leastBusy];
 }
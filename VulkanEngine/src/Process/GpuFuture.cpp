@@ -0,0 +1,22 @@
+#include "Process/GpuFuture.h"
+
+bool VK_NAMESPACE::VK_CORE::GpuFuture::Wait(
+	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+{
+	if (!mTimeline)
+		return true;
+
+	vk::SemaphoreWaitInfo waitInfo{};
+	waitInfo.setSemaphores(mTimeline);
+	waitInfo.setValues(mValue);
+
+	return mDevice.waitSemaphores(waitInfo, timeOut.count()) == vk::Result::eSuccess;
+}
+
+bool VK_NAMESPACE::VK_CORE::GpuFuture::IsReady() const
+{
+	if (!mTimeline)
+		return true;
+
+	return mDevice.getSemaphoreCounterValue(mTimeline) >= mValue;
+}
@@ -30,6 +30,22 @@ uint32_t VK_NAMESPACE::QueueManager::FindOptimalQueueFamilyIndex(vk::QueueFlagBi
 	return OptimalFamilyIndex;
 }
 
+uint32_t VK_NAMESPACE::QueueManager::FindTransferOnlyFamilyIndex() const
+{
+	vk::QueueFlags TransferFlags = vk::QueueFlagBits::eTransfer | vk::QueueFlagBits::eSparseBinding |
+		vk::QueueFlagBits::eProtected;
+
+	for (const auto& [index, family] : mQueues)
+	{
+		bool CanTransfer = static_cast<bool>(family.Capabilities & vk::QueueFlagBits::eTransfer);
+
+		if (CanTransfer && !(family.Capabilities & ~TransferFlags))
+			return index;
+	}
+
+	return -1;
+}
+
 uint32_t VK_NAMESPACE::QueueManager::GetQueueCount(uint32_t FamilyIndex) const
 {
 	return static_cast<uint32_t>(mQueues.at(FamilyIndex).Queues.size());
@@ -1,120 +1,118 @@
 #include "Process/Queues.h"
 
 VK_NAMESPACE::VK_CORE::Queue::Queue(const Queue& Other)
-	: mHandle(Other.mHandle), mFence(Other.mFence), mDevice(Other.mDevice) {}
-
-vk::Result VK_NAMESPACE::VK_CORE::Queue::WaitIdleAsync(uint64_t timeout) const
+	: mHandle(Other.mHandle), mTimeline(Other.mTimeline), mDevice(Other.mDevice)
 {
-	return mDevice.waitForFences(mFence, VK_TRUE, timeout);
+	std::scoped_lock locker(Other.mLock);
+	mSubmittedValue = Other.mSubmittedValue;
 }
 
 VK_NAMESPACE::VK_CORE::Queue& VK_NAMESPACE::VK_CORE::Queue::operator=(const Queue& Other)
 {
-	std::scoped_lock locker(mLock);
+	std::scoped_lock locker(mLock, Other.mLock);
 
 	mHandle = Other.mHandle;
-	mFence = Other.mFence;
+	mTimeline = Other.mTimeline;
+	mSubmittedValue = Other.mSubmittedValue;
 	mDevice = Other.mDevice;
 
 	return *this;
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::Submit(const vk::SubmitInfo& submitInfo, 
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::Submit(const vk::SubmitInfo& submitInfo) const
 {
-	std::scoped_lock locker(mLock);
+	std::vector<vk::SubmitInfo> submitInfos = { submitInfo };
 
-	if (WaitIdleAsync(timeOut.count()) != vk::Result::eSuccess)
-		return false;
-
-	mDevice.resetFences(mFence);
-	mHandle.submit(submitInfo, mFence);
-
-	return true;
+	return SubmitBatches(submitInfos);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::Submit(vk::Semaphore signalSemaphore,
-	vk::CommandBuffer buffer, std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::Submit(
+	vk::Semaphore signalSemaphore, vk::CommandBuffer buffer) const
 {
 	vk::SubmitInfo submitInfo{};
 	submitInfo.setCommandBuffers(buffer);
 	submitInfo.setSignalSemaphores(signalSemaphore);
 
-	return Submit(submitInfo, timeOut);
+	return Submit(submitInfo);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::Submit(const QueueWaitingPoint& waitPoint,
-	vk::Semaphore signalSemaphore, vk::CommandBuffer buffer,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::Submit(const QueueWaitingPoint& waitPoint,
+	vk::Semaphore signalSemaphore, vk::CommandBuffer buffer) const
 {
 	vk::PipelineStageFlags WaitStages = { waitPoint.WaitDst };
 
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.setWaitSemaphoreValues(waitPoint.WaitValue);
+
 	vk::SubmitInfo submitInfo{};
 	submitInfo.setCommandBuffers(buffer);
 	submitInfo.setWaitDstStageMask(WaitStages);
 	submitInfo.setWaitSemaphores(waitPoint.WaitSemaphore);
-	submitInfo.setSignalSemaphores(signalSemaphore);
+	submitInfo.setPNext(&timelineInfo);
 
-	return Submit(submitInfo, timeOut);
+	if (signalSemaphore)
+		submitInfo.setSignalSemaphores(signalSemaphore);
+
+	return Submit(submitInfo);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::Submit(vk::CommandBuffer buffer,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::Submit(vk::CommandBuffer buffer) const
 {
 	vk::SubmitInfo submitInfo{};
 	submitInfo.setCommandBuffers(buffer);
 
-	return Submit(submitInfo, timeOut);
+	return Submit(submitInfo);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::SubmitRange(
-	const vk::SubmitInfo* Begin, const vk::SubmitInfo* End,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::SubmitRange(
+	const vk::SubmitInfo* Begin, const vk::SubmitInfo* End) const
 {
 	std::vector<vk::SubmitInfo> submitInfos(Begin, End);
 
-	std::scoped_lock locker(mLock);
-
-	if (WaitIdleAsync(timeOut.count()) != vk::Result::eSuccess)
-		return false;
-
-	mDevice.resetFences(mFence);
-	mHandle.submit(submitInfos);
-
-	return true;
+	return SubmitBatches(submitInfos);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::SubmitRange(vk::CommandBuffer* Begin, vk::CommandBuffer* End,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::SubmitRange(
+	vk::CommandBuffer* Begin, vk::CommandBuffer* End) const
 {
 	std::vector<vk::SubmitInfo> submitInfos(End - Begin);
 
 	for (auto& info : submitInfos)
 		info.setCommandBuffers(*(Begin++));
-	
-	std::scoped_lock locker(mLock);
-
-	if (WaitIdleAsync(timeOut.count()) != vk::Result::eSuccess)
-		return false;
 
-	mDevice.resetFences(mFence);
-	mHandle.submit(submitInfos);
-
-	return true;
+	return SubmitBatches(submitInfos);
 }
 
-bool VK_NAMESPACE::VK_CORE::Queue::BindSparse(const vk::BindSparseInfo& bindSparseInfo,
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::BindSparse(
+	const vk::BindSparseInfo& bindSparseInfo) const
 {
+	vk::BindSparseInfo bindInfo = bindSparseInfo;
+
+	std::vector<vk::Semaphore> signalSemaphores(bindInfo.pSignalSemaphores,
+		bindInfo.pSignalSemaphores + bindInfo.signalSemaphoreCount);
+
+	std::vector<uint64_t> waitValues(bindInfo.waitSemaphoreCount, 0);
+	std::vector<uint64_t> signalValues(bindInfo.signalSemaphoreCount, 0);
+
 	std::scoped_lock locker(mLock);
 
-	if (WaitIdleAsync(timeOut.count()) != vk::Result::eSuccess)
-		return false;
+	uint64_t value = mSubmittedValue + 1;
+
+	signalSemaphores.push_back(mTimeline);
+	signalValues.push_back(value);
 
-	mDevice.resetFences(mFence);
-	mHandle.bindSparse(bindSparseInfo, mFence);
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.setWaitSemaphoreValues(waitValues);
+	timelineInfo.setSignalSemaphoreValues(signalValues);
+	timelineInfo.setPNext(bindInfo.pNext);
 
-	return true;
+	bindInfo.setSignalSemaphores(signalSemaphores);
+	bindInfo.setPNext(&timelineInfo);
+
+	mHandle.bindSparse(bindInfo, nullptr);
+	mSubmittedValue = value;
+
+	return { mDevice, mTimeline, value };
 }
 
 vk::Result VK_NAMESPACE::VK_CORE::Queue::PresentKHR(const vk::PresentInfoKHR& presentInfo) const
@@ -123,17 +121,77 @@ vk::Result VK_NAMESPACE::VK_CORE::Queue::PresentKHR(const vk::PresentInfoKHR& pr
 }
 
 bool VK_NAMESPACE::VK_CORE::Queue::WaitIdle(
-	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/)const
+	std::chrono::nanoseconds timeOut /*= std::chrono::nanoseconds::max()*/) const
 {
-	auto Result = WaitIdleAsync(timeOut.count());
+	return GetLastSubmission().Wait(timeOut);
+}
+
+uint64_t VK_NAMESPACE::VK_CORE::Queue::GetPendingCount() const
+{
+	uint64_t submittedValue = 0;
+
+	{
+		std::scoped_lock locker(mLock);
+		submittedValue = mSubmittedValue;
+	}
+
+	return submittedValue - std::min(submittedValue, mDevice.getSemaphoreCounterValue(mTimeline));
+}
+
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::GetLastSubmission() const
+{
+	std::scoped_lock locker(mLock);
+	return { mDevice, mTimeline, mSubmittedValue };
+}
+
+VK_NAMESPACE::VK_CORE::GpuFuture VK_NAMESPACE::VK_CORE::Queue::SubmitBatches(
+	std::vector<vk::SubmitInfo>& submitInfos) const
+{
+	_STL_ASSERT(!submitInfos.empty(), "Submitting an empty range to the queue!");
 
-	// Notify any thread, in case, it's stuck waiting for the resource to be free
-	// --> The notification is received by Core::Executor::SubmitWork(...)
-	if (Result == vk::Result::eSuccess)
+	// The timeline is signalled by the last batch
+	// A signal operation covers all the work submitted to the queue before it
+	vk::SubmitInfo& lastInfo = submitInfos.back();
+
+	std::vector<vk::Semaphore> signalSemaphores(lastInfo.pSignalSemaphores,
+		lastInfo.pSignalSemaphores + lastInfo.signalSemaphoreCount);
+
+	std::vector<uint64_t> waitValues(lastInfo.waitSemaphoreCount, 0);
+	std::vector<uint64_t> signalValues(lastInfo.signalSemaphoreCount, 0);
+
+	const void* next = lastInfo.pNext;
+
+	// Keeping the values of the caller's timeline waits and signals
+	auto callerInfo = static_cast<const vk::TimelineSemaphoreSubmitInfo*>(lastInfo.pNext);
+
+	if (callerInfo && callerInfo->sType == vk::StructureType::eTimelineSemaphoreSubmitInfo)
 	{
-		std::scoped_lock locker(mFamilyInfo->NotifierMutex);
-		mFamilyInfo->IdleNotifier.notify_one();
+		std::copy_n(callerInfo->pWaitSemaphoreValues,
+			std::min<size_t>(callerInfo->waitSemaphoreValueCount, waitValues.size()), waitValues.begin());
+		std::copy_n(callerInfo->pSignalSemaphoreValues,
+			std::min<size_t>(callerInfo->signalSemaphoreValueCount, signalValues.size()), signalValues.begin());
+
+		next = callerInfo->pNext;
 	}
 
-	return Result == vk::Result::eSuccess;
+	std::scoped_lock locker(mLock);
+
+	// Values only go up in submission order, since the lock is held until the submit is done
+	uint64_t value = mSubmittedValue + 1;
+
+	signalSemaphores.push_back(mTimeline);
+	signalValues.push_back(value);
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.setWaitSemaphoreValues(waitValues);
+	timelineInfo.setSignalSemaphoreValues(signalValues);
+	timelineInfo.setPNext(next);
+
+	lastInfo.setSignalSemaphores(signalSemaphores);
+	lastInfo.setPNext(&timelineInfo);
+
+	mHandle.submit(submitInfos);
+	mSubmittedValue = value;
+
+	return { mDevice, mTimeline, value };
 }
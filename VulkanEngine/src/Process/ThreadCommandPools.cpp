@@ -0,0 +1,28 @@
+#include "Process/ThreadCommandPools.h"
+
+VK_NAMESPACE::ThreadCommandPools::ThreadCommandPools(CommandPoolsFactory&& factory)
+	: mRegistry(std::make_shared<Core::ThreadCommandPoolsData>())
+{
+	mRegistry->Factory = std::move(factory);
+}
+
+const VK_NAMESPACE::CommandPools& VK_NAMESPACE::ThreadCommandPools::GetThreadPools() const
+{
+	_STL_ASSERT(mRegistry, "ThreadCommandPools is used without a factory!");
+
+	std::scoped_lock locker(mRegistry->Lock);
+
+	auto found = mRegistry->Pools.find(std::this_thread::get_id());
+
+	if (found != mRegistry->Pools.end())
+		return found->second;
+
+	// The references stay valid, the map never moves its nodes
+	return mRegistry->Pools[std::this_thread::get_id()] = mRegistry->Factory();
+}
+
+size_t VK_NAMESPACE::ThreadCommandPools::GetThreadCount() const
+{
+	std::scoped_lock locker(mRegistry->Lock);
+	return mRegistry->Pools.size();
+}
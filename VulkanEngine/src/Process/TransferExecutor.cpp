@@ -0,0 +1,83 @@
+#include "Process/TransferExecutor.h"
+
+VK_NAMESPACE::TransferExecutor::TransferExecutor(QueueManagerRef queueManager,
+	const CommandPools& commandPools, uint32_t dstFamilyIndex)
+	: mQueueManager(queueManager), mCommandPools(commandPools), mDstFamily(dstFamilyIndex)
+{
+	mTransferFamily = mQueueManager->FindTransferOnlyFamilyIndex();
+
+	// Falling back to the destination family, e.g. lavapipe exposes a single queue
+	if (mTransferFamily == static_cast<uint32_t>(-1))
+		mTransferFamily = mDstFamily;
+}
+
+void VK_NAMESPACE::TransferExecutor::RecordRelease(vk::CommandBuffer cmdBuffer,
+	const std::vector<Core::Ref<Core::Buffer>>& buffers, uint32_t srcFamily, uint32_t dstFamily) const
+{
+	std::vector<vk::BufferMemoryBarrier> barriers;
+
+	// The access masks of the other half are ignored
+	for (const auto& buffer : buffers)
+	{
+		vk::BufferMemoryBarrier barrier{};
+		barrier.setBuffer(buffer->Handle);
+		barrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite);
+		barrier.setSrcQueueFamilyIndex(srcFamily);
+		barrier.setDstQueueFamilyIndex(dstFamily);
+		barrier.setSize(VK_WHOLE_SIZE);
+
+		barriers.push_back(barrier);
+	}
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+		vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, barriers, nullptr);
+}
+
+void VK_NAMESPACE::TransferExecutor::RecordAcquire(vk::CommandBuffer cmdBuffer,
+	const std::vector<Core::Ref<Core::Buffer>>& buffers, uint32_t srcFamily, uint32_t dstFamily) const
+{
+	std::vector<vk::BufferMemoryBarrier> barriers;
+
+	for (const auto& buffer : buffers)
+	{
+		vk::BufferMemoryBarrier barrier{};
+		barrier.setBuffer(buffer->Handle);
+		barrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite);
+		barrier.setSrcQueueFamilyIndex(srcFamily);
+		barrier.setDstQueueFamilyIndex(dstFamily);
+		barrier.setSize(VK_WHOLE_SIZE);
+
+		barriers.push_back(barrier);
+	}
+
+	cmdBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+		vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, barriers, nullptr);
+}
+
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::TransferExecutor::ReleaseToTransfer(
+	const std::vector<Core::Ref<Core::Buffer>>& buffers, const std::vector<Core::GpuFuture>& waitFor) const
+{
+	vk::CommandBuffer cmdBuffer = mCommandPools[mDstFamily].BeginOneTimeCommands();
+
+	RecordRelease(cmdBuffer, buffers, mDstFamily, mTransferFamily);
+
+	return EndCommands(cmdBuffer, mDstFamily, waitFor);
+}
+
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::TransferExecutor::AcquireFromTransfer(
+	const std::vector<Core::Ref<Core::Buffer>>& buffers, const Core::GpuFuture& copied) const
+{
+	vk::CommandBuffer cmdBuffer = mCommandPools[mDstFamily].BeginOneTimeCommands();
+
+	RecordAcquire(cmdBuffer, buffers, mTransferFamily, mDstFamily);
+
+	return EndCommands(cmdBuffer, mDstFamily, { copied });
+}
+
+VK_NAMESPACE::Core::GpuFuture VK_NAMESPACE::TransferExecutor::EndCommands(vk::CommandBuffer cmdBuffer,
+	uint32_t familyIndex, const std::vector<Core::GpuFuture>& waitFor) const
+{
+	auto executor = mQueueManager->FetchExecutor(familyIndex, QueueAccessType::eWorker);
+
+	return mCommandPools[familyIndex].EndOneTimeCommandsAsync(cmdBuffer, executor, waitFor);
+}
@@ -5,4 +5,6 @@ configurations { "Debug", "Release" }
 startproject "vkEngineTester"
 
 include "VulkanEngine/MakeVulkanEngine.lua"
+include "AquaFlow/MakeAquaFlow.lua"
 include "vkEngineTester/MakevkEngineTester.lua"
+include "Tests/MakeTests.lua"
@@ -85,8 +85,6 @@ bool ComputePipelineTester::OnUpdate(float ElaspedTime)
 	i++;
 
 	vk::SubmitInfo submitInfo{};
-	vk::PipelineStageFlags waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-	uint32_t index = 0;
 
 	ActiveFrame.CmdBuffer.reset();
 
@@ -107,21 +105,39 @@ bool ComputePipelineTester::OnUpdate(float ElaspedTime)
 
 	ActiveFrame.CmdBuffer.end();
 
-	waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+	std::vector<vk::Semaphore> waitSemaphores = { *Data.ImageAcquired };
+	std::vector<vk::PipelineStageFlags> waitStageMasks = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+	std::vector<uint64_t> waitValues = { 0 }; // Ignored for the binary semaphore
+
+#if USE_WAVEFRONT_PATHTRACER
+	// The scene geometry is still streaming in right after TraceSession::End
+	vkEngine::Core::GpuFuture sceneUploads = mExecutor.GetTraceSession().GetSceneUploads();
+
+	if (sceneUploads)
+	{
+		waitSemaphores.push_back(sceneUploads.GetSemaphore());
+		waitStageMasks.push_back(vk::PipelineStageFlagBits::eComputeShader);
+		waitValues.push_back(sceneUploads.GetValue());
+	}
+#endif
+
+	vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.setWaitSemaphoreValues(waitValues);
 
 	submitInfo = vk::SubmitInfo();
 
 	submitInfo.setCommandBuffers(ActiveFrame.CmdBuffer);
-	submitInfo.setWaitDstStageMask(waitStages);
-	submitInfo.setWaitSemaphores(*Data.ImageAcquired);
+	submitInfo.setWaitDstStageMask(waitStageMasks);
+	submitInfo.setWaitSemaphores(waitSemaphores);
 	submitInfo.setSignalSemaphores(ActiveFrame.ImageRendered);
+	submitInfo.setPNext(&timelineInfo);
 
-	index = mGraphicsWorker.SubmitWork(submitInfo);
+	vkEngine::Core::GpuFuture rendered = mGraphicsWorker.SubmitWork(submitInfo);
 
 	ActiveFrame.RenderTarget.TransitionColorAttachmentLayouts(vk::ImageLayout::ePresentSrcKHR,
 		vk::PipelineStageFlagBits::eTopOfPipe);
 
-	mGraphicsWorker[index]->WaitIdle();
+	rendered.Wait();
 
 #if 0
 	FillWavefrontHostBuffers();
@@ -92,12 +92,12 @@ bool GraphicsPipelineTester::OnUpdate(float ElaspedTime)
 
 	auto& ActiveFrame = Data.Frames[FrameIndex.value];
 
-	uint32_t index = Render(*ActiveFrame, Data);
+	vkEngine::Core::GpuFuture rendered = Render(*ActiveFrame, Data);
 
 	ActiveFrame->RenderTarget.TransitionColorAttachmentLayouts(vk::ImageLayout::ePresentSrcKHR,
 		vk::PipelineStageFlagBits::eTopOfPipe);
 
-	mGraphicsWorker[index]->WaitIdle();
+	rendered.Wait();
 
 	PresentScreen(FrameIndex.value, *ActiveFrame);
 
@@ -120,7 +120,7 @@ void GraphicsPipelineTester::PresentScreen(uint32_t FrameIndex, vkEngine::Swapch
 	_STL_ASSERT(Result == vk::Result::eSuccess, "Could not present image!");
 }
 
-uint32_t GraphicsPipelineTester::Render(vkEngine::SwapchainFrame& ActiveFrame, vkEngine::SwapchainData& Data)
+vkEngine::Core::GpuFuture GraphicsPipelineTester::Render(vkEngine::SwapchainFrame& ActiveFrame, vkEngine::SwapchainData& Data)
 {
 	vkEngine::Framebuffer renderTarget = ActiveFrame.RenderTarget;
 	vkEngine::Framebuffer pipelineTarget = mPipeline.GetRenderTarget();
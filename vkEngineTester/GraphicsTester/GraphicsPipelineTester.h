@@ -31,5 +31,5 @@ private:
 private:
 	void PresentScreen(uint32_t FrameIndex, vkEngine::SwapchainFrame& ActiveFrame);
 
-	uint32_t Render(vkEngine::SwapchainFrame& ActiveFrame, vkEngine::SwapchainData& Data);
+	vkEngine::Core::GpuFuture Render(vkEngine::SwapchainFrame& ActiveFrame, vkEngine::SwapchainData& Data);
 };